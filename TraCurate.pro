@@ -17,4 +17,6 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     tracurate_application.pro \
-    tools/validate.pro
+    tools/validate.pro \
+    tools/cli.pro \
+    tools/benchmark.pro
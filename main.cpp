@@ -25,13 +25,20 @@
 #if 0
 #include "examples/examples.h"
 #endif
+#include "io/journal.h"
 #include "provider/tcsettings.h"
 #include "provider/dataprovider.h"
 #include "provider/guicontroller.h"
 #include "provider/guistate.h"
+#include "provider/imagecache.h"
 #include "provider/imageprovider.h"
+#include "provider/lineageview.h"
 #include "provider/messagerelay.h"
+#include "provider/thumbnailcache.h"
+#include "provider/thumbnailprovider.h"
 #include "provider/timetracker.h"
+#include "provider/tracer.h"
+#include "provider/undostack.h"
 
 #include <QFile>
 #include <QTextStream>
@@ -58,6 +65,9 @@ int main(int argc, char *argv[])
     TCSettings::getInstance();
     GUIState::getInstance();
     DataProvider::getInstance();
+    Journal::getInstance();
+    ThumbnailCache::getInstance();
+    UndoStack::getInstance();
 
     ImageProvider *provider = new ImageProvider();
 
@@ -66,11 +76,17 @@ int main(int argc, char *argv[])
     qmlRegisterSingletonType<GUIState>     ("imb.tracurate", 1,0, "GUIState",      GUIState::qmlInstanceProvider);
     qmlRegisterSingletonType<DataProvider> ("imb.tracurate", 1,0, "DataProvider",  DataProvider::qmlInstanceProvider);
     qmlRegisterSingletonType<MessageRelay> ("imb.tracurate", 1,0, "MessageRelay",  MessageRelay::qmlInstanceProvider);
+    qmlRegisterSingletonType<Tracer>       ("imb.tracurate", 1,0, "Tracer",        Tracer::qmlInstanceProvider);
+    qmlRegisterSingletonType<Journal>      ("imb.tracurate", 1,0, "Journal",       Journal::qmlInstanceProvider);
+    qmlRegisterSingletonType<ThumbnailCache>("imb.tracurate", 1,0, "ThumbnailCache", ThumbnailCache::qmlInstanceProvider);
+    qmlRegisterSingletonType<UndoStack>    ("imb.tracurate", 1,0, "UndoStack",     UndoStack::qmlInstanceProvider);
     qmlRegisterType<Annotation> ("imb.tracurate", 1,0, "Annotation");
     qmlRegisterType<TCOption>   ("imb.tracurate", 1,0, "TCOption");
     qmlRegisterType<Tracklet>   ("imb.tracurate", 1,0, "Tracklet");
+    qmlRegisterType<LineageView>("imb.tracurate", 1,0, "LineageView");
 
     engine.addImageProvider("celltracking", provider);
+    engine.addImageProvider("thumbnails", new ThumbnailProvider());
     engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
 
     DataProvider::getInstance()->setDevicePixelRatio(app.devicePixelRatio());
@@ -87,9 +103,11 @@ int main(int argc, char *argv[])
     }
 
     GUIController::getInstance()->abortStrategy();
+    UndoStack::getInstance()->flush();
 
     /* Wait for threads started by QtConcurrent to finish */
-    GUIController::getInstance()->waitForFutures();
+    ImageCache::getInstance()->waitForPrefetch();
+    ThumbnailCache::getInstance()->waitForDone();
     DataProvider::getInstance()->waitForFutures();
 
     return ret;
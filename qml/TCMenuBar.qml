@@ -89,6 +89,25 @@ MenuBar {
         }
     }
 
+    Menu {
+        /* Undo and redo segmentation and tracking edits. */
+        title: "Edit"
+
+        MenuItem {
+            text: UndoStack.canUndo ? "Undo: " + UndoStack.undoText : "Undo"
+            enabled: UndoStack.canUndo
+            shortcut: StandardKey.Undo
+            onTriggered: GUIController.undo()
+        }
+
+        MenuItem {
+            text: UndoStack.canRedo ? "Redo: " + UndoStack.redoText : "Redo"
+            enabled: UndoStack.canRedo
+            shortcut: StandardKey.Redo
+            onTriggered: GUIController.redo()
+        }
+    }
+
     Menu {
         title: "View"
         enabled: trackingViewIsVisible
@@ -162,6 +162,7 @@ Item {
             Qt.quit()
         }
         onNo: {
+            Journal.discard()
             Qt.quit()
         }
     }
@@ -178,6 +179,7 @@ Item {
             loadFileDialog.open()
         }
         onNo: {
+            Journal.discard()
             loadFileDialog.open()
         }
     }
@@ -426,7 +428,7 @@ Item {
         visible: false
         modality: Qt.ApplicationModal
 
-        height: 100
+        height: 120
         width: 300
         minimumHeight: height
         maximumHeight: height
@@ -443,6 +445,7 @@ Item {
         property string detailName: "detailName"
         property int detailMax: 0
         property int detailCurr: 0
+        property string detailRate: ""
 
         Connections {
             target: MessageRelay
@@ -450,8 +453,12 @@ Item {
             onUpdateOverallMax: { statusWindow.overallCurr = 0; statusWindow.overallMax = newMax }
             onIncreaseOverall: { statusWindow.overallCurr++ }
             onUpdateDetailName: { statusWindow.detailName = text }
-            onUpdateDetailMax: { statusWindow.detailCurr = 0; statusWindow.detailMax = newMax }
-            onIncreaseDetail: { statusWindow.detailCurr++ }
+            onUpdateDetailMax: { statusWindow.detailCurr = 0; statusWindow.detailMax = newMax; statusWindow.detailRate = "" }
+            onDetailProgress: {
+                statusWindow.detailCurr = curr
+                statusWindow.detailMax = max
+                statusWindow.detailRate = statusWindow.formatRate(perSecond, etaSeconds)
+            }
             onFinishNotification: { statusWindow.reset() }
         }
 
@@ -462,10 +469,22 @@ Item {
             statusWindow.detailName = ""
             statusWindow.detailMax = 0
             statusWindow.detailCurr = 0
+            statusWindow.detailRate = ""
             statusWindow.visible = false
             GUIState.mouseAreaActive = true
         }
 
+        function formatRate(perSecond, etaSeconds) {
+            var text = perSecond.toFixed(perSecond < 10 ? 1 : 0) + " items/s"
+            if (etaSeconds >= 0) {
+                var secs = Math.round(etaSeconds)
+                var mins = Math.floor(secs / 60)
+                secs = secs % 60
+                text += ", " + mins + ":" + (secs < 10 ? "0" : "") + secs + " left"
+            }
+            return text
+        }
+
         Connections {
             target: GUIState
             onNeedsSaveChanged: {
@@ -530,6 +549,17 @@ Item {
 
                 onVisibleChanged: GUIState.mouseAreaActive = !visible
             }
+
+            Text {
+                id: detailRateField
+                anchors.left: parent.left
+                anchors.right: parent.right
+                width: 300
+
+                horizontalAlignment: Text.AlignHCenter
+                font.pointSize: TCSettings.value("text/default_fontsize")
+                text: statusWindow.detailRate
+            }
         }
     }
 
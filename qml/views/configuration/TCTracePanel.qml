@@ -0,0 +1,124 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.2
+import QtQuick.Dialogs 1.2
+import QtQuick.Controls 1.4
+import QtQuick.Layouts 1.1
+import imb.tracurate 1.0
+
+Rectangle {
+    /* Shows latency and throughput of the traced hot paths. The
+       statistics are polled from the Tracer while the panel is
+       active, the recorded events can be saved as a Chrome trace. */
+    id: tracePanel
+    property bool active: false
+    property int windowMs: 5000
+
+    border.color: "orange"
+
+    function refresh() {
+        tm.clear()
+        var s = Tracer.getStats(windowMs)
+        for (var i = 0; i < s.length; i++)
+            tm.append({ "name"         : s[i].name,
+                        "counter"      : s[i].counter,
+                        "count"        : s[i].count,
+                        "meanMs"       : s[i].meanMs,
+                        "maxMs"        : s[i].maxMs,
+                        "recentMeanMs" : s[i].recentMeanMs,
+                        "perSecond"    : s[i].perSecond,
+                        "value"        : s[i].value });
+    }
+
+    function isCounter(row) { return row >= 0 && row < tm.count && tm.get(row).counter }
+
+    ListModel { id: tm }
+
+    Timer {
+        interval: 1000
+        repeat: true
+        running: tracePanel.active && Tracer.isEnabled()
+        triggeredOnStart: true
+        onTriggered: tracePanel.refresh()
+    }
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 4
+
+        RowLayout {
+            Layout.fillWidth: true
+            Text {
+                text: Tracer.isEnabled() ? "Performance (last " + tracePanel.windowMs/1000 + "s)"
+                                         : "Performance tracing is disabled (build with CONFIG+=tracing)"
+                Layout.fillWidth: true
+            }
+            Button {
+                text: "Clear"
+                enabled: Tracer.isEnabled()
+                onClicked: { Tracer.clear(); tracePanel.refresh() }
+            }
+            Button {
+                text: "Save Trace…"
+                enabled: Tracer.isEnabled()
+                onClicked: traceDialog.open()
+            }
+        }
+
+        TableView {
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            model: tm
+            visible: Tracer.isEnabled()
+
+            TableViewColumn { role: "name"; title: "Name"; width: 300 }
+            TableViewColumn { role: "count"; title: "Count"; width: 80 }
+            TableViewColumn {
+                role: "perSecond"; title: "Rate [1/s]"; width: 90
+                delegate: Text { text: styleData.value.toFixed(1) }
+            }
+            TableViewColumn {
+                role: "recentMeanMs"; title: "Recent Mean [ms]"; width: 120
+                delegate: Text { text: tracePanel.isCounter(styleData.row) ? "" : styleData.value.toFixed(2) }
+            }
+            TableViewColumn {
+                role: "meanMs"; title: "Mean [ms]"; width: 90
+                delegate: Text { text: tracePanel.isCounter(styleData.row) ? "" : styleData.value.toFixed(2) }
+            }
+            TableViewColumn {
+                role: "maxMs"; title: "Max [ms]"; width: 90
+                delegate: Text { text: tracePanel.isCounter(styleData.row) ? "" : styleData.value.toFixed(2) }
+            }
+            TableViewColumn {
+                role: "value"; title: "Value"; width: 90
+                delegate: Text { text: tracePanel.isCounter(styleData.row) ? styleData.value : "" }
+            }
+        }
+    }
+
+    FileDialog {
+        id: traceDialog
+        title: "Save Chrome trace"
+        selectExisting: false
+        nameFilters: [ "Trace files (*.json)" ]
+        onAccepted: {
+            if (!Tracer.dumpChromeTrace(traceDialog.fileUrl))
+                MessageRelay.updateStatusBar("Could not save the trace")
+        }
+    }
+}
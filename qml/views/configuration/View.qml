@@ -26,8 +26,8 @@ import imb.tracurate 1.0
 import "."
 
 Item {
-    function viewActivationHook() { cl.buildModel() }
-    function viewDeactivationHook() { }
+    function viewActivationHook() { cl.buildModel(); tracePanel.active = true }
+    function viewDeactivationHook() { tracePanel.active = false }
 
     ColumnLayout {
         anchors.fill: parent
@@ -215,5 +215,11 @@ Item {
                 }
             }
         }
+
+        TCTracePanel {
+            id: tracePanel
+            Layout.fillWidth: true
+            Layout.preferredHeight: 250
+        }
     }
 }
@@ -0,0 +1,118 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.2
+import QtQuick.Controls 1.2
+import QtQuick.Layouts 1.1
+import imb.tracurate 1.0
+import "."
+
+Rectangle {
+    id: lineageDisplay
+    color: "white"
+
+    property string titleText: ""
+
+    function updateDisplay() {
+        lineageView.refresh()
+    }
+
+    ColumnLayout {
+        anchors.fill: parent
+        anchors.margins: 5
+
+        RowLayout {
+            Layout.fillWidth: true
+
+            Text {
+                text: titleText
+                font.pixelSize: 16
+                Layout.fillWidth: true
+                horizontalAlignment: Text.AlignHCenter
+            }
+
+            Button {
+                text: "Fit"
+                tooltip: "Zoom so all lineage trees are visible"
+                onClicked: lineageView.fit()
+            }
+        }
+
+        Text {
+            id: hoverInfo
+            Layout.fillWidth: true
+            text: " "
+        }
+
+        LineageView {
+            id: lineageView
+            Layout.fillWidth: true
+            Layout.fillHeight: true
+            clip: true
+
+            MouseArea {
+                id: lineageMouse
+                anchors.fill: parent
+                hoverEnabled: true
+
+                property real lastX: 0
+                property real lastY: 0
+
+                onPressed: {
+                    lastX = mouse.x
+                    lastY = mouse.y
+                }
+
+                onPositionChanged: {
+                    if (pressed) {
+                        lineageView.contentX -= mouse.x - lastX
+                        lineageView.contentY -= mouse.y - lastY
+                        lastX = mouse.x
+                        lastY = mouse.y
+                    }
+                    var id = lineageView.trackletAt(mouse.x, mouse.y)
+                    hoverInfo.text = id < 0 ? " " : "Tracklet " + id + ", frame " + lineageView.frameAt(mouse.x, id)
+                }
+
+                onClicked: {
+                    var id = lineageView.trackletAt(mouse.x, mouse.y)
+                    if (id < 0)
+                        return
+                    GUIController.selectLastCellByTrackId(id)
+                    GUIState.currentFrame = lineageView.frameAt(mouse.x, id)
+                    mainItem.state = "Tracking"
+                }
+
+                /* ctrl zooms the frames, shift the rows, both around the cursor */
+                onWheel: {
+                    var factor = wheel.angleDelta.y > 0 ? 1.25 : 0.8
+                    if (wheel.modifiers & Qt.ControlModifier) {
+                        var frame = (wheel.x + lineageView.contentX) / lineageView.frameWidth
+                        lineageView.frameWidth *= factor
+                        lineageView.contentX = frame * lineageView.frameWidth - wheel.x
+                    } else if (wheel.modifiers & Qt.ShiftModifier) {
+                        var row = (wheel.y + lineageView.contentY) / lineageView.rowHeight
+                        lineageView.rowHeight *= factor
+                        lineageView.contentY = row * lineageView.rowHeight - wheel.y
+                    } else {
+                        lineageView.contentY -= wheel.angleDelta.y / 2
+                    }
+                }
+            }
+        }
+    }
+}
@@ -28,6 +28,7 @@ Item {
         objectAnnotationView.updateDisplay()
         trackAnnotationView.updateDisplay()
         trackletView.updateDisplay()
+        lineageView.updateDisplay()
     }
 
     function viewDeactivationHook() { }
@@ -83,6 +84,18 @@ Item {
                 }
             }
 
+            ColumnLayout {
+                id: lineage
+                anchors.fill: parent
+
+                TCLineageDisplay {
+                    id: lineageView
+                    anchors.fill: parent
+
+                    titleText: "Lineage"
+                }
+            }
+
             ColumnLayout {
                 id: time
                 anchors.fill: parent
@@ -175,6 +188,16 @@ Item {
                         onClicked: contentPane.children = [tracklets]
                     }
 
+                    Button {
+                        text: "Lineage"
+                        anchors.left: parent.left
+                        anchors.right: parent.right
+                        onClicked: {
+                            contentPane.children = [lineage]
+                            lineageView.updateDisplay()
+                        }
+                    }
+
                     Button {
                         text: "Time"
                         anchors.left: parent.left
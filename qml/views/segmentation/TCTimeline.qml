@@ -0,0 +1,121 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+import QtQuick 2.2
+import imb.tracurate 1.0
+
+Rectangle {
+    /* A strip of thumbnails above the frame slider. While the slider or the
+       strip is dragged, the thumbnail of the frame under the cursor is shown
+       above it, the frame itself is loaded when the mouse is released. */
+    id: timeline
+    color: "black"
+    height: TCSettings.value("graphics/thumbnail_size") > 0 ? thumbHeight : 0
+    visible: height > 0
+
+    property Item slider
+    property int thumbHeight: 40
+    property int frames: GUIState.maximumFrame + 1
+    property int stripFrame: 0
+    property int previewFrame: stripMouse.pressed ? stripFrame : ((slider && slider.pressed) ? slider.value : -1)
+
+    /* changes when thumbnails were read or have to be drawn again */
+    property string key: [ThumbnailCache.revision, GUIState.currentSlice, GUIState.currentChannel,
+                          GUIState.contrastLow, GUIState.contrastHigh, GUIState.contrastGamma,
+                          GUIState.contrastColormap].join("_")
+
+    function frameAt(x) {
+        return Math.max(0, Math.min(Math.floor(x / width * frames), frames - 1))
+    }
+
+    function xOf(frame) {
+        return (frame + 0.5) / frames * width
+    }
+
+    Row {
+        anchors.fill: parent
+
+        Repeater {
+            id: tiles
+            model: Math.max(Math.floor(timeline.width / (timeline.thumbHeight * 4 / 3)), 1)
+
+            Image {
+                property int frame: Math.min(Math.floor((index + 0.5) * timeline.frames / tiles.count), timeline.frames - 1)
+                width: timeline.width / tiles.count
+                height: timeline.height
+                sourceSize.width: width
+                sourceSize.height: height
+                fillMode: Image.PreserveAspectCrop
+                clip: true
+                cache: false
+                asynchronous: true
+                source: timeline.visible ? "image://thumbnails/" + frame + "/" + timeline.key : ""
+            }
+        }
+    }
+
+    Rectangle {
+        /* the current frame */
+        width: 2
+        height: parent.height
+        x: timeline.xOf(GUIState.currentFrame) - width / 2
+        color: "orange"
+    }
+
+    MouseArea {
+        id: stripMouse
+        anchors.fill: parent
+
+        onPressed: timeline.stripFrame = timeline.frameAt(mouse.x)
+        onPositionChanged: timeline.stripFrame = timeline.frameAt(mouse.x)
+        onReleased: if (timeline.slider) timeline.slider.value = timeline.frameAt(mouse.x)
+    }
+
+    Rectangle {
+        id: preview
+        visible: timeline.visible && timeline.previewFrame >= 0
+        width: timeline.thumbHeight * 4
+        height: timeline.thumbHeight * 3 + previewText.height
+        x: Math.max(0, Math.min(timeline.xOf(timeline.previewFrame) - width / 2, timeline.width - width))
+        y: -height - 5
+        color: "black"
+        border.color: "white"
+
+        Image {
+            anchors {
+                top: parent.top
+                left: parent.left
+                right: parent.right
+                bottom: previewText.top
+                margins: 2
+            }
+            sourceSize.width: width
+            sourceSize.height: height
+            fillMode: Image.PreserveAspectFit
+            cache: false
+            source: preview.visible ? "image://thumbnails/" + timeline.previewFrame + "/" + timeline.key : ""
+        }
+
+        Text {
+            id: previewText
+            anchors.bottom: parent.bottom
+            anchors.horizontalCenter: parent.horizontalCenter
+            text: timeline.previewFrame
+            color: "white"
+        }
+    }
+}
@@ -38,6 +38,15 @@ Item {
 
     function viewDeactivationHook() {
         resetSegmentationVariables()
+        GUIController.discardResegmentation()
+    }
+
+    /* segments the selected track again, prefers the Tracklet over the AutoTracklet */
+    function resegmentSelectedTrack(watershed) {
+        if (GUIState.selectedTrackID !== -1)
+            GUIController.resegmentTrack(GUIState.selectedTrackID, false, watershed)
+        else if (GUIState.selectedAutoTrackID !== -1)
+            GUIController.resegmentTrack(GUIState.selectedAutoTrackID, true, watershed)
     }
 
     function resetSegmentationVariables() {
@@ -46,10 +55,13 @@ Item {
         GUIState.drawSeparation = false
         GUIState.drawDeletion = false
         GUIState.drawFlood = false
+        GUIState.drawWatershed = false
         GUIState.startX = -1
         GUIState.startY = -1
         GUIState.endX = -1
         GUIState.endY = -1
+        GUIState.cutPath = []
+        GUIState.seeds = []
     }
 
     RowLayout {
@@ -69,7 +81,7 @@ Item {
                 clip: true
                 anchors {
                     top: parent.top
-                    bottom: slider.top
+                    bottom: timeline.top
                     left: parent.left
                     right: parent.right
                 }
@@ -134,6 +146,10 @@ Item {
                         onStartYChanged: cellImage.updateImage()
                         onEndXChanged: cellImage.updateImage()
                         onEndYChanged: cellImage.updateImage()
+                        onCutPathChanged: cellImage.updateImage()
+                        onDrawWatershedChanged: cellImage.updateImage()
+                        onSeedsChanged: cellImage.updateImage()
+                        onDrawResegmentationChanged: cellImage.updateImage()
                         onThreshChanged: cellImage.updateImage()
                     }
 
@@ -160,19 +176,33 @@ Item {
                                 GUIState.startY = GUIState.mouseY
                                 GUIState.endX = -1
                                 GUIState.endY = -1
+                                GUIState.cutPath = [Qt.point(GUIState.mouseX, GUIState.mouseY)]
                                 GUIState.drawCutLine = true
                                 GUIState.drawSeparation = false
                             }
                         }
 
+                        /* adds the mouse position to the cut path, unless it is too close to the last point */
+                        function extendCutPath(force) {
+                            var path = GUIState.cutPath
+                            var last = path[path.length - 1]
+                            if (force || !last || Math.abs(GUIState.mouseX - last.x) + Math.abs(GUIState.mouseY - last.y) >= 3) {
+                                path.push(Qt.point(GUIState.mouseX, GUIState.mouseY))
+                                GUIState.cutPath = path
+                            }
+                        }
+
                         onPositionChanged: {
-                            if (GUIState.drawCutLine && mode === "sep")
+                            if (GUIState.drawCutLine && mode === "sep") {
                                 updateMousePosition()
+                                extendCutPath(false)
+                            }
                         }
 
                         onReleased: {
                             if (mode === "sep") {
                                 updateMousePosition()
+                                extendCutPath(true)
                                 GUIState.endX = GUIState.mouseX
                                 GUIState.endY = GUIState.mouseY
                                 GUIState.drawSeparation = true
@@ -216,6 +246,13 @@ Item {
                                 GUIState.startY = GUIState.mouseY
                                 GUIState.drawFlood = true
                             }
+                            if (mode === "ws") {
+                                updateMousePosition()
+                                var seeds = GUIState.seeds
+                                seeds.push(Qt.point(GUIState.mouseX, GUIState.mouseY))
+                                GUIState.seeds = seeds
+                                GUIState.drawWatershed = true
+                            }
                         }
 
                         Keys.onPressed: {
@@ -231,13 +268,15 @@ Item {
                             case Qt.Key_Space:
                                 updateMousePosition()
                                 if (mode === "sep") {
-                                    GUIController.cutObject(GUIState.startX, GUIState.startY, GUIState.endX, GUIState.endY)
+                                    GUIController.cutObjectsAlong(GUIState.cutPath)
                                 } else if (mode === "agg") {
                                     GUIController.mergeObjects(GUIState.startX, GUIState.startY, GUIState.endX, GUIState.endY)
                                 } else if (mode === "del") {
                                     GUIController.deleteObject(GUIState.startX, GUIState.startY)
                                 } else if (mode === "ff") {
                                     GUIController.floodFill(GUIState.startX, GUIState.startY)
+                                } else if (mode === "ws") {
+                                    GUIController.watershedSplit(GUIState.seeds)
                                 }
 
                                 resetSegmentationVariables()
@@ -250,6 +289,16 @@ Item {
                 }
             }
 
+            TCTimeline {
+                id: timeline
+                slider: slider
+                anchors {
+                    bottom: slider.top
+                    left: slider.left
+                    right: slider.right
+                }
+            }
+
             Slider {
                 /* This is the slider element for navigating through the frames.
                    Reloads the image provider and updates the properties, if its
@@ -291,7 +340,9 @@ Item {
                     }
                 }
 
-                onValueChanged: GUIController.changeFrameAbs(value)
+                /* while dragging, the timeline shows the thumbnail, the frame is loaded on release */
+                onValueChanged: if (!pressed || !timeline.visible) GUIController.changeFrameAbs(value)
+                onPressedChanged: if (!pressed) GUIController.changeFrameAbs(value)
 
                 Component.onCompleted: GUIState.setSlider(slider)
             }
@@ -398,6 +449,47 @@ Item {
                         }
                     }
                 }
+
+                Button {
+                    text: "Split Cell (Watershed)"
+                    onClicked: {
+                        resetSegmentationVariables()
+                        mode = "ws"
+                    }
+                    style: ButtonStyle {
+                        label: Text {
+                            verticalAlignment: Text.AlignVCenter
+                            horizontalAlignment: Text.AlignHCenter
+                            font.pixelSize: 12
+                            color: (parent.enabled)? ((mode === "ws")? "red" : "black") : "gray"
+                            text: control.text
+                        }
+                    }
+                }
+
+                Button {
+                    text: "Segment Track again (FloodFill) (thresh %1)".arg(GUIState.thresh)
+                    enabled: GUIState.selectedTrackID !== -1 || GUIState.selectedAutoTrackID !== -1
+                    onClicked: resegmentSelectedTrack(false)
+                }
+
+                Button {
+                    text: "Segment Track again (Watershed)"
+                    enabled: GUIState.selectedTrackID !== -1 || GUIState.selectedAutoTrackID !== -1
+                    onClicked: resegmentSelectedTrack(true)
+                }
+
+                RowLayout {
+                    visible: GUIState.drawResegmentation
+                    Button {
+                        text: "Apply"
+                        onClicked: GUIController.applyResegmentation()
+                    }
+                    Button {
+                        text: "Discard"
+                        onClicked: GUIController.discardResegmentation()
+                    }
+                }
             }
         }
     }
@@ -53,7 +53,7 @@ Item {
                 clip: true
                 anchors {
                     top: parent.top
-                    bottom: slider.top
+                    bottom: timeline.top
                     left: parent.left
                     right: parent.right
                 }
@@ -107,6 +107,7 @@ Item {
                         onHoveredAutoTrackIDChanged: cellImage.updateImage()
                         onBackingDataChanged: cellImage.updateImage()
                         onZoomFactorChanged: cellImage.updateImage()
+                        onDrawLinkProposalsChanged: cellImage.updateImage()
                     }
 
                     property real offsetWidth: (width - paintedWidth) / 2
@@ -226,6 +227,12 @@ Item {
                                             GUIState.ACTION_DEFAULT:
                                             GUIState.ACTION_DELETE_CELLS_FROM
                                 break;
+                            case Qt.Key_L: /* accept the current link proposal */
+                                GUIController.acceptLinkProposal()
+                                break;
+                            case Qt.Key_K: /* reject the current link proposal */
+                                GUIController.rejectLinkProposal()
+                                break;
                             case Qt.Key_Left:
                                 GUIState.offX -= TCSettings.value("scrolling/scroll_factor_x")*1
                                 break;
@@ -274,6 +281,16 @@ Item {
                 }
             }
 
+            TCTimeline {
+                id: timeline
+                slider: slider
+                anchors {
+                    bottom: slider.top
+                    left: slider.left
+                    right: slider.right
+                }
+            }
+
             Slider {
                 /* This is the slider element for navigating through the frames.
                    Reloads the image provider and updates the properties, if its
@@ -315,7 +332,9 @@ Item {
                     }
                 }
 
-                onValueChanged: GUIController.changeFrameAbs(value)
+                /* while dragging, the timeline shows the thumbnail, the frame is loaded on release */
+                onValueChanged: if (!pressed || !timeline.visible) GUIController.changeFrameAbs(value)
+                onPressedChanged: if (!pressed) GUIController.changeFrameAbs(value)
 
                 Component.onCompleted: GUIState.setSlider(slider)
             }
@@ -349,7 +368,7 @@ Item {
                 /* This is a flickable element that arranges the collapsible panels
                    in the sidebar. Each panel needs a model for showing information
                    and a delegate to implement the functionality. */
-                contentHeight: cellInfo.height + eventPanel.height +  navigationPanel.height + actionsPanel.height + strategiesPanel.height /* + slicesPanel.height + channelPanel.height */
+                contentHeight: cellInfo.height + eventPanel.height +  navigationPanel.height + actionsPanel.height + strategiesPanel.height + contrastPanel.height + linkingPanel.height /* + slicesPanel.height + channelPanel.height */
                 anchors.fill: parent
                 anchors.leftMargin: 5
                 id: flick
@@ -692,6 +711,131 @@ Item {
                     }
                 }
 
+                /* ================= Panel contrastPanel ================= */
+                TCCollapsiblePanel {
+                    id: contrastPanel
+                    anchors { top: strategiesPanel.bottom; left: parent.left; right: parent.right }
+                    titleText : "contrast"
+                    state : "collapsed"
+                    model : 1
+                    delegate : contrastDelegate
+                }
+
+                Component {
+                    id: contrastDelegate
+
+                    GridLayout {
+                        columns: 2
+
+                        Text { text: "low"; color: "black" }
+                        Slider {
+                            minimumValue: 0
+                            maximumValue: GUIState.contrastMax
+                            stepSize: 1
+                            value: GUIState.contrastLow
+                            onValueChanged: if (value < GUIState.contrastHigh) GUIState.contrastLow = value
+                        }
+
+                        Text { text: "high"; color: "black" }
+                        Slider {
+                            minimumValue: 0
+                            maximumValue: GUIState.contrastMax
+                            stepSize: 1
+                            value: GUIState.contrastHigh
+                            onValueChanged: if (value > GUIState.contrastLow) GUIState.contrastHigh = value
+                        }
+
+                        Text { text: "gamma"; color: "black" }
+                        Slider {
+                            minimumValue: 0.1
+                            maximumValue: 3.0
+                            stepSize: 0.05
+                            value: GUIState.contrastGamma
+                            onValueChanged: GUIState.contrastGamma = value
+                        }
+
+                        Text { text: "colormap"; color: "black" }
+                        ComboBox {
+                            model: [ "gray", "red", "green", "blue", "fire" ]
+                            currentIndex: GUIState.contrastColormap
+                            onActivated: GUIState.contrastColormap = index
+                        }
+
+                        Button {
+                            text: "auto"
+                            onClicked: GUIController.autoContrast()
+                        }
+                        Button {
+                            text: "reset"
+                            onClicked: GUIController.resetContrast()
+                        }
+                    }
+                }
+
+                /* ================= Panel linkingPanel ================= */
+                TCCollapsiblePanel {
+                    id: linkingPanel
+                    anchors { top: contrastPanel.bottom; left: parent.left; right: parent.right }
+                    titleText : "linking assistant"
+                    state : "collapsed"
+                    model : 1
+                    delegate : linkingDelegate
+                }
+
+                Component {
+                    id: linkingDelegate
+
+                    GridLayout {
+                        columns: 2
+
+                        Button {
+                            text: "propose links"
+                            onClicked: {
+                                GUIController.proposeLinks()
+                                mouseArea.forceActiveFocus()
+                            }
+                        }
+                        Text {
+                            text: GUIState.drawLinkProposals ?
+                                      "%1 of %2".arg(GUIState.currentLinkProposal + 1).arg(GUIState.linkProposals) : ""
+                            color: "black"
+                        }
+
+                        Button {
+                            text: "accept (l)"
+                            enabled: GUIState.drawLinkProposals
+                            onClicked: GUIController.acceptLinkProposal()
+                        }
+                        Button {
+                            text: "reject (k)"
+                            enabled: GUIState.drawLinkProposals
+                            onClicked: GUIController.rejectLinkProposal()
+                        }
+
+                        Button {
+                            text: "previous"
+                            enabled: GUIState.drawLinkProposals && GUIState.currentLinkProposal > 0
+                            onClicked: GUIController.showLinkProposal(GUIState.currentLinkProposal - 1)
+                        }
+                        Button {
+                            text: "next"
+                            enabled: GUIState.drawLinkProposals && GUIState.currentLinkProposal + 1 < GUIState.linkProposals
+                            onClicked: GUIController.showLinkProposal(GUIState.currentLinkProposal + 1)
+                        }
+
+                        Button {
+                            text: "accept all"
+                            enabled: GUIState.drawLinkProposals
+                            onClicked: GUIController.applyLinkProposals()
+                        }
+                        Button {
+                            text: "discard"
+                            enabled: GUIState.drawLinkProposals
+                            onClicked: GUIController.discardLinkProposals()
+                        }
+                    }
+                }
+
                 /* ================= Panel slicesPanel ================= */
 /*                TCCollapsiblePanel {
                     id: slicesPanel
@@ -34,9 +34,21 @@ AutoTracklet::AutoTracklet(int id) :
     trackID(IdProvider::claimAutoTrackletId(id)?id:IdProvider::getNewAutoTrackletId()) { }
 
 AutoTracklet::~AutoTracklet() {
-    IdProvider::returnAutoTrackletId(this->trackID);
+    if (!snapshot)
+        IdProvider::returnAutoTrackletId(this->trackID);
 }
 
+/*!
+ * \brief constructs a copy of an AutoTracklet for a ProjectSnapshot
+ * \param other the AutoTracklet to copy
+ *
+ * The copy shares the id with other without claiming it from the IdProvider.
+ */
+AutoTracklet::AutoTracklet(AutoTracklet const &other) :
+    snapshot(true),
+    trackID(other.trackID),
+    components(other.components) {}
+
 /*!
  * \brief constructs a QPair out of the given std::shared_ptr%s and calls addComponent(QPair) with it
  *
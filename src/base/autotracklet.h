@@ -28,7 +28,7 @@
 #include "base/object.h"
 #include "tracked/trackevent.h"
 
-namespace TraCurate { class AutoTracklet; }
+namespace TraCurate { class AutoTracklet; class ProjectSnapshot; }
 std::ostream& operator<< (std::ostream&, TraCurate::AutoTracklet&);
 std::ostream& operator<< (std::ostream&, QPair<std::shared_ptr<TraCurate::Frame>, std::shared_ptr<TraCurate::Object>>&);
 
@@ -68,6 +68,10 @@ public:
     void setPrev(const std::shared_ptr<TrackEvent<AutoTracklet> > &value);
 
 private:
+    friend class ProjectSnapshot;
+    AutoTracklet(AutoTracklet const &other);
+    bool snapshot = false;                          /*!< copies made by ProjectSnapshot don't own their id */
+
     int trackID;                                    /*!< the ID of this AutoTracklet */
     QMap<int,std::shared_ptr<Object>> components;   /*!< the components (i.e. pairs of frameId + Object%s) contained in this Tracklet */
     std::shared_ptr<TrackEvent<AutoTracklet>> next; /*!< the TrackEvent, that follows this AutoTracklet */
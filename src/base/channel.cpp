@@ -76,6 +76,24 @@ std::shared_ptr<QImage> Channel::getImage() const
 void Channel::addObject(const std::shared_ptr<Object> &o)
 {
     objects.insert(o->getId(),o);
+    if (o->getOutline())
+        features.update(o->getId(), *o->getOutline());
+    else
+        features.remove(o->getId());
+}
+
+/*!
+ * \brief adds an Object to this Channel whose features are already known
+ * \param o the Object
+ * \param f the Features of its outline, e.g. from the FeatureTable of another Channel
+ */
+void Channel::addObject(const std::shared_ptr<Object> &o, FeatureTable::Features const &f)
+{
+    objects.insert(o->getId(),o);
+    if (o->getOutline())
+        features.set(o->getId(), f);
+    else
+        features.remove(o->getId());
 }
 
 /*!
@@ -85,6 +103,7 @@ void Channel::addObject(const std::shared_ptr<Object> &o)
  */
 int Channel::removeObject(uint32_t id)
 {
+    features.remove(id);
     return objects.remove(id);
 }
 
@@ -107,6 +126,29 @@ QHash<uint32_t,std::shared_ptr<Object>> Channel::getObjects()
     return objects;
 }
 
+/*!
+ * \brief returns the geometric features of the Object%s in this Channel
+ * \return the FeatureTable
+ */
+FeatureTable const &Channel::getFeatures() const
+{
+    return features;
+}
+
+/*!
+ * \brief recomputes the features of an Object after its outline changed
+ * \param o the Object (ignored, if it was not added to this Channel)
+ */
+void Channel::updateFeatures(Object const &o)
+{
+    if (objects.value(o.getId()).get() != &o)
+        return;
+    if (o.getOutline())
+        features.update(o.getId(), *o.getOutline());
+    else
+        features.remove(o.getId());
+}
+
 /*!
  * \brief returns the sliceID of this Channel
  * \return the sliceID
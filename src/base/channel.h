@@ -19,6 +19,7 @@
 #define CHANNEL_H
 
 #include "object.h"
+#include "featuretable.h"
 
 #include <iostream>
 #include <string>
@@ -56,9 +57,12 @@ public:
     friend std::ostream& ::operator<<(std::ostream&, const Channel&);
 
     void addObject(const std::shared_ptr<Object> &);
+    void addObject(const std::shared_ptr<Object> &, FeatureTable::Features const &);
     int removeObject(uint32_t);
     std::shared_ptr<Object> getObject(uint32_t) const;
     QHash<uint32_t,std::shared_ptr<Object>> getObjects();
+    FeatureTable const &getFeatures() const;
+    void updateFeatures(Object const &);
 
     uint32_t getChanId() const;
     uint32_t getSliceId() const;
@@ -71,6 +75,7 @@ private:
     std::shared_ptr<QImage> image;                   /*!< the QImage that is associated with this Channel. Currently unused,
                                                         as images are loaded ad-hoc by the ImageProvider */
     QHash<uint32_t,std::shared_ptr<Object>> objects; /*!< the Object%s that can be seen in this Channel */
+    FeatureTable features;                           /*!< the geometric features of the Object%s */
 };
 
 }
@@ -0,0 +1,267 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "featuretable.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace TraCurate {
+
+/*!
+ * \brief computes the features of an outline
+ * \param outline the outline (implicitly closed)
+ * \return the Features of the outline
+ *
+ * Area, centroid and orientation are computed from the moments of the enclosed
+ * area (shoelace formula). The sums are accumulated in four independent lanes,
+ * so the compiler can vectorize the loop without reordering the additions.
+ * If the outline encloses no area, the centroid is the mean of its points.
+ */
+FeatureTable::Features FeatureTable::compute(QPolygonF const &outline)
+{
+    Features f {QPointF(), QRectF(), 0, 0, 0, 0};
+    int n = outline.size();
+    if (n == 0)
+        return f;
+
+    /* QPolygonF stores the points as consecutive (x,y) pairs */
+    const double *p = reinterpret_cast<const double *>(outline.constData());
+    static_assert(sizeof(QPointF) == 2 * sizeof(double), "QPointF is expected to hold two doubles");
+
+    constexpr int L = 4;
+    double a[L] = {}, sx[L] = {}, sy[L] = {}, sxx[L] = {}, syy[L] = {}, sxy[L] = {}, per[L] = {};
+    double mnx[L], mny[L], mxx[L], mxy[L];
+    std::fill(mnx, mnx + L, p[0]); std::fill(mxx, mxx + L, p[0]);
+    std::fill(mny, mny + L, p[1]); std::fill(mxy, mxy + L, p[1]);
+    double px[L] = {}, py[L] = {};
+
+    auto edge = [&](int l, double x0, double y0, double x1, double y1) {
+        double cr = x0 * y1 - x1 * y0;
+        a[l]   += cr;
+        sx[l]  += (x0 + x1) * cr;
+        sy[l]  += (y0 + y1) * cr;
+        sxx[l] += (x0 * x0 + x0 * x1 + x1 * x1) * cr;
+        syy[l] += (y0 * y0 + y0 * y1 + y1 * y1) * cr;
+        sxy[l] += (x0 * y1 + 2 * x0 * y0 + 2 * x1 * y1 + x1 * y0) * cr;
+        double dx = x1 - x0, dy = y1 - y0;
+        per[l] += std::sqrt(dx * dx + dy * dy);
+        mnx[l] = std::min(mnx[l], x0); mxx[l] = std::max(mxx[l], x0);
+        mny[l] = std::min(mny[l], y0); mxy[l] = std::max(mxy[l], y0);
+        px[l] += x0; py[l] += y0;
+    };
+
+    /* edges (i,i+1) in blocks of L, the rest and the closing edge (n-1,0) afterwards */
+    int i = 0;
+    for (; i + L < n; i += L)
+        for (int l = 0; l < L; l++)
+            edge(l, p[2*(i+l)], p[2*(i+l)+1], p[2*(i+l)+2], p[2*(i+l)+3]);
+    for (; i < n; i++) {
+        int j = (i + 1 == n) ? 0 : i + 1;
+        edge(0, p[2*i], p[2*i+1], p[2*j], p[2*j+1]);
+    }
+
+    for (int l = 1; l < L; l++) {
+        a[0] += a[l]; sx[0] += sx[l]; sy[0] += sy[l];
+        sxx[0] += sxx[l]; syy[0] += syy[l]; sxy[0] += sxy[l]; per[0] += per[l];
+        mnx[0] = std::min(mnx[0], mnx[l]); mxx[0] = std::max(mxx[0], mxx[l]);
+        mny[0] = std::min(mny[0], mny[l]); mxy[0] = std::max(mxy[0], mxy[l]);
+        px[0] += px[l]; py[0] += py[l];
+    }
+
+    double signedArea = a[0] / 2;
+    f.signedArea = signedArea;
+    f.area = std::abs(signedArea);
+    f.perimeter = per[0];
+    f.boundingBox = QRectF(QPointF(mnx[0], mny[0]), QPointF(mxx[0], mxy[0]));
+
+    if (f.area < 1e-9) {
+        f.centroid = QPointF(px[0] / n, py[0] / n);
+        return f;
+    }
+
+    double cx = sx[0] / (6 * signedArea);
+    double cy = sy[0] / (6 * signedArea);
+    f.centroid = QPointF(cx, cy);
+
+    /* central second moments, normalized by the area */
+    double mu20 = sxx[0] / (12 * signedArea) - cx * cx;
+    double mu02 = syy[0] / (12 * signedArea) - cy * cy;
+    double mu11 = sxy[0] / (24 * signedArea) - cx * cy;
+    f.orientation = 0.5 * std::atan2(2 * mu11, mu20 - mu02);
+    return f;
+}
+
+/*!
+ * \brief adds or replaces the row of an Object
+ * \param id the id of the Object
+ * \param outline the outline of the Object
+ */
+void FeatureTable::update(uint32_t id, QPolygonF const &outline)
+{
+    set(id, compute(outline));
+}
+
+/*!
+ * \brief adds or replaces the row of an Object with already computed Features
+ * \param id the id of the Object
+ * \param f the Features of its outline
+ */
+void FeatureTable::set(uint32_t id, Features const &f)
+{
+    int row = rows.value(id, -1);
+    if (row < 0) {
+        row = ids.size();
+        rows.insert(id, row);
+        ids.append(id);
+        for (QVector<double> *col : {&cx, &cy, &area, &signedArea, &perimeter, &orientation, &minX, &minY, &maxX, &maxY})
+            col->append(0);
+    }
+    cx[row] = f.centroid.x();
+    cy[row] = f.centroid.y();
+    area[row] = f.area;
+    signedArea[row] = f.signedArea;
+    perimeter[row] = f.perimeter;
+    orientation[row] = f.orientation;
+    minX[row] = f.boundingBox.left();
+    minY[row] = f.boundingBox.top();
+    maxX[row] = f.boundingBox.right();
+    maxY[row] = f.boundingBox.bottom();
+}
+
+/*!
+ * \brief removes the row of an Object, the last row takes its place
+ * \param id the id of the Object
+ * \return true if the Object had a row
+ */
+bool FeatureTable::remove(uint32_t id)
+{
+    int row = rows.value(id, -1);
+    if (row < 0)
+        return false;
+    rows.remove(id);
+
+    int last = ids.size() - 1;
+    if (row != last) {
+        ids[row] = ids[last];
+        rows[ids[row]] = row;
+        for (QVector<double> *col : {&cx, &cy, &area, &signedArea, &perimeter, &orientation, &minX, &minY, &maxX, &maxY})
+            (*col)[row] = (*col)[last];
+    }
+    ids.removeLast();
+    for (QVector<double> *col : {&cx, &cy, &area, &signedArea, &perimeter, &orientation, &minX, &minY, &maxX, &maxY})
+        col->removeLast();
+    return true;
+}
+
+void FeatureTable::clear()
+{
+    rows.clear();
+    ids.clear();
+    for (QVector<double> *col : {&cx, &cy, &area, &signedArea, &perimeter, &orientation, &minX, &minY, &maxX, &maxY})
+        col->clear();
+}
+
+int FeatureTable::size() const
+{
+    return ids.size();
+}
+
+bool FeatureTable::contains(uint32_t id) const
+{
+    return rows.contains(id);
+}
+
+/*!
+ * \brief returns the Features of an Object
+ * \param id the id of the Object
+ * \return the Features or all zero if the Object has no row
+ */
+FeatureTable::Features FeatureTable::get(uint32_t id) const
+{
+    int row = rows.value(id, -1);
+    if (row < 0)
+        return Features {QPointF(), QRectF(), 0, 0, 0, 0};
+    return Features {QPointF(cx[row], cy[row]),
+                QRectF(QPointF(minX[row], minY[row]), QPointF(maxX[row], maxY[row])),
+                area[row], signedArea[row], perimeter[row], orientation[row]};
+}
+
+/*!
+ * \brief returns the Object%s whose bounding box contains a point
+ * \param p the point
+ * \return the ids of the Object%s
+ */
+QVector<uint32_t> FeatureTable::candidatesAt(QPointF const &p) const
+{
+    QVector<uint32_t> ret;
+    const double x = p.x(), y = p.y();
+    const int n = ids.size();
+    const double *x0 = minX.constData(), *y0 = minY.constData(), *x1 = maxX.constData(), *y1 = maxY.constData();
+    for (int i = 0; i < n; i++)
+        if (x0[i] <= x && x <= x1[i] && y0[i] <= y && y <= y1[i])
+            ret.append(ids[i]);
+    return ret;
+}
+
+/*!
+ * \brief returns the Object%s whose bounding box intersects a rectangle
+ * \param r the rectangle
+ * \return the ids of the Object%s
+ */
+QVector<uint32_t> FeatureTable::candidatesIn(QRectF const &r) const
+{
+    QVector<uint32_t> ret;
+    const double rx0 = r.left(), ry0 = r.top(), rx1 = r.right(), ry1 = r.bottom();
+    const int n = ids.size();
+    const double *x0 = minX.constData(), *y0 = minY.constData(), *x1 = maxX.constData(), *y1 = maxY.constData();
+    for (int i = 0; i < n; i++)
+        if (x0[i] <= rx1 && rx0 <= x1[i] && y0[i] <= ry1 && ry0 <= y1[i])
+            ret.append(ids[i]);
+    return ret;
+}
+
+QVector<uint32_t> const &FeatureTable::getIds() const
+{
+    return ids;
+}
+
+QVector<double> const &FeatureTable::getCentroidsX() const
+{
+    return cx;
+}
+
+QVector<double> const &FeatureTable::getCentroidsY() const
+{
+    return cy;
+}
+
+QVector<double> const &FeatureTable::getAreas() const
+{
+    return area;
+}
+
+QVector<double> const &FeatureTable::getPerimeters() const
+{
+    return perimeter;
+}
+
+QVector<double> const &FeatureTable::getOrientations() const
+{
+    return orientation;
+}
+}
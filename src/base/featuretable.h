@@ -0,0 +1,88 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef FEATURETABLE_H
+#define FEATURETABLE_H
+
+#include <cstdint>
+
+#include <QHash>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+
+namespace TraCurate {
+/*!
+ * \brief The FeatureTable class
+ *
+ * Holds the geometric features of all Object%s of a Channel, so hit-testing,
+ * drawing and the tools do not need to derive them from the outlines again.
+ * The features are stored column by column (one QVector per feature), rows
+ * are looked up by the id of the Object.
+ *
+ * The Channel keeps the table up to date when Object%s are added or removed
+ * or their outlines change.
+ */
+class FeatureTable
+{
+public:
+    /*!
+     * \brief the features of a single outline
+     */
+    struct Features {
+        QPointF centroid;       /*!< the centroid of the enclosed area */
+        QRectF boundingBox;
+        double area;
+        double signedArea;      /*!< positive if the outline is counter-clockwise in a y-up coordinate system */
+        double perimeter;
+        double orientation;     /*!< angle of the major axis to the x-axis in radians, in (-pi/2,pi/2] */
+    };
+
+    static Features compute(QPolygonF const &outline);
+
+    void update(uint32_t id, QPolygonF const &outline);
+    void set(uint32_t id, Features const &f);
+    bool remove(uint32_t id);
+    void clear();
+
+    int size() const;
+    bool contains(uint32_t id) const;
+    Features get(uint32_t id) const;
+    QVector<uint32_t> candidatesAt(QPointF const &p) const;
+    QVector<uint32_t> candidatesIn(QRectF const &r) const;
+
+    QVector<uint32_t> const &getIds() const;
+    QVector<double> const &getCentroidsX() const;
+    QVector<double> const &getCentroidsY() const;
+    QVector<double> const &getAreas() const;
+    QVector<double> const &getPerimeters() const;
+    QVector<double> const &getOrientations() const;
+
+private:
+    QHash<uint32_t,int> rows;   /*!< the row of each Object id */
+    QVector<uint32_t> ids;
+    QVector<double> cx, cy;
+    QVector<double> area;
+    QVector<double> signedArea;
+    QVector<double> perimeter;
+    QVector<double> orientation;
+    QVector<double> minX, minY, maxX, maxY;
+};
+}
+
+#endif // FEATURETABLE_H
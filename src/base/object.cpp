@@ -73,12 +73,28 @@ void Object::setBoundingBox(std::shared_ptr<QRect> bbox)
 }
 
 /*!
- * \brief sets the Outline of the Object
+ * \brief sets the Outline of the Object and updates its features in the Channel
  * \param value the Outline of the Object
  */
 void Object::setOutline(std::shared_ptr<QPolygonF> value)
 {
     this->outline = value;
+    this->outlineLOD = std::make_shared<OutlineLOD>(value);
+    if (std::shared_ptr<Channel> c = channel.lock())
+        c->updateFeatures(*this);
+}
+
+/*!
+ * \brief uses the Outline of another Object together with its simplified versions
+ * \param other the Object to share the Outline with
+ *
+ * The features in the Channel are not updated, the Object should be added
+ * with the features of the other Object.
+ */
+void Object::shareOutline(Object const &other)
+{
+    this->outline = other.outline;
+    this->outlineLOD = other.outlineLOD;
 }
 
 /*!
@@ -189,6 +205,19 @@ std::shared_ptr<QPolygonF> Object::getOutline() const
     return this->outline;
 }
 
+/*!
+ * \brief returns the Outline of the Object simplified for drawing it at a given scale
+ * \param scaleFactor the factor the Outline is scaled by when drawing
+ * \param tolerance how far (in pixels on the screen) the result may deviate from the Outline
+ * \return the simplified Outline
+ */
+std::shared_ptr<QPolygonF> Object::getOutlineForScale(double scaleFactor, double tolerance) const
+{
+    if (!this->outlineLOD)
+        return this->outline;
+    return this->outlineLOD->forScale(scaleFactor, tolerance);
+}
+
 /*!
  * \brief returns the Centroid of the Object
  * \return the Centroid of the Object
@@ -29,6 +29,7 @@
 #include <QRect>
 
 #include "channel.h"
+#include "outlinelod.h"
 
 namespace TraCurate { class Object; class Channel; }
 std::ostream& operator<< (std::ostream&, TraCurate::Object&);
@@ -61,6 +62,7 @@ public:
 
     std::shared_ptr<QRect> getBoundingBox() const;
     std::shared_ptr<QPolygonF> getOutline() const;
+    std::shared_ptr<QPolygonF> getOutlineForScale(double scaleFactor, double tolerance) const;
     std::shared_ptr<QPoint> getCentroid() const;
 
     void setId(uint32_t value);
@@ -70,6 +72,7 @@ public:
     void setCentroid(std::shared_ptr<QPoint>);
     void setBoundingBox(std::shared_ptr<QRect>);
     void setOutline(std::shared_ptr<QPolygonF>);
+    void shareOutline(Object const &other);
 
     friend std::ostream& ::operator<< (std::ostream&, Object&);
 
@@ -81,6 +84,7 @@ private:
     std::shared_ptr<QPoint> centroid;   /*!< The center of this Object */
     std::shared_ptr<QRect> boundingBox; /*!< The boundingBox of this Object */
     std::shared_ptr<QPolygonF> outline; /*!< The outline of this Object */
+    std::shared_ptr<OutlineLOD> outlineLOD; /*!< Simplified versions of the outline for drawing */
 
 };
 
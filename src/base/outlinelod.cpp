@@ -0,0 +1,126 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "outlinelod.h"
+
+#include <cmath>
+
+#include <QPair>
+#include <QVector>
+
+namespace TraCurate {
+
+/*!
+ * \brief constructor for OutlineLOD
+ * \param outline the original outline
+ */
+OutlineLOD::OutlineLOD(std::shared_ptr<QPolygonF> const &outline) :
+    outline(outline) {}
+
+/*!
+ * \brief returns the outline to draw at a given scale
+ * \param scaleFactor the factor the outline is scaled by when drawing
+ * \param tolerance how far (in pixels on the screen) the drawn outline may deviate from the original
+ * \return the coarsest level that deviates at most tolerance pixels, or the
+ * original outline if the finest level is already too coarse
+ */
+std::shared_ptr<QPolygonF> OutlineLOD::forScale(double scaleFactor, double tolerance)
+{
+    if (!outline || scaleFactor <= 0)
+        return outline;
+
+    /* the allowed deviation in image pixels */
+    double allowed = tolerance / scaleFactor;
+    int level = -1;
+    for (double t = MIN_TOLERANCE; level + 1 < LEVELS && t <= allowed; t *= 2)
+        level++;
+    if (level < 0)
+        return outline;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!levels[level])
+        levels[level] = std::make_shared<QPolygonF>(simplify(*outline, MIN_TOLERANCE * (1 << level)));
+    return levels[level];
+}
+
+static double distanceToSegment(QPointF const &p, QPointF const &a, QPointF const &b)
+{
+    QPointF ab = b - a, ap = p - a;
+    double len2 = QPointF::dotProduct(ab, ab);
+    double t = (len2 > 0) ? qBound(0.0, QPointF::dotProduct(ap, ab) / len2, 1.0) : 0.0;
+    QPointF d = ap - t * ab;
+    return std::sqrt(QPointF::dotProduct(d, d));
+}
+
+/*!
+ * \brief simplifies a closed outline using the Douglas-Peucker algorithm
+ * \param outline the outline (implicitly closed)
+ * \param tolerance the maximal distance of a removed point to the simplified outline
+ * \return the simplified outline, or the original one if less than three points would be left
+ *
+ * The outline is split at its first point and the point farthest from it, both
+ * halves are simplified separately.
+ */
+QPolygonF OutlineLOD::simplify(QPolygonF const &outline, double tolerance)
+{
+    int n = outline.size();
+    if (n <= 4)
+        return outline;
+
+    int far = 0;
+    double farDist = -1;
+    for (int i = 1; i < n; i++) {
+        QPointF d = outline[i] - outline[0];
+        double dist = QPointF::dotProduct(d, d);
+        if (dist > farDist) {
+            farDist = dist;
+            far = i;
+        }
+    }
+
+    QVector<bool> keep(n, false);
+    keep[0] = keep[far] = true;
+
+    /* ranges of indices, n stands for the first point again */
+    QVector<QPair<int,int>> stack {{0, far}, {far, n}};
+    while (!stack.isEmpty()) {
+        QPair<int,int> r = stack.takeLast();
+        QPointF const &a = outline[r.first];
+        QPointF const &b = outline[r.second % n];
+        int maxIdx = -1;
+        double maxDist = tolerance;
+        for (int i = r.first + 1; i < r.second; i++) {
+            double dist = distanceToSegment(outline[i], a, b);
+            if (dist > maxDist) {
+                maxDist = dist;
+                maxIdx = i;
+            }
+        }
+        if (maxIdx >= 0) {
+            keep[maxIdx] = true;
+            stack.append({r.first, maxIdx});
+            stack.append({maxIdx, r.second});
+        }
+    }
+
+    QPolygonF ret;
+    for (int i = 0; i < n; i++)
+        if (keep[i])
+            ret.append(outline[i]);
+    return (ret.size() < 3) ? outline : ret;
+}
+}
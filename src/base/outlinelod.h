@@ -0,0 +1,58 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OUTLINELOD_H
+#define OUTLINELOD_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+#include <QPolygonF>
+
+namespace TraCurate {
+/*!
+ * \brief The OutlineLOD class
+ *
+ * Holds simplified versions of the outline of an Object for drawing it at low
+ * zoom levels. The outline is simplified with the Douglas-Peucker algorithm at
+ * tolerances of 0.25, 0.5, ... 8 image pixels. Each level is only computed when
+ * it is requested for the first time.
+ *
+ * forScale() may be called from the thread that renders the images while the
+ * Object is accessed from the GUI thread, so the levels are protected by a mutex.
+ */
+class OutlineLOD
+{
+public:
+    explicit OutlineLOD(std::shared_ptr<QPolygonF> const &outline);
+
+    std::shared_ptr<QPolygonF> forScale(double scaleFactor, double tolerance);
+
+    static QPolygonF simplify(QPolygonF const &outline, double tolerance);
+
+private:
+    static constexpr int LEVELS = 6;
+    static constexpr double MIN_TOLERANCE = 0.25;
+
+    std::mutex mtx;
+    std::shared_ptr<QPolygonF> outline;
+    std::array<std::shared_ptr<QPolygonF>, LEVELS> levels;
+};
+}
+
+#endif // OUTLINELOD_H
@@ -0,0 +1,138 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "rawimage.h"
+
+#include <cstring>
+
+#include "graphics/displaylut.h"
+
+namespace TraCurate {
+
+RawImage::RawImage() :
+    w(0), h(0), spp(1), depth(8) {}
+
+/*!
+ * \brief creates an uninitialized RawImage
+ * \param width the width in pixels
+ * \param height the height in pixels
+ * \param samples the samples per pixel, 1 or 3
+ * \param bitDepth the bits per sample, 8 or 16
+ */
+RawImage::RawImage(int width, int height, int samples, int bitDepth) :
+    w(width),
+    h(height),
+    spp(samples),
+    depth(bitDepth),
+    data(width * height * samples * (bitDepth / 8), Qt::Uninitialized) {}
+
+/*!
+ * \brief converts a QImage to an 8 bit RawImage, e.g. for Project%s imported from XML
+ * \param image the image
+ * \return the RawImage including its histogram
+ */
+RawImage RawImage::fromImage(QImage const &image)
+{
+    if (image.isNull())
+        return RawImage();
+
+    QImage img = image.convertToFormat(image.isGrayscale() ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+    RawImage ret(img.width(), img.height(), img.isGrayscale() ? 1 : 3, 8);
+    int stride = ret.w * ret.spp;
+    for (int y = 0; y < ret.h; y++)
+        memcpy(ret.bits() + y * stride, img.constScanLine(y), static_cast<size_t>(stride));
+    ret.computeHistogram();
+    return ret;
+}
+
+bool RawImage::isNull() const { return data.isEmpty(); }
+int RawImage::width() const { return w; }
+int RawImage::height() const { return h; }
+int RawImage::samples() const { return spp; }
+int RawImage::bitDepth() const { return depth; }
+int RawImage::maxValue() const { return (1 << depth) - 1; }
+int RawImage::byteCount() const { return data.size(); }
+
+uchar *RawImage::bits() { return reinterpret_cast<uchar*>(data.data()); }
+uchar const *RawImage::constBits() const { return reinterpret_cast<uchar const*>(data.constData()); }
+
+template <typename T>
+static void countSamples(T const *in, int n, quint32 *bins)
+{
+    for (int i = 0; i < n; i++)
+        bins[in[i]]++;
+}
+
+/*!
+ * \brief counts the samples of the image, called by the importers after reading it
+ */
+void RawImage::computeHistogram()
+{
+    hist.fill(0, maxValue() + 1);
+    int n = w * h * spp;
+    if (depth == 16)
+        countSamples(reinterpret_cast<uint16_t const*>(constBits()), n, hist.data());
+    else
+        countSamples(constBits(), n, hist.data());
+}
+
+QVector<quint32> const &RawImage::histogram() const { return hist; }
+
+/*!
+ * \brief converts the RawImage to a QImage with 8 bits per sample
+ * \return a QImage in Format_Grayscale8 or Format_RGB888
+ *
+ * 8 bit images are copied as they are, 16 bit images are scaled to the
+ * window chosen by DisplayLUT::autoWindow().
+ */
+QImage RawImage::toImage() const
+{
+    if (isNull())
+        return QImage();
+
+    QImage::Format format = (spp == 3) ? QImage::Format_RGB888 : QImage::Format_Grayscale8;
+    if (depth == 8) {
+        QImage ret(w, h, format);
+        int stride = w * spp;
+        for (int y = 0; y < h; y++)
+            memcpy(ret.scanLine(y), constBits() + y * stride, static_cast<size_t>(stride));
+        return ret;
+    }
+    return DisplayLUT(DisplayLUT::autoWindow(hist), depth).apply(*this).convertToFormat(format);
+}
+
+/*!
+ * \brief keeps every step-th pixel in both directions, e.g. for thumbnails
+ * \param step the distance between the kept pixels
+ * \return the smaller RawImage including its histogram
+ */
+RawImage RawImage::decimated(int step) const
+{
+    if (isNull() || step <= 1)
+        return *this;
+
+    RawImage ret((w + step - 1) / step, (h + step - 1) / step, spp, depth);
+    int pixel = spp * (depth / 8);
+    uchar const *in = constBits();
+    uchar *out = ret.bits();
+    for (int y = 0; y < h; y += step)
+        for (int x = 0; x < w; x += step, out += pixel)
+            memcpy(out, in + (y * w + x) * pixel, static_cast<size_t>(pixel));
+    ret.computeHistogram();
+    return ret;
+}
+}
@@ -0,0 +1,73 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef RAWIMAGE_H
+#define RAWIMAGE_H
+
+#include <cstdint>
+
+#include <QByteArray>
+#include <QImage>
+#include <QVector>
+
+namespace TraCurate {
+/*!
+ * \brief The RawImage class
+ *
+ * Holds the samples of an image as they are stored in the Project, with 8 or
+ * 16 bits per sample and one (grayscale) or three (RGB) samples per pixel.
+ * Rows are packed without padding. The histogram of the samples is computed
+ * once when the image is read, it is used to choose the contrast of the
+ * displayed image (see DisplayLUT).
+ *
+ * Like QImage, a RawImage is implicitly shared and cheap to copy.
+ */
+class RawImage
+{
+public:
+    RawImage();
+    RawImage(int width, int height, int samples, int bitDepth);
+    static RawImage fromImage(QImage const &image);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    int samples() const;
+    int bitDepth() const;
+    int maxValue() const;
+    int byteCount() const;
+
+    uchar *bits();
+    uchar const *constBits() const;
+
+    void computeHistogram();
+    QVector<quint32> const &histogram() const;
+
+    QImage toImage() const;
+    RawImage decimated(int step) const;
+
+private:
+    int w;
+    int h;
+    int spp;                    /*!< samples per pixel */
+    int depth;                  /*!< bits per sample */
+    QByteArray data;
+    QVector<quint32> hist;      /*!< one bin per value, all samples of a pixel are counted */
+};
+}
+
+#endif // RAWIMAGE_H
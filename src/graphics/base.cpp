@@ -19,8 +19,11 @@
 
 #include <QDebug>
 
+#include "graphics/separate.h"
+#include "graphics/watershed.h"
 #include "provider/dataprovider.h"
 #include "provider/guistate.h"
+#include "provider/imagecache.h"
 
 namespace TraCurate {
 
@@ -84,4 +87,84 @@ std::shared_ptr<TraCurate::Object> Base::objectCutByLine(QLineF &line) {
 
     return cutObjects.first();
 }
+
+/*!
+ * \brief converts a list of points (e.g. from QML) to a polyline
+ * \param points the points
+ * \return the polyline
+ */
+QPolygonF Base::toPolyline(QVariantList const &points) {
+    QPolygonF ret;
+    for (QVariant const &v : points)
+        ret.append(v.toPointF());
+    return ret;
+}
+
+/*!
+ * \brief cuts all Object%s of the current Frame/Slice/Channel along a polyline
+ * \param polyline the polyline in screen coordinates
+ * \return the Object%s that were cut, each with the pieces it was cut into
+ */
+QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> Base::objectsCutByPolyline(QPolygonF const &polyline) {
+    QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> ret;
+    GUIState *gs = GUIState::getInstance();
+    std::shared_ptr<Project> proj = gs->getProj();
+    if (!proj || polyline.size() < 2)
+        return ret;
+
+    std::shared_ptr<Frame> f = proj->getMovie()->getFrame(gs->getCurrentFrame());
+    std::shared_ptr<Slice> s = f ? f->getSlice(gs->getCurrentSlice()) : nullptr;
+    std::shared_ptr<Channel> c = s ? s->getChannel(gs->getCurrentChannel()) : nullptr;
+    if (!c)
+        return ret;
+
+    double sf = DataProvider::getInstance()->getScaleFactor();
+    QPolygonF path;
+    for (QPointF const &p : polyline)
+        path.append(p / sf);
+
+    /* only Objects whose bounding box meets the one of the polyline can be cut */
+    for (uint32_t id : c->getFeatures().candidatesIn(path.boundingRect())) {
+        std::shared_ptr<Object> o = c->getObject(id);
+        if (!o)
+            continue;
+        QList<QPolygonF> pieces = Separate::compute(*o->getOutline(), path);
+        if (pieces.size() >= 2)
+            ret.append(qMakePair(o, pieces));
+    }
+    return ret;
+}
+
+/*!
+ * \brief splits the Object at the first of some seeds by a Watershed on the stored image of the current Channel
+ * \param seeds the seeds in screen coordinates, seeds outside of the Object are ignored
+ * \return the Object (or nullptr if the first seed is not in an Object) and its pieces
+ */
+QPair<std::shared_ptr<Object>,QList<QPolygonF>> Base::objectSplitBySeeds(QPolygonF const &seeds) {
+    QPair<std::shared_ptr<Object>,QList<QPolygonF>> ret;
+    if (seeds.size() < 2)
+        return ret;
+    std::shared_ptr<Object> o = DataProvider::getInstance()->cellAt(seeds[0].x(), seeds[0].y());
+    if (!o)
+        return ret;
+
+    double sf = DataProvider::getInstance()->getScaleFactor();
+    QList<QPointF> inside;
+    for (QPointF const &p : seeds)
+        if (o->getOutline()->containsPoint(p / sf, Qt::OddEvenFill))
+            inside.append(p / sf);
+
+    /* called while drawing, so a failed read only leaves the Object unsplit */
+    GUIState *gs = GUIState::getInstance();
+    RawImage raw;
+    try {
+        raw = ImageCache::getInstance()->raw(gs->getProjPath(), gs->getCurrentFrame(), gs->getCurrentSlice(), gs->getCurrentChannel());
+    } catch (...) {
+        qDebug() << "could not read the image of the current frame";
+        return ret;
+    }
+    ret.first = o;
+    ret.second = Watershed::compute(raw, *o->getOutline(), inside);
+    return ret;
+}
 }
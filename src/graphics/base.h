@@ -20,6 +20,11 @@
 
 #include <memory>
 
+#include <QList>
+#include <QPair>
+#include <QPolygonF>
+#include <QVariantList>
+
 #include "base/object.h"
 
 namespace TraCurate {
@@ -35,6 +40,9 @@ public:
     static bool pointInObject(QPointF &&p);
 
     static std::shared_ptr<Object> objectCutByLine(QLineF &line);
+    static QPolygonF toPolyline(QVariantList const &points);
+    static QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> objectsCutByPolyline(QPolygonF const &polyline);
+    static QPair<std::shared_ptr<Object>,QList<QPolygonF>> objectSplitBySeeds(QPolygonF const &seeds);
 };
 }
 
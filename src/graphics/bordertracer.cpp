@@ -0,0 +1,161 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "bordertracer.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <QHash>
+
+namespace TraCurate {
+
+int BorderTracer::direction(int dx, int dy)
+{
+    static const int dirs[9] = {5, 4, 3, 6, -1, 2, 7, 0, 1};
+    return dirs[(dx + 1) * 3 + (dy + 1)];
+}
+
+template <typename T>
+static QList<BorderTracer::Region> findRegions(T const *px, int w, int h)
+{
+    struct Stats { int start; int minX, minY, maxX, maxY; qint64 area; double sumX, sumY; };
+    QHash<uint32_t, Stats> stats;
+    QList<uint32_t> order;
+
+    /* the runs of a label that touch in consecutive rows are joined into parts */
+    struct Run { int x0, x1, id; T lbl; };
+    std::vector<Run> prev, cur;
+    std::vector<int> parent;
+    std::vector<uint32_t> runLabels;
+    auto root = [&parent](int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    /* one pass over the runs of equal labels, the first run of a label contains its first pixel */
+    for (int y = 0; y < h; y++) {
+        T const *row = px + y * w;
+        size_t j = 0;
+        for (int x = 0; x < w; ) {
+            T lbl = row[x];
+            int end = x + 1;
+            while (end < w && row[end] == lbl)
+                end++;
+            if (lbl != 0) {
+                int id = static_cast<int>(parent.size());
+                parent.push_back(id);
+                runLabels.push_back(lbl);
+                cur.push_back(Run {x, end - 1, id, lbl});
+                /* runs touching diagonally are 8-connected as well */
+                while (j < prev.size() && prev[j].x1 < x - 1)
+                    j++;
+                for (size_t k = j; k < prev.size() && prev[k].x0 <= end; k++) {
+                    if (prev[k].lbl != lbl)
+                        continue;
+                    int a = root(prev[k].id), b = root(id);
+                    if (a != b)
+                        parent[static_cast<size_t>(std::max(a, b))] = std::min(a, b);
+                }
+
+                auto it = stats.find(lbl);
+                if (it == stats.end()) {
+                    it = stats.insert(lbl, Stats {y * w + x, x, y, end - 1, y, 0, 0, 0});
+                    order.append(lbl);
+                }
+                Stats &s = it.value();
+                qint64 n = end - x;
+                s.minX = std::min(s.minX, x);
+                s.maxX = std::max(s.maxX, end - 1);
+                s.maxY = y;
+                s.area += n;
+                s.sumX += (x + end - 1) * 0.5 * n;
+                s.sumY += static_cast<double>(y) * n;
+            }
+            x = end;
+        }
+        prev.swap(cur);
+        cur.clear();
+    }
+
+    QHash<uint32_t, int> parts;
+    for (size_t i = 0; i < parent.size(); i++)
+        if (parent[i] == static_cast<int>(i))
+            parts[runLabels[i]]++;
+
+    QList<BorderTracer::Region> ret;
+    ret.reserve(order.size());
+    for (uint32_t lbl : order) {
+        Stats const &s = stats[lbl];
+        ret.append(BorderTracer::Region {lbl,
+                                         BorderTracer::trace(px, w, h, s.start),
+                                         QRect(QPoint(s.minX, s.minY), QPoint(s.maxX, s.maxY)),
+                                         QPointF(s.sumX / s.area, s.sumY / s.area),
+                                         s.area,
+                                         parts.value(lbl)});
+    }
+    return ret;
+}
+
+/*!
+ * \brief finds the regions of a label image
+ * \param labels an image with one sample per pixel, 0 is the background
+ * \return the regions in the order of their first pixel
+ */
+QList<BorderTracer::Region> BorderTracer::regions(RawImage const &labels)
+{
+    if (labels.isNull() || labels.samples() != 1)
+        return QList<Region>();
+    if (labels.bitDepth() == 16)
+        return findRegions(reinterpret_cast<uint16_t const*>(labels.constBits()), labels.width(), labels.height());
+    return findRegions(labels.constBits(), labels.width(), labels.height());
+}
+
+/*!
+ * \brief traces the outline of a set of pixels, e.g. the mask of a flood fill
+ * \param points the pixels, they should be 8-connected
+ * \return the closed outline starting at the first pixel in raster order, a single point for a single pixel
+ */
+QPolygonF BorderTracer::traceMask(QList<QPoint> const &points)
+{
+    if (points.isEmpty())
+        return QPolygonF();
+
+    int minX = std::numeric_limits<int>::max(), minY = minX;
+    int maxX = std::numeric_limits<int>::min(), maxY = maxX;
+    for (QPoint const &p : points) {
+        minX = std::min(minX, p.x());
+        minY = std::min(minY, p.y());
+        maxX = std::max(maxX, p.x());
+        maxY = std::max(maxY, p.y());
+    }
+    const int w = maxX - minX + 1, h = maxY - minY + 1;
+    std::vector<uint8_t> mask(static_cast<size_t>(w) * static_cast<size_t>(h), 0);
+    for (QPoint const &p : points)
+        mask[static_cast<size_t>((p.y() - minY) * w + (p.x() - minX))] = 1;
+
+    int start = static_cast<int>(std::find(mask.begin(), mask.end(), 1) - mask.begin());
+    QPolygonF ret = trace(mask.data(), w, h, start, QPoint(minX, minY));
+    if (ret.size() > 1)
+        ret.append(ret.first());
+    return ret;
+}
+}
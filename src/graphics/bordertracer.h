@@ -0,0 +1,129 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef BORDERTRACER_H
+#define BORDERTRACER_H
+
+#include <cstdint>
+
+#include <QList>
+#include <QPoint>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRect>
+
+#include "base/rawimage.h"
+
+namespace TraCurate {
+/*!
+ * \brief The BorderTracer class
+ *
+ * Traces the outlines of regions in label images through the centers of
+ * their border pixels (Moore neighborhood tracing, 8-connected). The outline
+ * of a region starts at its first pixel in raster order and ends when the
+ * first move is repeated there, so regions that touch themselves at a single
+ * pixel are traced completely.
+ *
+ * regions() finds all regions of a label image: a single raster pass over the
+ * runs of equal labels collects the bounding box, area, centroid and first
+ * pixel of every label and joins its runs into 8-connected parts, then only
+ * the borders are followed. A label that forms several unconnected parts is
+ * traced along the part with its first pixel, holes are not traced.
+ *
+ * Watershed, FloodFill and ImportLabels use it to turn labeled pixels into
+ * outlines.
+ */
+class BorderTracer
+{
+public:
+    BorderTracer() = delete;
+
+    /*! \brief a region of a label image */
+    struct Region {
+        uint32_t label;
+        QPolygonF outline;      /*!< not closed, a single point for regions of one pixel */
+        QRect boundingBox;
+        QPointF centroid;       /*!< the mean of the pixel centers */
+        qint64 area;            /*!< in pixels */
+        int parts;              /*!< the number of 8-connected parts of the label */
+    };
+
+    static QList<Region> regions(RawImage const &labels);
+    static QPolygonF traceMask(QList<QPoint> const &points);
+
+    /*!
+     * \brief traces the outline of a region through the centers of its border pixels
+     * \param labels the labels of the pixels, row by row
+     * \param width the width of the buffer
+     * \param height the height of the buffer
+     * \param start the index of the first pixel of the region in raster order
+     * \param offset the position of the buffer in the image
+     * \return the outline, not closed
+     */
+    template <typename T>
+    static QPolygonF trace(T const *labels, int width, int height, int start, QPoint const &offset = QPoint())
+    {
+        /* the 8 neighbors of a pixel in clockwise order (y pointing down), starting east */
+        static const int DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+        static const int DY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+        const T lbl = labels[start];
+        auto in = [&](int x, int y) {
+            return x >= 0 && x < width && y >= 0 && y < height && labels[y * width + x] == lbl;
+        };
+
+        QPolygonF ret;
+        const int sx = start % width, sy = start / width;
+        int x = sx, y = sy;
+        int back = 4; /* the pixel west of the start is not part of the region */
+        int first = -1;
+        const int maxSteps = 4 * width * height + 8;
+        for (int step = 0; step < maxSteps; step++) {
+            int d = 0;
+            bool found = false;
+            for (int k = 1; k <= 8; k++) {
+                d = (back + k) % 8;
+                if (in(x + DX[d], y + DY[d])) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) { /* a single pixel */
+                ret.append(QPointF(x + offset.x(), y + offset.y()));
+                break;
+            }
+            /* the outline is closed when the first move repeats */
+            if (first < 0)
+                first = d;
+            else if (x == sx && y == sy && d == first)
+                break;
+            ret.append(QPointF(x + offset.x(), y + offset.y()));
+
+            /* the last pixel looked at before the next one becomes the new backtrack */
+            int bx = x + DX[(d + 7) % 8], by = y + DY[(d + 7) % 8];
+            x += DX[d];
+            y += DY[d];
+            back = direction(bx - x, by - y);
+        }
+        return ret;
+    }
+
+private:
+    static int direction(int dx, int dy);
+};
+}
+
+#endif // BORDERTRACER_H
@@ -0,0 +1,166 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "displaylut.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief builds the tables for the given contrast settings
+ * \param params the contrast settings, identity() is used if they are not valid
+ * \param bitDepth the bits per sample of the images this DisplayLUT is applied to
+ */
+DisplayLUT::DisplayLUT(Params const &params, int bitDepth) :
+    params(params.isValid() ? params : identity(bitDepth)),
+    depth(bitDepth)
+{
+    int size = 1 << bitDepth;
+    levels.resize(static_cast<size_t>(size));
+    colors.resize(static_cast<size_t>(size));
+
+    double range = this->params.high - this->params.low;
+    double exponent = 1.0 / this->params.gamma;
+    for (int v = 0; v < size; v++) {
+        double t = std::min(std::max((v - this->params.low) / range, 0.0), 1.0);
+        int level = static_cast<int>(std::lround(std::pow(t, exponent) * 255));
+        levels[static_cast<size_t>(v)] = static_cast<uchar>(level);
+        colors[static_cast<size_t>(v)] = colorize(level, this->params.colormap);
+    }
+}
+
+/*!
+ * \brief returns the contrast settings that show the values as they are stored
+ * \param bitDepth the bits per sample
+ * \return the full range of values with a gamma of 1 in gray
+ */
+DisplayLUT::Params DisplayLUT::identity(int bitDepth)
+{
+    return {0, (1 << bitDepth) - 1, 1.0, GRAY};
+}
+
+/*!
+ * \brief chooses a window from the histogram of an image
+ * \param histogram the histogram, one bin per value
+ * \param saturated the share of samples that may be clamped, half of it on each end
+ * \return the window, with a gamma of 1 in gray
+ */
+DisplayLUT::Params DisplayLUT::autoWindow(QVector<quint32> const &histogram, double saturated)
+{
+    Params ret {0, histogram.size() - 1, 1.0, GRAY};
+    quint64 total = 0;
+    for (quint32 count : histogram)
+        total += count;
+    if (total == 0 || histogram.size() < 2)
+        return ret;
+
+    double clamped = total * saturated / 2;
+    quint64 sum = 0;
+    int low = 0;
+    while (low < histogram.size() - 1 && sum + histogram[low] <= clamped)
+        sum += histogram[low++];
+    sum = 0;
+    int high = histogram.size() - 1;
+    while (high > 0 && sum + histogram[high] <= clamped)
+        sum += histogram[high--];
+
+    if (high <= low) { /* (almost) all samples have the same value */
+        high = std::min(low + 1, histogram.size() - 1);
+        low = high - 1;
+    }
+    ret.low = low;
+    ret.high = high;
+    return ret;
+}
+
+DisplayLUT::Params DisplayLUT::getParams() const
+{
+    return params;
+}
+
+int DisplayLUT::getBitDepth() const
+{
+    return depth;
+}
+
+QRgb DisplayLUT::colorize(int level, int colormap)
+{
+    switch (colormap) {
+    case RED:   return qRgb(level, 0, 0);
+    case GREEN: return qRgb(0, level, 0);
+    case BLUE:  return qRgb(0, 0, level);
+    case FIRE:  return qRgb(std::min(3 * level, 255),
+                            std::min(std::max(3 * level - 255, 0), 255),
+                            std::min(std::max(3 * level - 510, 0), 255));
+    default:    return qRgb(level, level, level);
+    }
+}
+
+/* branch-free lookups over a packed row, so the compiler can unroll them (and use gathers where available) */
+template <typename T>
+static void applyGray(T const *in, QRgb *out, int n, QRgb const *colors)
+{
+    for (int i = 0; i < n; i++)
+        out[i] = colors[in[i]];
+}
+
+template <typename T>
+static void applyRGB(T const *in, QRgb *out, int n, uchar const *levels)
+{
+    for (int i = 0; i < n; i++, in += 3)
+        out[i] = 0xff000000u | (static_cast<QRgb>(levels[in[0]]) << 16) | (static_cast<QRgb>(levels[in[1]]) << 8) | levels[in[2]];
+}
+
+/*!
+ * \brief draws a RawImage with these contrast settings
+ * \param raw the RawImage, it needs to have the bit depth of this DisplayLUT
+ * \return the image in QImage::Format_ARGB32_Premultiplied
+ */
+QImage DisplayLUT::apply(RawImage const &raw) const
+{
+    TC_TRACE_SCOPE("DisplayLUT::apply");
+    if (raw.isNull() || raw.bitDepth() != depth)
+        return QImage();
+
+    /* all pixels are opaque, so premultiplied and straight alpha are the same */
+    QImage ret(raw.width(), raw.height(), QImage::Format_ARGB32_Premultiplied);
+    int w = raw.width();
+    int rowSamples = w * raw.samples();
+    for (int y = 0; y < raw.height(); y++) {
+        QRgb *out = reinterpret_cast<QRgb*>(ret.scanLine(y));
+        if (depth == 16) {
+            uint16_t const *in = reinterpret_cast<uint16_t const*>(raw.constBits()) + y * rowSamples;
+            if (raw.samples() == 3)
+                applyRGB(in, out, w, levels.data());
+            else
+                applyGray(in, out, w, colors.data());
+        } else {
+            uchar const *in = raw.constBits() + y * rowSamples;
+            if (raw.samples() == 3)
+                applyRGB(in, out, w, levels.data());
+            else
+                applyGray(in, out, w, colors.data());
+        }
+    }
+    return ret;
+}
+}
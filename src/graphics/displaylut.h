@@ -0,0 +1,80 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef DISPLAYLUT_H
+#define DISPLAYLUT_H
+
+#include <vector>
+
+#include <QImage>
+#include <QRgb>
+#include <QVector>
+
+#include "base/rawimage.h"
+
+namespace TraCurate {
+/*!
+ * \brief The DisplayLUT class
+ *
+ * Maps the samples of a RawImage to the colors they are displayed in. The
+ * values from low to high (the window) are stretched to the full range of the
+ * display, then the gamma is applied and the result is colored by the
+ * colormap. Values outside of the window are clamped.
+ *
+ * All of this is precomputed into a table with one entry per possible value,
+ * so drawing an image is a single lookup per sample.
+ */
+class DisplayLUT
+{
+public:
+    enum Colormap {
+        GRAY = 0,
+        RED,
+        GREEN,
+        BLUE,
+        FIRE
+    };
+
+    /*! \brief the contrast settings of a Channel */
+    struct Params {
+        int low;
+        int high;
+        double gamma;       /*!< values > 1 brighten the midtones */
+        int colormap;       /*!< a Colormap, ignored for RGB images */
+        bool isValid() const { return high > low && gamma > 0; }
+    };
+
+    DisplayLUT(Params const &params, int bitDepth);
+
+    static Params identity(int bitDepth);
+    static Params autoWindow(QVector<quint32> const &histogram, double saturated = 0.0035);
+
+    Params getParams() const;
+    int getBitDepth() const;
+    QImage apply(RawImage const &raw) const;
+
+private:
+    static QRgb colorize(int level, int colormap);
+
+    Params params;
+    int depth;
+    std::vector<uchar> levels;  /*!< the display level of every value */
+    std::vector<QRgb> colors;   /*!< the colorized display level of every value */
+};
+}
+
+#endif // DISPLAYLUT_H
@@ -24,73 +24,13 @@
 #include <QSet>
 #include <QImage>
 
+#include "graphics/bordertracer.h"
 #include "provider/tcsettings.h"
 
-/* Code adapted from Konstantin Thierbach's code */
+/* the mask is traced on a flat buffer of its bounding box instead of looking up every neighbor in a QSet */
 QPolygonF FloodFill::maskToPoly(QList<QPoint> points)
 {
-    QPolygon outline;
-    QSet<QPoint> set = points.toSet();
-    QList<QPoint> directions = {
-        QPoint{-1,0}, QPoint{-1,-1}, QPoint{0,-1}, QPoint{1,-1},
-        QPoint{1,0}, QPoint{1,1}, QPoint{0,1}, QPoint{-1,1}
-    };
-
-    std::sort(points.begin(), points.end(),
-              [](const QPoint &a, const QPoint &b){return (a.y() == b.y())?(a.x() < b.x()):(a.y() < b.y());});
-
-    if (!points.empty()) {
-        if(points.size() == 1) {
-            outline.append(points.front());
-            return outline;
-        }
-        QPoint b, c, b0, b1, tmp, c1, previousDir, currentDir;
-
-        int currDir = directions.indexOf(QPoint(-1,0));
-
-        b0 = points.at(0);
-
-        for (int i = 1; i < directions.size(); i++) {
-            previousDir = directions[currDir];
-            currDir = (currDir + 1) % directions.size();
-            currentDir = directions[currDir];
-            tmp = b0 + currentDir;
-
-            if (set.contains(tmp)) {
-                b1 = tmp;
-                c1 = b0 + previousDir;
-                outline.append(b0);
-                outline.append(b1);
-                break;
-            }
-        }
-
-        b = b1;
-        c = c1;
-
-        while (true) {
-            currDir = directions.indexOf(c - b);
-
-            for (int i = 1; i < directions.size(); i++) {
-                previousDir = directions[currDir];
-                currDir = (currDir + 1) % directions.size();
-                currentDir = directions[currDir];
-                tmp = b + currentDir;
-
-                if (set.contains(tmp)) {
-                    c = b + previousDir;
-                    b = tmp;
-                    outline.append(b);
-
-                    break;
-                }
-            }
-            if (b == b0)
-                break;
-        }
-    }
-
-    return outline;
+    return TraCurate::BorderTracer::traceMask(points);
 }
 
 
@@ -1,6 +1,6 @@
 /*
  * TraCurate – A curation tool for object tracks.
- * Copyright (C) 2016 Sebastian Wagner
+ * Copyright (C) 2016 Konstantin Thierbach, Sebastian Wagner
  *
  * TraCurate is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License as published by
@@ -18,23 +18,28 @@
 #ifndef MERGE_H
 #define MERGE_H
 
-#include <QLineF>
-#include <QPair>
+#include <QList>
 #include <QPolygonF>
 
+/*!
+ * \brief The Merge class
+ *
+ * Joins the outlines of several Object%s into one outline. Overlapping and
+ * adjacent outlines are united, gaps between outlines are closed along their
+ * convex hull (see TraCurate::PolygonUnion). Outlines are rounded to 1/8 pixel
+ * for the computation. If the result does not cover the outlines, they are
+ * united with QPolygonF::united() instead.
+ */
 class Merge
 {
 public:
     Merge() = default;
     static QPolygonF compute(QPolygonF&, QPolygonF&);
-    static QPolygonF segment(const QPolygonF &poly, const QPointF &start, const QPointF &end);
+    static QPolygonF compute(QList<QPolygonF> const &outlines);
+    static QPolygonF compute(QList<QPolygonF> const &outlines, bool &fallback);
 
 private:
-    static QPair<QPointF,QPointF> tangentPoints(QPointF&, QPolygonF&);
-    static int polygonRotation(QPolygonF& poly);
-    static QList<QPair<QPointF, qreal>> angleToAll(QPointF &c, QPolygonF &poly);
-    static QPair<QPointF, QPointF> extremaToBase(QList<QPair<QPointF, qreal>> points);
-    static QList<QLineF> segmentsOf(QPolygonF &p);
+    static constexpr double GRID = 8;
 };
 
 #endif // MERGE_H
@@ -0,0 +1,723 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "polygonunion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <utility>
+
+namespace TraCurate {
+
+using Point = PolygonUnion::Point;
+using Ring = PolygonUnion::Ring;
+
+static int64_t cross(Point const &o, Point const &a, Point const &b)
+{
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+static int64_t dot(Point const &o, Point const &a, Point const &b)
+{
+    return (a.x - o.x) * (b.x - o.x) + (a.y - o.y) * (b.y - o.y);
+}
+
+static int sign(int64_t v)
+{
+    return (v > 0) - (v < 0);
+}
+
+/* p is known to be collinear with a and b */
+static bool onSegment(Point const &p, Point const &a, Point const &b)
+{
+    return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x)
+            && std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+}
+
+/* the largest integer whose square is at most v, v >= 0 */
+static int64_t isqrt(int64_t v)
+{
+    int64_t r = static_cast<int64_t>(std::sqrt(static_cast<double>(v)));
+    while (r > 0 && r > v / r)
+        r--;
+    while (r + 1 <= v / (r + 1))
+        r++;
+    return r;
+}
+
+/* num/den rounded to the nearest integer, den > 0 */
+static int64_t roundDiv(int64_t num, int64_t den)
+{
+    return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+/*!
+ * \brief returns twice the signed area of a ring, positive if it is counter-clockwise
+ * \param ring the ring
+ * \return twice the signed area
+ */
+int64_t PolygonUnion::area2(Ring const &ring)
+{
+    int64_t sum = 0;
+    size_t n = ring.size();
+    for (size_t i = 0; i < n; i++) {
+        Point const &p = ring[i];
+        Point const &q = ring[(i + 1) % n];
+        sum += p.x * q.y - q.x * p.y;
+    }
+    return sum;
+}
+
+/*!
+ * \brief removes duplicate and collinear points and orients a ring counter-clockwise
+ * \param ring the ring
+ * \return the normalized ring or an empty ring if it does not enclose any area
+ */
+Ring PolygonUnion::normalize(Ring const &ring)
+{
+    Ring r;
+    for (Point const &p : ring) {
+        if (!r.empty() && r.back() == p)
+            continue;
+        /* drop points in the middle of straight lines and the tips of spikes */
+        while (r.size() >= 2 && cross(r[r.size() - 2], r.back(), p) == 0)
+            r.pop_back();
+        if (r.empty() || r.back() != p)
+            r.push_back(p);
+    }
+    /* the same for the points where the ring is closed */
+    bool changed = true;
+    while (changed && r.size() >= 3) {
+        changed = false;
+        if (r.front() == r.back()) {
+            r.pop_back();
+            changed = true;
+        } else if (cross(r[r.size() - 2], r.back(), r.front()) == 0) {
+            r.pop_back();
+            changed = true;
+        } else if (cross(r.back(), r[0], r[1]) == 0) {
+            r.erase(r.begin());
+            changed = true;
+        }
+    }
+    if (r.size() < 3)
+        return Ring();
+
+    int64_t a = area2(r);
+    if (a == 0)
+        return Ring();
+    if (a < 0)
+        std::reverse(r.begin(), r.end());
+    return r;
+}
+
+/*!
+ * \brief builds the index for a ring
+ * \param ring the ring
+ */
+PolygonUnion::RingIndex::RingIndex(Ring const &ring)
+{
+    for (Point const &p : ring)
+        pts.push_back({2 * p.x, 2 * p.y});
+    if (pts.empty())
+        return;
+    minX = minY = std::numeric_limits<int64_t>::max();
+    maxX = maxY = std::numeric_limits<int64_t>::min();
+    for (Point const &p : pts) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+    }
+    size_t n = pts.size();
+    size_t count = std::max<size_t>(1, n / 2);
+    height = (maxY - minY) / static_cast<int64_t>(count) + 1;
+    strips.resize(count);
+    for (size_t i = 0; i < n; i++) {
+        int64_t y0 = std::min(pts[i].y, pts[(i + 1) % n].y);
+        int64_t y1 = std::max(pts[i].y, pts[(i + 1) % n].y);
+        for (int64_t s = (y0 - minY) / height; s <= (y1 - minY) / height; s++)
+            strips[static_cast<size_t>(s)].push_back(static_cast<int>(i));
+    }
+}
+
+/*!
+ * \brief tests if a point lies inside of the ring
+ * \param p the point in doubled coordinates
+ * \return true, if the point is inside (points on the boundary give an arbitrary result)
+ */
+bool PolygonUnion::RingIndex::contains(Point const &p) const
+{
+    if (pts.empty() || p.x < minX || p.x > maxX || p.y < minY || p.y > maxY)
+        return false;
+    size_t n = pts.size();
+    bool inside = false;
+    for (int i : strips[static_cast<size_t>((p.y - minY) / height)]) {
+        Point const &u = pts[static_cast<size_t>(i)];
+        Point const &v = pts[(static_cast<size_t>(i) + 1) % n];
+        if ((u.y > p.y) == (v.y > p.y))
+            continue;
+        int64_t c = cross(u, v, p);
+        if ((v.y > u.y) ? (c > 0) : (c < 0))
+            inside = !inside;
+    }
+    return inside;
+}
+
+/*!
+ * \brief returns the edges of rings
+ * \param rings the rings
+ * \return the edges, each tagged with the index of its ring
+ */
+std::vector<PolygonUnion::Edge> PolygonUnion::ringEdges(std::vector<Ring> const &rings)
+{
+    std::vector<Edge> edges;
+    for (size_t r = 0; r < rings.size(); r++)
+        for (size_t i = 0; i < rings[r].size(); i++)
+            edges.push_back({rings[r][i], rings[r][(i + 1) % rings[r].size()], static_cast<int>(r)});
+    return edges;
+}
+
+/*!
+ * \brief splits edges at their intersections with each other
+ * \param edges the edges
+ * \return the split edges, which keep the ring of the edge they are part of and its order
+ *
+ * Candidate pairs are found by sweeping over the edges sorted by their
+ * smallest x-coordinate. The split edges are snap rounded, they only meet at
+ * their end points or coincide.
+ */
+std::vector<PolygonUnion::Edge> PolygonUnion::splitEdges(std::vector<Edge> const &edges)
+{
+    std::vector<std::vector<Point>> splits(edges.size());
+    std::vector<size_t> order(edges.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        int64_t ma = std::min(edges[a].a.x, edges[a].b.x), mb = std::min(edges[b].a.x, edges[b].b.x);
+        return ma < mb || (ma == mb && a < b);
+    });
+
+    std::vector<size_t> active;
+    for (size_t e : order) {
+        Edge const &p = edges[e];
+        int64_t minX = std::min(p.a.x, p.b.x);
+        active.erase(std::remove_if(active.begin(), active.end(), [&](size_t o) {
+            return std::max(edges[o].a.x, edges[o].b.x) < minX;
+        }), active.end());
+
+        for (size_t o : active) {
+            Edge const &q = edges[o];
+            if (std::max(p.a.y, p.b.y) < std::min(q.a.y, q.b.y) || std::max(q.a.y, q.b.y) < std::min(p.a.y, p.b.y))
+                continue;
+
+            int64_t d1 = cross(q.a, q.b, p.a), d2 = cross(q.a, q.b, p.b);
+            int64_t d3 = cross(p.a, p.b, q.a), d4 = cross(p.a, p.b, q.b);
+            if (sign(d1) * sign(d2) < 0 && sign(d3) * sign(d4) < 0) {
+                /* proper crossing, rounded to the grid */
+                int64_t den = d1 - d2;
+                int64_t num = d1;
+                if (den < 0) {
+                    den = -den;
+                    num = -num;
+                }
+                Point x {p.a.x + roundDiv((p.b.x - p.a.x) * num, den), p.a.y + roundDiv((p.b.y - p.a.y) * num, den)};
+                splits[e].push_back(x);
+                splits[o].push_back(x);
+                continue;
+            }
+            /* touching points and collinear overlaps */
+            if (d1 == 0 && onSegment(p.a, q.a, q.b)) splits[o].push_back(p.a);
+            if (d2 == 0 && onSegment(p.b, q.a, q.b)) splits[o].push_back(p.b);
+            if (d3 == 0 && onSegment(q.a, p.a, p.b)) splits[e].push_back(q.a);
+            if (d4 == 0 && onSegment(q.b, p.a, p.b)) splits[e].push_back(q.b);
+        }
+        active.push_back(e);
+    }
+
+    /* iterated snap rounding: an edge passing through the pixel around a
+     * vertex or a rounded intersection point is bent through that point. The
+     * bent parts may pass through further pixels, so this repeats until no
+     * edge is split any more. Afterwards the edges only meet at their ends. */
+    std::vector<Point> hot;
+    for (size_t e = 0; e < edges.size(); e++) {
+        hot.push_back(edges[e].a);
+        hot.insert(hot.end(), splits[e].begin(), splits[e].end());
+    }
+    std::sort(hot.begin(), hot.end());
+    hot.erase(std::unique(hot.begin(), hot.end()), hot.end());
+
+    auto snap = [&hot](Edge const &edge, std::vector<Point> &s) {
+        int64_t minX = std::min(edge.a.x, edge.b.x), maxX = std::max(edge.a.x, edge.b.x);
+        int64_t minY = std::min(edge.a.y, edge.b.y), maxY = std::max(edge.a.y, edge.b.y);
+        Point a2 {2 * edge.a.x, 2 * edge.a.y}, b2 {2 * edge.b.x, 2 * edge.b.y};
+        auto it = std::lower_bound(hot.begin(), hot.end(), Point {minX, std::numeric_limits<int64_t>::min()});
+        for (; it != hot.end() && it->x <= maxX; ++it) {
+            Point const &h = *it;
+            if (h.y < minY || h.y > maxY || h == edge.a || h == edge.b)
+                continue;
+            /* the edge misses the pixel if all its corners are on one side (doubled coordinates) */
+            bool left = false, right = false;
+            for (int dx : {-1, 1}) {
+                for (int dy : {-1, 1}) {
+                    int64_t c = cross(a2, b2, Point {2 * h.x + dx, 2 * h.y + dy});
+                    left = left || c >= 0;
+                    right = right || c <= 0;
+                }
+            }
+            if (left && right)
+                s.push_back(h);
+        }
+    };
+    auto split = [](Edge const &edge, std::vector<Point> &s, std::vector<Edge> &out) {
+        std::sort(s.begin(), s.end(), [&](Point const &u, Point const &v) {
+            return dot(edge.a, edge.b, u) < dot(edge.a, edge.b, v);
+        });
+        Point prev = edge.a;
+        for (Point const &p : s) {
+            if (p == prev || p == edge.a || p == edge.b)
+                continue;
+            out.push_back({prev, p, edge.ring});
+            prev = p;
+        }
+        if (prev != edge.b)
+            out.push_back({prev, edge.b, edge.ring});
+    };
+
+    std::vector<Edge> ret, parts, next;
+    std::vector<Point> s;
+    for (size_t e = 0; e < edges.size(); e++) {
+        snap(edges[e], splits[e]);
+        parts.clear();
+        split(edges[e], splits[e], parts);
+        for (bool changed = !splits[e].empty(); changed;) {
+            changed = false;
+            next.clear();
+            for (Edge const &part : parts) {
+                s.clear();
+                snap(part, s);
+                changed = changed || !s.empty();
+                split(part, s, next);
+            }
+            parts.swap(next);
+        }
+        ret.insert(ret.end(), parts.begin(), parts.end());
+    }
+    return ret;
+}
+
+/*!
+ * \brief links edges into rings
+ * \param edges the edges, each edge is used once
+ * \return the rings
+ *
+ * Where several edges leave a point, the one turning left the most is taken,
+ * so rings touching in a single point stay separate.
+ */
+std::vector<Ring> PolygonUnion::linkEdges(std::vector<Edge> const &edges)
+{
+    std::multimap<Point, size_t> outgoing;
+    for (size_t i = 0; i < edges.size(); i++)
+        outgoing.insert({edges[i].a, i});
+
+    std::vector<bool> used(edges.size(), false);
+    std::vector<Ring> rings;
+    for (size_t start = 0; start < edges.size(); start++) {
+        if (used[start])
+            continue;
+        used[start] = true;
+        Ring ring {edges[start].a};
+        size_t cur = start;
+        bool closed = false;
+        while (true) {
+            Point const &p = edges[cur].b;
+            if (p == ring.front()) {
+                closed = true;
+                break;
+            }
+            ring.push_back(p);
+
+            Point in {p.x - edges[cur].a.x, p.y - edges[cur].a.y};
+            size_t best = edges.size();
+            double bestAngle = 0;
+            auto range = outgoing.equal_range(p);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (used[it->second])
+                    continue;
+                Edge const &o = edges[it->second];
+                Point out {o.b.x - o.a.x, o.b.y - o.a.y};
+                double c = static_cast<double>(in.x * out.y - in.y * out.x);
+                double d = static_cast<double>(in.x * out.x + in.y * out.y);
+                double angle = std::atan2(c, d);
+                if (c == 0 && d < 0) /* going back is the last resort */
+                    angle = -4;
+                if (best == edges.size() || angle > bestAngle) {
+                    best = it->second;
+                    bestAngle = angle;
+                }
+            }
+            if (best == edges.size())
+                break;
+            used[best] = true;
+            cur = best;
+        }
+        if (closed)
+            rings.push_back(ring);
+    }
+    return rings;
+}
+
+/*!
+ * \brief computes the outer rings of the union of rings
+ * \param rings counter-clockwise rings
+ * \return the counter-clockwise outer rings of the union, largest first
+ *
+ * Holes and rings inside of holes are dropped.
+ */
+std::vector<Ring> PolygonUnion::outerBoundary(std::vector<Ring> const &rings)
+{
+    /* snap rounding may fold a ring onto itself, an edge followed by its
+     * reverse encloses no area and would hide what is on both sides of it */
+    std::vector<Edge> split = splitEdges(ringEdges(rings));
+    std::vector<Edge> edges;
+    for (size_t begin = 0, end = 0; begin < split.size(); begin = end) {
+        while (end < split.size() && split[end].ring == split[begin].ring)
+            end++;
+        std::vector<Edge> kept;
+        for (size_t i = begin; i < end; i++) {
+            if (!kept.empty() && kept.back().a == split[i].b)
+                kept.pop_back();
+            else
+                kept.push_back(split[i]);
+        }
+        /* the same where the ring is closed */
+        size_t first = 0;
+        while (kept.size() - first >= 2 && kept.back().a == kept[first].b) {
+            kept.pop_back();
+            first++;
+        }
+        edges.insert(edges.end(), kept.begin() + static_cast<std::ptrdiff_t>(first), kept.end());
+    }
+
+    /* the split edges of a ring are in order, test against the snapped rings like the edges */
+    std::vector<Ring> snapped(rings.size());
+    for (Edge const &e : edges)
+        snapped[static_cast<size_t>(e.ring)].push_back(e.a);
+    std::vector<RingIndex> index;
+    for (Ring const &r : snapped)
+        index.emplace_back(r);
+
+    /* group identical edges, regardless of their direction */
+    auto key = [&](size_t i) {
+        Point const &a = edges[i].a, &b = edges[i].b;
+        return (a < b) ? std::make_pair(a, b) : std::make_pair(b, a);
+    };
+    std::vector<size_t> order(edges.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        auto ka = key(a), kb = key(b);
+        return ka < kb || (!(kb < ka) && a < b);
+    });
+
+    std::vector<Edge> boundary;
+    std::vector<bool> onEdge(rings.size(), false);
+    std::vector<int> net(rings.size(), 0);
+    for (size_t i = 0; i < order.size();) {
+        size_t j = i;
+        while (j < order.size() && !(key(order[i]) < key(order[j]))) {
+            Edge const &e = edges[order[j]];
+            net[static_cast<size_t>(e.ring)] += (e.a < e.b) ? 1 : -1;
+            onEdge[static_cast<size_t>(e.ring)] = true;
+            j++;
+        }
+        /* a ring running along itself in both directions does not count */
+        bool forward = false, backward = false;
+        for (size_t k = i; k < j; k++) {
+            int n = net[static_cast<size_t>(edges[order[k]].ring)];
+            forward = forward || n > 0;
+            backward = backward || n < 0;
+        }
+
+        /* edges shared in opposite directions separate two parts of the union */
+        if (forward != backward) {
+            size_t k = i;
+            while ((edges[order[k]].a < edges[order[k]].b) != forward)
+                k++;
+            Edge const &e = edges[order[k]];
+            Point mid {e.a.x + e.b.x, e.a.y + e.b.y};
+            bool inside = false;
+            for (size_t r = 0; r < rings.size() && !inside; r++)
+                inside = !onEdge[r] && index[r].contains(mid);
+            if (!inside)
+                boundary.push_back(e);
+        }
+
+        for (size_t k = i; k < j; k++) {
+            onEdge[static_cast<size_t>(edges[order[k]].ring)] = false;
+            net[static_cast<size_t>(edges[order[k]].ring)] = 0;
+        }
+        i = j;
+    }
+
+    std::vector<Ring> outer;
+    for (Ring const &r : linkEdges(boundary)) {
+        if (area2(r) <= 0) /* holes */
+            continue;
+        Ring n = normalize(r);
+        if (!n.empty())
+            outer.push_back(n);
+    }
+    std::stable_sort(outer.begin(), outer.end(), [](Ring const &a, Ring const &b) {
+        return area2(a) > area2(b);
+    });
+
+    /* rings in holes of larger rings are covered once the holes are filled */
+    std::vector<Ring> ret;
+    std::vector<RingIndex> kept;
+    for (Ring const &r : outer) {
+        Point mid {r[0].x + r[1].x, r[0].y + r[1].y};
+        bool covered = false;
+        for (RingIndex const &k : kept)
+            covered = covered || k.contains(mid);
+        if (covered)
+            continue;
+        kept.emplace_back(r);
+        ret.push_back(r);
+    }
+    return ret;
+}
+
+/*!
+ * \brief joins two disjoint rings by the edges of their convex hull that bridge the gap between them
+ * \param a the first counter-clockwise ring
+ * \param b the second counter-clockwise ring
+ * \param slitted set to true if the rings were joined by a slit
+ * \return the joined ring
+ *
+ * If the rings do not appear on the hull as one run each (e.g. if b lies in a
+ * bay of a), they are joined by a slit between their closest points instead.
+ */
+Ring PolygonUnion::bridge(Ring const &a, Ring const &b, bool &slitted)
+{
+    struct HullPoint { Point p; int ring; size_t idx; };
+    std::vector<HullPoint> pts;
+    for (size_t i = 0; i < a.size(); i++)
+        pts.push_back({a[i], 0, i});
+    for (size_t i = 0; i < b.size(); i++)
+        pts.push_back({b[i], 1, i});
+    std::sort(pts.begin(), pts.end(), [](HullPoint const &u, HullPoint const &v) {
+        return u.p < v.p || (u.p == v.p && u.ring < v.ring);
+    });
+    pts.erase(std::unique(pts.begin(), pts.end(), [](HullPoint const &u, HullPoint const &v) {
+        return u.p == v.p;
+    }), pts.end());
+
+    /* Andrew's monotone chain, counter-clockwise without collinear points */
+    std::vector<HullPoint> hull(2 * pts.size());
+    size_t k = 0;
+    for (size_t i = 0; i < pts.size(); i++) {
+        while (k >= 2 && cross(hull[k - 2].p, hull[k - 1].p, pts[i].p) <= 0)
+            k--;
+        hull[k++] = pts[i];
+    }
+    for (size_t i = pts.size() - 1, t = k + 1; i > 0; i--) {
+        while (k >= t && cross(hull[k - 2].p, hull[k - 1].p, pts[i - 1].p) <= 0)
+            k--;
+        hull[k++] = pts[i - 1];
+    }
+    hull.resize(k - 1);
+
+    size_t toB = hull.size(), toA = hull.size();
+    int transitions = 0;
+    for (size_t i = 0; i < hull.size(); i++) {
+        HullPoint const &u = hull[i];
+        HullPoint const &v = hull[(i + 1) % hull.size()];
+        if (u.ring == v.ring)
+            continue;
+        transitions++;
+        (u.ring == 0 ? toB : toA) = i;
+    }
+    if (transitions != 2) {
+        slitted = true;
+        return slit(a, b);
+    }
+
+    size_t aLast = hull[toB].idx, bFirst = hull[(toB + 1) % hull.size()].idx;
+    size_t bLast = hull[toA].idx, aFirst = hull[(toA + 1) % hull.size()].idx;
+
+    Ring ret;
+    for (size_t i = aFirst; ; i = (i + 1) % a.size()) {
+        ret.push_back(a[i]);
+        if (i == aLast)
+            break;
+    }
+    for (size_t i = bFirst; ; i = (i + 1) % b.size()) {
+        ret.push_back(b[i]);
+        if (i == bLast)
+            break;
+    }
+    return ret;
+}
+
+/*!
+ * \brief joins two rings by a slit between their closest points
+ * \param a the first ring
+ * \param b the second ring
+ * \return the joined ring, which touches itself along the slit
+ */
+Ring PolygonUnion::slit(Ring const &a, Ring const &b)
+{
+    size_t ai = 0, bi = 0;
+    int64_t best = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < a.size(); i++) {
+        for (size_t j = 0; j < b.size(); j++) {
+            int64_t dx = a[i].x - b[j].x, dy = a[i].y - b[j].y;
+            if (dx * dx + dy * dy < best) {
+                best = dx * dx + dy * dy;
+                ai = i;
+                bi = j;
+            }
+        }
+    }
+    Ring ret;
+    for (size_t i = 0; i <= a.size(); i++)
+        ret.push_back(a[(ai + i) % a.size()]);
+    for (size_t j = 0; j <= b.size(); j++)
+        ret.push_back(b[(bi + j) % b.size()]);
+    return ret;
+}
+
+/*!
+ * \brief computes the outline of the union of rings
+ * \param rings the rings, in any orientation
+ * \return the counter-clockwise outline or an empty ring if the rings do not enclose any area
+ *
+ * Parts that do not overlap are joined to the largest part, nearest first.
+ */
+Ring PolygonUnion::unite(std::vector<Ring> const &rings)
+{
+    std::vector<Ring> input;
+    for (Ring const &r : rings) {
+        Ring n = normalize(r);
+        if (!n.empty())
+            input.push_back(n);
+    }
+    if (input.empty())
+        return Ring();
+
+    std::vector<Ring> parts = outerBoundary(input);
+    if (parts.empty())
+        return Ring();
+
+    auto bounds = [](Ring const &r) {
+        std::pair<Point,Point> b {r[0], r[0]};
+        for (Point const &p : r) {
+            b.first = {std::min(b.first.x, p.x), std::min(b.first.y, p.y)};
+            b.second = {std::max(b.second.x, p.x), std::max(b.second.y, p.y)};
+        }
+        return b;
+    };
+
+    Ring result = parts[0];
+    std::vector<Ring> rest(parts.begin() + 1, parts.end());
+    bool hasSlit = false;
+    while (!rest.empty()) {
+        /* the part with the smallest gap between the bounding boxes */
+        std::pair<Point,Point> rb = bounds(result);
+        size_t next = 0;
+        int64_t nextGap = std::numeric_limits<int64_t>::max();
+        for (size_t i = 0; i < rest.size(); i++) {
+            std::pair<Point,Point> b = bounds(rest[i]);
+            int64_t gx = std::max<int64_t>(0, std::max(b.first.x - rb.second.x, rb.first.x - b.second.x));
+            int64_t gy = std::max<int64_t>(0, std::max(b.first.y - rb.second.y, rb.first.y - b.second.y));
+            if (gx * gx + gy * gy < nextGap) {
+                nextGap = gx * gx + gy * gy;
+                next = i;
+            }
+        }
+        Ring part = rest[next];
+        rest.erase(rest.begin() + static_cast<std::ptrdiff_t>(next));
+
+        bool slitted = false;
+        result = bridge(result, part, slitted);
+
+        /* the joined ring may overlap the other parts. Uniting them also
+         * dissolves the slits of earlier joins, that is only accepted if it
+         * leaves fewer parts, so the loop ends */
+        if (!slitted && !rest.empty()) {
+            std::vector<Ring> all {result};
+            all.insert(all.end(), rest.begin(), rest.end());
+            std::vector<Ring> merged = outerBoundary(all);
+            if (merged.empty())
+                return Ring();
+            if (!hasSlit || merged.size() <= rest.size()) {
+                result = merged[0];
+                rest.assign(merged.begin() + 1, merged.end());
+            }
+        }
+        hasSlit = hasSlit || slitted;
+    }
+    return result;
+}
+
+/*!
+ * \brief checks if an outline covers rings, i.e. if it can be their union
+ * \param outline the outline computed by unite()
+ * \param rings the rings, in any orientation
+ * \return true, if every point of the rings lies inside of the outline or at most two units away from it
+ *
+ * Snap rounding moves edges by one or two units, e.g. narrow tips of the
+ * rings may collapse. This is a plausibility check for the result of unite(), it
+ * does not detect every error.
+ */
+bool PolygonUnion::covers(Ring const &outline, std::vector<Ring> const &rings)
+{
+    Ring o = normalize(outline);
+    if (o.empty())
+        return false;
+    RingIndex index(o);
+    size_t n = o.size();
+    int64_t const tolerance2 = 4;
+    auto near = [&o, n, tolerance2](Point const &p) {
+        for (size_t i = 0; i < n; i++) {
+            Point const &a = o[i], &b = o[(i + 1) % n];
+            int64_t len2 = dot(a, b, b), t = dot(a, b, p);
+            /* squared distance to the segment, times its squared length in the middle part */
+            if (t <= 0) {
+                if (dot(a, p, p) <= tolerance2)
+                    return true;
+            } else if (t >= len2) {
+                if (dot(b, p, p) <= tolerance2)
+                    return true;
+            } else {
+                /* c * c overflows for points far from the segment, |c| is compared to the root instead */
+                int64_t c = cross(a, b, p);
+                if (std::abs(c) <= isqrt(tolerance2 * len2))
+                    return true;
+            }
+        }
+        return false;
+    };
+    for (Ring const &r : rings)
+        for (Point const &p : r)
+            if (!index.contains(Point {2 * p.x, 2 * p.y}) && !near(p))
+                return false;
+    return true;
+}
+}
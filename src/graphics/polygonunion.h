@@ -0,0 +1,99 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef POLYGONUNION_H
+#define POLYGONUNION_H
+
+#include <cstdint>
+#include <vector>
+
+namespace TraCurate {
+/*!
+ * \brief The PolygonUnion class
+ *
+ * Computes the outline of the union of several polygons on integer
+ * coordinates. Merge uses it to join the outlines of Object%s.
+ *
+ * Edges are intersected in a sweep over the x-axis, split at all
+ * intersections and kept if they lie on the boundary of the union. Holes of
+ * the union are filled. If the polygons do not overlap, the separate parts are
+ * joined by the two edges of their convex hull that bridge the gap between
+ * them, which repeats until a single outline is left.
+ *
+ * The building blocks (normalizing rings, splitting edges at intersections,
+ * linking edges to rings and point-in-polygon tests) are public, Separate uses
+ * them to cut outlines.
+ *
+ * Intersection points are snap rounded to the integer grid: every edge that
+ * passes through the pixel around a vertex or a rounded intersection point is
+ * bent through that point, so rounding does not create new crossings. All
+ * other computations are exact. Coordinates must stay below 2^19, so that
+ * products of coordinate differences fit into 64 bits.
+ */
+class PolygonUnion
+{
+public:
+    struct Point {
+        int64_t x, y;
+        bool operator==(Point const &o) const { return x == o.x && y == o.y; }
+        bool operator!=(Point const &o) const { return !(*this == o); }
+        bool operator<(Point const &o) const { return x < o.x || (x == o.x && y < o.y); }
+    };
+    using Ring = std::vector<Point>;
+
+    /* a directed edge, ring tells which input it belongs to */
+    struct Edge {
+        Point a, b;
+        int ring;
+    };
+
+    /*!
+     * \brief Index over the edges of a ring for point-in-polygon tests
+     *
+     * The edges are sorted into horizontal strips, a test only looks at the
+     * edges in the strip of the point. Coordinates are doubled, so midpoints
+     * of edges can be tested exactly.
+     */
+    class RingIndex
+    {
+    public:
+        explicit RingIndex(Ring const &ring);
+        bool contains(Point const &p) const;
+
+    private:
+        Ring pts;
+        int64_t minX, maxX, minY, maxY, height;
+        std::vector<std::vector<int>> strips;
+    };
+
+    static Ring unite(std::vector<Ring> const &rings);
+    static bool covers(Ring const &outline, std::vector<Ring> const &rings);
+
+    static int64_t area2(Ring const &ring);
+    static Ring normalize(Ring const &ring);
+    static std::vector<Edge> splitEdges(std::vector<Edge> const &edges);
+    static std::vector<Ring> linkEdges(std::vector<Edge> const &edges);
+
+private:
+    static std::vector<Edge> ringEdges(std::vector<Ring> const &rings);
+    static std::vector<Ring> outerBoundary(std::vector<Ring> const &rings);
+    static Ring bridge(Ring const &a, Ring const &b, bool &slitted);
+    static Ring slit(Ring const &a, Ring const &b);
+};
+}
+
+#endif // POLYGONUNION_H
@@ -1,6 +1,6 @@
 /*
  * TraCurate – A curation tool for object tracks.
- * Copyright (C) 2017, 2016 Sebastian Wagner
+ * Copyright (C) 2018 Sebastian Wagner
  *
  * TraCurate is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License as published by
@@ -17,51 +17,189 @@
  */
 #include "separate.h"
 
-#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "graphics/polygonunion.h"
 
 namespace TraCurate {
 
+using Point = PolygonUnion::Point;
+using Ring = PolygonUnion::Ring;
+using Edge = PolygonUnion::Edge;
+
+/*!
+ * \brief cuts an outline along a straight line
+ * \param poly the outline
+ * \param line the line, its end points should lie outside of the outline
+ * \return the two pieces or two empty polygons if the line does not cut the
+ * outline into exactly two pieces
+ */
 QPair<QPolygonF,QPolygonF> Separate::compute(QPolygonF &poly, QLineF &line) {
-    QList<QPointF> l = poly.toList();
-    QList<QLineF> lines;
-
-    for (int i = 0; i < l.length(); i++) {
-        QPointF p1(l[i]), p2(l[(i+1)%l.length()]);
-        if (p1 != p2) { /* remove lines with length 0 */
-            QLineF tmpLine(p1,p2);
-            lines.push_back(tmpLine);
+    QList<QPolygonF> pieces = compute(poly, QPolygonF({line.p1(), line.p2()}));
+    if (pieces.size() != 2)
+        return QPair<QPolygonF,QPolygonF>();
+    return QPair<QPolygonF,QPolygonF>(pieces[0], pieces[1]);
+}
+
+/*!
+ * \brief cuts an outline along a polyline
+ * \param outline the outline
+ * \param polyline the points of the (open) polyline
+ * \return the pieces, largest first, or an empty list if the polyline does not
+ * cut the outline
+ */
+QList<QPolygonF> Separate::compute(QPolygonF const &outline, QPolygonF const &polyline) {
+    auto toGrid = [](QPointF const &p) {
+        return Point {static_cast<int64_t>(std::llround(p.x() * GRID)), static_cast<int64_t>(std::llround(p.y() * GRID))};
+    };
+
+    Ring ring;
+    ring.reserve(static_cast<size_t>(outline.size()));
+    for (QPointF const &p : outline)
+        ring.push_back(toGrid(p));
+    ring = PolygonUnion::normalize(ring);
+    if (ring.empty())
+        return QList<QPolygonF>();
+
+    Point lo = ring[0], hi = ring[0];
+    for (Point const &p : ring) {
+        lo = {std::min(lo.x, p.x), std::min(lo.y, p.y)};
+        hi = {std::max(hi.x, p.x), std::max(hi.y, p.y)};
+    }
+
+    /* the outline is counter-clockwise, so its inside is left of its edges */
+    std::vector<Edge> edges;
+    for (size_t i = 0; i < ring.size(); i++)
+        edges.push_back({ring[i], ring[(i + 1) % ring.size()], 0});
+    size_t ringEdges = edges.size();
+
+    /* segments of the polyline that miss the bounding box cannot cut anything */
+    for (int i = 0; i + 1 < polyline.size(); i++) {
+        Point a = toGrid(polyline[i]), b = toGrid(polyline[i + 1]);
+        if (a == b || std::max(a.x, b.x) < lo.x || std::min(a.x, b.x) > hi.x
+                || std::max(a.y, b.y) < lo.y || std::min(a.y, b.y) > hi.y)
+            continue;
+        edges.push_back({a, b, 1});
+    }
+    if (edges.size() == ringEdges)
+        return QList<QPolygonF>();
+
+    edges = PolygonUnion::splitEdges(edges);
+
+    /* keep the pieces of the polyline that are inside of the outline, once */
+    auto key = [](Edge const &e) {
+        return (e.a < e.b) ? std::make_pair(e.a, e.b) : std::make_pair(e.b, e.a);
+    };
+    std::set<std::pair<Point,Point>> seen;
+    for (Edge const &e : edges)
+        if (e.ring == 0)
+            seen.insert(key(e));
+
+    PolygonUnion::RingIndex index(ring);
+    std::vector<Edge> boundary, cuts;
+    for (Edge const &e : edges) {
+        if (e.ring == 0) {
+            boundary.push_back(e);
+            continue;
+        }
+        if (e.a == e.b || !seen.insert(key(e)).second)
+            continue;
+        if (index.contains({e.a.x + e.b.x, e.a.y + e.b.y}))
+            cuts.push_back(e);
+    }
+
+    /* drop dangling ends, they do not separate anything */
+    std::map<Point,int> degree;
+    std::multimap<Point,size_t> cutsAt;
+    for (Edge const &e : boundary) {
+        degree[e.a]++;
+        degree[e.b]++;
+    }
+    for (size_t i = 0; i < cuts.size(); i++) {
+        degree[cuts[i].a]++;
+        degree[cuts[i].b]++;
+        cutsAt.insert({cuts[i].a, i});
+        cutsAt.insert({cuts[i].b, i});
+    }
+    std::vector<bool> removed(cuts.size(), false);
+    std::vector<Point> work;
+    for (auto const &d : degree)
+        if (d.second == 1)
+            work.push_back(d.first);
+    while (!work.empty()) {
+        Point p = work.back();
+        work.pop_back();
+        auto range = cutsAt.equal_range(p);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (removed[it->second])
+                continue;
+            removed[it->second] = true;
+            Edge const &e = cuts[it->second];
+            Point other = (e.a == p) ? e.b : e.a;
+            degree[p]--;
+            if (--degree[other] == 1)
+                work.push_back(other);
         }
     }
 
-    QList<QList<QLineF>> polys;
-    QList<QLineF> poly1, poly2;
-    polys.push_back(poly1);
-    polys.push_back(poly2);
-    int currPoly = 0;
-
-    for (QLineF polyLine : lines) {
-        QLineF lF(polyLine);
-        QPointF intersectPoint;
-        switch (lF.intersect(line, &intersectPoint)) {
-        case QLineF::IntersectType::NoIntersection:        /* lines parallel */
-        case QLineF::IntersectType::UnboundedIntersection: /* intersection not in the bounds of the line */
-            polys[currPoly] << lF;
-            break;
-        case QLineF::IntersectType::BoundedIntersection:   /* intersection in the bounds of the line */
-            polys[currPoly] << QLineF(lF.p1(),intersectPoint);
-            currPoly = (currPoly+1)%polys.length();
-            polys[currPoly] << QLineF(intersectPoint,lF.p2());
-            break;
+    /* loops that do not touch the outline would leave holes, drop them as well */
+    std::set<Point> reached;
+    for (Edge const &e : boundary)
+        reached.insert(e.a);
+    std::vector<Point> queue(reached.begin(), reached.end());
+    while (!queue.empty()) {
+        Point p = queue.back();
+        queue.pop_back();
+        auto range = cutsAt.equal_range(p);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (removed[it->second])
+                continue;
+            Edge const &e = cuts[it->second];
+            Point other = (e.a == p) ? e.b : e.a;
+            if (reached.insert(other).second)
+                queue.push_back(other);
         }
     }
 
-    QPolygonF ply1, ply2;
-    for (QLineF ln : polys[0])
-        ply1 << ln.p1() << ln.p2();
-    for (QLineF ln : polys[1])
-        ply2 << ln.p1() << ln.p2();
+    /* the cuts bound pieces on both sides */
+    std::vector<Edge> graph = boundary;
+    for (size_t i = 0; i < cuts.size(); i++) {
+        if (removed[i] || !reached.count(cuts[i].a))
+            continue;
+        graph.push_back(cuts[i]);
+        graph.push_back({cuts[i].b, cuts[i].a, 1});
+    }
+    if (graph.size() == boundary.size())
+        return QList<QPolygonF>();
+
+    std::vector<Ring> faces;
+    for (Ring const &r : PolygonUnion::linkEdges(graph)) {
+        if (PolygonUnion::area2(r) <= 0)
+            continue;
+        Ring n = PolygonUnion::normalize(r);
+        if (!n.empty())
+            faces.push_back(n);
+    }
+    if (faces.size() < 2)
+        return QList<QPolygonF>();
+    std::stable_sort(faces.begin(), faces.end(), [](Ring const &a, Ring const &b) {
+        return PolygonUnion::area2(a) > PolygonUnion::area2(b);
+    });
 
-    return QPair<QPolygonF,QPolygonF>(ply1, ply2);
+    QList<QPolygonF> ret;
+    for (Ring const &f : faces) {
+        QPolygonF poly;
+        poly.reserve(static_cast<int>(f.size()));
+        for (Point const &p : f)
+            poly.append(QPointF(p.x / GRID, p.y / GRID));
+        ret.append(poly);
+    }
+    return ret;
 }
 
 }
@@ -1,6 +1,6 @@
 /*
  * TraCurate – A curation tool for object tracks.
- * Copyright (C) 2016 Sebastian Wagner
+ * Copyright (C) 2018 Sebastian Wagner
  *
  * TraCurate is free software: you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License as published by
@@ -19,16 +19,34 @@
 #define SEPARATE_H
 
 #include <QLineF>
+#include <QList>
 #include <QPair>
 #include <QPolygonF>
 
 namespace TraCurate {
+/*!
+ * \brief The Separate class
+ *
+ * Cuts the outline of an Object along a line or a freehand polyline. The
+ * polyline may cross the outline any number of times and cross itself, every
+ * region of the outline that is enclosed by the outline and the polyline
+ * becomes a piece. Parts of the polyline that end inside the outline without
+ * closing a region (e.g. the overshooting ends of a scribble) are ignored.
+ *
+ * The outline and the polyline are put on a grid of 1/GRID pixels and split at
+ * their intersections by PolygonUnion, the pieces are the faces of the
+ * resulting planar graph.
+ */
 class Separate
 {
 public:
     Separate() = default;
 
     static QPair<QPolygonF,QPolygonF> compute(QPolygonF&, QLineF&);
+    static QList<QPolygonF> compute(QPolygonF const &outline, QPolygonF const &polyline);
+
+private:
+    static constexpr double GRID = 8;
 };
 
 }
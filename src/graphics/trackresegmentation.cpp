@@ -0,0 +1,174 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "trackresegmentation.h"
+
+#include <algorithm>
+#include <exception>
+
+#include <QtConcurrent/QtConcurrent>
+#include <QDebug>
+#include <QImage>
+#include <QRect>
+#include <QSet>
+
+#include "base/autotracklet.h"
+#include "base/channel.h"
+#include "base/frame.h"
+#include "base/movie.h"
+#include "base/slice.h"
+#include "graphics/floodfill.h"
+#include "graphics/watershed.h"
+#include "provider/imagecache.h"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+#include "tracked/genealogy.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief returns the Object%s of a Tracklet or AutoTracklet
+ * \param proj the Project
+ * \param id the id of the Tracklet or AutoTracklet
+ * \param autoTracklet if true, id is the id of an AutoTracklet
+ * \return the Object%s, ordered by Frame
+ */
+QList<std::shared_ptr<Object>> TrackResegmentation::objectsOf(std::shared_ptr<Project> const &proj, int id, bool autoTracklet)
+{
+    QList<std::shared_ptr<Object>> ret;
+    if (!proj)
+        return ret;
+
+    if (autoTracklet) {
+        std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(id);
+        if (at)
+            ret = at->getComponents().values(); /* a QMap, already ordered by Frame */
+    } else if (proj->getGenealogy()) {
+        std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(id);
+        if (t)
+            for (auto const &p : t->getContained())
+                ret.append(p.second);
+        std::sort(ret.begin(), ret.end(), [](std::shared_ptr<Object> const &a, std::shared_ptr<Object> const &b) {
+            return a->getFrameId() < b->getFrameId();
+        });
+    }
+    return ret;
+}
+
+/*!
+ * \brief collects what is needed to segment Object%s again
+ * \param proj the Project
+ * \param path the URL of the Project file, as the ImageCache is used with (see GUIState::getProjPath())
+ * \param objects the Object%s
+ * \param method how the Object%s are segmented
+ * \param thresh the threshold of the FloodFill
+ * \return one Job per Object
+ */
+QList<TrackResegmentation::Job> TrackResegmentation::prepare(std::shared_ptr<Project> const &proj, QString const &path,
+                                                             QList<std::shared_ptr<Object>> const &objects,
+                                                             Method method, int thresh)
+{
+    QList<Job> jobs;
+    double maxShare = TCSettings::value("graphics/max_pixelmask_percentage").toReal();
+    for (std::shared_ptr<Object> const &o : objects) {
+        std::shared_ptr<Frame> f = proj->getMovie()->getFrame(o->getFrameId());
+        std::shared_ptr<Slice> s = f ? f->getSlice(o->getSliceId()) : nullptr;
+        std::shared_ptr<Channel> c = s ? s->getChannel(o->getChannelId()) : nullptr;
+        if (!c)
+            continue;
+
+        Job job;
+        job.object = o;
+        job.path = path;
+        job.centroid = *o->getCentroid();
+        job.method = method;
+        job.thresh = thresh;
+        job.maxPixelShare = maxShare;
+
+        /* the area around the Object, its corners are seeds of the background */
+        QRectF bb = o->getOutline()->boundingRect();
+        double margin = std::max(5.0, std::max(bb.width(), bb.height()) / 2);
+        QRectF area = bb.adjusted(-margin, -margin, margin, margin);
+        job.area << area.topLeft() << area.topRight() << area.bottomRight() << area.bottomLeft();
+        job.neighbors << area.topLeft() << area.topRight() << area.bottomRight() << area.bottomLeft();
+        for (uint32_t id : c->getFeatures().candidatesIn(area)) {
+            if (id == o->getId())
+                continue;
+            FeatureTable::Features nf = c->getFeatures().get(id);
+            if (area.contains(nf.centroid))
+                job.neighbors << nf.centroid;
+        }
+        jobs.append(job);
+    }
+    return jobs;
+}
+
+/*!
+ * \brief segments the Object%s of the Job%s in the background
+ * \param jobs the Job%s
+ * \return the future of the Result%s, in the order of the Job%s
+ */
+QFuture<TrackResegmentation::Result> TrackResegmentation::start(QList<Job> const &jobs)
+{
+    MessageRelay::emitUpdateDetailName("Segmenting frames");
+    MessageRelay::emitUpdateDetailMax(jobs.size());
+    return QtConcurrent::mapped(jobs, &TrackResegmentation::run);
+}
+
+/*!
+ * \brief segments the Object of one Job
+ * \param job the Job
+ * \return the new outline of the Object
+ */
+TrackResegmentation::Result TrackResegmentation::run(Job const &job)
+{
+    TC_TRACE_SCOPE("TrackResegmentation::run");
+    Result ret {job.object, QPolygonF()};
+    try {
+        RawImage raw = ImageCache::getInstance()->raw(job.path, static_cast<int>(job.object->getFrameId()),
+                                                      static_cast<int>(job.object->getSliceId()),
+                                                      static_cast<int>(job.object->getChannelId()));
+        QPoint seed = job.centroid;
+        if (!raw.isNull() && QRect(0, 0, raw.width(), raw.height()).contains(seed)) {
+            switch (job.method) {
+            case FLOOD_FILL: {
+                /* the threshold is meant for 8 bit gray values, without the contrast settings of the display */
+                QImage image = raw.toImage();
+                int maxPixels = static_cast<int>(image.width() * image.height() * job.maxPixelShare);
+                QSet<QPoint> mask = FloodFill::calculateMask(image, seed, job.thresh, maxPixels, FloodFill::C8);
+                ret.outline = FloodFill::maskToPoly(mask.toList());
+                break; }
+            case WATERSHED: {
+                QList<QPointF> seeds {QPointF(seed)};
+                seeds.append(job.neighbors);
+                ret.outline = Watershed::grow(raw, job.area, seeds);
+                break; }
+            }
+        }
+    } catch (std::exception &e) {
+        qDebug() << "could not segment frame" << job.object->getFrameId() << "again:" << e.what();
+    } catch (...) {
+        qDebug() << "could not segment frame" << job.object->getFrameId() << "again";
+    }
+    if (ret.outline.size() < 3)
+        ret.outline.clear();
+    MessageRelay::emitIncreaseDetail();
+    return ret;
+}
+}
@@ -0,0 +1,86 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TRACKRESEGMENTATION_H
+#define TRACKRESEGMENTATION_H
+
+#include <memory>
+
+#include <QFuture>
+#include <QList>
+#include <QPoint>
+#include <QPointF>
+#include <QPolygonF>
+#include <QString>
+
+#include "base/object.h"
+#include "project.h"
+
+namespace TraCurate {
+/*!
+ * \brief The TrackResegmentation class
+ *
+ * Segments the Object%s of a Tracklet or AutoTracklet again, in all Frame%s
+ * at once. Each Object is replaced by the result of a FloodFill or a
+ * Watershed seeded at its stored centroid. The Watershed grows the Object
+ * against seeds in the corners of the area around it and at the centroids of
+ * the Object%s next to it.
+ *
+ * The Project is only read on the calling thread (prepare()), the Frame%s
+ * are segmented in parallel by the QtConcurrent worker pool (start()). The
+ * images are read through the ImageCache, the reads take turns with all
+ * other uses of the HDF5 library (see lockHDF5()). Both methods work on the
+ * images as they are stored, not on the images drawn with the contrast
+ * settings of the Channel.
+ */
+class TrackResegmentation
+{
+public:
+    TrackResegmentation() = delete;
+
+    enum Method {
+        FLOOD_FILL,
+        WATERSHED
+    };
+
+    /*! \brief everything needed to segment one Frame, copied from the Project */
+    struct Job {
+        std::shared_ptr<Object> object;
+        QString path;               /*!< the URL of the Project file, see GUIState::getProjPath() */
+        QPoint centroid;
+        QPolygonF area;             /*!< the area the Watershed grows in */
+        QList<QPointF> neighbors;   /*!< seeds of other Object%s and the background */
+        Method method;
+        int thresh;
+        double maxPixelShare;       /*!< the largest FloodFill, as a share of the image */
+    };
+
+    /*! \brief the new outline of an Object, empty if the segmentation failed */
+    struct Result {
+        std::shared_ptr<Object> object;
+        QPolygonF outline;
+    };
+
+    static QList<std::shared_ptr<Object>> objectsOf(std::shared_ptr<Project> const &proj, int id, bool autoTracklet);
+    static QList<Job> prepare(std::shared_ptr<Project> const &proj, QString const &path,
+                              QList<std::shared_ptr<Object>> const &objects, Method method, int thresh);
+    static QFuture<Result> start(QList<Job> const &jobs);
+    static Result run(Job const &job);
+};
+}
+
+#endif // TRACKRESEGMENTATION_H
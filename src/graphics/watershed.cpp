@@ -0,0 +1,302 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "watershed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <queue>
+
+#include "bordertracer.h"
+
+namespace TraCurate {
+
+/* the 8 neighbors of a pixel in clockwise order (y pointing down), starting east */
+static const int DX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int DY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+/* the gray values of the pixels in crop at the bit depth of the image, RGB is weighted like qGray() */
+static std::vector<int> grayValues(RawImage const &image, QRect const &crop)
+{
+    std::vector<int> ret(static_cast<size_t>(crop.width() * crop.height()));
+    const int spp = image.samples();
+    auto sample = [&](int x, int y, int s) {
+        size_t i = static_cast<size_t>((y * image.width() + x) * spp + s);
+        return image.bitDepth() == 16 ? static_cast<int>(reinterpret_cast<uint16_t const*>(image.constBits())[i])
+                                      : static_cast<int>(image.constBits()[i]);
+    };
+    for (int y = 0; y < crop.height(); y++) {
+        for (int x = 0; x < crop.width(); x++) {
+            int ix = x + crop.left(), iy = y + crop.top();
+            ret[static_cast<size_t>(y * crop.width() + x)] = (spp == 3)
+                    ? (sample(ix, iy, 0) * 11 + sample(ix, iy, 1) * 16 + sample(ix, iy, 2) * 5) / 32
+                    : sample(ix, iy, 0);
+        }
+    }
+    return ret;
+}
+
+/* the Sobel gradient magnitude |gx| + |gy| */
+static std::vector<int> gradient(std::vector<int> const &gray, int w, int h)
+{
+    auto at = [&](int x, int y) {
+        return gray[static_cast<size_t>(std::min(std::max(y, 0), h - 1) * w + std::min(std::max(x, 0), w - 1))];
+    };
+    std::vector<int> ret(gray.size());
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int gx = at(x + 1, y - 1) + 2 * at(x + 1, y) + at(x + 1, y + 1) - at(x - 1, y - 1) - 2 * at(x - 1, y) - at(x - 1, y + 1);
+            int gy = at(x - 1, y + 1) + 2 * at(x, y + 1) + at(x + 1, y + 1) - at(x - 1, y - 1) - 2 * at(x, y - 1) - at(x + 1, y - 1);
+            ret[static_cast<size_t>(y * w + x)] = std::abs(gx) + std::abs(gy);
+        }
+    }
+    return ret;
+}
+
+/* maps values linearly from their range onto the 256 levels of the queue */
+static std::vector<uint8_t> quantize(std::vector<int> const &values)
+{
+    std::vector<uint8_t> ret(values.size(), 0);
+    if (values.empty())
+        return ret;
+    auto range = std::minmax_element(values.begin(), values.end());
+    const int lo = *range.first, span = *range.second - *range.first;
+    if (span == 0)
+        return ret;
+    for (size_t i = 0; i < values.size(); i++)
+        ret[i] = static_cast<uint8_t>((static_cast<int64_t>(values[i] - lo) * 255 + span / 2) / span);
+    return ret;
+}
+
+/*!
+ * \brief grows a region from each seed until all pixels inside of an outline are labeled
+ * \param image the image of the Channel as it is stored
+ * \param outline the outline, in the coordinates of the image
+ * \param seeds the seeds, seeds outside of the outline are ignored
+ * \param relief what the regions are flooded by
+ * \param crop receives the part of the image that was labeled
+ * \param seedLabels receives the label of each seed, 0 for ignored seeds
+ * \return the labels of the pixels in crop, 0 for unreached pixels and -1 outside of the outline
+ */
+std::vector<int> Watershed::flood(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds,
+                                  Relief relief, QRect &crop, QVector<int> &seedLabels)
+{
+    seedLabels = QVector<int>(seeds.size(), 0);
+    QRectF bb = outline.boundingRect();
+    crop = QRect(QPoint(static_cast<int>(std::floor(bb.left())), static_cast<int>(std::floor(bb.top()))),
+                       QPoint(static_cast<int>(std::ceil(bb.right())), static_cast<int>(std::ceil(bb.bottom()))))
+            .intersected(QRect(0, 0, image.width(), image.height()));
+    if (image.isNull() || crop.isEmpty() || seeds.isEmpty())
+        return std::vector<int>();
+
+    const int w = crop.width(), h = crop.height();
+    std::vector<int> gray = grayValues(image, crop);
+    std::vector<uint8_t> inside = rasterize(outline, crop);
+
+    /* 0 is unlabeled, -1 is outside of the outline */
+    std::vector<int> labels(static_cast<size_t>(w * h), 0);
+    for (size_t i = 0; i < inside.size(); i++)
+        if (!inside[i])
+            labels[i] = -1;
+
+    /* the relief is computed at the bit depth of the image and only then reduced to 256 levels */
+    std::vector<uint8_t> level = quantize(relief == GRADIENT ? gradient(gray, w, h) : gray);
+
+    /* bright objects are flooded from their bright centers */
+    double seedSum = 0, borderSum = 0;
+    int seedCount = 0, borderCount = 0;
+    for (QPointF const &s : seeds) {
+        int x = static_cast<int>(std::lround(s.x())) - crop.left();
+        int y = static_cast<int>(std::lround(s.y())) - crop.top();
+        if (x >= 0 && x < w && y >= 0 && y < h && inside[static_cast<size_t>(y * w + x)]) {
+            seedSum += level[static_cast<size_t>(y * w + x)];
+            seedCount++;
+        }
+    }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            size_t i = static_cast<size_t>(y * w + x);
+            if (inside[i] && (x == 0 || y == 0 || x == w - 1 || y == h - 1
+                              || !inside[i - 1] || !inside[i + 1] || !inside[i - static_cast<size_t>(w)] || !inside[i + static_cast<size_t>(w)])) {
+                borderSum += level[i];
+                borderCount++;
+            }
+        }
+    }
+    if (seedCount == 0)
+        return std::vector<int>();
+    if (relief == INTENSITY && borderCount > 0 && seedSum / seedCount > borderSum / borderCount)
+        for (uint8_t &l : level)
+            l = static_cast<uint8_t>(255 - l);
+
+    std::vector<std::queue<int>> queues(256);
+    int label = 0;
+    for (int k = 0; k < seeds.size(); k++) {
+        int x = static_cast<int>(std::lround(seeds[k].x())) - crop.left();
+        int y = static_cast<int>(std::lround(seeds[k].y())) - crop.top();
+        if (x < 0 || x >= w || y < 0 || y >= h)
+            continue;
+        int i = y * w + x;
+        if (labels[static_cast<size_t>(i)] != 0) /* outside or a second seed on the same pixel */
+            continue;
+        labels[static_cast<size_t>(i)] = ++label;
+        seedLabels[k] = label;
+        queues[level[static_cast<size_t>(i)]].push(i);
+    }
+
+    /* pixels are labeled when queued and never queued below the current level */
+    for (int l = 0; l < 256; l++) {
+        std::queue<int> &q = queues[static_cast<size_t>(l)];
+        while (!q.empty()) {
+            int i = q.front();
+            q.pop();
+            int x = i % w, y = i / w;
+            int lbl = labels[static_cast<size_t>(i)];
+            for (int d = 0; d < 8; d += 2) {
+                int nx = x + DX[d], ny = y + DY[d];
+                if (nx < 0 || nx >= w || ny < 0 || ny >= h)
+                    continue;
+                int n = ny * w + nx;
+                if (labels[static_cast<size_t>(n)] != 0)
+                    continue;
+                labels[static_cast<size_t>(n)] = lbl;
+                queues[std::max<size_t>(level[static_cast<size_t>(n)], static_cast<size_t>(l))].push(n);
+            }
+        }
+    }
+
+    return labels;
+}
+
+/*!
+ * \brief splits an outline at the ridges of an image between seeds
+ * \param image the image of the Channel as it is stored
+ * \param outline the outline of the Object, in the coordinates of the image
+ * \param seeds the seeds, one region is grown from each seed inside of the outline
+ * \return the outlines of the regions or an empty list if there are less than two
+ */
+QList<QPolygonF> Watershed::compute(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds)
+{
+    if (seeds.size() < 2)
+        return QList<QPolygonF>();
+    QRect crop;
+    QVector<int> seedLabels;
+    std::vector<int> labels = flood(image, outline, seeds, INTENSITY, crop, seedLabels);
+    int label = *std::max_element(seedLabels.begin(), seedLabels.end());
+    if (label < 2)
+        return QList<QPolygonF>();
+    const int w = crop.width(), h = crop.height();
+
+    /* each region is traced from its first pixel in raster order */
+    std::vector<int> starts(static_cast<size_t>(label) + 1, -1);
+    for (int i = 0; i < w * h; i++) {
+        int lbl = labels[static_cast<size_t>(i)];
+        if (lbl > 0 && starts[static_cast<size_t>(lbl)] < 0)
+            starts[static_cast<size_t>(lbl)] = i;
+    }
+
+    QList<QPolygonF> ret;
+    for (int lbl = 1; lbl <= label; lbl++) {
+        if (starts[static_cast<size_t>(lbl)] < 0)
+            continue;
+        QPolygonF piece = BorderTracer::trace(labels.data(), w, h, starts[static_cast<size_t>(lbl)], crop.topLeft());
+        if (piece.size() >= 3)
+            ret.append(piece);
+    }
+    if (ret.size() < 2)
+        return QList<QPolygonF>();
+    return ret;
+}
+
+/*!
+ * \brief grows the region of the first seed against the regions of the other seeds
+ *
+ * Unlike compute, the regions are flooded by the gradient of the image, so
+ * seeds in the background stop the region at the edge of the Object.
+ *
+ * \param image the image of the Channel as it is stored
+ * \param outline the area to grow in, in the coordinates of the image
+ * \param seeds the seeds, the first one has to lie inside of the outline
+ * \return the outline of the region of the first seed or an empty polygon
+ */
+QPolygonF Watershed::grow(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds)
+{
+    QRect crop;
+    QVector<int> seedLabels;
+    std::vector<int> labels = flood(image, outline, seeds, GRADIENT, crop, seedLabels);
+    if (labels.empty() || seedLabels[0] == 0)
+        return QPolygonF();
+    auto start = std::find(labels.begin(), labels.end(), seedLabels[0]);
+    QPolygonF ret = BorderTracer::trace(labels.data(), crop.width(), crop.height(), static_cast<int>(start - labels.begin()), crop.topLeft());
+    return (ret.size() >= 3) ? ret : QPolygonF();
+}
+
+/*!
+ * \brief marks the pixels whose centers lie inside of an outline and those it runs through
+ * \param outline the outline
+ * \param crop the pixels to test
+ * \return one byte per pixel of crop, 1 if inside
+ */
+std::vector<uint8_t> Watershed::rasterize(QPolygonF const &outline, QRect const &crop)
+{
+    const int w = crop.width(), h = crop.height();
+    std::vector<uint8_t> ret(static_cast<size_t>(w * h), 0);
+
+    /* the crossings of the edges with the rows of pixel centers, per row */
+    std::vector<std::vector<double>> crossings(static_cast<size_t>(h));
+    const int n = outline.size();
+    for (int k = 0; k < n; k++) {
+        QPointF const &a = outline[k];
+        QPointF const &b = outline[(k + 1) % n];
+        if (a.y() == b.y())
+            continue;
+        double y0 = std::min(a.y(), b.y()), y1 = std::max(a.y(), b.y());
+        int r0 = std::max(0, static_cast<int>(std::ceil(y0)) - crop.top());
+        int r1 = std::min(h - 1, static_cast<int>(std::ceil(y1)) - 1 - crop.top());
+        for (int r = r0; r <= r1; r++) {
+            double y = r + crop.top();
+            crossings[static_cast<size_t>(r)].push_back(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+        }
+    }
+
+    for (int r = 0; r < h; r++) {
+        std::vector<double> &c = crossings[static_cast<size_t>(r)];
+        std::sort(c.begin(), c.end());
+        for (size_t k = 0; k + 1 < c.size(); k += 2) {
+            int x0 = std::max(0, static_cast<int>(std::ceil(c[k])) - crop.left());
+            int x1 = std::min(w - 1, static_cast<int>(std::floor(c[k + 1])) - crop.left());
+            for (int x = x0; x <= x1; x++)
+                ret[static_cast<size_t>(r * w + x)] = 1;
+        }
+    }
+
+    /* outlines often run through the centers of the border pixels, which belong to the Object */
+    for (int k = 0; k < n; k++) {
+        QPointF const &a = outline[k];
+        QPointF const &b = outline[(k + 1) % n];
+        int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::fabs(b.x() - a.x()), std::fabs(b.y() - a.y())))));
+        for (int t = 0; t <= steps; t++) {
+            int x = static_cast<int>(std::lround(a.x() + (b.x() - a.x()) * t / steps)) - crop.left();
+            int y = static_cast<int>(std::lround(a.y() + (b.y() - a.y()) * t / steps)) - crop.top();
+            if (x >= 0 && x < w && y >= 0 && y < h)
+                ret[static_cast<size_t>(y * w + x)] = 1;
+        }
+    }
+    return ret;
+}
+}
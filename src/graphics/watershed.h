@@ -0,0 +1,75 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef WATERSHED_H
+#define WATERSHED_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QList>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRect>
+#include <QVector>
+
+#include "base/rawimage.h"
+
+namespace TraCurate {
+/*!
+ * \brief The Watershed class
+ *
+ * Splits the outline of an Object by a seeded watershed on the channel image
+ * as it is stored (RawImage), so neither the contrast settings nor the
+ * colormap of the display change the result. Every seed starts a region. The
+ * regions grow from the seeds in the order of the gray values of the pixels,
+ * using a hierarchical queue with one FIFO per gray level, until every pixel
+ * inside of the outline belongs to a region. The regions meet on the ridges
+ * of the image between the seeds. The gray values (or their gradient) are
+ * computed at the bit depth of the image and then spread linearly over the
+ * 256 levels of the queue, from the lowest to the highest value around the
+ * Object.
+ *
+ * If the seeds are brighter than the border of the Object, the Object is
+ * taken to be bright on a dark background and the gray values are inverted,
+ * so the regions meet in the dark gaps between touching cells.
+ *
+ * Only the bounding box of the outline is copied from the image, all work is
+ * done on flat buffers of that size. The outlines of the regions are traced
+ * by the BorderTracer.
+ */
+class Watershed
+{
+public:
+    Watershed() = delete;
+
+    enum Relief {
+        INTENSITY,  /*!< the gray values, inverted for bright objects */
+        GRADIENT    /*!< the magnitude of the gradient of the gray values */
+    };
+
+    static QList<QPolygonF> compute(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds);
+    static QPolygonF grow(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds);
+
+private:
+    static std::vector<int> flood(RawImage const &image, QPolygonF const &outline, QList<QPointF> const &seeds,
+                                  Relief relief, QRect &crop, QVector<int> &seedLabels);
+    static std::vector<uint8_t> rasterize(QPolygonF const &outline, QRect const &crop);
+};
+}
+
+#endif // WATERSHED_H
@@ -17,6 +17,17 @@
  */
 #include "export.h"
 
+#include <algorithm>
+
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+#include "exceptions/tcexportexception.h"
+#include "tracked/trackeventdivision.hpp"
+#include "tracked/trackeventmerge.hpp"
+#include "tracked/trackeventunmerge.hpp"
+#include "provider/messagerelay.h"
+
 namespace TraCurate {
 
 Export::~Export() {}
@@ -31,4 +42,110 @@ bool Export::save(std::shared_ptr<Project> project)
     return save(project, project->getFileName());
 }
 
+/*!
+ * \brief returns the Frame%s of a Project ordered by their id
+ * \param proj the Project
+ * \return the Frame%s
+ */
+QList<std::shared_ptr<Frame>> Export::sortedFrames(std::shared_ptr<Project> const &proj)
+{
+    QList<std::shared_ptr<Frame>> frames = proj->getMovie()->getFrames().values();
+    std::sort(frames.begin(), frames.end(), [](std::shared_ptr<Frame> const &a, std::shared_ptr<Frame> const &b) {
+        return a->getID() < b->getID();
+    });
+    return frames;
+}
+
+/*!
+ * \brief encodes Frame%s in parallel and writes the results in the order of the Frame%s
+ * \param frames the Frame%s to encode
+ * \param encode called for each Frame on the global QThreadPool, must not modify the Project
+ * \param out receives the encoded Frame%s, may be nullptr if encode writes its own output
+ *
+ * Only a few Frame%s per thread are encoded before they are written, so the
+ * memory used does not grow with the length of the Movie.
+ */
+void Export::streamFrames(QList<std::shared_ptr<Frame>> const &frames, FrameEncoder const &encode, QIODevice *out)
+{
+    int chunk = std::max(QThreadPool::globalInstance()->maxThreadCount(), 1) * 4;
+    MessageRelay::emitUpdateDetailMax(frames.size());
+    for (int i = 0; i < frames.size(); i += chunk) {
+        QList<QByteArray> encoded = QtConcurrent::blockingMapped<QList<QByteArray>>(frames.mid(i, chunk), encode);
+        for (QByteArray const &bytes : encoded) {
+            if (out && out->write(bytes) != bytes.size())
+                throw TCExportException("Writing failed: " + out->errorString().toStdString());
+            MessageRelay::emitIncreaseDetail();
+        }
+    }
+}
+
+/*!
+ * \brief returns the ids of the Tracklet%s that a Tracklet emerged from
+ * \param t the Tracklet
+ * \return the mother of a division, the merged Tracklet of an unmerge or the Tracklet%s of a merge
+ */
+QList<int> Export::previousTracklets(std::shared_ptr<Tracklet> const &t)
+{
+    QList<int> ret;
+    std::shared_ptr<TrackEvent<Tracklet>> ev = t->getPrev();
+    if (!ev)
+        return ret;
+    std::shared_ptr<Tracklet> prev;
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+        prev = std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev)->getPrev().lock();
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+        prev = std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev)->getPrev().lock();
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:
+        for (std::weak_ptr<Tracklet> const &w : *std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev)->getPrev())
+            if (std::shared_ptr<Tracklet> p = w.lock())
+                ret.append(p->getId());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_LOST:
+    case TrackEvent<Tracklet>::EVENT_TYPE_DEAD:
+    case TrackEvent<Tracklet>::EVENT_TYPE_ENDOFMOVIE:
+        break;
+    }
+    if (prev)
+        ret.append(prev->getId());
+    return ret;
+}
+
+/*!
+ * \brief returns the ids of the Tracklet%s that follow a Tracklet
+ * \param t the Tracklet
+ * \return the daughters of a division or unmerge or the merged Tracklet of a merge
+ */
+QList<int> Export::nextTracklets(std::shared_ptr<Tracklet> const &t)
+{
+    QList<int> ret;
+    std::shared_ptr<TrackEvent<Tracklet>> ev = t->getNext();
+    if (!ev)
+        return ret;
+    std::shared_ptr<QList<std::weak_ptr<Tracklet>>> next;
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+        next = std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev)->getNext();
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+        next = std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev)->getNext();
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:
+        if (std::shared_ptr<Tracklet> n = std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev)->getNext().lock())
+            ret.append(n->getId());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_LOST:
+    case TrackEvent<Tracklet>::EVENT_TYPE_DEAD:
+    case TrackEvent<Tracklet>::EVENT_TYPE_ENDOFMOVIE:
+        break;
+    }
+    if (next)
+        for (std::weak_ptr<Tracklet> const &w : *next)
+            if (std::shared_ptr<Tracklet> n = w.lock())
+                ret.append(n->getId());
+    return ret;
+}
+
 }
@@ -18,8 +18,13 @@
 #ifndef EXPORT_H
 #define EXPORT_H
 
+#include <functional>
 #include <memory>
 
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+
 #include "project.h"
 
 namespace TraCurate {
@@ -31,6 +36,10 @@ namespace TraCurate {
  * identified via a QString.
  *
  * Also provides methods to save to same file that the Project was loaded from.
+ *
+ * Exporters that write one record per Frame (ExportCSV, ExportCTC) use
+ * streamFrames(), which encodes a few Frame%s at a time in parallel and writes
+ * them in order, so the output never has to be held in memory as a whole.
  */
 class Export
 {
@@ -50,6 +59,14 @@ public:
 
     virtual bool save(std::shared_ptr<Project>,QString) = 0;
     bool save(std::shared_ptr<Project>);
+
+protected:
+    typedef std::function<QByteArray(std::shared_ptr<Frame> const &)> FrameEncoder;
+
+    static QList<std::shared_ptr<Frame>> sortedFrames(std::shared_ptr<Project> const &proj);
+    static void streamFrames(QList<std::shared_ptr<Frame>> const &frames, FrameEncoder const &encode, QIODevice *out);
+    static QList<int> previousTracklets(std::shared_ptr<Tracklet> const &t);
+    static QList<int> nextTracklets(std::shared_ptr<Tracklet> const &t);
 };
 
 }
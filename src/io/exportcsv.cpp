@@ -0,0 +1,214 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "exportcsv.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+
+#include "base/frame.h"
+#include "base/slice.h"
+#include "exceptions/tcexportexception.h"
+#include "provider/messagerelay.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief constructor for ExportCSV
+ * \param separator the separator of the fields, ',' writes .csv files and '\t' writes .tsv files
+ */
+ExportCSV::ExportCSV(QChar separator) :
+    sep(separator.toLatin1())
+{
+}
+
+/*!
+ * \brief writes the tables of a Project to a directory
+ * \param project the Project to export
+ * \param dirName the directory, it is created if it does not exist
+ * \return true if saving was successful
+ */
+bool ExportCSV::save(std::shared_ptr<Project> project, QString dirName)
+{
+    TC_TRACE_SCOPE("ExportCSV::save");
+    if (!QDir().mkpath(dirName))
+        throw TCExportException("Could not create the directory " + dirName.toStdString());
+    QDir dir(dirName);
+    QString suffix = (sep == '\t') ? ".tsv" : ".csv";
+
+    MessageRelay::emitUpdateOverallName("Exporting tables");
+    MessageRelay::emitUpdateOverallMax(2);
+
+    qDebug() << "Saving objects";
+    MessageRelay::emitUpdateDetailName("Saving objects");
+    saveObjects(project, dir.filePath("objects" + suffix));
+    MessageRelay::emitIncreaseOverall();
+
+    qDebug() << "Saving tracklets";
+    MessageRelay::emitUpdateDetailName("Saving tracklets");
+    saveTracklets(project, dir.filePath("tracklets" + suffix));
+    MessageRelay::emitIncreaseOverall();
+
+    qDebug() << "Finished";
+    return true;
+}
+
+QByteArray ExportCSV::row(QList<QByteArray> const &fields) const
+{
+    QByteArray ret;
+    for (int i = 0; i < fields.size(); i++) {
+        if (i > 0)
+            ret.append(sep);
+        ret.append(fields[i]);
+    }
+    ret.append('\n');
+    return ret;
+}
+
+/*!
+ * \brief encodes the rows of all Object%s in a Frame
+ * \param frame the Frame
+ * \return the rows, ordered by Slice, Channel and Object id
+ */
+QByteArray ExportCSV::encodeFrame(std::shared_ptr<Frame> const &frame) const
+{
+    TC_TRACE_SCOPE("ExportCSV::encodeFrame");
+    QByteArray ret;
+    QList<std::shared_ptr<Slice>> slices = frame->getSlices();
+    std::sort(slices.begin(), slices.end(), [](std::shared_ptr<Slice> const &a, std::shared_ptr<Slice> const &b) {
+        return a->getSliceId() < b->getSliceId();
+    });
+    for (std::shared_ptr<Slice> const &s : slices) {
+        QList<uint32_t> chanIds = s->getChannels().keys();
+        std::sort(chanIds.begin(), chanIds.end());
+        for (uint32_t chanId : chanIds) {
+            std::shared_ptr<Channel> ch = s->getChannel(chanId);
+            FeatureTable const &features = ch->getFeatures();
+            QHash<uint32_t,std::shared_ptr<Object>> objects = ch->getObjects();
+            QList<uint32_t> ids = objects.keys();
+            std::sort(ids.begin(), ids.end());
+            for (uint32_t id : ids) {
+                std::shared_ptr<Object> o = objects.value(id);
+                FeatureTable::Features f = features.get(id);
+                ret.append(row({QByteArray::number(frame->getID()),
+                                QByteArray::number(s->getSliceId()),
+                                QByteArray::number(chanId),
+                                QByteArray::number(id),
+                                o->isInTracklet() ? QByteArray::number(o->getTrackId()) : QByteArray(),
+                                o->isInAutoTracklet() ? QByteArray::number(o->getAutoId()) : QByteArray(),
+                                QByteArray::number(f.centroid.x(), 'g', 10),
+                                QByteArray::number(f.centroid.y(), 'g', 10),
+                                QByteArray::number(f.area, 'g', 10),
+                                QByteArray::number(f.perimeter, 'g', 10),
+                                QByteArray::number(f.orientation, 'g', 10),
+                                QByteArray::number(f.boundingBox.x(), 'g', 10),
+                                QByteArray::number(f.boundingBox.y(), 'g', 10),
+                                QByteArray::number(f.boundingBox.width(), 'g', 10),
+                                QByteArray::number(f.boundingBox.height(), 'g', 10)}));
+            }
+        }
+    }
+    return ret;
+}
+
+void ExportCSV::saveObjects(std::shared_ptr<Project> const &proj, QString const &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw TCExportException("Could not open " + fileName.toStdString() + ": " + file.errorString().toStdString());
+
+    QByteArray header = row({"frame", "slice", "channel", "object", "tracklet", "autotracklet",
+                             "centroid_x", "centroid_y", "area", "perimeter", "orientation",
+                             "bbox_x", "bbox_y", "bbox_width", "bbox_height"});
+    if (file.write(header) != header.size())
+        throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+    streamFrames(sortedFrames(proj), [this](std::shared_ptr<Frame> const &f) { return encodeFrame(f); }, &file);
+}
+
+void ExportCSV::saveTracklets(std::shared_ptr<Project> const &proj, QString const &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw TCExportException("Could not open " + fileName.toStdString() + ": " + file.errorString().toStdString());
+
+    std::shared_ptr<QHash<int,std::shared_ptr<Tracklet>>> tracklets = proj->getGenealogy()->getTracklets();
+    QList<int> ids = tracklets->keys();
+    std::sort(ids.begin(), ids.end());
+    MessageRelay::emitUpdateDetailMax(ids.size());
+
+    /* write a few thousand rows at a time, so the table is never held as a whole */
+    QByteArray buf = row({"tracklet", "start", "end", "objects", "previous_event", "previous", "next_event", "next"});
+    for (int i = 0; i < ids.size(); i++) {
+        std::shared_ptr<Tracklet> t = tracklets->value(ids[i]);
+        QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> start = t->getStart();
+        QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> end = t->getEnd();
+        buf.append(row({QByteArray::number(t->getId()),
+                        start.first ? QByteArray::number(start.first->getID()) : QByteArray(),
+                        end.first ? QByteArray::number(end.first->getID()) : QByteArray(),
+                        QByteArray::number(t->getContained().size()),
+                        eventName(t->getPrev()),
+                        joinIds(previousTracklets(t)),
+                        eventName(t->getNext()),
+                        joinIds(nextTracklets(t))}));
+        MessageRelay::emitIncreaseDetail();
+        if (buf.size() >= (1 << 16)) {
+            if (file.write(buf) != buf.size())
+                throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+            buf.clear();
+        }
+    }
+    if (!buf.isEmpty() && file.write(buf) != buf.size())
+        throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+}
+
+/*!
+ * \brief returns the name of a TrackEvent as it is used in the HDF5 file
+ * \param ev the TrackEvent, may be nullptr
+ * \return the name or "open" if there is no TrackEvent
+ */
+QByteArray ExportCSV::eventName(std::shared_ptr<TrackEvent<Tracklet>> const &ev)
+{
+    if (!ev)
+        return "open";
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:   return "cell_division";
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:      return "cell_merge";
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:    return "cell_unmerge";
+    case TrackEvent<Tracklet>::EVENT_TYPE_LOST:       return "cell_lost";
+    case TrackEvent<Tracklet>::EVENT_TYPE_DEAD:       return "cell_death";
+    case TrackEvent<Tracklet>::EVENT_TYPE_ENDOFMOVIE: return "end_of_movie";
+    }
+    return QByteArray();
+}
+
+/* lists of ids are separated by ';', so they stay in one field */
+QByteArray ExportCSV::joinIds(QList<int> const &ids)
+{
+    QByteArray ret;
+    for (int i = 0; i < ids.size(); i++) {
+        if (i > 0)
+            ret.append(';');
+        ret.append(QByteArray::number(ids[i]));
+    }
+    return ret;
+}
+
+}
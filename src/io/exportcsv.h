@@ -0,0 +1,71 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EXPORTCSV_H
+#define EXPORTCSV_H
+
+#include "export.h"
+
+#include <memory>
+
+#include <QByteArray>
+#include <QChar>
+#include <QString>
+
+#include "project.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief The ExportCSV class
+ *
+ * Writes the Object%s and Tracklet%s of a Project as tables for analysis
+ * tools, either comma separated (.csv) or tab separated (.tsv). save() takes
+ * a directory and creates two files in it:
+ *
+ * - objects.csv: one row per Object with its ids, the Tracklet and
+ *   AutoTracklet it belongs to and its features from the FeatureTable.
+ * - tracklets.csv: one row per Tracklet with its first and last Frame, the
+ *   TrackEvent%s before and after it and the Tracklet%s they connect to,
+ *   which is the lineage of the Tracklet.
+ *
+ * The rows of the Object%s are encoded frame by frame (see Export::streamFrames),
+ * empty fields mean that an Object is not part of a (Auto)Tracklet.
+ */
+class ExportCSV : public Export
+{
+public:
+    explicit ExportCSV(QChar separator = ',');
+    ~ExportCSV() = default;
+
+    bool save(std::shared_ptr<Project>, QString);
+
+private:
+    QByteArray row(QList<QByteArray> const &fields) const;
+    QByteArray encodeFrame(std::shared_ptr<Frame> const &frame) const;
+    void saveObjects(std::shared_ptr<Project> const &proj, QString const &fileName) const;
+    void saveTracklets(std::shared_ptr<Project> const &proj, QString const &fileName) const;
+
+    static QByteArray eventName(std::shared_ptr<TrackEvent<Tracklet>> const &ev);
+    static QByteArray joinIds(QList<int> const &ids);
+
+    char sep;
+};
+
+}
+
+#endif // EXPORTCSV_H
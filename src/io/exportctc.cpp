@@ -0,0 +1,297 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "exportctc.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+
+#include "base/frame.h"
+#include "base/slice.h"
+#include "exceptions/tcexportexception.h"
+#include "io/tiffio.h"
+#include "provider/messagerelay.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief constructor for ExportCTC
+ * \param slice_ the Slice to export
+ * \param channel_ the Channel to export
+ */
+ExportCTC::ExportCTC(uint32_t slice_, uint32_t channel_) :
+    slice(slice_),
+    channel(channel_)
+{
+}
+
+/*!
+ * \brief writes the masks and the track file of a Project to a directory
+ * \param project the Project to export
+ * \param dirName the directory, it is created if it does not exist
+ * \return true if saving was successful
+ */
+bool ExportCTC::save(std::shared_ptr<Project> project, QString dirName)
+{
+    TC_TRACE_SCOPE("ExportCTC::save");
+    if (!QDir().mkpath(dirName))
+        throw TCExportException("Could not create the directory " + dirName.toStdString());
+    QDir dir(dirName);
+
+    MessageRelay::emitUpdateOverallName("Exporting to the Cell Tracking Challenge format");
+    MessageRelay::emitUpdateOverallMax(2);
+
+    qDebug() << "Saving tracks";
+    MessageRelay::emitUpdateDetailName("Saving tracks");
+    Labels labels = saveTracks(project, dir.filePath("res_track.txt"));
+    MessageRelay::emitIncreaseOverall();
+
+    qDebug() << "Saving masks";
+    MessageRelay::emitUpdateDetailName("Saving masks");
+    QList<std::shared_ptr<Frame>> frames = sortedFrames(project);
+    QSize size = imageSize(project);
+    int digits = (!frames.isEmpty() && frames.last()->getID() >= 1000) ? 4 : 3;
+    streamFrames(frames, [&](std::shared_ptr<Frame> const &f) {
+        QString name = QString("mask%1.tif").arg(f->getID(), digits, 10, QChar('0'));
+        return saveMask(f, dir.filePath(name), size, labels);
+    }, nullptr);
+    MessageRelay::emitIncreaseOverall();
+
+    qDebug() << "Finished";
+    return true;
+}
+
+/*!
+ * \brief returns the size of the images, from the CoordinateSystemInfo or else from the outlines
+ * \param proj the Project
+ * \return the size of the masks
+ */
+QSize ExportCTC::imageSize(std::shared_ptr<Project> const &proj) const
+{
+    std::shared_ptr<Project::CoordinateSystemInfo> csi = proj->getCoordinateSystemInfo();
+    if (csi) {
+        Project::CoordinateSystemInfo::CoordinateSystemData csd = csi->getCoordinateSystemData();
+        if (csd.imageWidth > 0 && csd.imageHeight > 0)
+            return QSize(static_cast<int>(csd.imageWidth), static_cast<int>(csd.imageHeight));
+    }
+
+    QRectF bounds(0, 0, 1, 1);
+    for (std::shared_ptr<Frame> const &f : proj->getMovie()->getFrames()) {
+        std::shared_ptr<Slice> s = f->getSlice(static_cast<int>(slice));
+        std::shared_ptr<Channel> ch = s ? s->getChannel(channel) : nullptr;
+        if (!ch)
+            continue;
+        for (std::shared_ptr<Object> const &o : ch->getObjects())
+            if (o->getOutline())
+                bounds = bounds.united(o->getOutline()->boundingRect());
+    }
+    return QSize(static_cast<int>(std::ceil(bounds.right())) + 1, static_cast<int>(std::ceil(bounds.bottom())) + 1);
+}
+
+/*!
+ * \brief writes res_track.txt
+ * \param proj the Project
+ * \param fileName the name of the file
+ * \return the labels of the Tracklet%s, see ExportCTC::Labels
+ *
+ * A track of the format has no gaps, so a Tracklet that skips Frame%s is
+ * split into one track per run of consecutive Frame%s. The first run keeps
+ * the label id + 1, the later runs get labels after the largest Tracklet id
+ * and the run before the gap as their parent.
+ */
+ExportCTC::Labels ExportCTC::saveTracks(std::shared_ptr<Project> const &proj, QString const &fileName) const
+{
+    struct Run { int begin; int end; uint16_t label; };
+    struct Track { QList<Run> runs; QList<int> parents; std::shared_ptr<TrackEvent<Tracklet>> prev; };
+
+    /* only the Tracklets with Objects in the exported Channel are tracks */
+    QMap<int, Track> tracks;
+    std::vector<int> frames;
+    int maxId = -1;
+    for (std::shared_ptr<Tracklet> const &t : *proj->getGenealogy()->getTracklets()) {
+        frames.clear();
+        for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &p : t->getContained())
+            if (p.second->getSliceId() == slice && p.second->getChannelId() == channel)
+                frames.push_back(static_cast<int>(p.first->getID()));
+        if (frames.empty())
+            continue;
+        std::sort(frames.begin(), frames.end());
+
+        Track tr {{}, previousTracklets(t), t->getPrev()};
+        for (int f : frames) {
+            if (!tr.runs.isEmpty() && f <= tr.runs.last().end + 1)
+                tr.runs.last().end = f;
+            else
+                tr.runs.append({f, f, 0});
+        }
+        tracks.insert(t->getId(), tr);
+        maxId = std::max(maxId, t->getId());
+    }
+
+    Labels labels;
+    int next = maxId + 2;
+    for (auto it = tracks.begin(); it != tracks.end(); ++it) {
+        QList<Run> &runs = it.value().runs;
+        for (int i = 0; i < runs.size(); i++) {
+            int label = (i == 0) ? it.key() + 1 : next++;
+            if (label > UINT16_MAX)
+                throw TCExportException("Tracklet " + std::to_string(it.key()) + " has no label in a 16 bit mask");
+            runs[i].label = static_cast<uint16_t>(label);
+            labels[it.key()].insert(runs[i].begin, runs[i].label);
+        }
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw TCExportException("Could not open " + fileName.toStdString() + ": " + file.errorString().toStdString());
+
+    MessageRelay::emitUpdateDetailMax(tracks.size());
+    QByteArray buf;
+    for (auto it = tracks.begin(); it != tracks.end(); ++it) {
+        Track const &tr = it.value();
+        /* daughters emerge from the last run of their mother */
+        int parent = 0;
+        bool split = tr.prev && (tr.prev->getType() == TrackEvent<Tracklet>::EVENT_TYPE_DIVISION
+                                 || tr.prev->getType() == TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE);
+        if (split && tr.parents.size() == 1 && tracks.contains(tr.parents.first()))
+            parent = tracks.constFind(tr.parents.first())->runs.last().label;
+        for (Run const &r : tr.runs) {
+            buf.append(QByteArray::number(r.label)).append(' ')
+                    .append(QByteArray::number(r.begin)).append(' ')
+                    .append(QByteArray::number(r.end)).append(' ')
+                    .append(QByteArray::number(parent)).append('\n');
+            parent = r.label;
+        }
+        MessageRelay::emitIncreaseDetail();
+        if (buf.size() >= (1 << 16)) {
+            if (file.write(buf) != buf.size())
+                throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+            buf.clear();
+        }
+    }
+    if (!buf.isEmpty() && file.write(buf) != buf.size())
+        throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+
+    return labels;
+}
+
+/*!
+ * \brief rasterizes the tracked Object%s of a Frame and writes the mask
+ * \param frame the Frame
+ * \param fileName the name of the mask
+ * \param size the size of the mask
+ * \param labels the labels of the Tracklet%s as returned by saveTracks()
+ * \return an empty QByteArray, the mask is written by this function
+ *
+ * Called concurrently for different Frame%s.
+ */
+QByteArray ExportCTC::saveMask(std::shared_ptr<Frame> const &frame, QString const &fileName, QSize const &size, Labels const &labels) const
+{
+    TC_TRACE_SCOPE("ExportCTC::saveMask");
+    RawImage mask(size.width(), size.height(), 1, 16);
+    std::fill_n(mask.bits(), mask.byteCount(), 0);
+
+    std::shared_ptr<Slice> s = frame->getSlice(static_cast<int>(slice));
+    std::shared_ptr<Channel> ch = s ? s->getChannel(channel) : nullptr;
+    if (ch) {
+        int f = static_cast<int>(frame->getID());
+        QHash<uint32_t,std::shared_ptr<Object>> objects = ch->getObjects();
+        QList<uint32_t> ids = objects.keys();
+        std::sort(ids.begin(), ids.end());
+        for (uint32_t id : ids) {
+            std::shared_ptr<Object> o = objects.value(id);
+            if (!o->isInTracklet() || !o->getOutline())
+                continue;
+            /* the run of the Tracklet that contains this Frame is the last one starting at or before it */
+            auto runs = labels.find(static_cast<int>(o->getTrackId()));
+            if (runs == labels.end())
+                continue;
+            auto run = runs->upperBound(f);
+            if (run == runs->begin())
+                continue;
+            rasterize(mask, *o->getOutline(), (--run).value());
+        }
+    }
+
+    TiffIO::write(fileName, mask);
+    return QByteArray();
+}
+
+/*!
+ * \brief sets the pixels covered by an outline to a label
+ * \param labels a RawImage with one 16 bit sample per pixel
+ * \param outline the outline, its points are the centers of the border pixels (as traced by the BorderTracer)
+ * \param label the label
+ *
+ * The interior is filled scanline by scanline (even-odd rule, sampled at the
+ * pixel centers), then the outline itself is drawn, so the border pixels and
+ * parts that are only one pixel wide are set as well.
+ */
+void ExportCTC::rasterize(RawImage &labels, QPolygonF const &outline, uint16_t label)
+{
+    int w = labels.width();
+    int h = labels.height();
+    uint16_t *px = reinterpret_cast<uint16_t*>(labels.bits());
+    int n = outline.size();
+    if (n > 1 && outline.isClosed())
+        n--;
+    if (n <= 0)
+        return;
+
+    QRectF br = outline.boundingRect();
+    int top = std::max(0, static_cast<int>(std::ceil(br.top())));
+    int bottom = std::min(h - 1, static_cast<int>(std::floor(br.bottom())));
+    std::vector<double> xs;
+    for (int y = top; y <= bottom; y++) {
+        xs.clear();
+        for (int i = 0; i < n; i++) {
+            QPointF a = outline[i];
+            QPointF b = outline[(i + 1) % n];
+            if ((a.y() <= y && b.y() > y) || (b.y() <= y && a.y() > y))
+                xs.push_back(a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y()));
+        }
+        std::sort(xs.begin(), xs.end());
+        for (size_t i = 0; i + 1 < xs.size(); i += 2) {
+            int from = std::max(0, static_cast<int>(std::ceil(xs[i])));
+            int to = std::min(w - 1, static_cast<int>(std::floor(xs[i + 1])));
+            std::fill(px + y * w + from, px + y * w + std::max(from, to + 1), label);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        QPointF a = outline[i];
+        QPointF d = outline[(i + 1) % n] - a;
+        int steps = static_cast<int>(std::ceil(std::max(std::abs(d.x()), std::abs(d.y()))));
+        for (int j = 0; j <= steps; j++) {
+            QPointF p = steps ? a + d * (static_cast<double>(j) / steps) : a;
+            int x = static_cast<int>(std::lround(p.x()));
+            int y = static_cast<int>(std::lround(p.y()));
+            if (x >= 0 && x < w && y >= 0 && y < h)
+                px[y * w + x] = label;
+        }
+    }
+}
+
+}
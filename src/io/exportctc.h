@@ -0,0 +1,84 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EXPORTCTC_H
+#define EXPORTCTC_H
+
+#include "export.h"
+
+#include <cstdint>
+#include <memory>
+
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QPolygonF>
+#include <QSize>
+#include <QString>
+
+#include "base/rawimage.h"
+#include "project.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief The ExportCTC class
+ *
+ * Writes the Tracklet%s of one Slice and Channel in the result format of the
+ * Cell Tracking Challenge. save() takes a directory and creates in it
+ *
+ * - maskT.tif for every Frame T (three digits, four for movies with 1000
+ *   Frame%s or more): a 16 bit label image in which the pixels of each
+ *   tracked Object have the label of its Tracklet, the background is 0.
+ * - res_track.txt: one line "L B E P" per track with its label L, its
+ *   first and last Frame B and E and the label P of the track it emerged
+ *   from by a division or an unmerge (0 if there is none).
+ *
+ * The label of a Tracklet is its id + 1. A Tracklet with gaps is written as
+ * one track per run of consecutive Frame%s, each run after a gap gets a new
+ * label and the run before the gap as its parent. Object%s that are not part of a
+ * Tracklet are left out, as the format requires every label to be a track.
+ * Merges can not be expressed, the merged Tracklet gets no parent.
+ *
+ * The outlines are rasterized frame by frame on the global QThreadPool, only
+ * the masks that are being drawn are held in memory.
+ */
+class ExportCTC : public Export
+{
+public:
+    explicit ExportCTC(uint32_t slice = 0, uint32_t channel = 0);
+    ~ExportCTC() = default;
+
+    bool save(std::shared_ptr<Project>, QString);
+
+    static void rasterize(RawImage &labels, QPolygonF const &outline, uint16_t label);
+
+private:
+    /*! \brief for each Tracklet id the first Frame of each of its runs and the label of the run */
+    typedef QHash<int, QMap<int, uint16_t>> Labels;
+
+    QSize imageSize(std::shared_ptr<Project> const &proj) const;
+    Labels saveTracks(std::shared_ptr<Project> const &proj, QString const &fileName) const;
+    QByteArray saveMask(std::shared_ptr<Frame> const &frame, QString const &fileName, QSize const &size, Labels const &labels) const;
+
+    uint32_t slice;
+    uint32_t channel;
+};
+
+}
+
+#endif // EXPORTCTC_H
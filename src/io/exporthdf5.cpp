@@ -17,8 +17,10 @@
  */
 #include "exporthdf5.h"
 
+#include <algorithm>
 #include <list>
 #include <set>
+#include <vector>
 #include <H5Cpp.h>
 #include <QDebug>
 #include <QFile>
@@ -38,6 +40,7 @@
 #include "provider/tcsettings.h"
 #include "provider/guistate.h"
 #include "provider/messagerelay.h"
+#include "provider/tracer.h"
 #include "io/importxml.h"
 
 #define TC_DEBUG std::cerr << "Debug statement at " << __FILE__ << ":" << __LINE__ << std::endl;
@@ -207,11 +210,15 @@ bool ExportHDF5::save(std::shared_ptr<Project> project, QString filename, Export
     bool sObjects = so.objects;
     bool sTracklets = so.tracklets;
 
+    TC_TRACE_SCOPE("ExportHDF5::save");
+    /* held for the whole save, but the phases let waiting threads go first after each step (see yieldHDF5()) */
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+
     /* sanity check options */
     sanityCheckOptions(project, filename, so);
 
     try {
-        H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR|H5F_ACC_CREAT, H5P_FILE_CREATE);
+        H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR|H5F_ACC_CREAT, H5P_FILE_CREATE, writeAccess());
 
         /* for a description see ImportHDF5::load */
         struct phase {
@@ -234,10 +241,14 @@ bool ExportHDF5::save(std::shared_ptr<Project> project, QString filename, Export
         qDebug() << "Saving to HDF5";
         for (phase p : phases) {
             std::string text = "Saving " + p.name;
+            TC_TRACE_SCOPE(Tracer::intern(QString::fromStdString(text)));
             qDebug() << text.c_str();
             MessageRelay::emitUpdateDetailName(QString::fromStdString(text));
             if (!p.functionPrt(file, project))
                 throw TCExportException(text + " failed");
+            /* readers that open the file between two phases find it consistent */
+            file.flush(H5F_SCOPE_GLOBAL);
+            yieldHDF5();
             MessageRelay::emitIncreaseOverall();
         }
 
@@ -250,6 +261,17 @@ bool ExportHDF5::save(std::shared_ptr<Project> project, QString filename, Export
     return true;
 }
 
+/*!
+ * \brief returns the access properties for opening a file to write to
+ *
+ * With hdf5/swmr, files are written in the latest file format, so SWMR readers
+ * (see ImportHDF5::setSwmrRead) can open them.
+ * \return the access properties
+ */
+H5::FileAccPropList ExportHDF5::writeAccess() {
+    return fileAccess(TCSettings::value("hdf5/swmr").toBool());
+}
+
 bool ExportHDF5::hasBackingHDF5(std::shared_ptr<Project> const &proj) {
     QFileInfo qfi(proj->getFileName()); /* Scoping, so QFileInfo is destroyed early */
     if (qfi.isFile() && qfi.isReadable() && H5File::isHdf5(proj->getFileName().toStdString()))
@@ -262,7 +284,7 @@ bool ExportHDF5::saveObjects(H5File file, std::shared_ptr<Project> proj) {
     H5File oldFile;
     bool hasFile = hasBackingHDF5(proj);
     if (hasFile)
-        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE);
+        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE, writeAccess());
 
     std::shared_ptr<Movie> mov = proj->getMovie();
     Group oldObjectsGroup;
@@ -389,6 +411,7 @@ bool ExportHDF5::saveObjects(H5File file, std::shared_ptr<Project> proj) {
         }
 
         MessageRelay::emitIncreaseDetail();
+        yieldHDF5();
     }
 
     return true;
@@ -398,7 +421,7 @@ bool ExportHDF5::saveInfo(H5File file, std::shared_ptr<Project> proj) {
     H5File oldFile;
     bool hasFile = hasBackingHDF5(proj);
     if (hasFile)
-        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE);
+        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE, writeAccess());
 
     MessageRelay::emitUpdateDetailMax(4);
 
@@ -534,7 +557,7 @@ bool ExportHDF5::saveImages(H5File file, std::shared_ptr<Project> proj) {
     H5File oldFile;
     bool hasFile = hasBackingHDF5(proj);
     if (hasFile)
-        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE);
+        oldFile = H5File(proj->getFileName().toStdString().c_str(), H5F_ACC_RDWR, H5P_FILE_CREATE, writeAccess());
     if (!proj)
         return false;
 
@@ -641,12 +664,14 @@ bool ExportHDF5::saveImages(H5File file, std::shared_ptr<Project> proj) {
             }
         }
         MessageRelay::emitIncreaseDetail();
+        yieldHDF5();
     }
     return true;
 }
 
 bool ExportHDF5::saveAutoTracklets(H5File file, std::shared_ptr<Project> proj) {
     Group autoTrackletsGroup = clearOrCreateGroup(file, "autotracklets", proj->getAutoTracklets().count());
+    bool objectLinks = TCSettings::value("export/object_links").toBool();
 
     MessageRelay::emitUpdateDetailMax(proj->getAutoTracklets().count());
     for (std::shared_ptr<AutoTracklet> autotracklet : proj->getAutoTracklets()) {
@@ -655,29 +680,27 @@ bool ExportHDF5::saveAutoTracklets(H5File file, std::shared_ptr<Project> proj) {
         uint32_t end = autotracklet->getEnd();
 
         /*! \todo clearOrCreateGroup() */
-        Group autoTrackletGroup = autoTrackletsGroup.createGroup(std::to_string(autotrackletId), 3); /* id, start, end, objects */
+        Group autoTrackletGroup = autoTrackletsGroup.createGroup(std::to_string(autotrackletId), 5); /* id, start, end, members, objects */
         /* {next,previous}_{,event} are written in saveEvents */
 
         writeSingleValue<uint32_t>(autotrackletId, autoTrackletGroup, "autotracklet_id", PredType::NATIVE_UINT32);
         writeSingleValue<uint32_t>(start, autoTrackletGroup, "start", PredType::NATIVE_UINT32);
         writeSingleValue<uint32_t>(end, autoTrackletGroup, "end", PredType::NATIVE_UINT32);
 
-        /*! \todo clearOrCreateGroup() */
-        Group objectsGroup = autoTrackletGroup.createGroup("objects", autotracklet->getComponents().count());
-        for (std::shared_ptr<Object> object : autotracklet->getComponents()) {
-            uint32_t frameId = object->getFrameId();
-            uint32_t sliceId = object->getSliceId();
-            uint32_t channId = object->getChannelId();
-            uint32_t objectId = object->getId();
-
-            std::string objectPath = "/objects/frames/" + std::to_string(frameId) +
-                                     "/slices/" + std::to_string(sliceId) +
-                                     "/channels/" + std::to_string(channId) +
-                                     "/objects/" + std::to_string(objectId);
-
-            linkOrOverwriteLink(H5L_TYPE_SOFT, objectsGroup, objectPath, std::to_string(frameId));
+        std::vector<MemberRow> members;
+        members.reserve(autotracklet->getComponents().count());
+        for (std::shared_ptr<Object> object : autotracklet->getComponents())
+            members.push_back(memberRow(object));
+        writeMembers(members, autoTrackletGroup);
+
+        if (objectLinks) {
+            /*! \todo clearOrCreateGroup() */
+            Group objectsGroup = autoTrackletGroup.createGroup("objects", members.size());
+            for (MemberRow const &m : members)
+                linkOrOverwriteLink(H5L_TYPE_SOFT, objectsGroup, memberPath(m), std::to_string(m[0]));
         }
         MessageRelay::emitIncreaseDetail();
+        yieldHDF5();
     }
 
     return true;
@@ -811,44 +834,47 @@ bool ExportHDF5::saveEvents(H5File file, std::shared_ptr<Project> proj) {
             }
         }
         MessageRelay::emitIncreaseDetail();
+        yieldHDF5();
     }
     return true;
 }
 
 /*!
- * \brief when saving a Tracklet, this creates the links in the /tracklets/\<id\>/objects group
- * \param file the file to save to
+ * \brief returns the path of the Object in a row of a membership table
+ * \param m the row (frame, slice, channel, object)
+ * \return the path of the Object
+ */
+std::string ExportHDF5::memberPath(MemberRow const &m) {
+    return "/objects/frames/" + std::to_string(m[0])
+            + "/slices/" + std::to_string(m[1])
+            + "/channels/" + std::to_string(m[2])
+            + "/objects/" + std::to_string(m[3]);
+}
+
+/*!
+ * \brief when saving a Tracklet, this writes the /tracklets/\<id\>/members table
+ * and, if export/object_links is set, the links in the /tracklets/\<id\>/objects group
  * \param grp the group of the Tracklet
  * \param t the Tracklet, whose contained Objects should be saved
+ * \param objectLinks whether the links should be written
  * \return true if saving was successful, false otherwise
  */
-bool ExportHDF5::saveTrackletsContained(H5File file, Group grp, std::shared_ptr<Tracklet> t) {
-    Group containedGroup = grp.createGroup("objects");
+bool ExportHDF5::saveTrackletsContained(Group grp, std::shared_ptr<Tracklet> t, bool objectLinks) {
     QHash<uint,QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>>> contained = t->getContained();
 
-    /* sort the tracklets */
-    QList<QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>>> ps = contained.values();
-    qSort(ps.begin(), ps.end(),
-          [](const QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> a, const QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> b) -> bool {
-        return (a.first->getID() != b.first->getID())?
-                    (a.first->getID() > b.first->getID()):
-                    (a.second->getId() > b.second->getId());
-    });
-
-    /* write objects of this tracklet */
-    for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> pair : ps) {
-        uint32_t fId = pair.first->getID();
-        uint32_t oId = pair.second->getId();
-        uint32_t sId = pair.second->getSliceId();
-        uint32_t cId = pair.second->getChannelId();
-
-        std::string target = "/objects/frames/"+std::to_string(fId)
-                +"/slices/"+std::to_string(sId)
-                +"/channels/"+std::to_string(cId)
-                +"/objects/"+std::to_string(oId);
-        if(!linkExists(file, target.c_str()))
-            qDebug() << target.c_str() << "does not exist";
-        linkOrOverwriteLink(H5L_TYPE_SOFT, containedGroup, target, std::to_string(fId));
+    /* sort the objects by frame */
+    std::vector<MemberRow> members;
+    members.reserve(contained.size());
+    for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &pair : contained)
+        members.push_back({{pair.first->getID(), pair.second->getSliceId(), pair.second->getChannelId(), pair.second->getId()}});
+    std::sort(members.begin(), members.end());
+
+    writeMembers(members, grp);
+
+    if (objectLinks) {
+        Group containedGroup = grp.createGroup("objects", members.size());
+        for (MemberRow const &m : members)
+            linkOrOverwriteLink(H5L_TYPE_SOFT, containedGroup, memberPath(m), std::to_string(m[0]));
     }
     return true;
 }
@@ -975,6 +1001,7 @@ bool ExportHDF5::saveTracklets(H5File file, std::shared_ptr<Project> project)
 {
     std::shared_ptr<QHash<int,std::shared_ptr<Tracklet>>> tracklets = project->getGenealogy()->getTracklets();
     Group trackletsGroup = clearOrCreateGroup(file, "/tracklets", tracklets->size());
+    bool objectLinks = TCSettings::value("export/object_links").toBool();
 
     MessageRelay::emitUpdateDetailName("Saving tracklets");
     MessageRelay::emitUpdateDetailMax(tracklets->size());
@@ -986,7 +1013,7 @@ bool ExportHDF5::saveTracklets(H5File file, std::shared_ptr<Project> project)
         bool hasPreviousEvent = (t->getPrev() != nullptr);
 
         int size = 1                            /* tracklet_id */
-                 + ((hasContained)?3:0)         /* start, end, contained */
+                 + ((hasContained)?4:0)         /* start, end, members, contained */
                  + ((hasAnnotations)?1:0)       /* annotations-Group */
                  + ((hasNextEvent)?2:0)         /* next_event + next-Group */
                  + ((hasPreviousEvent)?2:0);    /* previous_event + previous-Group */
@@ -1000,8 +1027,8 @@ bool ExportHDF5::saveTracklets(H5File file, std::shared_ptr<Project> project)
             writeSingleValue<uint32_t>(t->getStart().first->getID(), trackletGroup, "start", PredType::NATIVE_UINT32);
             writeSingleValue<uint32_t>(t->getEnd().first->getID(), trackletGroup, "end", PredType::NATIVE_UINT32);
 
-            /* write the links to the objects contained by this tracklet */
-            saveTrackletsContained(file, trackletGroup, t);
+            /* write the objects contained by this tracklet */
+            saveTrackletsContained(trackletGroup, t, objectLinks);
         }
 
 //        /* write the links to the next_event, create next-Group and fill it with links to tracklets, if it has a next event */
@@ -1014,6 +1041,7 @@ bool ExportHDF5::saveTracklets(H5File file, std::shared_ptr<Project> project)
 
 
         MessageRelay::emitIncreaseDetail();
+        yieldHDF5();
     }
     return true;
 }
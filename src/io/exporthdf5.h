@@ -47,6 +47,8 @@ public:
     static bool sanityCheckOptions(std::shared_ptr<Project>, QString, SaveOptions &);
 
     static bool saveObject(H5::H5File file, std::shared_ptr<Project> proj, std::shared_ptr<Object> obj);
+    static H5::FileAccPropList writeAccess();
+    static std::string memberPath(MemberRow const &m);
 
 private:
     static bool saveObjects(H5::H5File file, std::shared_ptr<Project> proj);
@@ -57,7 +59,7 @@ private:
     static bool saveTracklets(H5::H5File file, std::shared_ptr<Project> project);
     static bool saveAnnotation(H5::Group grp, std::shared_ptr<Annotation> a);
     static bool saveAnnotations(H5::H5File file, std::shared_ptr<Project> project);
-    static bool saveTrackletsContained(H5::H5File file, H5::Group grp, std::shared_ptr<Tracklet> t);
+    static bool saveTrackletsContained(H5::Group grp, std::shared_ptr<Tracklet> t, bool objectLinks);
     static bool saveTrackletsNextEvent(H5::Group grp, std::shared_ptr<Tracklet> t);
     static bool saveTrackletsPreviousEvent(H5::Group grp, std::shared_ptr<Tracklet> t);
 
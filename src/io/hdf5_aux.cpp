@@ -16,11 +16,15 @@
  * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "hdf5_aux.h"
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <thread>
 
 namespace H5 {
-static void *HDF5_ERROR_CLIENT_DATA;
-static H5E_auto2_t HDF5_ERROR_FUNC;
+/* a thread-safe HDF5 library keeps the error handler per thread, so do we */
+static thread_local void *HDF5_ERROR_CLIENT_DATA;
+static thread_local H5E_auto2_t HDF5_ERROR_FUNC;
 
 /*!
  * \brief disables all HDF5 error-printing
@@ -193,6 +197,105 @@ hsize_t getGroupSize(hid_t gid, const char *name) {
 
 }
 
+/*!
+ * \brief tells whether the HDF5 library supports single-writer/multiple-reader access
+ * \return true for HDF5 1.10 and later
+ */
+bool swmrSupported() {
+#if H5_VERSION_GE(1,10,0)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief returns the access properties for opening a file to write to
+ * \param latestFormat use the latest file format, which SWMR readers need. Such
+ * files can not be read by HDF5 1.8 anymore. Ignored if swmrSupported() is false.
+ * \return the access properties
+ */
+H5::FileAccPropList fileAccess(bool latestFormat) {
+    H5::FileAccPropList fapl;
+#if H5_VERSION_GE(1,10,0)
+    if (latestFormat)
+        fapl.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+#else
+    (void) latestFormat;
+#endif
+    return fapl;
+}
+
+/*!
+ * \brief returns the flags for opening a file to read from
+ * \param swmr open the file as SWMR reader, so it can be read while it is written
+ * to. Ignored if swmrSupported() is false.
+ * \return the flags
+ */
+unsigned readFlags(bool swmr) {
+#if H5_VERSION_GE(1,10,0)
+    if (swmr)
+        return H5F_ACC_RDONLY | H5F_ACC_SWMR_READ;
+#else
+    (void) swmr;
+#endif
+    return H5F_ACC_RDONLY;
+}
+
+namespace {
+std::recursive_mutex hdf5Mutex;
+std::atomic<int> hdf5Waiting(0);   /* the threads that wait for hdf5Mutex */
+}
+
+/*!
+ * \brief locks the HDF5 library for the calling thread
+ * \return the lock, it is held until it is destroyed
+ *
+ * The HDF5 library is usually not built thread-safe, but it is used from
+ * several threads: loading and saving in the background, ModifyHDF5 on the
+ * GUI thread, the prefetching and thumbnails of the ImageCache, the
+ * resegmentation workers and the import of label images. Each of them holds
+ * this lock while it has files or other HDF5 objects open. The lock is
+ * recursive, so these functions may call each other. Long writes let the
+ * waiting threads go first from time to time, see yieldHDF5().
+ *
+ * A thread-safe HDF5 library (H5_HAVE_THREADSAFE) serializes the calls
+ * itself, then the returned lock is not locked.
+ */
+std::unique_lock<std::recursive_mutex> lockHDF5() {
+#ifdef H5_HAVE_THREADSAFE
+    return std::unique_lock<std::recursive_mutex>(hdf5Mutex, std::defer_lock);
+#else
+    std::unique_lock<std::recursive_mutex> lock(hdf5Mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        hdf5Waiting++;
+        lock.lock();
+        hdf5Waiting--;
+    }
+    return lock;
+#endif
+}
+
+/*!
+ * \brief lets the threads that wait for lockHDF5() go first
+ *
+ * Long writes (ExportHDF5) call it between two steps, while they make no call
+ * into the HDF5 library, so others wait for one step instead of the whole
+ * save. The files and objects the calling thread has open stay valid. Has to
+ * be called by a thread that holds lockHDF5() exactly once, otherwise the
+ * lock is not released and the call only takes a few milliseconds.
+ */
+void yieldHDF5() {
+#ifndef H5_HAVE_THREADSAFE
+    if (hdf5Waiting == 0)
+        return;
+    hdf5Mutex.unlock();
+    for (int i = 0; i < 50 && hdf5Waiting > 0; i++)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    hdf5Mutex.lock();
+#endif
+}
+
 /*!
  * \brief opens or, if it does not yet exist, creates a H5::DataSet
  * \param cfg where to place the H5::DataSet (either H5::H5File or H5::Group)
@@ -456,6 +559,8 @@ std::string hdfSearch(H5::H5File file, std::shared_ptr<TraCurate::Tracklet> trac
 
     if (linkExists(file, trackletPath)) {
         Group trackletGroup = file.openGroup(trackletPath);
+        if (!groupExists(trackletGroup, "objects")) /* the soft links are optional */
+            return "";
         Group objectsGroup = trackletGroup.openGroup("objects");
 
         std::list<std::string> names = collectGroupElementNames(objectsGroup);
@@ -476,6 +581,8 @@ std::string hdfSearch(H5::H5File file, std::shared_ptr<TraCurate::AutoTracklet>
     std::string atPath = hdfPath(at);
 
     Group atGroup = file.openGroup(atPath);
+    if (!groupExists(atGroup, "objects")) /* the soft links are optional */
+        return "";
     Group objectsGroup = atGroup.openGroup("objects");
 
     std::list<std::string> names = collectGroupElementNames(objectsGroup);
@@ -513,6 +620,57 @@ Group clearOrCreateGroup(CommonFG &cfg, std::string name, size_t size)
     return clearOrCreateGroup(cfg, name.c_str(), size);
 }
 
+/*!
+ * \brief reads the membership table of a Tracklet or AutoTracklet
+ * \param group the group of the Tracklet or AutoTracklet
+ * \param name the name of the table
+ * \return the rows of the table
+ * \throw H5::DataSetIException if the table does not have four columns
+ */
+std::vector<MemberRow> readMembers(H5::CommonFG &group, const char *name)
+{
+    H5::DataSet dset = group.openDataSet(name);
+    H5::DataSpace space = dset.getSpace();
+    hsize_t dims[2] = {0, 0};
+    if (space.getSimpleExtentNdims() == 2)
+        space.getSimpleExtentDims(dims);
+    if (dims[1] != 4)
+        throw H5::DataSetIException("readMembers", "the membership table has to have the shape N×4");
+
+    std::vector<MemberRow> ret(dims[0]);
+    if (!ret.empty())
+        dset.read(ret.data(), H5::PredType::NATIVE_UINT32);
+    return ret;
+}
+
+/*!
+ * \brief writes the membership table of a Tracklet or AutoTracklet, replacing an existing one
+ * \param members the rows of the table
+ * \param group the group of the Tracklet or AutoTracklet
+ * \param name the name of the table
+ */
+void writeMembers(std::vector<MemberRow> const &members, H5::CommonFG &group, const char *name)
+{
+    if (linkExists(group, name))
+        group.unlink(name);
+
+    hsize_t dims[2] = {members.size(), 4};
+    H5::DataSpace space(2, dims);
+    H5::DataSet dset = group.createDataSet(name, H5::PredType::NATIVE_UINT32, space);
+    if (!members.empty())
+        dset.write(members.data(), H5::PredType::NATIVE_UINT32);
+}
+
+/*!
+ * \brief returns the row of an Object in a membership table
+ * \param obj the Object
+ * \return the row (frame, slice, channel, object)
+ */
+MemberRow memberRow(std::shared_ptr<TraCurate::Object> obj)
+{
+    return {{obj->getFrameId(), obj->getSliceId(), obj->getChannelId(), obj->getId()}};
+}
+
 void writeFixedLengthString(std::string value, H5::CommonFG &group, const char *name) {
     H5::StrType st(H5::PredType::C_S1);
     st.setSize(value.length());
@@ -18,9 +18,12 @@
 #ifndef HDF5_AUX
 #define HDF5_AUX
 
+#include <array>
 #include <tuple>
 #include <list>
+#include <vector>
 #include <memory>
+#include <mutex>
 #include <H5Cpp.h>
 
 #include "base/object.h"
@@ -63,6 +66,15 @@ std::list<std::string> collectGroupElementNames(H5::CommonFG &cfg);
 
 H5L_type_t getLinkType(H5::H5Object &obj);
 
+/* opening files, the latest file format and SWMR access need HDF5 1.10 */
+bool swmrSupported();
+H5::FileAccPropList fileAccess(bool latestFormat);
+unsigned readFlags(bool swmr);
+
+/* every call into a HDF5 library that is not thread-safe has to hold this lock */
+std::unique_lock<std::recursive_mutex> lockHDF5();
+void yieldHDF5();
+
 /* convenience functions */
 H5::DataSet openOrCreateDataSet(H5::CommonFG& cfg, const char *name, H5::DataType type, H5::DataSpace space);
 H5::DataSet openOrCreateDataSet(H5::CommonFG& cfg, std::string name, H5::DataType type, H5::DataSpace space);
@@ -291,6 +303,12 @@ std::string hdfSearch(H5::H5File file, std::shared_ptr<TraCurate::AutoTracklet>
 
 bool isObject(H5::H5File file, std::string &path, std::shared_ptr<TraCurate::Object> object);
 
+/* membership tables of Tracklets and AutoTracklets, one row of (frame, slice, channel, object) per Object */
+typedef std::array<uint32_t,4> MemberRow;
+std::vector<MemberRow> readMembers(H5::CommonFG &group, const char *name = "members");
+void writeMembers(std::vector<MemberRow> const &members, H5::CommonFG &group, const char *name = "members");
+MemberRow memberRow(std::shared_ptr<TraCurate::Object> obj);
+
 void writeFixedLengthString(std::string value, H5::CommonFG &group, const char *name);
 void writeFixedLengthString(const char *value, H5::CommonFG &group, const char *name);
 std::string readString(H5::Group group, const char *name);
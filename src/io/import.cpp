@@ -17,6 +17,8 @@
  */
 #include "import.h"
 
+#include <algorithm>
+
 #include "project.h"
 #include "base/info.h"
 #include "base/movie.h"
@@ -26,6 +28,42 @@ namespace TraCurate {
 
 Import::~Import() {}
 
+/*!
+ * \brief reads an image with the samples as they are stored
+ * \param path the path of the Project
+ * \param frame the frame, to which the image belongs
+ * \param slice the slice, to which the image belongs
+ * \param channel the channel, to which the image belongs
+ * \return the RawImage
+ *
+ * Importers that only support 8 bit images do not need to override this, the
+ * image returned by requestImage() is converted.
+ */
+RawImage Import::requestRawImage(QString path, int frame, int slice, int channel)
+{
+    std::shared_ptr<QImage> img = requestImage(path, frame, slice, channel);
+    return img ? RawImage::fromImage(*img) : RawImage();
+}
+
+/*!
+ * \brief reads a downsampled image with the samples as they are stored
+ * \param path the path of the Project
+ * \param frame the frame, to which the image belongs
+ * \param slice the slice, to which the image belongs
+ * \param channel the channel, to which the image belongs
+ * \param maxSize the image is decimated until neither side is longer than this
+ * \return the RawImage
+ *
+ * Importers that can read only parts of an image should override this, this
+ * implementation reads the whole image and decimates it afterwards.
+ */
+RawImage Import::requestRawThumbnail(QString path, int frame, int slice, int channel, int maxSize)
+{
+    RawImage raw = requestRawImage(path, frame, slice, channel);
+    int longest = std::max(raw.width(), raw.height());
+    return raw.decimated((longest + maxSize - 1) / std::max(maxSize, 1));
+}
+
 /*!
  * \brief sets up an empty Project and instantiates all required Objects (Info,
  * Movie, Genealogy) to work on it.
@@ -23,6 +23,7 @@
 #include <QString>
 
 #include "project.h"
+#include "base/rawimage.h"
 
 namespace TraCurate {
 
@@ -45,6 +46,8 @@ public:
 
     virtual std::shared_ptr<Project> load(QString) = 0;
     virtual std::shared_ptr<QImage> requestImage(QString path, int frame, int slice, int channel) = 0;
+    virtual RawImage requestRawImage(QString path, int frame, int slice, int channel);
+    virtual RawImage requestRawThumbnail(QString path, int frame, int slice, int channel, int maxSize);
 
 protected:
     std::shared_ptr<Project> setupEmptyProject();
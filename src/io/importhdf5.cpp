@@ -18,9 +18,11 @@
 #include "importhdf5.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <mutex>
 #include <tuple>
 #include <utility>
 
@@ -32,6 +34,9 @@
 #include <QPolygonF>
 #include <QPoint>
 #include <QRect>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
 
 #include "hdf5_aux.h"
 #include "tracked/trackeventdead.hpp"
@@ -45,6 +50,7 @@
 #include "exceptions/tcmissingelementexception.h"
 #include "provider/guistate.h"
 #include "provider/messagerelay.h"
+#include "provider/tracer.h"
 
 namespace TraCurate {
 using namespace H5;
@@ -54,6 +60,7 @@ using namespace H5;
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 static std::shared_ptr<Project> currentProject;
 static QList<std::shared_ptr<Object>> annotatedObjects;
+static std::atomic<bool> swmrRead(false);
 static QList<std::shared_ptr<Tracklet>> annotatedTracklets;
 #pragma clang diagnostic pop
 
@@ -77,13 +84,15 @@ static QList<std::shared_ptr<Tracklet>> annotatedTracklets;
  */
 std::shared_ptr<Project> ImportHDF5::load(QString fileName)
 {
+    TC_TRACE_SCOPE("ImportHDF5::load");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
     std::shared_ptr<Project> proj;
 
     try {
         if (!H5File::isHdf5(fileName.toStdString().c_str()))
             return proj;
 
-        H5File file(fileName.toStdString().c_str(), H5F_ACC_RDONLY);
+        H5File file(fileName.toStdString().c_str(), readFlags(swmrRead));
 
         /* If you want to add new phases, do it here.
          *
@@ -118,6 +127,7 @@ std::shared_ptr<Project> ImportHDF5::load(QString fileName)
         qDebug() << "Importing from HDF5";
         for (phase p : phases) {
             std::string text = "Loading " + p.name;
+            TC_TRACE_SCOPE(Tracer::intern(QString::fromStdString(text)));
             qDebug() << text.c_str();
             MessageRelay::emitUpdateDetailName(QString::fromStdString(text));
             if (!p.functionPtr(file, proj))
@@ -347,11 +357,6 @@ bool ImportHDF5::loadAnnotations(H5File file, std::shared_ptr<Project> proj) {
     return true;
 }
 
-void ImportHDF5::imageCleanupHandler(void *info) {
-    uint8_t *buf = reinterpret_cast<uint8_t*>(info);
-    delete[] buf;
-}
-
 /*!
  * \brief reads the requested image from a given file
  * \param filename the name of the HDF5 file
@@ -359,36 +364,115 @@ void ImportHDF5::imageCleanupHandler(void *info) {
  * \param slice the slice, to which the image belongs
  * \param channel the channel, to which the image belongs
  * \return a std::shared_ptr<QImage>, that points to the requested QImage
+ *
+ * Images with more than 8 bits per sample are scaled to 8 bits, see RawImage::toImage().
  */
 std::shared_ptr<QImage> ImportHDF5::requestImage (QString filename, int frame, int slice, int channel) {
-    H5File file (filename.toStdString().c_str(), H5F_ACC_RDONLY);
+    return std::make_shared<QImage>(requestRawImage(filename, frame, slice, channel).toImage());
+}
+
+/*!
+ * \brief sets whether files are opened as single-writer/multiple-reader (SWMR) reader
+ * \param swmr true to open files as SWMR reader
+ *
+ * This is meant for secondary viewers and analysis jobs that read a file while
+ * TraCurate curates it. The writer has to use the latest file format for this
+ * (see the setting hdf5/swmr). Has no effect with HDF5 1.8.
+ */
+void ImportHDF5::setSwmrRead(bool swmr) {
+    if (swmr && !swmrSupported())
+        qDebug() << "SWMR needs HDF5 1.10 or later, files are opened read-only instead";
+    swmrRead = swmr;
+}
+
+/*!
+ * \brief tells whether files are opened as SWMR reader
+ * \return true, if files are opened as SWMR reader
+ */
+bool ImportHDF5::getSwmrRead() {
+    return swmrRead;
+}
+
+/*!
+ * \brief reads the requested image from a given file with the samples as they are stored
+ * \param filename the name of the HDF5 file
+ * \param frame the frame, to which the image belongs
+ * \param slice the slice, to which the image belongs
+ * \param channel the channel, to which the image belongs
+ * \return the RawImage including its histogram
+ */
+RawImage ImportHDF5::requestRawImage(QString filename, int frame, int slice, int channel) {
+    TC_TRACE_SCOPE("ImportHDF5::requestRawImage");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+    H5File file (filename.toStdString().c_str(), readFlags(swmrRead));
     Group imagesGroup = file.openGroup("images");
     Group framesGroup = imagesGroup.openGroup("frames");
     Group frameGroup = framesGroup.openGroup((std::to_string(frame)+"/slices").c_str());
     Group sliceGroup = frameGroup.openGroup((std::to_string(slice)+"/channels").c_str());
 
-    auto data = readMultipleValues<uint8_t>(sliceGroup,std::to_string(channel).c_str());
+    return readRawImage(sliceGroup.openDataSet(std::to_string(channel).c_str()));
+}
 
-    uint8_t *buf = std::get<0>(data);
-    hsize_t *dims = std::get<1>(data);
-    int rank = std::get<2>(data);
+/*!
+ * \brief reads a downsampled image from a given file, only every n-th row and column is read
+ * \param filename the name of the HDF5 file
+ * \param frame the frame, to which the image belongs
+ * \param slice the slice, to which the image belongs
+ * \param channel the channel, to which the image belongs
+ * \param maxSize the longest side of the image that is read
+ * \return the RawImage including its histogram
+ */
+RawImage ImportHDF5::requestRawThumbnail(QString filename, int frame, int slice, int channel, int maxSize) {
+    TC_TRACE_SCOPE("ImportHDF5::requestRawThumbnail");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+    H5File file (filename.toStdString().c_str(), readFlags(swmrRead));
+    Group imagesGroup = file.openGroup("images");
+    Group framesGroup = imagesGroup.openGroup("frames");
+    Group frameGroup = framesGroup.openGroup((std::to_string(frame)+"/slices").c_str());
+    Group sliceGroup = frameGroup.openGroup((std::to_string(slice)+"/channels").c_str());
 
-    std::shared_ptr<QImage> img;
-    int height = static_cast<int>(dims[0]);
-    int width = static_cast<int>(dims[1]);
-    int depth = rank;
+    return readRawImage(sliceGroup.openDataSet(std::to_string(channel).c_str()), maxSize);
+}
 
-    if (depth == 3) {
-        img = std::make_shared<QImage>(buf, width, height, depth * width * sizeof(uint8_t), QImage::Format_RGB888, ImportHDF5::imageCleanupHandler, buf);
-    } else {
-        img = std::make_shared<QImage>(buf, width, height, width * sizeof(uint8_t), QImage::Format_Grayscale8, imageCleanupHandler, buf);
+/*!
+ * \brief reads an image DataSet of the form [height][width] or [height][width][3]
+ * \param ds the DataSet
+ * \param maxSize if positive, only every n-th row and column is read, so no side is longer than this
+ * \return the RawImage including its histogram
+ *
+ * 8 bit samples are read as they are, wider samples are converted to 16 bits
+ * by the HDF5 library.
+ */
+RawImage ImportHDF5::readRawImage(DataSet ds, int maxSize) {
+    DataSpace space = ds.getSpace();
+    int rank = space.getSimpleExtentNdims();
+    if (rank != 2 && rank != 3)
+        throw TCFormatException("Image has " + std::to_string(rank) + " dimensions, expected 2 or 3");
+
+    hsize_t dims[3] = {0, 0, 1};
+    space.getSimpleExtentDims(dims);
+    if (dims[2] != 1 && dims[2] != 3)
+        throw TCFormatException("Image has " + std::to_string(dims[2]) + " samples per pixel, expected 1 or 3");
+
+    bool wide = ds.getDataType().getSize() > 1;
+    hsize_t step = (maxSize > 0) ? (std::max(dims[0], dims[1]) + maxSize - 1) / static_cast<hsize_t>(maxSize) : 1;
+    if (step <= 1) {
+        RawImage raw(static_cast<int>(dims[1]), static_cast<int>(dims[0]), static_cast<int>(dims[2]), wide ? 16 : 8);
+        ds.read(raw.bits(), wide ? PredType::NATIVE_UINT16 : PredType::NATIVE_UINT8);
+        raw.computeHistogram();
+        return raw;
     }
 
-    delete[] dims;
-    /* buffer will be reused by QImage and cleaned up in imageCleanupHandler */
-    // delete[] buf;
-
-    return img;
+    /* let the HDF5 library skip the rows and columns that are not needed */
+    hsize_t start[3] = {0, 0, 0};
+    hsize_t stride[3] = {step, step, 1};
+    hsize_t count[3] = {(dims[0] + step - 1) / step, (dims[1] + step - 1) / step, dims[2]};
+    space.selectHyperslab(H5S_SELECT_SET, count, start, stride);
+    DataSpace memSpace(rank, count);
+    RawImage raw(static_cast<int>(count[1]), static_cast<int>(count[0]), static_cast<int>(count[2]), wide ? 16 : 8);
+    ds.read(raw.bits(), wide ? PredType::NATIVE_UINT16 : PredType::NATIVE_UINT8, memSpace, space);
+    raw.computeHistogram();
+    return raw;
 }
 
 /*!
@@ -415,22 +499,7 @@ herr_t ImportHDF5::process_images_frames_slices_channels(hid_t group_id, const c
             }
 
             DataSet ds = openDataset(group_id, name);
-            auto data = readMultipleValues<uint8_t>(ds);
-            uint8_t *buf = std::get<0>(data);
-            hsize_t *dims = std::get<1>(data);
-            int rank = std::get<2>(data);
-
-            std::shared_ptr<QImage> img;
-            if (rank == 3) {
-                img = bufToImage(buf, dims[0], dims[1], dims[2]);
-            } else {
-                img = bufToImage(buf, dims[0], dims[1], 1);
-            }
-
-            delete[] (buf);
-            delete[] (dims);
-
-            channel->setImage(img);
+            channel->setImage(std::make_shared<QImage>(readRawImage(ds).toImage()));
         }
     }
     return 0;
@@ -620,42 +689,6 @@ std::shared_ptr<QPolygonF> ImportHDF5::readOutline (hid_t objGroup) {
     return poly;
 }
 
-/*!
- * \brief converts a unit8_t[][][] into a QImage
- * \param buf the buffer that holds the image
- * \param height height of the image in pixels
- * \param width width of the image in pixels
- * \param depth depth of the image (1 if grayscale, 3 if rgb)
- * \return a std::shared_ptr<QImage>, that points to the image
- */
-std::shared_ptr<QImage> ImportHDF5::bufToImage(uint8_t *buf, hsize_t height, hsize_t width, hsize_t depth)
-{
-    int offy = static_cast<int>(width*depth);
-    int offx = static_cast<int>(depth);
-
-    auto img = std::make_shared<QImage>(width, height, QImage::Format_RGB32);
-    QRgb *data = reinterpret_cast<QRgb *>(img->bits());
-
-    for (unsigned int posy=0; posy<height; posy++) {
-        for (unsigned int posx=0; posx<width; posx++) {
-            unsigned int pxl_idx = posy * offy + posx * offx;
-            QColor col;
-            if(depth == 3) {
-                uint8_t r = buf[pxl_idx + 0];
-                uint8_t g = buf[pxl_idx + 1];
-                uint8_t b = buf[pxl_idx + 2];
-                col.setRgb(r,g,b);
-            } else {
-                uint8_t c = buf[pxl_idx];
-                col.setRgb(c,c,c);
-            }
-            data[posy * width + posx] = col.rgb();
-        }
-    }
-
-    return img;
-}
-
 /*!
  * \brief Callback for iterating over /objects/frames/\<id\>/slices/\<id\>/channels/\<id\>/objects/\<id\>
  * \param group_id callback parameter
@@ -925,6 +958,37 @@ herr_t ImportHDF5::process_autotracklets_events(hid_t group_id_o, const char *na
     return 0;
 }
 
+/*!
+ * \brief returns the Frame of a row of a membership table
+ * \param project the Project
+ * \param m the row (frame, slice, channel, object)
+ * \return the Frame
+ * \throw TCMissingElementException if the Frame could not be found
+ */
+std::shared_ptr<Frame> ImportHDF5::findMemberFrame(Project *project, MemberRow const &m) {
+    std::shared_ptr<Frame> frame = project->getMovie()->getFrame(m[0]);
+    if (frame == nullptr)
+        throw TCMissingElementException("Did not find frame " + std::to_string(m[0]) + " in Movie");
+    return frame;
+}
+
+/*!
+ * \brief returns the Object of a row of a membership table
+ * \param frame the Frame of the row
+ * \param m the row (frame, slice, channel, object)
+ * \return the Object
+ * \throw TCMissingElementException if the Object could not be found
+ */
+std::shared_ptr<Object> ImportHDF5::findMemberObject(std::shared_ptr<Frame> const &frame, MemberRow const &m) {
+    std::shared_ptr<Slice> slice = frame->getSlice(m[1]);
+    std::shared_ptr<Channel> channel = slice ? slice->getChannel(m[2]) : nullptr;
+    std::shared_ptr<Object> object = channel ? channel->getObject(m[3]) : nullptr;
+    if (object == nullptr)
+        throw TCMissingElementException("Did not find object " + std::to_string(m[3]) + " in channel " + std::to_string(m[2])
+                                        + " of slice " + std::to_string(m[1]) + " of frame " + std::to_string(m[0]));
+    return object;
+}
+
 /*!
  * \brief Callback for iterating over /autotracklets/\<id\>
  * \param group_id callback parameter
@@ -947,9 +1011,16 @@ herr_t ImportHDF5::process_autotracklets (hid_t group_id, const char *name, void
         autoTracklet = std::make_shared<AutoTracklet>(atnr);
         project->addAutoTracklet(autoTracklet);
 
-        std::pair<std::shared_ptr<AutoTracklet>,Project*> p(autoTracklet,project);
-        /* add the objects to this autotracklet */
-        err = H5Giterate(trackGroup.getId(), "objects", NULL, process_autotracklets_objects, &(p));
+        /* add the objects to this autotracklet, prefer the membership table over the links */
+        if (datasetExists(trackGroup, "members")) {
+            for (MemberRow const &m : readMembers(trackGroup)) {
+                std::shared_ptr<Frame> frame = findMemberFrame(project, m);
+                autoTracklet->addComponent(frame, findMemberObject(frame, m));
+            }
+        } else if (groupExists(trackGroup, "objects")) {
+            std::pair<std::shared_ptr<AutoTracklet>,Project*> p(autoTracklet,project);
+            err = H5Giterate(trackGroup.getId(), "objects", NULL, process_autotracklets_objects, &(p));
+        }
     }
 
     MessageRelay::emitIncreaseDetail();
@@ -1173,9 +1244,16 @@ herr_t ImportHDF5::process_tracklets (hid_t group_id, const char *name, void *op
         if (groupExists(trackGroup, "annotations"))
             annotatedTracklets.append(tracklet);
 
-        std::pair<std::shared_ptr<Tracklet>,Project*> p(tracklet,project);
-        /* add the objects to this tracklet */
-        err = H5Giterate(trackGroup.getId(), "objects", NULL, process_tracklets_objects, &(p));
+        /* add the objects to this tracklet, prefer the membership table over the links */
+        if (datasetExists(trackGroup, "members")) {
+            for (MemberRow const &m : readMembers(trackGroup)) {
+                std::shared_ptr<Frame> frame = findMemberFrame(project, m);
+                tracklet->addToContained(frame, findMemberObject(frame, m));
+            }
+        } else if (groupExists(trackGroup, "objects")) {
+            std::pair<std::shared_ptr<Tracklet>,Project*> p(tracklet,project);
+            err = H5Giterate(trackGroup.getId(), "objects", NULL, process_tracklets_objects, &(p));
+        }
     }
 
     MessageRelay::emitIncreaseDetail();
@@ -1197,6 +1275,8 @@ bool ImportHDF5::loadAutoTracklets(H5File file, std::shared_ptr<Project> proj) {
         err = H5Giterate(file.getId(), "autotracklets", NULL, process_autotracklets, &(*proj));
     } catch (H5::GroupIException &e) {
         throw TCFormatException ("Format mismatch while trying to read autotracklets: " + e.getDetailMsg());
+    } catch (H5::DataSetIException &e) {
+        throw TCFormatException ("Format mismatch while trying to read autotracklets: " + e.getDetailMsg());
     }
 
     return !err;
@@ -1220,6 +1300,8 @@ bool ImportHDF5::loadTracklets(H5File file, std::shared_ptr<Project> proj)
         }
     } catch (H5::GroupIException &e) {
         throw TCFormatException ("Format mismatch while trying to read tracklets: " + e.getDetailMsg());
+    } catch (H5::DataSetIException &e) {
+        throw TCFormatException ("Format mismatch while trying to read tracklets: " + e.getDetailMsg());
     }
 
     return !err;
@@ -1400,6 +1482,126 @@ bool Validator::test_groupname_matches_autotracklet_id(H5::H5File file, checkObj
     return false;
 }
 
+/*!
+ * \brief returns the layout of a TraCurate project file, which validTraCurateFile() checks against
+ * \return the root of the layout
+ */
+Validator::checkObject const &Validator::layout()
+{
+    static checkObject const cProj = { "", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr,
+                                       {{"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"object_annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"*", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                           {"object_annotation_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                           {"title", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                         {"track_annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"*", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                           {"track_annotation_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                           {"title", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}}}},
+                                        {"autotracklets", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_autotracklet_id, {
+                                          {"autotracklet_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"start", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"end", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"next_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
+                                          {"previous_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
+                                          {"members", false, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"objects", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                          {"next", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                          {"previous", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}}}}}},
+                                        {"events", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"cell_death", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                         {"cell_division", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                         {"cell_lost", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                         {"cell_merge", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                         {"cell_unmerge", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                         {"end_of_movie", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                        {"images", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"frames", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_frame_id, {
+                                           {"slices", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                            {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_slice_id, {
+                                             {"channels", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                              {"*", false, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                             {"dimensions", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                             {"nchannels", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                             {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                           {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                         {"frame_rate", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                         {"nframes", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                         {"nslices", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                         {"slice_shape", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
+                                        {"info", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {}},
+                                        {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"frames", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                          {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_frame_id, {
+                                           {"slices", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                            {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_slice_id, {
+                                             {"channels", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                              {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_channel_id, {
+                                               {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                                {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_object_id, {
+                                                 {"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                                 {"bounding_box", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"centroid", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"channel_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"object_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"outline", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"packed_mask", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                                 {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                               {"channel_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                             {"dimensions", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
+                                             {"nchannels", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
+                                             {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                           {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
+                                         {"frame_rate", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
+                                         {"nframes", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
+                                         {"nslices", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
+                                         {"slice_shape", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}}}},
+                                        {"tracklets", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                         {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_tracklet_id, {
+                                          {"tracklet_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"start", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"end", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"next_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
+                                          {"previous_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
+                                          {"members", false, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
+                                          {"objects", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                          {"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                          {"next", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
+                                          {"previous", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
+                                           {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}}}}}}}};
+    return cProj;
+}
+
 /*!
  * \brief Checks if a given file is a valid TraCurate project file and coheres to certain basic constraints.
  * \param fileName the filename of the file to check
@@ -1407,226 +1609,248 @@ bool Validator::test_groupname_matches_autotracklet_id(H5::H5File file, checkObj
  * \param warnLink warn, if some part is not of the expected link type (soft, hard)
  * \param warnTest warn, if some part doesn't pass the test function, that is associated with it
  * \return true, if this is a valid TraCurate-File, false otherwise
+ *
+ * The findings are written to qDebug().
  */
 bool Validator::validTraCurateFile(QString fileName, bool warnType, bool warnLink, bool warnTest)
 {
-    bool valid = true;
-    { /* Check if valid HDF5 file */
-        if (!H5File::isHdf5(fileName.toStdString())) {
-            qDebug() << "invalid file" << fileName;
-            return false;
-        }
+    Options options;
+    options.warnType = warnType;
+    options.warnLink = warnLink;
+    options.warnTest = warnTest;
+    options.report = [](Finding const &f) { qDebug() << f.path.c_str() << f.message.c_str(); };
+    return validTraCurateFile(fileName, options);
+}
+
+/*!
+ * \brief The state of one run of Validator::validTraCurateFile()
+ *
+ * The file is checked in units of work: every top-level group is one unit and
+ * wildcards with more than chunkSize elements are split into units of chunkSize
+ * elements, for /objects/frames and /images/frames these are ranges of frames.
+ * The units run on a QThreadPool if the HDF5 library was built thread-safe,
+ * otherwise one after another on the calling thread. Each unit opens the file
+ * on its own.
+ */
+class ValidatorRun
+{
+public:
+    ValidatorRun(QString const &fileName, Validator::Options const &options);
+    bool exec();
+
+private:
+    void submit(Validator::workItem const &w);
+    void check(Validator::workItem w);
+    bool checkItem(H5File &file, std::string const &prefix, Validator::checkObject const &item, std::string const &name);
+    void report(Validator::Finding::Severity severity, std::string const &path, std::string const &message);
+
+    static constexpr size_t chunkSize = 64;
+
+    std::string fileName;
+    Validator::Options const &options;
+    bool parallel;
+    QThreadPool pool;
+    std::mutex mtx;                         /*!< protects pending and serializes the calls of options.report */
+    std::list<Validator::workItem> pending; /*!< units that are not yet run, if not parallel */
+    std::atomic<bool> valid;
+    std::atomic<bool> stopped;
+};
+
+ValidatorRun::ValidatorRun(QString const &fileName, Validator::Options const &options) :
+    fileName(fileName.toStdString()),
+    options(options),
+    parallel(false),
+    valid(true),
+    stopped(false)
+{
+    int threads = (options.threads > 0) ? options.threads : QThread::idealThreadCount();
+#ifdef H5_HAVE_THREADSAFE
+    parallel = threads > 1;
+#endif
+    pool.setMaxThreadCount(std::max(threads, 1));
+}
+
+/*!
+ * \brief runs the validation
+ * \return true, if no ERROR was found
+ */
+bool ValidatorRun::exec()
+{
+    if (!H5File::isHdf5(fileName)) {
+        report(Validator::Finding::ERROR, fileName, "is not a HDF5 file");
+        return false;
     }
-    H5File file(fileName.toStdString().c_str(), H5F_ACC_RDONLY);
-    { /* Check if all required Groups/DataSets exist */
-        checkObject cProj = { "", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr,
-                              {{"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"object_annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"*", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                  {"object_annotation_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                  {"title", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                {"track_annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"*", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                  {"track_annotation_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                  {"title", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}}}},
-                               {"autotracklets", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_autotracklet_id, {
-                                 {"autotracklet_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"start", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"end", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"next_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
-                                 {"previous_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
-                                 {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                 {"next", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                 {"previous", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}}}}}},
-                               {"events", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"cell_death", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                {"cell_division", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                {"cell_lost", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                {"cell_merge", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                {"cell_unmerge", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                {"end_of_movie", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"description", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"event_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"name", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                               {"images", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"frames", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_frame_id, {
-                                  {"slices", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                   {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_slice_id, {
-                                    {"channels", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                     {"*", false, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                                    {"dimensions", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                    {"nchannels", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                    {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                  {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                {"frame_rate", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                {"nframes", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                {"nslices", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                {"slice_shape", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}},
-                               {"info", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {}},
-                               {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"frames", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                 {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_frame_id, {
-                                  {"slices", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                   {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_slice_id, {
-                                    {"channels", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                     {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_channel_id, {
-                                      {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                       {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_object_id, {
-                                        {"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                         {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                        {"bounding_box", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"centroid", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"channel_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"object_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"outline", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"packed_mask", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                        {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                      {"channel_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                    {"dimensions", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
-                                    {"nchannels", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
-                                    {"slice_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                  {"frame_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}}}}}},
-                                {"frame_rate", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
-                                {"nframes", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
-                                {"nslices", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}},
-                                {"slice_shape", true, H5L_TYPE_SOFT, TYPE_DATASET, nullptr, {}}}},
-                               {"tracklets", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                {"*", false, H5L_TYPE_HARD, TYPE_GROUP, test_groupname_matches_tracklet_id, {
-                                 {"tracklet_id", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"start", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"end", true, H5L_TYPE_HARD, TYPE_DATASET, nullptr, {}},
-                                 {"next_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
-                                 {"previous_event", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}},
-                                 {"objects", true, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                 {"annotations", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                 {"next", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}},
-                                 {"previous", false, H5L_TYPE_HARD, TYPE_GROUP, nullptr, {
-                                  {"*", false, H5L_TYPE_SOFT, TYPE_GROUP, nullptr, {}}}}}}}}}};
-
-        std::list<workItem> workQueue = {{"", cProj}};
-        while (!workQueue.empty()) {
-            workItem currentWork = workQueue.front();
-            workQueue.pop_front();
-            std::string currentPrefix = currentWork.prefix;
-            checkObject currentObject = currentWork.item;
-            std::string currentFullName = currentPrefix + "/" + currentObject.name;
-            std::list<workItem> newWork;
-            bool checkExistence = true;
-
-            /* Check current item */
-            if (currentObject.name.compare("") == 0 && currentPrefix.compare("") == 0) {
-                /* root */
-                currentFullName = "";
-                checkExistence = false;
-            } else if (currentObject.name.compare("*") == 0) {
-                /* wildcard */
-                checkExistence = false;
+
+    submit({"", &Validator::layout(), "", {}});
+    if (parallel) {
+        pool.waitForDone();
+    } else {
+        for (;;) {
+            Validator::workItem w;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (pending.empty())
+                    break;
+                w = pending.front();
+                pending.pop_front();
             }
+            check(w);
+        }
+    }
+    return valid;
+}
 
-            if (checkExistence) {
-                /* check existence */
-                if (!linkExists(file, currentFullName.c_str())) {
-                    if (currentObject.necessary)
-                        qDebug() << currentFullName.c_str() << "does not exist though it is necessary";
-                    /* continue with the next item in the queue, as this item does not exist, it also doesn't have children */
-                    continue;
-                }
+void ValidatorRun::submit(Validator::workItem const &w)
+{
+    if (stopped)
+        return;
+    if (parallel) {
+        QtConcurrent::run(&pool, this, &ValidatorRun::check, w);
+    } else {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(w);
+    }
+}
 
-                /* check type */
-                if (warnType && currentObject.type == TYPE_GROUP) {
-                    if (!groupExists(file, currentFullName.c_str()))
-                        qDebug() << currentFullName.c_str() << "is not a group";
-                    /* check link */
-                    Group g = file.openGroup(currentFullName);
-                    if (warnLink && currentObject.link == H5L_TYPE_SOFT && getLinkType(g) != H5L_TYPE_SOFT) {
-                        qDebug() << currentFullName.c_str() << "is not a soft link";
-                        valid = false;
-                    } else if (warnLink && currentObject.link == H5L_TYPE_HARD && getLinkType(g) != H5L_TYPE_HARD) {
-                        qDebug() << currentFullName.c_str() << "is not a hard link";
-                        valid = false;
-                    }
-                    /* test function */
-                    std::string errBuf;
-                    if (warnTest && currentObject.test && !currentObject.test(file, currentObject, currentPrefix, errBuf))
-                        qDebug() << currentFullName.c_str() << "did not pass the test function with the following error message:" << errBuf.c_str();
-                } else if (warnType && currentObject.type == TYPE_DATASET) {
-                    if (!datasetExists(file, currentFullName.c_str()))
-                        qDebug() << currentFullName.c_str() << "is not a dataset";
-                    /* check link */
-                    DataSet d = file.openDataSet(currentFullName);
-                    if (warnLink && currentObject.link == H5L_TYPE_SOFT && getLinkType(d) != H5L_TYPE_SOFT) {
-                        qDebug() << currentFullName.c_str() << "is not a soft link";
-                        valid = false;
-                    } else if (warnLink && currentObject.link == H5L_TYPE_HARD && getLinkType(d) != H5L_TYPE_HARD) {
-                        qDebug() << currentFullName.c_str() << "is not a hard link";
-                        valid = false;
-                    }
-                    /* test function */
-                    std::string errBuf;
-                    if (warnTest && currentObject.test && !currentObject.test(file, currentObject, currentPrefix, errBuf))
-                        qDebug() << currentFullName.c_str() << "did not pass the test function with the following error message:" << errBuf.c_str();
-                }
-            }
+void ValidatorRun::report(Validator::Finding::Severity severity, std::string const &path, std::string const &message)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (severity == Validator::Finding::ERROR) {
+        valid = false;
+        if (options.stopAtFirstError) {
+            if (stopped)
+                return;
+            stopped = true;
+            pool.clear();
+            pending.clear();
+        }
+    }
+    if (options.report)
+        options.report({severity, path, message});
+}
 
-            /* collect children */
-            if (currentObject.name.compare("*") == 0) {
+/*!
+ * \brief checks one unit of work and everything below it
+ * \param w the unit
+ */
+void ValidatorRun::check(Validator::workItem w)
+{
+    using namespace Validator;
+    TC_TRACE_SCOPE("Validator::check");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+
+    std::string current = w.prefix + "/" + (w.name.empty() ? w.item->name : w.name);
+    try {
+        H5File file(fileName.c_str(), readFlags(ImportHDF5::getSwmrRead()));
+        std::list<workItem> workQueue = {w};
+        while (!workQueue.empty() && !stopped) {
+            workItem currentWork = workQueue.front();
+            workQueue.pop_front();
+            checkObject const &currentObject = *currentWork.item;
+            std::string const &currentPrefix = currentWork.prefix;
+            current = currentPrefix + "/" + (currentWork.name.empty() ? currentObject.name : currentWork.name);
+
+            if (currentObject.name.empty() && currentPrefix.empty()) {
+                /* root, every top-level group is a unit of its own */
+                for (checkObject const &c : currentObject.dependents)
+                    submit({"", &c, "", {}});
+            } else if (!currentWork.name.empty()) {
+                /* element of a wildcard, its dependents were enqueued when the wildcard was expanded */
+                checkItem(file, currentPrefix, currentObject, currentWork.name);
+            } else if (currentObject.name.compare("*") == 0) {
                 /* wildcard */
-                Group grp = file.openGroup(currentPrefix);
-                std::list<std::string> childrenNames = collectGroupElementNames(grp);
-                for (std::string childName : childrenNames) {
-                    checkObject wildcardObject = {childName,
-                                                  currentObject.necessary,
-                                                  currentObject.link,
-                                                  currentObject.type,
-                                                  currentObject.test,
-                                                  {}};
-                    workItem self = { currentPrefix, wildcardObject};
-                    newWork.push_front(self);
-                    for (checkObject c : currentObject.dependents) {
-                        workItem nI = {currentPrefix + "/" + childName, c};
-                        newWork.push_front(nI);
+                std::vector<std::string> childrenNames = currentWork.names;
+                if (childrenNames.empty()) {
+                    Group grp = file.openGroup(currentPrefix);
+                    std::list<std::string> names = collectGroupElementNames(grp);
+                    childrenNames.assign(names.begin(), names.end());
+                    if (childrenNames.size() > chunkSize) {
+                        for (size_t i = 0; i < childrenNames.size(); i += chunkSize) {
+                            auto begin = childrenNames.begin() + i;
+                            auto end = childrenNames.begin() + std::min(i + chunkSize, childrenNames.size());
+                            submit({currentPrefix, &currentObject, "", std::vector<std::string>(begin, end)});
+                        }
+                        continue;
                     }
                 }
-            } else {
-                /* regular */
-                for (checkObject c : currentObject.dependents){
-                    workItem nI = { currentFullName, c };
-                    newWork.push_back(nI);
+                for (std::string const &childName : childrenNames) {
+                    for (checkObject const &c : currentObject.dependents)
+                        workQueue.push_front({currentPrefix + "/" + childName, &c, "", {}});
+                    workQueue.push_front({currentPrefix, &currentObject, childName, {}});
                 }
+            } else if (checkItem(file, currentPrefix, currentObject, currentObject.name)) {
+                /* regular, the dependents are only checked if it exists */
+                for (checkObject const &c : currentObject.dependents)
+                    workQueue.push_front({current, &c, "", {}});
             }
-
-            /* enqueue children */
-            if (!newWork.empty())
-                std::copy(newWork.begin(), newWork.end(), std::front_insert_iterator<std::list<workItem>>(workQueue));
         }
+    } catch (H5::Exception &e) {
+        report(Finding::ERROR, current, "could not be read: " + e.getDetailMsg());
     }
-    return valid;
+}
+
+/*!
+ * \brief checks a single group or dataset
+ * \param file the file to check
+ * \param prefix the path of the parent group
+ * \param item what is expected
+ * \param name the name of the element (the same as item.name, unless item is a wildcard)
+ * \return true, if the element exists
+ */
+bool ValidatorRun::checkItem(H5File &file, std::string const &prefix, Validator::checkObject const &item, std::string const &name)
+{
+    using namespace Validator;
+    std::string fullName = prefix + "/" + name;
+
+    /* check existence */
+    if (!linkExists(file, fullName.c_str())) {
+        if (item.necessary)
+            report(Finding::WARNING, fullName, "does not exist though it is necessary");
+        /* as this item does not exist, it also doesn't have children */
+        return false;
+    }
+    if (!options.warnType)
+        return true;
+
+    /* check type and link */
+    H5L_type_t linkType;
+    if (item.type == TYPE_GROUP) {
+        if (!groupExists(file, fullName.c_str()))
+            report(Finding::WARNING, fullName, "is not a group");
+        Group g = file.openGroup(fullName);
+        linkType = getLinkType(g);
+    } else {
+        if (!datasetExists(file, fullName.c_str()))
+            report(Finding::WARNING, fullName, "is not a dataset");
+        DataSet d = file.openDataSet(fullName);
+        linkType = getLinkType(d);
+    }
+    if (options.warnLink && item.link != linkType)
+        report(Finding::ERROR, fullName, (item.link == H5L_TYPE_SOFT) ? "is not a soft link" : "is not a hard link");
+
+    /* test function */
+    std::string errBuf;
+    checkObject self = {name, item.necessary, item.link, item.type, item.test, {}};
+    if (options.warnTest && item.test && !item.test(file, self, prefix, errBuf))
+        report(Finding::WARNING, fullName, "did not pass the test function with the following error message: " + errBuf);
+    return true;
+}
+
+/*!
+ * \brief Checks if a given file is a valid TraCurate project file and coheres to certain basic constraints.
+ * \param fileName the filename of the file to check
+ * \param options what to check and where to report the findings to
+ * \return true, if this is a valid TraCurate-File, false otherwise
+ *
+ * Missing, mistyped or untested parts are reported as WARNING, parts with the
+ * wrong link type or that could not be read as ERROR. Only ERROR%s make the
+ * file invalid.
+ */
+bool Validator::validTraCurateFile(QString fileName, Options const &options)
+{
+    TC_TRACE_SCOPE("Validator::validTraCurateFile");
+    ValidatorRun run(fileName, options);
+    return run.exec();
 }
 
 
@@ -20,12 +20,17 @@
 
 #include "import.h"
 
+#include <functional>
+#include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <QString>
 #include <QImage>
 #include <H5Cpp.h>
 
+#include "hdf5_aux.h"
 #include "project.h"
 
 
@@ -49,8 +54,12 @@ public:
 
     std::shared_ptr<Project> load(QString);
     std::shared_ptr<QImage> requestImage(QString, int, int, int);
+    RawImage requestRawImage(QString, int, int, int);
+    RawImage requestRawThumbnail(QString, int, int, int, int);
+
+    static void setSwmrRead(bool swmr);
+    static bool getSwmrRead();
 
-    static void imageCleanupHandler(void *info);
 private:
     static bool loadInfo(H5::H5File file, std::shared_ptr<Project> proj);
     static bool loadEvents(H5::H5File file, std::shared_ptr<Project> proj);
@@ -81,11 +90,13 @@ private:
     static herr_t process_tracklets_objects(hid_t group_id, const char *name, void *opdata);
     static herr_t process_tracklets (hid_t group_id, const char *name, void *op_data);
 
+    static std::shared_ptr<Frame> findMemberFrame(Project *project, MemberRow const &m);
+    static std::shared_ptr<Object> findMemberObject(std::shared_ptr<Frame> const &frame, MemberRow const &m);
     static std::shared_ptr<QPoint> readCentroid(hid_t objGroup);
+    static RawImage readRawImage(H5::DataSet ds, int maxSize = 0);
     static std::shared_ptr<QRect> readBoundingBox(hid_t objGroup);
     static std::shared_ptr<QPolygonF> readOutline (hid_t objGroup);
 
-    static std::shared_ptr<QImage> bufToImage (uint8_t *buf, hsize_t height, hsize_t width, hsize_t depth);
 };
 
 namespace Validator {
@@ -100,12 +111,42 @@ struct checkObject {
     checkFun               test;
     std::list<checkObject> dependents;
 };
+/*!
+ * \brief something to check: item below prefix
+ *
+ * If item is a wildcard, name is the element of the group it stands for. If
+ * name is empty, the wildcard is expanded to names or, if names is empty, to
+ * all elements of the group.
+ */
 struct workItem {
-    std::string prefix;
-    checkObject item;
+    std::string               prefix;
+    checkObject const        *item;
+    std::string               name;
+    std::vector<std::string>  names;
+};
+
+/*! \brief a problem that was found while validating */
+struct Finding {
+    enum Severity { WARNING, ERROR };
+    Severity    severity;   /*!< ERROR%s make the file invalid */
+    std::string path;
+    std::string message;
+};
+typedef std::function<void(Finding const &)> reportFun;
+
+/*! \brief options for validTraCurateFile() */
+struct Options {
+    bool warnType = true;           /*!< warn, if some part is not of the expected type (group, dataset) */
+    bool warnLink = true;           /*!< warn, if some part is not of the expected link type (soft, hard) */
+    bool warnTest = true;           /*!< warn, if some part doesn't pass the test function, that is associated with it */
+    bool stopAtFirstError = false;  /*!< stop as soon as the file is known to be invalid */
+    int threads = 0;                /*!< threads to use, 0 for QThread::idealThreadCount() */
+    reportFun report;               /*!< receives the Finding%s as they are found, never called concurrently */
 };
 
 bool validTraCurateFile(QString, bool warnType, bool warnLink, bool warnTest);
+bool validTraCurateFile(QString, Options const &options);
+checkObject const &layout();
 
 bool test_groupname_matches_object_id(H5::H5File file, checkObject checkee, std::string prefix, std::string &err);
 bool test_groupname_matches_channel_id(H5::H5File file, checkObject checkee, std::string prefix, std::string &err);
@@ -0,0 +1,250 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "importlabels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <vector>
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QtConcurrent/QtConcurrent>
+
+#include "base/frame.h"
+#include "base/slice.h"
+#include "exceptions/tcimportexception.h"
+#include "graphics/bordertracer.h"
+#include "io/hdf5_aux.h"
+#include "io/tiffio.h"
+#include "provider/messagerelay.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief constructor for ImportLabels
+ * \param labels_ a directory of label images or file.h5:/dataset, empty for the labels directory of the project
+ */
+ImportLabels::ImportLabels(QString labels_) :
+    labels(labels_)
+{
+}
+
+ImportLabels::~ImportLabels()
+{
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+    dataset.close();
+    file.close();
+}
+
+/*!
+ * \brief loads a project directory with images and label images
+ * \param filePath the directory of the project, containing the images directory
+ * \return the Project
+ */
+std::shared_ptr<Project> ImportLabels::load(QString filePath)
+{
+    TC_TRACE_SCOPE("ImportLabels::load");
+    std::shared_ptr<Project> proj = Import::setupEmptyProject();
+    QDir qd(filePath);
+    proj->setFileName(filePath);
+    Project::XMLProjectSpec xps;
+    xps.cols = 1;
+    xps.rows = 1;
+    xps.projectFile = qd.filePath("");
+    Project::XMLSliceSpec xss;
+    xss.channels.append(qd.filePath("images"));
+    xss.tracks = qd.filePath("tracksXML.xml");
+    xss.xml = labels.isEmpty() ? qd.filePath("labels") : labels;
+    xps.slices.append(xss);
+
+    MessageRelay::emitUpdateOverallName("Importing from label images");
+    MessageRelay::emitUpdateOverallMax(4);
+
+    if (!loadFrames(filePath, proj, DEFAULT_SLICE, DEFAULT_CHANNEL))
+        throw TCImportException("loading of frames failed");
+    MessageRelay::emitIncreaseOverall();
+
+    if (!loadInfo(filePath, proj))
+        throw TCImportException("loading of info failed");
+    MessageRelay::emitIncreaseOverall();
+
+    QList<std::shared_ptr<Frame>> frames = proj->getMovie()->getFrames().values();
+    int count = openLabels(xss.xml);
+    if (count != frames.size())
+        throw TCImportException("There are " + std::to_string(count) + " label images for "
+                                + std::to_string(frames.size()) + " images");
+
+    Project::CoordinateSystemInfo::CoordinateSystemData csd = proj->getCoordinateSystemInfo()->getCoordinateSystemData();
+    MessageRelay::emitUpdateDetailName("Tracing objects");
+    MessageRelay::emitUpdateDetailMax(count);
+    std::mutex errorMtx;
+    std::string error;
+    std::atomic<int> split(0);
+    QtConcurrent::blockingMap(frames, [&](std::shared_ptr<Frame> &frame) {
+        std::string frameName = "frame " + std::to_string(frame->getID());
+        try {
+            RawImage l = readLabels(static_cast<int>(frame->getID()));
+            if (static_cast<uint32_t>(l.width()) != csd.imageWidth || static_cast<uint32_t>(l.height()) != csd.imageHeight)
+                throw TCImportException("The label image of " + frameName + " does not have the size of the images");
+            if (l.samples() != 1)
+                throw TCImportException("The label image of " + frameName + " is not a grayscale image");
+            split += loadObjectsInFrame(l, frame->getSlice(DEFAULT_SLICE)->getChannel(DEFAULT_CHANNEL));
+        } catch (TCException &e) {
+            std::lock_guard<std::mutex> lock(errorMtx);
+            if (error.empty())
+                error = e.what();
+        } catch (H5::Exception &e) {
+            std::lock_guard<std::mutex> lock(errorMtx);
+            if (error.empty())
+                error = "Reading the labels of " + frameName + " failed: " + e.getDetailMsg();
+        }
+        MessageRelay::emitIncreaseDetail();
+    });
+    if (!error.empty())
+        throw TCImportException(error);
+    if (split > 0)
+        MessageRelay::emitUpdateStatusBar(QString("%1 labels have unconnected parts, only the part with the first pixel was imported")
+                                          .arg(split.load()));
+    MessageRelay::emitIncreaseOverall();
+
+    /* the AutoTracklets are optional, label images usually come without them */
+    if (QFileInfo::exists(xss.tracks) && !loadAutoTracklets(xss.tracks, proj, DEFAULT_SLICE, DEFAULT_CHANNEL))
+        throw TCImportException("loading of autotracklets failed");
+    MessageRelay::emitIncreaseOverall();
+
+    proj->setProjectSpec(xps);
+    proj->setImported(true);
+    return proj;
+}
+
+/*!
+ * \brief opens the label images
+ * \param source a directory or file.h5:/dataset
+ * \return the number of label images
+ */
+int ImportLabels::openLabels(QString const &source)
+{
+    int sep = source.lastIndexOf(":/");
+    if (sep > 1 && QFileInfo(source.left(sep)).isFile()) {
+        std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+        try {
+            file = H5::H5File(source.left(sep).toStdString(), H5F_ACC_RDONLY);
+            dataset = file.openDataSet(source.mid(sep + 1).toStdString());
+            H5::DataSpace space = dataset.getSpace();
+            rank = space.getSimpleExtentNdims();
+            hsize_t dims[4] = {0, 0, 0, 1};
+            if (rank != 3 && rank != 4)
+                throw TCImportException("The label dataset has to be of the shape [frames][height][width]");
+            space.getSimpleExtentDims(dims);
+            if (dims[3] != 1)
+                throw TCImportException("The label dataset has more than one channel");
+            return static_cast<int>(dims[0]);
+        } catch (H5::Exception &e) {
+            throw TCImportException("Opening the label dataset " + source.toStdString() + " failed: " + e.getDetailMsg());
+        }
+    }
+
+    QDir dir(source);
+    if (!dir.exists() || !dir.isReadable())
+        throw TCImportException("The label directory " + source.toStdString() + " does not exist or is not readable");
+    dir.setNameFilters({"*.tif", "*.tiff", "*.png", "*.TIF", "*.TIFF", "*.PNG"});
+    dir.setFilter(QDir::Files | QDir::NoDotAndDotDot);
+    dir.setSorting(QDir::Name);
+    files.clear();
+    for (QString const &name : dir.entryList())
+        files.append(dir.absoluteFilePath(name));
+    rank = 0;
+    return files.size();
+}
+
+/*!
+ * \brief reads the label image of a frame
+ * \param frame the index of the frame
+ * \return the labels with one sample of 8 or 16 bits per pixel
+ *
+ * Can be called from multiple threads at once.
+ */
+RawImage ImportLabels::readLabels(int frame)
+{
+    TC_TRACE_SCOPE("ImportLabels::readLabels");
+    if (rank == 0) {
+        QString fileName = files.at(frame);
+        if (QFileInfo(fileName).suffix().toLower() != "png")
+            return TiffIO::read(fileName);
+        QImage img(fileName);
+        if (img.isNull())
+            throw TCImportException("Could not read " + fileName.toStdString());
+        return RawImage::fromImage(img);
+    }
+
+    /* read as 32 bits, so labels that do not fit into the 16 bits of a RawImage are not clipped unnoticed */
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
+    H5::DataSpace space = dataset.getSpace();
+    hsize_t dims[4] = {0, 0, 0, 1};
+    space.getSimpleExtentDims(dims);
+    hsize_t offset[4] = {static_cast<hsize_t>(frame), 0, 0, 0};
+    hsize_t count[4] = {1, dims[1], dims[2], 1};
+    space.selectHyperslab(H5S_SELECT_SET, count, offset);
+    hsize_t memDims[2] = {dims[1], dims[2]};
+    H5::DataSpace memSpace(2, memDims);
+
+    std::vector<uint32_t> buf(static_cast<size_t>(dims[1] * dims[2]));
+    dataset.read(buf.data(), H5::PredType::NATIVE_UINT32, memSpace, space);
+    lock.unlock();
+
+    if (!buf.empty() && *std::max_element(buf.begin(), buf.end()) > std::numeric_limits<uint16_t>::max())
+        throw TCImportException("The label image of frame " + std::to_string(frame) + " has labels above 65535");
+    RawImage ret(static_cast<int>(dims[2]), static_cast<int>(dims[1]), 1, 16);
+    std::copy(buf.begin(), buf.end(), reinterpret_cast<uint16_t*>(ret.bits()));
+    return ret;
+}
+
+/*!
+ * \brief adds an Object for every label of a label image to a Channel
+ * \param labels the label image
+ * \param chan the Channel, only used by the calling thread
+ * \return the number of labels with several unconnected parts, only their part with the first pixel is imported
+ */
+int ImportLabels::loadObjectsInFrame(RawImage const &labels, std::shared_ptr<Channel> const &chan)
+{
+    TC_TRACE_SCOPE("ImportLabels::loadObjectsInFrame");
+    int split = 0;
+    for (BorderTracer::Region const &r : BorderTracer::regions(labels)) {
+        if (r.parts > 1) {
+            qDebug() << "label" << r.label << "in frame" << chan->getFrameId() << "has" << r.parts
+                     << "unconnected parts, only the one with its first pixel is imported";
+            split++;
+        }
+        std::shared_ptr<Object> o = std::make_shared<Object>(r.label - 1, chan);
+        auto outline = std::make_shared<QPolygonF>(r.outline);
+        /* close the polygon, a single pixel becomes a polygon of two equal points */
+        outline->append(outline->first());
+
+        o->setCentroid(std::make_shared<QPoint>(qRound(r.centroid.x()), qRound(r.centroid.y())));
+        o->setBoundingBox(std::make_shared<QRect>(r.boundingBox));
+        o->setOutline(outline);
+        chan->addObject(o);
+    }
+    return split;
+}
+
+}
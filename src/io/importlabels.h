@@ -0,0 +1,81 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMPORTLABELS_H
+#define IMPORTLABELS_H
+
+#include "importxml.h"
+
+#include <memory>
+
+#include <QString>
+#include <QStringList>
+#include <H5Cpp.h>
+
+#include "base/rawimage.h"
+#include "project.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief The ImportLabels class
+ *
+ * Loads a project in the layout of the XML format, but takes the Object%s
+ * from label images instead of the per-frame XML files: every label value
+ * other than 0 in the label image of a frame becomes an Object with the id
+ * label - 1 (the XML format counts from 1 as well, so a tracksXML.xml next to
+ * the images still refers to the right Object%s and is loaded if present).
+ *
+ * The label images are either
+ * - a directory with one TIFF or PNG file per frame, ordered by name. TIFF
+ *   files are read by TiffIO and may have 16 bits per sample, PNG files are
+ *   read through Qt and are limited to 8 bits.
+ * - a dataset of an HDF5 file, given as file.h5:/path/to/dataset, of the
+ *   shape [frames][height][width] (a trailing dimension of size 1 is
+ *   allowed). Labels above 65535 are rejected.
+ *
+ * A label that forms several unconnected parts becomes one Object along the
+ * part with its first pixel, the other parts are reported.
+ *
+ * The outlines, bounding boxes and centroids are found by the BorderTracer.
+ * The frames are traced in parallel on the global QThreadPool, reads from an
+ * HDF5 file hold lockHDF5(). Saving the Project with ExportHDF5 (e.g.
+ * tracurate-cli convert) writes it to the HDF5 format.
+ */
+class ImportLabels : public ImportXML
+{
+public:
+    explicit ImportLabels(QString labels = QString());
+    ~ImportLabels();
+
+    std::shared_ptr<Project> load(QString);
+
+private:
+    int openLabels(QString const &filePath);
+    RawImage readLabels(int frame);
+    int loadObjectsInFrame(RawImage const &labels, std::shared_ptr<Channel> const &chan);
+
+    QString labels;             /*!< the directory or file.h5:/dataset, defaults to the labels directory of the project */
+    QStringList files;          /*!< the label images, if labels is a directory */
+    H5::H5File file;
+    H5::DataSet dataset;
+    int rank = 0;               /*!< the rank of dataset, 0 if labels is a directory */
+};
+
+}
+
+#endif // IMPORTLABELS_H
@@ -48,13 +48,14 @@ public:
     std::shared_ptr<Project> load(QString);
     std::shared_ptr<Project> load(Project::XMLProjectSpec&);
     std::shared_ptr<QImage> requestImage(QString, int, int, int);
-private:
+protected:
     bool loadFrames(QString, std::shared_ptr<Project> const &, int sliceNr, int channelNr);
     bool loadInfo(QString, std::shared_ptr<Project> const &);
+    bool loadAutoTracklets(QString fileName, std::shared_ptr<Project> const &, int sliceNr, int channelNr);
+private:
     bool loadObjects(QString, std::shared_ptr<Project> const &, int sliceNr, int channelNr);
     bool loadObjectsInFrame(QString, std::shared_ptr<Channel> &);
     std::shared_ptr<QPolygonF> loadObjectOutline(QDomElement &);
-    bool loadAutoTracklets(QString fileName, std::shared_ptr<Project> const &, int sliceNr, int channelNr);
 };
 
 }
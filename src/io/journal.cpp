@@ -0,0 +1,941 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "journal.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+#include <QDebug>
+#include <QFile>
+#include <QMap>
+#include <QVector>
+
+#include "base/frame.h"
+#include "base/movie.h"
+#include "tracked/genealogy.h"
+#include "tracked/trackeventdead.hpp"
+#include "tracked/trackeventdivision.hpp"
+#include "tracked/trackeventendofmovie.hpp"
+#include "tracked/trackeventlost.hpp"
+#include "tracked/trackeventmerge.hpp"
+#include "tracked/trackeventunmerge.hpp"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+namespace {
+quint32 const journalMagic = 0x54434A31; /* "TCJ1" */
+quint32 const journalVersion = 1;
+qint64 const headerSize = 2 * sizeof(quint32);
+}
+
+constexpr quint8 Journal::NO_EVENT;
+
+Journal *Journal::theInstance = nullptr;
+
+/*!
+ * \brief constructor for Journal
+ *
+ * This constructor is private, please use Journal::getInstance to obtain an
+ * instance of Journal. The instance should be created on the GUI thread, as
+ * changes are collected from a timer.
+ */
+Journal::Journal(QObject *parent) : QObject(parent)
+{
+    connect(&timer, &QTimer::timeout, this, &Journal::collect);
+    timer.start(1000 * std::max(TCSettings::value("autosave/interval").toInt(), 1));
+}
+
+/*!
+ * \brief returns an instance of the Journal
+ * \return an instance of the Journal
+ */
+Journal *Journal::getInstance()
+{
+    if (!theInstance)
+        theInstance = new Journal();
+    return theInstance;
+}
+
+/*!
+ * \brief provides an instance of Journal for use in QML
+ * \param engine (unused)
+ * \param scriptEngine (unused)
+ * \return a pointer to the instance of Journal
+ */
+QObject *Journal::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine) {
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+
+    return getInstance();
+}
+
+/*!
+ * \brief returns the name of the journal belonging to a HDF5 file
+ * \param fileName the name of the HDF5 file
+ * \return the name of the journal
+ */
+QString Journal::journalFileName(QString const &fileName)
+{
+    return fileName + ".journal";
+}
+
+/*!
+ * \brief hashes a record using 64 bit FNV-1a
+ * \param record the encoded record
+ * \return the hash
+ */
+quint64 Journal::fingerprint(QByteArray const &record)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (char c : record) {
+        hash ^= static_cast<quint8>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*!
+ * \brief encodes the state of a Tracklet
+ * \param out the stream to write to
+ * \param t the Tracklet
+ *
+ * The record holds the contained Object%s, the type of the previous
+ * TrackEvent, type and next Tracklet%s of the next TrackEvent and the
+ * Annotation%s of the Tracklet. Like in the HDF5 file, the links between
+ * Tracklet%s are only stored for the next TrackEvent.
+ */
+void Journal::encodeTracklet(QDataStream &out, std::shared_ptr<Tracklet> const &t)
+{
+    /* sort, so the fingerprint doesn't depend on the order of the QHash */
+    QVector<ObjectKey> objects;
+    objects.reserve(t->getContained().size());
+    for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &p : t->getContained())
+        objects.append({p.first->getID(), p.second->getSliceId(), p.second->getChannelId(), p.second->getId()});
+    std::sort(objects.begin(), objects.end(), [](ObjectKey const &a, ObjectKey const &b) {
+        return std::tie(a.frame, a.slice, a.chan, a.obj) < std::tie(b.frame, b.slice, b.chan, b.obj);
+    });
+
+    out << static_cast<quint8>(REC_TRACKLET) << static_cast<qint32>(t->getId());
+    out << static_cast<quint32>(objects.size());
+    for (ObjectKey const &k : objects)
+        out << k.frame << k.slice << k.chan << k.obj;
+
+    QList<quint32> nextIds;
+    std::shared_ptr<TrackEvent<Tracklet>> next = t->getNext();
+    if (next) {
+        switch (next->getType()) {
+        case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+            for (std::weak_ptr<Tracklet> n : *std::static_pointer_cast<TrackEventDivision<Tracklet>>(next)->getNext())
+                if (n.lock())
+                    nextIds.append(n.lock()->getId());
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+            for (std::weak_ptr<Tracklet> n : *std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(next)->getNext())
+                if (n.lock())
+                    nextIds.append(n.lock()->getId());
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_MERGE: {
+            std::shared_ptr<Tracklet> n = std::static_pointer_cast<TrackEventMerge<Tracklet>>(next)->getNext().lock();
+            if (n)
+                nextIds.append(n->getId());
+            break; }
+        default:
+            break;
+        }
+    }
+    out << (next ? static_cast<quint8>(next->getType()) : NO_EVENT) << nextIds;
+    out << (t->getPrev() ? static_cast<quint8>(t->getPrev()->getType()) : NO_EVENT);
+
+    QList<quint32> annotationIds;
+    for (std::shared_ptr<Annotation> a : *t->getAnnotations())
+        annotationIds.append(a->getId());
+    out << annotationIds;
+}
+
+/*!
+ * \brief returns the record of the current state of a Tracklet
+ * \param t the Tracklet
+ * \return the record, as it is written to the journal
+ */
+QByteArray Journal::trackletRecord(std::shared_ptr<Tracklet> const &t)
+{
+    QByteArray rec;
+    QDataStream out(&rec, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_8);
+    encodeTracklet(out, t);
+    return rec;
+}
+
+/*!
+ * \brief returns the record of a Tracklet that does not exist
+ * \param id the id of the Tracklet
+ * \return the record, as it is written to the journal
+ */
+QByteArray Journal::trackletRemovedRecord(int id)
+{
+    QByteArray rec;
+    QDataStream out(&rec, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_8);
+    out << static_cast<quint8>(REC_TRACKLET_REMOVED) << static_cast<qint32>(id);
+    return rec;
+}
+
+/*!
+ * \brief brings Tracklet%s into the state of concatenated records
+ * \param proj the Project
+ * \param records records of trackletRecord() and trackletRemovedRecord()
+ *
+ * This is what replay() does for the Tracklet%s in the journal, the
+ * UndoStack uses it to restore the Tracklet%s an edit changed.
+ */
+void Journal::applyTrackletRecords(std::shared_ptr<Project> const &proj, QByteArray const &records)
+{
+    if (!proj || !proj->getGenealogy() || !proj->getMovie())
+        return;
+
+    QMap<int, TrackletRecord> tracklets;
+    QDataStream in(records);
+    in.setVersion(QDataStream::Qt_5_8);
+    while (!in.atEnd()) {
+        quint8 type;
+        in >> type;
+        if ((type != REC_TRACKLET && type != REC_TRACKLET_REMOVED) || !readTracklet(in, type, tracklets)) {
+            qDebug() << "invalid tracklet record of type" << type;
+            break;
+        }
+    }
+    applyTracklets(proj, tracklets);
+}
+
+/*!
+ * \brief encodes an Annotation
+ * \param out the stream to write to
+ * \param a the Annotation
+ */
+void Journal::encodeAnnotation(QDataStream &out, std::shared_ptr<Annotation> const &a)
+{
+    out << static_cast<quint8>(REC_ANNOTATION) << a->getId() << static_cast<quint8>(a->getType())
+        << a->getTitle() << a->getDescription();
+}
+
+/*!
+ * \brief encodes the Annotation%s of an Object
+ * \param out the stream to write to
+ * \param key the Object the Annotation%s belong to
+ * \param o the Object or nullptr, if it is no longer annotated
+ */
+void Journal::encodeObjectAnnotations(QDataStream &out, ObjectKey const &key, std::shared_ptr<Annotateable> const &o)
+{
+    QList<quint32> annotationIds;
+    if (o)
+        for (std::shared_ptr<Annotation> a : *o->getAnnotations())
+            annotationIds.append(a->getId());
+    out << static_cast<quint8>(REC_OBJECT_ANNOTATIONS) << key.frame << key.slice << key.chan << key.obj << annotationIds;
+}
+
+/*!
+ * \brief encodes everything that changed since the last call
+ * \param proj the Project to collect from
+ * \param baseline if true, the changes are dropped and no records are returned
+ * \return the concatenated records
+ *
+ * Only the items the Genealogy noted as changed are encoded. The caller has to
+ * hold the mutex.
+ */
+QByteArray Journal::collectRecords(std::shared_ptr<Project> const &proj, bool baseline)
+{
+    QByteArray records;
+    QDataStream out(&records, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_8);
+
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    if (!gen)
+        return records;
+
+    QSet<int> trackletIds;
+    QSet<uint32_t> annotationIds;
+    QList<std::shared_ptr<Object>> objects;
+    gen->takeChanges(trackletIds, annotationIds, objects);
+    if (baseline) {
+        trackletFps.clear();
+        annotationFps.clear();
+        objectFps.clear();
+        return records;
+    }
+
+    QByteArray rec;
+    auto encodeInto = [&rec](std::function<void(QDataStream&)> const &encode) {
+        rec.resize(0);
+        QDataStream s(&rec, QIODevice::WriteOnly);
+        s.setVersion(QDataStream::Qt_5_8);
+        encode(s);
+        return fingerprint(rec);
+    };
+
+    for (uint32_t id : annotationIds) {
+        std::shared_ptr<Annotation> a = gen->getAnnotation(static_cast<int>(id));
+        if (!a) {
+            annotationFps.remove(id);
+            out << static_cast<quint8>(REC_ANNOTATION_REMOVED) << id;
+            continue;
+        }
+        quint64 fp = encodeInto([&a](QDataStream &s) { encodeAnnotation(s, a); });
+        if (annotationFps.value(id) != fp)
+            out.writeRawData(rec.constData(), rec.size());
+        annotationFps.insert(id, fp);
+    }
+
+    for (int id : trackletIds) {
+        std::shared_ptr<Tracklet> t = gen->getTracklet(id);
+        if (!t) {
+            trackletFps.remove(id);
+            out << static_cast<quint8>(REC_TRACKLET_REMOVED) << static_cast<qint32>(id);
+            continue;
+        }
+        quint64 fp = encodeInto([&t](QDataStream &s) { encodeTracklet(s, t); });
+        if (trackletFps.value(id) != fp)
+            out.writeRawData(rec.constData(), rec.size());
+        trackletFps.insert(id, fp);
+    }
+
+    for (std::shared_ptr<Object> const &o : objects) {
+        ObjectKey key{o->getFrameId(), o->getSliceId(), o->getChannelId(), o->getId()};
+        std::shared_ptr<Annotateable> a = o;
+        quint64 fp = encodeInto([&key, &a](QDataStream &s) { encodeObjectAnnotations(s, key, a); });
+        if (objectFps.value(key) != fp)
+            out.writeRawData(rec.constData(), rec.size());
+        objectFps.insert(key, fp);
+    }
+
+    return records;
+}
+
+/*!
+ * \brief appends a block of records to the pending data
+ * \param records the records
+ *
+ * The caller has to hold the mutex.
+ */
+void Journal::writeBlock(QByteArray const &records)
+{
+    QDataStream out(&pending, QIODevice::WriteOnly | QIODevice::Append);
+    out << static_cast<quint32>(records.size());
+    out.writeRawData(records.constData(), records.size());
+    out << fingerprint(records);
+}
+
+/*!
+ * \brief writes the pending blocks to the journal file
+ *
+ * The caller has to hold the mutex.
+ */
+void Journal::writePending()
+{
+    if (pending.isEmpty() || path.isEmpty() || compacting)
+        return;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "could not open the journal" << path;
+        return;
+    }
+    qint64 oldSize = file.size();
+    QByteArray data;
+    if (oldSize == 0) {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << journalMagic << journalVersion;
+    }
+    data.append(pending);
+    /* a partly written block would break the framing of the blocks after it, so it is cut off and written again later */
+    if (file.write(data) != data.size() || !file.flush()) {
+        qDebug() << "could not write to the journal" << path;
+        file.resize(oldSize);
+        return;
+    }
+    written += pending.size();
+    pending.clear();
+}
+
+/*!
+ * \brief collects the changes of the current Project into a new block
+ *
+ * Called from the timer every autosave/interval seconds. The block is written
+ * to disk by flush().
+ */
+void Journal::collect()
+{
+    timer.setInterval(1000 * std::max(TCSettings::value("autosave/interval").toInt(), 1));
+
+    TC_TRACE_SCOPE("Journal::collect");
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Project> proj = project.lock();
+    if (!proj)
+        return;
+
+    /* the Genealogy keeps noting changes, which would pile up */
+    if (!TCSettings::value("autosave/enabled").toBool() || path.isEmpty()) {
+        collectRecords(proj, true);
+        outdated = true;
+        return;
+    }
+    if (outdated) {
+        markChanged(proj);
+        outdated = false;
+    }
+
+    QByteArray records = collectRecords(proj, false);
+    if (!records.isEmpty())
+        writeBlock(records);
+}
+
+/*!
+ * \brief writes collected changes to the journal file
+ *
+ * This is called periodically from the TimeTracker thread, so the GUI thread
+ * never waits for the disk.
+ */
+void Journal::flush()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    writePending();
+}
+
+/*!
+ * \brief throws away the journal, e.g. if the user quits without saving
+ *
+ * If the Project stays open, the next collection writes its complete state.
+ */
+void Journal::discard()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!path.isEmpty())
+        QFile::remove(path);
+    trackletFps.clear();
+    annotationFps.clear();
+    objectFps.clear();
+    pending.clear();
+    written = 0;
+    mark = -1;
+
+    std::shared_ptr<Project> proj = project.lock();
+    if (proj)
+        markChanged(proj);
+}
+
+/*!
+ * \brief notes every Tracklet, Annotation and annotated Object of a Project as changed
+ * \param proj the Project
+ *
+ * The next collection writes its complete state.
+ */
+void Journal::markChanged(std::shared_ptr<Project> const &proj)
+{
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    if (!gen)
+        return;
+    for (std::shared_ptr<Annotation> const &a : *gen->getAnnotations())
+        gen->changed(a);
+    for (std::shared_ptr<Tracklet> const &t : *gen->getTracklets())
+        gen->changed(t);
+    for (std::shared_ptr<Annotateable> const &a : *gen->getAnnotated())
+        if (!a->getAnnotations()->isEmpty() && a->getAnnotations()->first()->getType() == Annotation::OBJECT_ANNOTATION)
+            gen->changed(std::static_pointer_cast<Object>(a));
+}
+
+/*!
+ * \brief starts journaling a Project
+ * \param proj the Project, which should already contain the replayed journal
+ */
+void Journal::open(std::shared_ptr<Project> const &proj)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    project = proj;
+    path = (proj && !proj->getFileName().isEmpty()) ? journalFileName(proj->getFileName()) : QString();
+    trackletFps.clear();
+    annotationFps.clear();
+    objectFps.clear();
+    pending.clear();
+    mark = -1;
+    outdated = false;
+
+    QFile file(path);
+    written = (!path.isEmpty() && file.exists()) ? std::max(file.size() - headerSize, qint64(0)) : 0;
+
+    if (proj)
+        collectRecords(proj, true);
+}
+
+/*!
+ * \brief marks the current state as the one being saved
+ *
+ * Has to be called on the GUI thread right before the ProjectSnapshot for a
+ * complete save is created. After the save, saved() drops everything up to
+ * this point from the journal.
+ */
+void Journal::checkpoint()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<Project> proj = project.lock();
+    if (!proj)
+        return;
+
+    if (path.isEmpty()) {
+        /* not journaled yet, start with the saved state */
+        collectRecords(proj, true);
+        outdated = false;
+        mark = 0;
+        return;
+    }
+    if (outdated) {
+        markChanged(proj);
+        outdated = false;
+    }
+    QByteArray records = collectRecords(proj, false);
+    if (!records.isEmpty())
+        writeBlock(records);
+    mark = written + pending.size();
+}
+
+/*!
+ * \brief compacts the journal after the Project was saved
+ * \param fileName the file the Project was saved to
+ *
+ * Called by the thread that saved the Project. The journal file is rewritten
+ * without holding the mutex, changes collected meanwhile stay pending until
+ * it is done.
+ */
+void Journal::saved(QString const &fileName)
+{
+    QString source;
+    QString target = journalFileName(fileName);
+    qint64 pos;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (mark < 0)
+            return;
+        writePending();
+        source = path;
+        pos = mark;
+        path = target;
+        written = 0;
+        mark = -1;
+        compacting = true;
+    }
+
+    TC_TRACE_SCOPE("Journal::compact");
+    qint64 size = std::max(compact(source, pos, target), qint64(0));
+
+    std::lock_guard<std::mutex> lock(mtx);
+    compacting = false;
+    if (path != target)
+        return;
+    written = size;
+    /* a checkpoint taken meanwhile counted from the start of the compacted journal */
+    if (mark >= 0)
+        mark += size;
+}
+
+/*!
+ * \brief drops the blocks before a checkpoint from a journal
+ * \param source the name of the journal, may be empty
+ * \param pos the position of the checkpoint
+ * \param target the name of the compacted journal
+ * \return the bytes of blocks in the compacted journal, -1 if it could not be written
+ *
+ * Only the blocks collected after the checkpoint are kept.
+ */
+qint64 Journal::compact(QString const &source, qint64 pos, QString const &target)
+{
+    QByteArray tail;
+    if (!source.isEmpty()) {
+        QFile file(source);
+        if (file.open(QIODevice::ReadOnly) && file.size() > headerSize + pos) {
+            file.seek(headerSize + pos);
+            tail = file.readAll();
+        }
+        file.close();
+        if (!file.remove() && file.exists())
+            qDebug() << "could not remove the journal" << source;
+    }
+
+    if (tail.isEmpty()) {
+        QFile::remove(target);
+        return 0;
+    }
+
+    QFile tmp(target + ".tmp");
+    if (!tmp.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return -1;
+    QDataStream out(&tmp);
+    out << journalMagic << journalVersion;
+    out.writeRawData(tail.constData(), tail.size());
+    tmp.close();
+
+    QFile::remove(target);
+    if (!tmp.rename(target))
+        return -1;
+    return tail.size();
+}
+
+namespace {
+/*!
+ * \brief removes a Tracklet from its next TrackEvent
+ * \param t the Tracklet
+ */
+void detachNext(std::shared_ptr<Tracklet> const &t)
+{
+    std::shared_ptr<TrackEvent<Tracklet>> next = t->getNext();
+    if (!next)
+        return;
+
+    switch (next->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+        for (std::weak_ptr<Tracklet> n : *std::static_pointer_cast<TrackEventDivision<Tracklet>>(next)->getNext())
+            if (n.lock() && n.lock()->getPrev() == next)
+                n.lock()->setPrev(nullptr);
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+        for (std::weak_ptr<Tracklet> n : *std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(next)->getNext())
+            if (n.lock() && n.lock()->getPrev() == next)
+                n.lock()->setPrev(nullptr);
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE: {
+        std::shared_ptr<TrackEventMerge<Tracklet>> tem = std::static_pointer_cast<TrackEventMerge<Tracklet>>(next);
+        QMutableListIterator<std::weak_ptr<Tracklet>> it(*tem->getPrev());
+        while (it.hasNext())
+            if (it.next().lock() == t)
+                it.remove();
+        if (tem->getPrev()->isEmpty() && tem->getNext().lock())
+            tem->getNext().lock()->setPrev(nullptr);
+        break; }
+    default:
+        break;
+    }
+    t->setNext(nullptr);
+}
+}
+
+/*!
+ * \brief recreates the next TrackEvent of a Tracklet
+ * \param proj the Project
+ * \param t the Tracklet
+ * \param type the type of the TrackEvent
+ * \param nextIds the ids of the next Tracklet%s
+ *
+ * This links the Tracklet%s in the same way as ImportHDF5 does.
+ */
+void Journal::applyEvent(std::shared_ptr<Project> const &proj, std::shared_ptr<Tracklet> const &t, quint8 type, QList<quint32> const &nextIds)
+{
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    auto nList = std::make_shared<QList<std::weak_ptr<Tracklet>>>();
+
+    switch (type) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION: {
+        auto ted = std::make_shared<TrackEventDivision<Tracklet>>();
+        ted->setPrev(t);
+        for (quint32 id : nextIds) {
+            std::shared_ptr<Tracklet> d = gen->getTracklet(id);
+            if (d) {
+                d->setPrev(ted);
+                nList->append(d);
+            }
+        }
+        ted->setNext(nList);
+        t->setNext(ted);
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE: {
+        auto teu = std::make_shared<TrackEventUnmerge<Tracklet>>();
+        teu->setPrev(t);
+        for (quint32 id : nextIds) {
+            std::shared_ptr<Tracklet> d = gen->getTracklet(id);
+            if (d) {
+                d->setPrev(teu);
+                nList->append(d);
+            }
+        }
+        teu->setNext(nList);
+        t->setNext(teu);
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE: {
+        std::shared_ptr<Tracklet> n = nextIds.isEmpty() ? nullptr : gen->getTracklet(nextIds.first());
+        if (!n)
+            break;
+        std::shared_ptr<TrackEventMerge<Tracklet>> tem;
+        if (n->getPrev() && n->getPrev()->getType() == TrackEvent<Tracklet>::EVENT_TYPE_MERGE) {
+            tem = std::static_pointer_cast<TrackEventMerge<Tracklet>>(n->getPrev());
+        } else {
+            tem = std::make_shared<TrackEventMerge<Tracklet>>();
+            tem->setNext(n);
+            n->setPrev(tem);
+        }
+        tem->getPrev()->append(t);
+        t->setNext(tem);
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_LOST: {
+        auto tel = std::make_shared<TrackEventLost<Tracklet>>();
+        tel->setPrev(t);
+        t->setNext(tel);
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_DEAD: {
+        auto ted = std::make_shared<TrackEventDead<Tracklet>>();
+        ted->setPrev(t);
+        t->setNext(ted);
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_ENDOFMOVIE: {
+        auto teeom = std::make_shared<TrackEventEndOfMovie<Tracklet>>();
+        teeom->setPrev(t);
+        t->setNext(teeom);
+        break; }
+    default:
+        break;
+    }
+}
+
+/*!
+ * \brief reads a Tracklet record into the last state of the Tracklet%s
+ * \param in the stream, positioned after the type of the record
+ * \param type REC_TRACKLET or REC_TRACKLET_REMOVED
+ * \param tracklets the records, the one of the Tracklet is replaced
+ * \return true, if the record could be read
+ */
+bool Journal::readTracklet(QDataStream &in, quint8 type, QMap<int, TrackletRecord> &tracklets)
+{
+    qint32 id;
+    TrackletRecord r;
+    in >> id;
+    if (type == REC_TRACKLET_REMOVED) {
+        r.removed = true;
+    } else {
+        quint32 n;
+        in >> n;
+        r.objects.resize(static_cast<int>(n));
+        for (ObjectKey &k : r.objects)
+            in >> k.frame >> k.slice >> k.chan >> k.obj;
+        in >> r.nextType >> r.nextIds >> r.prevType >> r.annotationIds;
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+    tracklets[id] = r;
+    return true;
+}
+
+/*!
+ * \brief brings Tracklet%s into the state of their records
+ * \param proj the Project
+ * \param tracklets the records of the Tracklet%s
+ *
+ * Tracklet%s that do not exist are created, removed ones are dropped. The
+ * Object%s and Annotation%s the records refer to have to exist.
+ */
+void Journal::applyTracklets(std::shared_ptr<Project> const &proj, QMap<int, TrackletRecord> const &tracklets)
+{
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+
+    /* the old neighbours lose their links, the records are applied directly */
+    for (auto it = tracklets.cbegin(); it != tracklets.cend(); ++it)
+        if (std::shared_ptr<Tracklet> t = gen->getTracklet(it.key()))
+            gen->changed(t);
+
+    /* contents of the Tracklets */
+    QList<std::shared_ptr<Tracklet>> replayed;
+    for (auto it = tracklets.cbegin(); it != tracklets.cend(); ++it) {
+        std::shared_ptr<Tracklet> t = gen->getTracklet(it.key());
+        TrackletRecord const &r = it.value();
+        if (r.removed) {
+            if (t) {
+                for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &p : t->getContained())
+                    t->removeFromContained(p.first->getID(), p.second->getId());
+                gen->removeTracklet(it.key());
+            }
+            continue;
+        }
+        if (t) {
+            for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &p : t->getContained())
+                t->removeFromContained(p.first->getID(), p.second->getId());
+            for (std::shared_ptr<Annotation> a : QList<std::shared_ptr<Annotation>>(*t->getAnnotations()))
+                gen->unannotate(t, a);
+        } else {
+            t = std::make_shared<Tracklet>();
+            t->setId(it.key());
+            gen->addTracklet(t);
+        }
+        for (ObjectKey const &k : r.objects) {
+            std::shared_ptr<Frame> f = proj->getMovie()->getFrame(k.frame);
+            std::shared_ptr<Object> o = gen->getObjectAt(k.frame, k.slice, k.chan, k.obj);
+            if (f && o)
+                t->addToContained(f, o);
+        }
+        for (quint32 id : r.annotationIds)
+            gen->annotate(t, gen->getAnnotation(static_cast<int>(id)));
+        replayed.append(t);
+    }
+
+    /* TrackEvents, like in the HDF5 file they are recreated from the next-side */
+    for (std::shared_ptr<Tracklet> const &t : replayed) {
+        detachNext(t);
+        if (tracklets.value(t->getId()).prevType == NO_EVENT)
+            t->setPrev(nullptr);
+    }
+    for (std::shared_ptr<Tracklet> const &t : replayed) {
+        TrackletRecord r = tracklets.value(t->getId());
+        if (r.nextType != NO_EVENT)
+            applyEvent(proj, t, r.nextType, r.nextIds);
+    }
+    for (std::shared_ptr<Tracklet> const &t : replayed)
+        gen->changed(t);
+}
+
+/*!
+ * \brief applies the journal of a freshly loaded Project
+ * \param proj the Project
+ * \return the number of replayed records
+ *
+ * The journal is read in one pass, only the last record for every Tracklet,
+ * Annotation and Object is applied. A block that was not completely written is
+ * cut off, so new blocks are appended after the last valid one.
+ */
+int Journal::replay(std::shared_ptr<Project> const &proj)
+{
+    TC_TRACE_SCOPE("Journal::replay");
+    if (!proj || !proj->getGenealogy() || !proj->getMovie() || proj->getFileName().isEmpty())
+        return 0;
+
+    QFile file(journalFileName(proj->getFileName()));
+    if (!file.exists() || !file.open(QIODevice::ReadWrite))
+        return 0;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_8);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != journalMagic || version != journalVersion) {
+        qDebug() << "ignoring journal" << file.fileName() << "with unknown format";
+        return 0;
+    }
+
+    struct AnnotationRecord {
+        bool removed = false;
+        quint8 type = 0;
+        QString title, description;
+    };
+    QMap<int, TrackletRecord> tracklets;
+    QMap<quint32, AnnotationRecord> annotations;
+    QHash<ObjectKey, QList<quint32>> objects;
+    int count = 0;
+
+    qint64 valid = file.pos();
+    while (!file.atEnd()) {
+        quint32 len = 0;
+        in >> len;
+        if (in.status() != QDataStream::Ok || file.bytesAvailable() < qint64(len) + qint64(sizeof(quint64)))
+            break;
+        QByteArray block(static_cast<int>(len), Qt::Uninitialized);
+        in.readRawData(block.data(), block.size());
+        quint64 fp = 0;
+        in >> fp;
+        if (fp != fingerprint(block))
+            break;
+        valid = file.pos();
+
+        QDataStream rs(block);
+        rs.setVersion(QDataStream::Qt_5_8);
+        while (!rs.atEnd()) {
+            quint8 type;
+            rs >> type;
+            switch (type) {
+            case REC_TRACKLET:
+            case REC_TRACKLET_REMOVED:
+                readTracklet(rs, type, tracklets);
+                break;
+            case REC_ANNOTATION: {
+                quint32 id;
+                AnnotationRecord r;
+                rs >> id >> r.type >> r.title >> r.description;
+                annotations[id] = r;
+                break; }
+            case REC_ANNOTATION_REMOVED: {
+                quint32 id;
+                rs >> id;
+                annotations[id] = AnnotationRecord();
+                annotations[id].removed = true;
+                break; }
+            case REC_OBJECT_ANNOTATIONS: {
+                ObjectKey k;
+                QList<quint32> ids;
+                rs >> k.frame >> k.slice >> k.chan >> k.obj >> ids;
+                objects[k] = ids;
+                break; }
+            default:
+                qDebug() << "unknown record type" << type << "in journal" << file.fileName();
+                rs.setStatus(QDataStream::ReadCorruptData);
+            }
+            if (rs.status() != QDataStream::Ok)
+                break;
+            count++;
+        }
+    }
+    if (valid < file.size()) {
+        qDebug() << "cutting off incomplete block at" << valid << "in journal" << file.fileName();
+        file.resize(valid);
+    }
+    file.close();
+
+    if (count == 0)
+        return 0;
+
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+
+    /* Annotations first, they are referenced by Tracklets and Objects */
+    for (auto it = annotations.cbegin(); it != annotations.cend(); ++it) {
+        std::shared_ptr<Annotation> a = gen->getAnnotation(static_cast<int>(it.key()));
+        AnnotationRecord const &r = it.value();
+        if (r.removed) {
+            if (a)
+                gen->deleteAnnotation(a);
+            continue;
+        }
+        Annotation::ANNOTATION_TYPE type = static_cast<Annotation::ANNOTATION_TYPE>(r.type);
+        if (!a) {
+            gen->addAnnotation(std::make_shared<Annotation>(type, it.key(), r.title, r.description));
+        } else {
+            a->setType(type);
+            a->setTitle(r.title);
+            a->setDescription(r.description);
+        }
+    }
+
+    applyTracklets(proj, tracklets);
+
+    for (auto it = objects.cbegin(); it != objects.cend(); ++it) {
+        ObjectKey const &k = it.key();
+        std::shared_ptr<Object> o = gen->getObjectAt(k.frame, k.slice, k.chan, k.obj);
+        if (!o)
+            continue;
+        for (std::shared_ptr<Annotation> a : QList<std::shared_ptr<Annotation>>(*o->getAnnotations()))
+            gen->unannotate(o, a);
+        for (quint32 id : it.value())
+            gen->annotate(o, gen->getAnnotation(static_cast<int>(id)));
+    }
+
+    MessageRelay::emitUpdateStatusBar(QString("Recovered %1 changes from the autosave journal").arg(count));
+    return count;
+}
+}
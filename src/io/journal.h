@@ -0,0 +1,156 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <memory>
+#include <mutex>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QJSEngine>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QQmlEngine>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include "project.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+/*!
+ * \brief The Journal class
+ *
+ * Implements the autosave of TraCurate. Changes to Tracklet%s, TrackEvent%s
+ * and Annotation%s are appended to a binary journal next to the HDF5 file
+ * (\<file\>.journal), which is replayed when the file is opened again. Saving
+ * the Project compacts the journal by dropping everything that is now
+ * contained in the HDF5 file.
+ *
+ * The Genealogy notes which Tracklet%s, Annotation%s and annotated Object%s
+ * were changed. Collecting happens on the GUI thread every autosave/interval
+ * seconds and only encodes these, an item whose fingerprint did not change
+ * since it was last written is skipped. The encoded records are written to
+ * disk by the TimeTracker thread, the journal is compacted by the thread
+ * that saved the Project. While autosave is off, the noted changes are
+ * dropped at every interval, and everything is collected again once it is
+ * turned back on.
+ *
+ * Segmentation changes are not journaled, ModifyHDF5 already writes them to
+ * the HDF5 file when they are made.
+ *
+ * The UndoStack keeps the records of the Tracklet%s an edit changed and
+ * restores them with applyTrackletRecords().
+ *
+ * The journal is a header followed by blocks of the form
+ * [length][records][checksum]. A block that was not completely written
+ * (e.g. because TraCurate crashed) fails the checksum and is ignored on replay.
+ */
+class Journal : public QObject
+{
+    Q_OBJECT
+public:
+    static Journal *getInstance();
+    static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
+    static QString journalFileName(QString const &fileName);
+
+    int replay(std::shared_ptr<Project> const &proj);
+    void open(std::shared_ptr<Project> const &proj);
+    void checkpoint();
+    void saved(QString const &fileName);
+    void flush();
+    Q_INVOKABLE void discard();
+
+    static QByteArray trackletRecord(std::shared_ptr<Tracklet> const &t);
+    static QByteArray trackletRemovedRecord(int id);
+    static void applyTrackletRecords(std::shared_ptr<Project> const &proj, QByteArray const &records);
+
+public slots:
+    void collect();
+
+private:
+    explicit Journal(QObject *parent = nullptr);
+    static Journal *theInstance;
+
+    enum RECORD_TYPE : quint8 {
+        REC_TRACKLET = 1,
+        REC_TRACKLET_REMOVED = 2,
+        REC_ANNOTATION = 3,
+        REC_ANNOTATION_REMOVED = 4,
+        REC_OBJECT_ANNOTATIONS = 5
+    };
+
+    static constexpr quint8 NO_EVENT = 0xFF;
+
+    /* a reference to an Object by frame, slice, channel and object id */
+    struct ObjectKey {
+        quint32 frame, slice, chan, obj;
+        bool operator==(ObjectKey const &o) const {
+            return frame == o.frame && slice == o.slice && chan == o.chan && obj == o.obj;
+        }
+        friend uint qHash(ObjectKey const &key, uint seed = 0) {
+            return qHashBits(&key, sizeof(key), seed);
+        }
+    };
+
+    /* the last state of a Tracklet read from the journal */
+    struct TrackletRecord {
+        bool removed = false;
+        QVector<ObjectKey> objects;
+        quint8 nextType = NO_EVENT;
+        QList<quint32> nextIds;
+        quint8 prevType = NO_EVENT;
+        QList<quint32> annotationIds;
+    };
+
+    static quint64 fingerprint(QByteArray const &record);
+    static void encodeTracklet(QDataStream &out, std::shared_ptr<Tracklet> const &t);
+    static void encodeAnnotation(QDataStream &out, std::shared_ptr<Annotation> const &a);
+    static void encodeObjectAnnotations(QDataStream &out, ObjectKey const &key, std::shared_ptr<Annotateable> const &o);
+    static void applyEvent(std::shared_ptr<Project> const &proj, std::shared_ptr<Tracklet> const &t, quint8 type, QList<quint32> const &nextIds);
+    static bool readTracklet(QDataStream &in, quint8 type, QMap<int, TrackletRecord> &tracklets);
+    static void applyTracklets(std::shared_ptr<Project> const &proj, QMap<int, TrackletRecord> const &tracklets);
+
+    static qint64 compact(QString const &source, qint64 pos, QString const &target);
+
+    QByteArray collectRecords(std::shared_ptr<Project> const &proj, bool baseline);
+    static void markChanged(std::shared_ptr<Project> const &proj);
+    void writeBlock(QByteArray const &records);
+    void writePending();
+
+    QTimer timer;
+
+    std::mutex mtx;                                 /*!< protects all members below */
+    std::weak_ptr<Project> project;
+    QString path;                                   /*!< file name of the journal, empty if none */
+    QHash<int, quint64> trackletFps;                /*!< fingerprints of the records written since the last baseline */
+    QHash<quint32, quint64> annotationFps;
+    QHash<ObjectKey, quint64> objectFps;
+    QByteArray pending;                             /*!< encoded blocks, not yet written */
+    qint64 written = 0;                             /*!< bytes of blocks in the journal file */
+    qint64 mark = -1;                               /*!< position of the last checkpoint */
+    bool compacting = false;                        /*!< saved() is rewriting the journal file */
+    bool outdated = false;                          /*!< changes were dropped while autosave was off */
+};
+}
+
+#endif // JOURNAL_H
@@ -17,12 +17,16 @@
  */
 #include "modifyhdf5.h"
 
+#include <algorithm>
+
 #include <H5Cpp.h>
 #include <QString>
 
+#include "exporthdf5.h"
 #include "hdf5_aux.h"
 #include "provider/guistate.h"
 #include "provider/messagerelay.h"
+#include "provider/tracer.h"
 
 namespace TraCurate {
 bool ModifyHDF5::checkObjectExists(H5::H5File file, std::shared_ptr<Object> object) {
@@ -46,7 +50,7 @@ bool ModifyHDF5::checkObjectExistsInTracklet(H5::H5File file, std::shared_ptr<Tr
     std::string path = hdfSearch(file, t, o);
     std::string tPath = hdfPath(t);
 
-    if (!linkExists(file, path.c_str()))
+    if (path.empty() || !linkExists(file, path.c_str()))
         return false;
     if (!linkExists(file, tPath))
         return false;
@@ -68,7 +72,7 @@ bool ModifyHDF5::checkObjectExistsInAutoTracklet(H5::H5File file, std::shared_pt
     std::string path = hdfSearch(file, at, o);
     std::string atPath = hdfPath(at);
 
-    if (!linkExists(file, path.c_str()))
+    if (path.empty() || !linkExists(file, path.c_str()))
         return false;
     if (!linkExists(file, atPath))
         return false;
@@ -83,6 +87,65 @@ bool ModifyHDF5::checkObjectExistsInAutoTracklet(H5::H5File file, std::shared_pt
             && readSingleValue<uint32_t>(atGroup, "autotracklet_id") == o->getAutoId());
 }
 
+/*!
+ * \brief removes an Object from the membership table of a Tracklet or AutoTracklet
+ * \param file the HDF5 file
+ * \param path the path of the Tracklet or AutoTracklet
+ * \param o the Object to remove
+ * \return true, if the Object was in the table
+ */
+bool ModifyHDF5::removeMember(H5::H5File file, std::string const &path, std::shared_ptr<Object> o) {
+    using namespace H5;
+
+    if (!linkExists(file, path))
+        return false;
+    Group grp = file.openGroup(path);
+    if (!datasetExists(grp, "members"))
+        return false;
+
+    std::vector<MemberRow> members = readMembers(grp);
+    auto it = std::find(members.begin(), members.end(), memberRow(o));
+    if (it == members.end())
+        return false;
+    members.erase(it);
+    writeMembers(members, grp);
+    return true;
+}
+
+/*!
+ * \brief adds an Object to the membership table of a Tracklet or AutoTracklet
+ * \param file the HDF5 file
+ * \param path the path of the Tracklet or AutoTracklet
+ * \param o the Object to add
+ * \return true, if the Object was added
+ *
+ * If the Tracklet or AutoTracklet also has links to its Object%s, a link is
+ * added as well.
+ */
+bool ModifyHDF5::addMember(H5::H5File file, std::string const &path, std::shared_ptr<Object> o) {
+    using namespace H5;
+
+    if (!linkExists(file, path))
+        return false;
+    Group grp = file.openGroup(path);
+    if (!datasetExists(grp, "members"))
+        return false;
+
+    std::vector<MemberRow> members = readMembers(grp);
+    MemberRow m = memberRow(o);
+    if (std::find(members.begin(), members.end(), m) != members.end())
+        return false;
+    members.push_back(m);
+    std::sort(members.begin(), members.end());
+    writeMembers(members, grp);
+
+    if (groupExists(grp, "objects")) {
+        Group objectsGroup = grp.openGroup("objects");
+        linkOrOverwriteLink(H5L_TYPE_SOFT, objectsGroup, ExportHDF5::memberPath(m), std::to_string(m[0]));
+    }
+    return true;
+}
+
 bool ModifyHDF5::removeObject(H5::H5File file, std::shared_ptr<Object> o) {
     using namespace H5;
 
@@ -109,6 +172,7 @@ bool ModifyHDF5::removeObject(H5::H5File file, std::shared_ptr<Object> o) {
                     file.unlink(objPath);
                 /*! \todo update the tracklet (start, end) */
             }
+            removeMember(file, hdfPath(tracklet), o);
         }
     }
     /* remove from autotracklet */
@@ -116,15 +180,19 @@ bool ModifyHDF5::removeObject(H5::H5File file, std::shared_ptr<Object> o) {
         uint32_t atid = o->getAutoId();
         std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(atid);
         if (at) {
-            /* These should always exist in the file */
-            if (!checkObjectExistsInAutoTracklet(file, at, o))
+            /* These should always exist in the file, either as link or in the membership table */
+            bool linked = checkObjectExistsInAutoTracklet(file, at, o);
+            bool listed = removeMember(file, hdfPath(at), o);
+            if (!linked && !listed)
                 return false;
 
-            /*! \todo replace by hdfSearch if groupname is framenumber in data format */
-            std::string objPath = hdfSearch(file, at, o);
-            Group objectGroup = file.openGroup(objPath);
-            if (getLinkType(objectGroup) == H5L_TYPE_SOFT)
-                file.unlink(objPath);
+            if (linked) {
+                /*! \todo replace by hdfSearch if groupname is framenumber in data format */
+                std::string objPath = hdfSearch(file, at, o);
+                Group objectGroup = file.openGroup(objPath);
+                if (getLinkType(objectGroup) == H5L_TYPE_SOFT)
+                    file.unlink(objPath);
+            }
             /*! \todo update the autotracklet (start, end) */
         }
     }
@@ -141,6 +209,8 @@ bool ModifyHDF5::removeObject(H5::H5File file, std::shared_ptr<Object> o) {
 
 bool ModifyHDF5::removeObject(QString filename, std::shared_ptr<Object> o) {
     using namespace H5;
+    TC_TRACE_SCOPE("ModifyHDF5::removeObject");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
 
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     if (!proj)
@@ -148,7 +218,7 @@ bool ModifyHDF5::removeObject(QString filename, std::shared_ptr<Object> o) {
 
     if (!H5File::isHdf5(filename.toStdString()))
         return false;
-    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR);
+    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR, FileCreatPropList::DEFAULT, ExportHDF5::writeAccess());
 
     return removeObject(file, o);
 }
@@ -160,11 +230,22 @@ bool ModifyHDF5::insertObject(H5::H5File file, std::shared_ptr<Object> o) {
 
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
 
-    return ExportHDF5::saveObject(file, proj, o);
+    if (!ExportHDF5::saveObject(file, proj, o))
+        return false;
+
+    /* an Object that takes the place of another one (resegmentation) or is put
+     * back (UndoStack) is listed in its AutoTracklet, AutoTracklets are not
+     * written again when the Project is saved */
+    std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+    if (at)
+        addMember(file, hdfPath(at), o);
+    return true;
 }
 
 bool ModifyHDF5::insertObject(QString filename, std::shared_ptr<Object> o) {
     using namespace H5;
+    TC_TRACE_SCOPE("ModifyHDF5::insertObject");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
 
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     if (!proj)
@@ -172,7 +253,7 @@ bool ModifyHDF5::insertObject(QString filename, std::shared_ptr<Object> o) {
 
     if (!H5File::isHdf5(filename.toStdString()))
         return false;
-    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR);
+    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR, FileCreatPropList::DEFAULT, ExportHDF5::writeAccess());
 
     return insertObject(file, o);
 }
@@ -180,8 +261,31 @@ bool ModifyHDF5::insertObject(QString filename, std::shared_ptr<Object> o) {
 bool ModifyHDF5::replaceObjects(QString filename,
                                 std::initializer_list<std::shared_ptr<Object>> oldObjects,
                                 std::initializer_list<std::shared_ptr<Object>> newObjects)
+{
+    return replaceObjects(filename, QList<std::shared_ptr<Object>>(oldObjects), QList<std::shared_ptr<Object>>(newObjects));
+}
+
+bool ModifyHDF5::replaceObjects(QString filename,
+                                QList<std::shared_ptr<Object>> const &oldObjects,
+                                QList<std::shared_ptr<Object>> const &newObjects)
+{
+    return replaceObjects(filename, QList<Replacement>{Replacement{oldObjects, newObjects}});
+}
+
+/*!
+ * \brief applies several replacements of Object%s, opening the HDF5 file only once
+ * \param filename the HDF5 file
+ * \param replacements the replacements
+ * \return true, if all replacements were applied
+ *
+ * All replacements are checked before the file is modified, so nothing is
+ * changed if one of them refers to Object%s that do (not) exist.
+ */
+bool ModifyHDF5::replaceObjects(QString filename, QList<Replacement> const &replacements)
 {
     using namespace H5;
+    TC_TRACE_SCOPE("ModifyHDF5::replaceObjects");
+    std::unique_lock<std::recursive_mutex> lock = lockHDF5();
 
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     if (!proj)
@@ -189,28 +293,32 @@ bool ModifyHDF5::replaceObjects(QString filename,
 
     if (!H5File::isHdf5(filename.toStdString()))
         return false;
-    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR);
+    H5File file(filename.toStdString().c_str(), H5F_ACC_RDWR, FileCreatPropList::DEFAULT, ExportHDF5::writeAccess());
 
-    for (std::shared_ptr<Object> o : oldObjects)
-        if (!checkObjectExists(file, o)) /* old objects have to exist */
-            return false;
-    for (std::shared_ptr<Object> o : newObjects)
-        if (checkObjectExists(file, o)) /* new objects may not yet exist */
-            return false;
+    for (Replacement const &r : replacements) {
+        for (std::shared_ptr<Object> o : r.oldObjects)
+            if (!checkObjectExists(file, o)) /* old objects have to exist */
+                return false;
+        for (std::shared_ptr<Object> o : r.newObjects)
+            if (checkObjectExists(file, o)) /* new objects may not yet exist */
+                return false;
+    }
 
     bool ret = true;
-    for (std::shared_ptr<Object> o : oldObjects) { /* "delete" the old objects */
-        ret &= removeObject(file, o);
-        if (!ret) {
-            MessageRelay::emitUpdateStatusBar("Could not remove old objects from HDF5 file!");
-            return false;
+    for (Replacement const &r : replacements) {
+        for (std::shared_ptr<Object> o : r.oldObjects) { /* "delete" the old objects */
+            ret &= removeObject(file, o);
+            if (!ret) {
+                MessageRelay::emitUpdateStatusBar("Could not remove old objects from HDF5 file!");
+                return false;
+            }
         }
-    }
-    for (std::shared_ptr<Object> o : newObjects) { /* create the new objects */
-        ret &= insertObject(file, o);
-        if (!ret) {
-            MessageRelay::emitUpdateStatusBar("Could not insert new objects into HDF5 file!");
-            return false;
+        for (std::shared_ptr<Object> o : r.newObjects) { /* create the new objects */
+            ret &= insertObject(file, o);
+            if (!ret) {
+                MessageRelay::emitUpdateStatusBar("Could not insert new objects into HDF5 file!");
+                return false;
+            }
         }
     }
 
@@ -19,6 +19,7 @@
 #define MODIFYHDF5_H
 
 #include <memory>
+#include <QList>
 #include <QString>
 #include <initializer_list>
 
@@ -35,12 +36,22 @@ public:
     ModifyHDF5() = delete;
     ~ModifyHDF5() = delete;
 
+    /*! \brief Object%s that are replaced by other Object%s */
+    struct Replacement {
+        QList<std::shared_ptr<Object>> oldObjects;
+        QList<std::shared_ptr<Object>> newObjects;
+    };
+
     static bool removeObject(QString filename, std::shared_ptr<Object> o);
     static bool insertObject(QString filename, std::shared_ptr<Object> o);
 
     static bool replaceObjects(QString filename,
                                std::initializer_list<std::shared_ptr<Object> > oldObjects,
                                std::initializer_list<std::shared_ptr<Object> > newObjects);
+    static bool replaceObjects(QString filename,
+                               QList<std::shared_ptr<Object>> const &oldObjects,
+                               QList<std::shared_ptr<Object>> const &newObjects);
+    static bool replaceObjects(QString filename, QList<Replacement> const &replacements);
     static bool replaceObjects(QString filename,
                               std::shared_ptr<Object> oldObject,
                               std::initializer_list<std::shared_ptr<Object>> newObjects);
@@ -57,6 +68,8 @@ private:
     static bool checkObjectExists(H5::H5File file, std::shared_ptr<Object> object);
     static bool checkObjectExistsInTracklet(H5::H5File file, std::shared_ptr<Tracklet> t, std::shared_ptr<Object> o);
     static bool checkObjectExistsInAutoTracklet(H5::H5File file, std::shared_ptr<AutoTracklet> at, std::shared_ptr<Object> o);
+    static bool removeMember(H5::H5File file, std::string const &path, std::shared_ptr<Object> o);
+    static bool addMember(H5::H5File file, std::string const &path, std::shared_ptr<Object> o);
 };
 }
 
@@ -0,0 +1,254 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "projectsnapshot.h"
+
+#include "base/frame.h"
+#include "base/movie.h"
+#include "base/slice.h"
+#include "tracked/genealogy.h"
+#include "tracked/trackeventdead.hpp"
+#include "tracked/trackeventdivision.hpp"
+#include "tracked/trackeventendofmovie.hpp"
+#include "tracked/trackeventlost.hpp"
+#include "tracked/trackeventmerge.hpp"
+#include "tracked/trackeventunmerge.hpp"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief creates a snapshot of a Project
+ * \param proj the Project to copy
+ * \return the snapshot or nullptr if proj is nullptr
+ */
+std::shared_ptr<Project> ProjectSnapshot::create(std::shared_ptr<Project> const &proj)
+{
+    TC_TRACE_SCOPE("ProjectSnapshot::create");
+    if (!proj)
+        return nullptr;
+
+    Mapping m;
+    std::shared_ptr<Project> snap = std::make_shared<Project>();
+    snap->setInfo(proj->getInfo());
+    snap->setCoordinateSystemInfo(proj->getCoordinateSystemInfo());
+    snap->setFileName(proj->getFileName());
+    snap->setProjectSpec(proj->getProjectSpec());
+    snap->setImported(proj->getImported());
+
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    std::shared_ptr<Genealogy> snapGen;
+    if (gen) {
+        /* Annotations first, they are referenced by Objects and Tracklets */
+        snapGen = std::make_shared<Genealogy>(snap);
+        auto annotations = std::make_shared<QList<std::shared_ptr<Annotation>>>();
+        for (std::shared_ptr<Annotation> a : *gen->getAnnotations()) {
+            std::shared_ptr<Annotation> copy(new Annotation(*a));
+            m.annotations.insert(a.get(), copy);
+            annotations->append(copy);
+        }
+        snapGen->setAnnotations(annotations);
+        snap->setGenealogy(snapGen);
+    }
+
+    if (proj->getMovie())
+        snap->setMovie(copyMovie(proj->getMovie(), m));
+
+    for (std::shared_ptr<AutoTracklet> at : proj->getAutoTracklets()) {
+        std::shared_ptr<AutoTracklet> copy(new AutoTracklet(*at));
+        for (auto it = copy->components.begin(); it != copy->components.end(); ++it)
+            it.value() = m.objects.value(it.value().get(), it.value());
+        /* the events of AutoTracklets are not exported, so they are left out */
+        snap->addAutoTracklet(copy);
+    }
+
+    if (!gen)
+        return snap;
+
+    /* Tracklets need to exist before the TrackEvents referencing them are copied */
+    QList<std::shared_ptr<Tracklet>> origTracklets = gen->getTracklets()->values();
+    for (std::shared_ptr<Tracklet> t : origTracklets) {
+        std::shared_ptr<Tracklet> copy(new Tracklet(*t));
+        for (auto it = copy->contained.begin(); it != copy->contained.end(); ++it) {
+            QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> &p = it.value();
+            p.first = m.frames.value(p.first.get(), p.first);
+            p.second = m.objects.value(p.second.get(), p.second);
+        }
+        copyAnnotations(t, copy, m);
+        m.tracklets.insert(t.get(), copy);
+        snapGen->addTracklet(copy);
+    }
+    for (std::shared_ptr<Tracklet> t : origTracklets) {
+        std::shared_ptr<Tracklet> copy = m.tracklets.value(t.get());
+        copy->setNext(copyEvent(t->getNext(), m));
+        copy->setPrev(copyEvent(t->getPrev(), m));
+    }
+
+    auto annotated = std::make_shared<QList<std::shared_ptr<Annotateable>>>();
+    for (std::shared_ptr<Annotateable> a : *gen->getAnnotated()) {
+        if (a->getAnnotations()->isEmpty())
+            continue;
+        /* Annotateable is not polymorphic, like ExportHDF5 use the type of the annotations */
+        switch (a->getAnnotations()->first()->getType()) {
+        case Annotation::OBJECT_ANNOTATION: {
+            std::shared_ptr<Object> o = std::static_pointer_cast<Object>(a);
+            annotated->append(m.objects.value(o.get(), o));
+            break; }
+        case Annotation::TRACKLET_ANNOTATION: {
+            std::shared_ptr<Tracklet> t = std::static_pointer_cast<Tracklet>(a);
+            annotated->append(m.tracklets.value(t.get(), t));
+            break; }
+        }
+    }
+    snapGen->setAnnotated(annotated);
+
+    return snap;
+}
+
+/*!
+ * \brief copies the Movie and all Frame%s, Slice%s, Channel%s and Object%s in it
+ * \param movie the Movie to copy
+ * \param m the Mapping, to which the copied Frame%s and Object%s are added
+ * \return the copy of the Movie
+ */
+std::shared_ptr<Movie> ProjectSnapshot::copyMovie(std::shared_ptr<Movie> const &movie, Mapping &m)
+{
+    std::shared_ptr<Movie> snapMovie = std::make_shared<Movie>();
+    for (std::shared_ptr<Frame> f : movie->getFrames()) {
+        std::shared_ptr<Frame> snapFrame = std::make_shared<Frame>(f->getID());
+        for (std::shared_ptr<Slice> s : f->getSlices()) {
+            std::shared_ptr<Slice> snapSlice = std::make_shared<Slice>(s->getSliceId(), s->getFrameId());
+            for (std::shared_ptr<Channel> c : s->getChannels()) {
+                std::shared_ptr<Channel> snapChan = std::make_shared<Channel>(c->getChanId(), c->getSliceId(), c->getFrameId());
+                snapChan->setImage(c->getImage());
+                FeatureTable const &features = c->getFeatures();
+                for (std::shared_ptr<Object> o : c->getObjects()) {
+                    std::shared_ptr<Object> snapObj = std::make_shared<Object>(o->getId(), snapChan);
+                    snapObj->setTrackId(o->getTrackId());
+                    snapObj->setAutoId(o->getAutoId());
+                    snapObj->setCentroid(o->getCentroid());
+                    snapObj->setBoundingBox(o->getBoundingBox());
+                    snapObj->shareOutline(*o);
+                    copyAnnotations(o, snapObj, m);
+                    if (features.contains(o->getId()))
+                        snapChan->addObject(snapObj, features.get(o->getId()));
+                    else
+                        snapChan->addObject(snapObj);
+                    m.objects.insert(o.get(), snapObj);
+                }
+                snapSlice->addChannel(snapChan);
+            }
+            snapFrame->addSlice(snapSlice);
+        }
+        snapMovie->addFrame(snapFrame);
+        m.frames.insert(f.get(), snapFrame);
+    }
+    return snapMovie;
+}
+
+/*!
+ * \brief copies the Annotation%s of one Annotateable to another, using the copied Annotation%s
+ * \param from the original Annotateable
+ * \param to the copy of the Annotateable
+ * \param m the Mapping that holds the copied Annotation%s
+ */
+void ProjectSnapshot::copyAnnotations(std::shared_ptr<Annotateable> const &from, std::shared_ptr<Annotateable> const &to, Mapping &m)
+{
+    if (from->getAnnotations()->isEmpty()) /* the copy already has an empty list */
+        return;
+    auto list = std::make_shared<QList<std::shared_ptr<Annotation>>>();
+    for (std::shared_ptr<Annotation> a : *from->getAnnotations())
+        list->append(m.annotations.value(a.get(), a));
+    to->setAnnotations(list);
+}
+
+std::weak_ptr<Tracklet> ProjectSnapshot::mapTracklet(std::weak_ptr<Tracklet> const &t, Mapping &m)
+{
+    std::shared_ptr<Tracklet> orig = t.lock();
+    if (!orig)
+        return std::weak_ptr<Tracklet>();
+    return m.tracklets.value(orig.get(), orig);
+}
+
+std::shared_ptr<QList<std::weak_ptr<Tracklet>>> ProjectSnapshot::mapTracklets(std::shared_ptr<QList<std::weak_ptr<Tracklet>>> const &ts, Mapping &m)
+{
+    auto ret = std::make_shared<QList<std::weak_ptr<Tracklet>>>();
+    for (std::weak_ptr<Tracklet> const &t : *ts)
+        ret->append(mapTracklet(t, m));
+    return ret;
+}
+
+/*!
+ * \brief copies a TrackEvent, replacing the Tracklet%s it references with their copies
+ * \param ev the TrackEvent to copy
+ * \param m the Mapping that holds the copied Tracklet%s and TrackEvent%s
+ * \return the copy of the TrackEvent (the same copy if called multiple times with the same TrackEvent)
+ */
+std::shared_ptr<TrackEvent<Tracklet>> ProjectSnapshot::copyEvent(std::shared_ptr<TrackEvent<Tracklet>> const &ev, Mapping &m)
+{
+    if (!ev)
+        return nullptr;
+    if (m.events.contains(ev.get()))
+        return m.events.value(ev.get());
+
+    std::shared_ptr<TrackEvent<Tracklet>> ret;
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION: {
+        auto orig = std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventDivision<Tracklet>>();
+        copy->setPrev(mapTracklet(orig->getPrev(), m));
+        copy->setNext(mapTracklets(orig->getNext(), m));
+        ret = copy;
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE: {
+        auto orig = std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventMerge<Tracklet>>();
+        copy->setPrev(mapTracklets(orig->getPrev(), m));
+        copy->setNext(mapTracklet(orig->getNext(), m));
+        ret = copy;
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE: {
+        auto orig = std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventUnmerge<Tracklet>>();
+        copy->setPrev(mapTracklet(orig->getPrev(), m));
+        copy->setNext(mapTracklets(orig->getNext(), m));
+        ret = copy;
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_LOST: {
+        auto orig = std::static_pointer_cast<TrackEventLost<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventLost<Tracklet>>();
+        copy->setPrev(mapTracklet(orig->getPrev(), m));
+        ret = copy;
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_DEAD: {
+        auto orig = std::static_pointer_cast<TrackEventDead<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventDead<Tracklet>>();
+        copy->setPrev(mapTracklet(orig->getPrev(), m));
+        ret = copy;
+        break; }
+    case TrackEvent<Tracklet>::EVENT_TYPE_ENDOFMOVIE: {
+        auto orig = std::static_pointer_cast<TrackEventEndOfMovie<Tracklet>>(ev);
+        auto copy = std::make_shared<TrackEventEndOfMovie<Tracklet>>();
+        copy->setPrev(mapTracklet(orig->getPrev(), m));
+        ret = copy;
+        break; }
+    }
+
+    m.events.insert(ev.get(), ret);
+    return ret;
+}
+}
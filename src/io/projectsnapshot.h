@@ -0,0 +1,77 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef PROJECTSNAPSHOT_H
+#define PROJECTSNAPSHOT_H
+
+#include <memory>
+
+#include <QHash>
+
+#include "project.h"
+#include "base/autotracklet.h"
+#include "base/channel.h"
+#include "base/object.h"
+#include "tracked/annotation.h"
+#include "tracked/annotateable.h"
+#include "tracked/trackevent.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+/*!
+ * \brief The ProjectSnapshot class
+ *
+ * Creates a frozen copy of a Project, so it can be exported in the background
+ * while the GUI keeps modifying the original.
+ *
+ * The copy is structural: every Frame, Slice, Channel, Object, AutoTracklet,
+ * Tracklet, TrackEvent and Annotation is copied, but the Qt-containers are
+ * implicitly shared and detach only when the original is modified afterwards.
+ * The geometry of Objects (outline and its simplified versions, bounding box,
+ * centroid) is shared, as it is never modified in place, and the rows of the
+ * FeatureTable%s are copied instead of computed again. Copied Tracklet%s, AutoTracklet%s and
+ * Annotation%s keep their ids without claiming them from the IdProvider.
+ *
+ * A snapshot has to be created on the thread that modifies the Project (i.e.
+ * the GUI thread).
+ */
+class ProjectSnapshot
+{
+public:
+    ProjectSnapshot() = delete;
+    ~ProjectSnapshot() = delete;
+
+    static std::shared_ptr<Project> create(std::shared_ptr<Project> const &proj);
+
+private:
+    struct Mapping {
+        QHash<Frame*, std::shared_ptr<Frame>> frames;
+        QHash<Object*, std::shared_ptr<Object>> objects;
+        QHash<Tracklet*, std::shared_ptr<Tracklet>> tracklets;
+        QHash<Annotation*, std::shared_ptr<Annotation>> annotations;
+        QHash<TrackEvent<Tracklet>*, std::shared_ptr<TrackEvent<Tracklet>>> events;
+    };
+
+    static std::shared_ptr<Movie> copyMovie(std::shared_ptr<Movie> const &movie, Mapping &m);
+    static void copyAnnotations(std::shared_ptr<Annotateable> const &from, std::shared_ptr<Annotateable> const &to, Mapping &m);
+    static std::weak_ptr<Tracklet> mapTracklet(std::weak_ptr<Tracklet> const &t, Mapping &m);
+    static std::shared_ptr<QList<std::weak_ptr<Tracklet>>> mapTracklets(std::shared_ptr<QList<std::weak_ptr<Tracklet>>> const &ts, Mapping &m);
+    static std::shared_ptr<TrackEvent<Tracklet>> copyEvent(std::shared_ptr<TrackEvent<Tracklet>> const &ev, Mapping &m);
+};
+}
+
+#endif // PROJECTSNAPSHOT_H
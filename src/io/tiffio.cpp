@@ -0,0 +1,191 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "tiffio.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QSysInfo>
+#include <QVector>
+#include <QtEndian>
+
+#include "exceptions/tcexportexception.h"
+#include "exceptions/tcimportexception.h"
+
+namespace TraCurate {
+
+quint32 TiffIO::readValue(QByteArray const &data, quint32 pos, int size, bool bigEndian)
+{
+    if (static_cast<qint64>(pos) + size > data.size())
+        throw TCImportException("The TIFF file is truncated");
+    uchar const *p = reinterpret_cast<uchar const*>(data.constData()) + pos;
+    switch (size) {
+    case 1:  return *p;
+    case 2:  return bigEndian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+    default: return bigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+    }
+}
+
+/*!
+ * \brief reads the first image of a TIFF file
+ * \param fileName the name of the file
+ * \return the image, without histogram
+ *
+ * Throws a TCImportException if the file can not be read or uses a feature
+ * that is not supported (compression, tiles, signed or floating point samples).
+ */
+RawImage TiffIO::read(QString const &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        throw TCImportException("Could not open " + fileName.toStdString() + ": " + file.errorString().toStdString());
+    QByteArray data = file.readAll();
+    std::string name = fileName.toStdString();
+
+    if (data.size() < 8 || !(data.startsWith("II") || data.startsWith("MM")))
+        throw TCImportException(name + " is not a TIFF file");
+    bool big = data.startsWith("MM");
+    if (readValue(data, 2, 2, big) != 42)
+        throw TCImportException(name + " is not a TIFF file (BigTIFF is not supported)");
+
+    /* the entries of the first IFD, values of other types than BYTE, SHORT and LONG are not needed */
+    quint32 ifd = readValue(data, 4, 4, big);
+    quint32 entries = readValue(data, ifd, 2, big);
+    QHash<quint32, QVector<quint32>> tags;
+    for (quint32 i = 0; i < entries; i++) {
+        quint32 e = ifd + 2 + i * 12;
+        quint32 tag = readValue(data, e, 2, big);
+        quint32 type = readValue(data, e + 2, 2, big);
+        quint32 count = readValue(data, e + 4, 4, big);
+        int size = (type == 1) ? 1 : (type == 3) ? 2 : (type == 4) ? 4 : 0;
+        if (size == 0)
+            continue;
+        quint32 pos = (size * count <= 4) ? e + 8 : readValue(data, e + 8, 4, big);
+        QVector<quint32> values;
+        values.reserve(static_cast<int>(count));
+        for (quint32 k = 0; k < count; k++)
+            values.append(readValue(data, pos + k * size, size, big));
+        tags.insert(tag, values);
+    }
+    auto tag = [&](quint32 t, quint32 def) { return tags.value(t).value(0, def); };
+
+    int width = static_cast<int>(tag(256, 0));
+    int height = static_cast<int>(tag(257, 0));
+    int bits = static_cast<int>(tag(258, 1));
+    int samples = static_cast<int>(tag(277, 1));
+    if (width <= 0 || height <= 0)
+        throw TCImportException(name + " has no image");
+    if (tag(259, 1) != 1)
+        throw TCImportException(name + " is compressed, only uncompressed TIFF files are supported");
+    if (!tags.contains(273) || !tags.contains(279))
+        throw TCImportException(name + " is tiled, only TIFF files with strips are supported");
+    if ((bits != 8 && bits != 16) || (samples != 1 && samples != 3) || tag(339, 1) != 1)
+        throw TCImportException(name + " has unsupported samples, only unsigned 8 or 16 bit gray or RGB is supported");
+    if (samples > 1 && tag(284, 1) != 1)
+        throw TCImportException(name + " stores the samples in planes, which is not supported");
+
+    RawImage ret(width, height, samples, bits);
+    qint64 total = ret.byteCount();
+    qint64 copied = 0;
+    QVector<quint32> offsets = tags.value(273);
+    QVector<quint32> counts = tags.value(279);
+    for (int i = 0; i < offsets.size() && i < counts.size() && copied < total; i++) {
+        qint64 len = std::min(static_cast<qint64>(counts[i]), total - copied);
+        if (offsets[i] + len > data.size())
+            throw TCImportException(name + " is truncated");
+        memcpy(ret.bits() + copied, data.constData() + offsets[i], static_cast<size_t>(len));
+        copied += len;
+    }
+    if (copied < total)
+        throw TCImportException(name + " is truncated");
+
+    if (bits == 16 && big != (QSysInfo::ByteOrder == QSysInfo::BigEndian)) {
+        quint16 *p = reinterpret_cast<quint16*>(ret.bits());
+        for (qint64 i = 0; i < total / 2; i++)
+            p[i] = qbswap(p[i]);
+    }
+    return ret;
+}
+
+/*!
+ * \brief writes a RawImage to a TIFF file
+ * \param fileName the name of the file, it is overwritten if it exists
+ * \param image the image with 8 or 16 bits per sample and one or three samples per pixel
+ *
+ * The image is stored as a single strip, throws a TCExportException if writing fails.
+ */
+void TiffIO::write(QString const &fileName, RawImage const &image)
+{
+    enum : quint16 { SHORT = 3, LONG = 4 };
+    struct Tag { quint16 tag; quint16 type; quint32 value; };
+
+    quint32 bytes = static_cast<quint32>(image.byteCount());
+    quint16 entries = 10;
+    quint32 bitsOffset = 0;                         /* BitsPerSample of RGB images do not fit into the entry */
+    quint32 dataOffset = 8 + 2 + entries * 12 + 4;
+    if (image.samples() > 1) {
+        bitsOffset = dataOffset;
+        dataOffset += 2 * image.samples();
+    }
+
+    Tag tags[] = {
+        {256, LONG,  static_cast<quint32>(image.width())},          /* ImageWidth */
+        {257, LONG,  static_cast<quint32>(image.height())},         /* ImageLength */
+        {258, SHORT, image.samples() > 1 ? bitsOffset : static_cast<quint32>(image.bitDepth())}, /* BitsPerSample */
+        {259, SHORT, 1},                                            /* Compression: none */
+        {262, SHORT, image.samples() > 1 ? 2u : 1u},                /* PhotometricInterpretation: RGB or BlackIsZero */
+        {273, LONG,  dataOffset},                                   /* StripOffsets */
+        {277, SHORT, static_cast<quint32>(image.samples())},        /* SamplesPerPixel */
+        {278, LONG,  static_cast<quint32>(image.height())},         /* RowsPerStrip */
+        {279, LONG,  bytes},                                        /* StripByteCounts */
+        {284, SHORT, 1}};                                           /* PlanarConfiguration: chunky */
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        throw TCExportException("Could not open " + fileName.toStdString() + ": " + file.errorString().toStdString());
+
+    bool little = QSysInfo::ByteOrder == QSysInfo::LittleEndian;
+    QDataStream out(&file);
+    out.setByteOrder(little ? QDataStream::LittleEndian : QDataStream::BigEndian);
+    out.writeRawData(little ? "II" : "MM", 2);
+    out << quint16(42) << quint32(8);
+    out << entries;
+    for (Tag const &t : tags) {
+        if (t.tag == 258 && image.samples() > 1) {
+            out << t.tag << t.type << quint32(image.samples()) << t.value;
+        } else if (t.type == SHORT) {
+            out << t.tag << t.type << quint32(1) << quint16(t.value) << quint16(0); /* SHORTs are left-aligned */
+        } else {
+            out << t.tag << t.type << quint32(1) << t.value;
+        }
+    }
+    out << quint32(0);                              /* no further IFD */
+    if (image.samples() > 1)
+        for (int i = 0; i < image.samples(); i++)
+            out << quint16(image.bitDepth());
+    out.writeRawData(reinterpret_cast<char const*>(image.constBits()), image.byteCount());
+
+    if (out.status() != QDataStream::Ok || !file.flush())
+        throw TCExportException("Writing " + fileName.toStdString() + " failed: " + file.errorString().toStdString());
+}
+
+}
@@ -0,0 +1,50 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TIFFIO_H
+#define TIFFIO_H
+
+#include <QString>
+
+#include "base/rawimage.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief The TiffIO class
+ *
+ * Reads and writes RawImage%s as uncompressed TIFF files. Qt's image plugins
+ * only handle 8 bits per sample, label masks (ExportCTC, ImportLabels) need 16
+ * bits. The samples are written in the byte order of the machine, which the
+ * TIFF header declares, so they are copied without conversion.
+ *
+ * Reading supports the first image of a file, stored in strips without
+ * compression, with one or three unsigned samples of 8 or 16 bits per pixel.
+ */
+class TiffIO
+{
+public:
+    static RawImage read(QString const &fileName);
+    static void write(QString const &fileName, RawImage const &image);
+
+private:
+    static quint32 readValue(QByteArray const &data, quint32 pos, int size, bool bigEndian);
+};
+
+}
+
+#endif // TIFFIO_H
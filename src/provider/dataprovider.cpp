@@ -15,12 +15,20 @@
  * You should have received a copy of the GNU Lesser General Public License
  * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
  */
+#include <exception>
+
 #include <QtConcurrent/QtConcurrent>
 #include <QtDebug>
 
 #include "dataprovider.h"
 #include "messagerelay.h"
 #include "guistate.h"
+#include "imagecache.h"
+#include "thumbnailcache.h"
+#include "undostack.h"
+#include "io/journal.h"
+#include "io/projectsnapshot.h"
+#include "tracer.h"
 #include "exceptions/tcexception.h"
 
 namespace TraCurate {
@@ -88,16 +96,17 @@ void DataProvider::changeAnnotation(int id, int t, QString title, QString descri
     std::shared_ptr<Genealogy> gen = proj->getGenealogy();
     if (!gen)
         return;
-    std::shared_ptr<QList<std::shared_ptr<Annotation>>> anno = gen->getAnnotations();
-    for (std::shared_ptr<Annotation> a : *anno)
-        if (id >= 0 && a->getId() == static_cast<uint32_t>(id)) {
-            bool changed = (a->getType() != type) || (a->getTitle() != title) || (a->getDescription() != description);
-            a->setType(type);
-            a->setTitle(title);
-            a->setDescription(description);
-            if (changed)
-                emit annotationsChanged(annotations);
-        }
+    std::shared_ptr<Annotation> a = gen->getAnnotation(id);
+    if (!a)
+        return;
+    bool changed = (a->getType() != type) || (a->getTitle() != title) || (a->getDescription() != description);
+    a->setType(type);
+    a->setTitle(title);
+    a->setDescription(description);
+    if (changed) {
+        gen->changed(a);
+        emit annotationsChanged(annotations);
+    }
 }
 
 /*!
@@ -321,7 +330,11 @@ QObject *DataProvider::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *script
 void DataProvider::runLoad(QString fileName) {
     QUrl url(fileName);
     std::shared_ptr<Project> proj = importer->load(url.toLocalFile());
+    ImageCache::getInstance()->clear();
+    Journal::getInstance()->replay(proj);
+    Journal::getInstance()->open(proj);
     GUIState::getInstance()->setProj(proj);
+    ThumbnailCache::getInstance()->open(proj, fileName);
     GUIState::getInstance()->setMaximumFrame(proj->getMovie()->getFrames().size()-1);
     GUIState::getInstance()->setMaximumSlice(proj->getMovie()->getFrame(0)->getSlices().size());
     GUIState::getInstance()->setMaximumChannel(proj->getMovie()->getFrame(0)->getSlice(0)->getChannels().size());
@@ -334,6 +347,10 @@ void DataProvider::runLoad(QString fileName) {
  */
 void DataProvider::loadHDF5(QString fileName)
 {
+    /* the prefetch thread of the ImageCache and the ThumbnailCache use the importer */
+    ImageCache::getInstance()->waitForPrefetch();
+    ThumbnailCache::getInstance()->waitForDone();
+    UndoStack::getInstance()->clear();
     importer = std::make_shared<ImportHDF5>();
     QFuture<void> f = QtConcurrent::run(this, &DataProvider::runLoad, fileName);
     futures.append(f);
@@ -345,68 +362,151 @@ void DataProvider::loadHDF5(QString fileName)
  */
 void DataProvider::loadXML(QString fileName)
 {
+    /* the prefetch thread of the ImageCache and the ThumbnailCache use the importer */
+    ImageCache::getInstance()->waitForPrefetch();
+    ThumbnailCache::getInstance()->waitForDone();
+    UndoStack::getInstance()->clear();
     importer = std::make_shared<ImportXML>();
     QFuture<void> f = QtConcurrent::run(this, &DataProvider::runLoad, fileName);
     futures.append(f);
 }
 
-void DataProvider::runSaveHDF5(QString filename, Export::SaveOptions &so)
+/*!
+ * \brief Writes a snapshot of the project to a HDF5 file using the given SaveOptions
+ * \param snapshot the ProjectSnapshot to save
+ * \param filename is the name of the HDF5 file
+ * \param so the SaveOptions
+ */
+void DataProvider::runSaveHDF5(std::shared_ptr<Project> snapshot, QString filename, Export::SaveOptions so)
 {
     QUrl url(filename);
-    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
-    exporter.save(proj, url.toLocalFile(), so);
-    MessageRelay::emitFinishNotification();
-    GUIState::getInstance()->setMaximumFrame(proj->getMovie()->getFrames().size()-1);
-    GUIState::getInstance()->setMaximumSlice(proj->getMovie()->getFrame(0)->getSlices().size());
-    GUIState::getInstance()->setMaximumChannel(proj->getMovie()->getFrame(0)->getSlice(0)->getChannels().size());
+    saveSnapshot(snapshot, [&]() { exporter.save(snapshot, url.toLocalFile(), so); });
 }
 
 /*!
- * \brief Writes the project to a HDF5 file
+ * \brief Writes a snapshot of the project to a HDF5 file
+ * \param snapshot the ProjectSnapshot to save
  * \param fileName is the name of the HDF5 file
  */
-void DataProvider::runSaveHDF5(QString fileName)
+void DataProvider::runSaveHDF5(std::shared_ptr<Project> snapshot, QString fileName)
 {
     QUrl url(fileName);
-    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
-    exporter.save(proj, url.toLocalFile());
+    saveSnapshot(snapshot, [&]() { exporter.save(snapshot, url.toLocalFile()); });
+}
+
+/*!
+ * \brief Writes a snapshot of the project to the HDF5 file it was loaded from
+ * \param snapshot the ProjectSnapshot to save
+ */
+void DataProvider::runSaveHDF5(std::shared_ptr<Project> snapshot)
+{
+    qDebug() << "saving to" << snapshot->getFileName();
+    saveSnapshot(snapshot, [&]() { exporter.save(snapshot, snapshot->getFileName()); });
+}
+
+/*!
+ * \brief saves a snapshot and notifies the GUI that saving has finished
+ * \param snapshot the ProjectSnapshot that is saved
+ * \param save saves the snapshot, throws if that fails
+ *
+ * Runs on the thread that saves, so the journal is compacted there. The
+ * exporter only updates the file name of the snapshot, the file name of the
+ * Project itself is updated in projectSaved() on the GUI thread, which is
+ * called even if saving failed, so the edits made in the meantime are written.
+ */
+void DataProvider::saveSnapshot(std::shared_ptr<Project> const &snapshot, std::function<void()> const &save)
+{
+    bool saved = false;
+    try {
+        save();
+        saved = true;
+    } catch (std::exception &e) {
+        qDebug() << "saving failed:" << e.what();
+        MessageRelay::emitUpdateStatusBar(QString("Saving failed: %1").arg(e.what()));
+    } catch (H5::Exception &e) {
+        qDebug() << "saving failed:" << e.getDetailMsg().c_str();
+        MessageRelay::emitUpdateStatusBar(QString("Saving failed: %1").arg(e.getDetailMsg().c_str()));
+    }
+    if (saved)
+        Journal::getInstance()->saved(snapshot->getFileName());
+    QMetaObject::invokeMethod(this, "projectSaved", Qt::QueuedConnection,
+                              Q_ARG(QString, snapshot->getFileName()), Q_ARG(bool, saved));
     MessageRelay::emitFinishNotification();
-    GUIState::getInstance()->setMaximumFrame(proj->getMovie()->getFrames().size()-1);
-    GUIState::getInstance()->setMaximumSlice(proj->getMovie()->getFrame(0)->getSlices().size());
-    GUIState::getInstance()->setMaximumChannel(proj->getMovie()->getFrame(0)->getSlice(0)->getChannels().size());
+    GUIState::getInstance()->setMaximumFrame(snapshot->getMovie()->getFrames().size()-1);
+    GUIState::getInstance()->setMaximumSlice(snapshot->getMovie()->getFrame(0)->getSlices().size());
+    GUIState::getInstance()->setMaximumChannel(snapshot->getMovie()->getFrame(0)->getSlice(0)->getChannels().size());
 }
 
 /*!
- * \brief Writes the project to the HDF5 file it was loaded from
+ * \brief updates the file name of the current Project after it was saved
+ * \param fileName the file the Project was saved to
+ * \param saved false, if saving failed
+ *
+ * The Object%s edited during the save are written afterwards, to the new file.
  */
-void DataProvider::runSaveHDF5()
+void DataProvider::projectSaved(QString fileName, bool saved)
 {
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
-    qDebug() << "saving to" << proj->getFileName();
-    exporter.save(proj, proj->getFileName());
-    MessageRelay::emitFinishNotification();
-    GUIState::getInstance()->setMaximumFrame(proj->getMovie()->getFrames().size()-1);
-    GUIState::getInstance()->setMaximumSlice(proj->getMovie()->getFrame(0)->getSlices().size());
-    GUIState::getInstance()->setMaximumChannel(proj->getMovie()->getFrame(0)->getSlice(0)->getChannels().size());
+    if (proj && saved)
+        proj->setFileName(fileName);
+    UndoStack::getInstance()->saveFinished();
+}
+
+/*!
+ * \brief writes the changes of undo and redo to the HDF5 file before the Project is saved
+ * \return true, if they were written
+ *
+ * If writing fails, it is tried once more, then the Project is not saved. A
+ * Project that is still being saved is not saved again.
+ */
+bool DataProvider::flushHistory()
+{
+    UndoStack *history = UndoStack::getInstance();
+    if (history->isSaving()) {
+        MessageRelay::emitUpdateStatusBar("The project is still being saved");
+        return false;
+    }
+    if (history->flush() || history->flush())
+        return true;
+    MessageRelay::emitUpdateStatusBar("The project was not saved, the undone changes could not be written to the HDF5 file");
+    return false;
 }
 
 void DataProvider::saveHDF5(QString filename, bool sAnnotations, bool sAutoTracklets, bool sEvents, bool sImages, bool sInfo, bool sObjects, bool sTracklets)
 {
     Export::SaveOptions so{sAnnotations, sAutoTracklets, sEvents, sImages, sInfo, sObjects, sTracklets};
+    /* Objects restored by undo/redo have to be in the file before it is copied */
+    if (!flushHistory())
+        return;
+    /* the journal can only be compacted if everything it contains is saved */
+    if (sAnnotations && sEvents && sTracklets)
+        Journal::getInstance()->checkpoint();
+    std::shared_ptr<Project> snapshot = ProjectSnapshot::create(GUIState::getInstance()->getProj());
+    UndoStack::getInstance()->saveStarted();
 
-    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5, filename, so);
+    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5, snapshot, filename, so);
     futures.append(f);
 }
 
 void DataProvider::saveHDF5(QString fileName)
 {
-    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5, fileName);
+    if (!flushHistory())
+        return;
+    Journal::getInstance()->checkpoint();
+    std::shared_ptr<Project> snapshot = ProjectSnapshot::create(GUIState::getInstance()->getProj());
+    UndoStack::getInstance()->saveStarted();
+    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5, snapshot, fileName);
     futures.append(f);
 }
 
 void DataProvider::saveHDF5()
 {
-    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5);
+    if (!flushHistory())
+        return;
+    Journal::getInstance()->checkpoint();
+    std::shared_ptr<Project> snapshot = ProjectSnapshot::create(GUIState::getInstance()->getProj());
+    UndoStack::getInstance()->saveStarted();
+    QFuture<void> f = QtConcurrent::run(this, &DataProvider::runSaveHDF5, snapshot);
     futures.append(f);
 }
 
@@ -464,6 +564,7 @@ void DataProvider::importFiji(QJSValue data)
         }
     }
 
+    UndoStack::getInstance()->clear();
     importer = std::make_shared<ImportXML>();
     QtConcurrent::run(this, &DataProvider::runImportFiji, p);
 }
@@ -484,6 +585,7 @@ QString DataProvider::localFileFromURL(QString path)
  * \return the Object or nullptr if there is none
  */
 std::shared_ptr<Object> DataProvider::cellAtFrame(int frame, int slice, int channel, double x, double y) {
+    TC_TRACE_SCOPE("DataProvider::cellAtFrame");
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     if (!proj)
         return nullptr;
@@ -505,15 +607,14 @@ std::shared_ptr<Object> DataProvider::cellAtFrame(int frame, int slice, int chan
         return nullptr;
 
     QPointF p = QPointF(x,y) / DataProvider::getInstance()->getScaleFactor();
-    qreal scaledX = p.x();
-    qreal scaledY = p.y();
 
-
-    for (std::shared_ptr<Object> o : c->getObjects().values()){
-        std::shared_ptr<QPolygonF> poly = o->getOutline();
-        if (poly->boundingRect().contains(scaledX, scaledY))
-            if (poly->containsPoint(p, Qt::OddEvenFill))
-                return o;
+    /* only test the outlines of Objects whose bounding box contains the point */
+    QVector<uint32_t> candidates = c->getFeatures().candidatesAt(p);
+    TC_TRACE_COUNTER("DataProvider::cellAtFrame candidates", candidates.size());
+    for (uint32_t id : candidates) {
+        std::shared_ptr<Object> o = c->getObject(id);
+        if (o && o->getOutline()->containsPoint(p, Qt::OddEvenFill))
+            return o;
     }
 
     return nullptr;
@@ -559,4 +660,33 @@ QImage DataProvider::requestImage(QString fileName, int frameNumber, int sliceNu
     return *img.get();
 }
 
+/*!
+ * \brief Returns an image of the current Project with the samples as they are stored.
+ * \param fileName is the name of the Project file
+ * \param frameNumber is the number of the Frame
+ * \param sliceNumber is the number of the Slice
+ * \param channelNumber is the number of the Channel
+ * \return the requested RawImage
+ */
+RawImage DataProvider::requestRawImage(QString fileName, int frameNumber, int sliceNumber, int channelNumber)
+{
+    QUrl url(fileName);
+    return importer->requestRawImage(url.toLocalFile(), frameNumber, sliceNumber, channelNumber);
+}
+
+/*!
+ * \brief Returns a downsampled image of the current Project with the samples as they are stored.
+ * \param fileName is the name of the Project file
+ * \param frameNumber is the number of the Frame
+ * \param sliceNumber is the number of the Slice
+ * \param channelNumber is the number of the Channel
+ * \param maxSize is the longest side of the returned image
+ * \return the requested RawImage
+ */
+RawImage DataProvider::requestRawThumbnail(QString fileName, int frameNumber, int sliceNumber, int channelNumber, int maxSize)
+{
+    QUrl url(fileName);
+    return importer->requestRawThumbnail(url.toLocalFile(), frameNumber, sliceNumber, channelNumber, maxSize);
+}
+
 }
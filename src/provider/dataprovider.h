@@ -18,6 +18,8 @@
 #ifndef DATAPROVIDER_H
 #define DATAPROVIDER_H
 
+#include <functional>
+
 #include <QFuture>
 #include <QObject>
 #include <QString>
@@ -47,9 +49,6 @@ public:
     Q_INVOKABLE void loadHDF5(QString fileName);
     Q_INVOKABLE void loadXML(QString fileName);
 
-    Q_INVOKABLE void runSaveHDF5(QString filename, Export::SaveOptions &so);
-    Q_INVOKABLE void runSaveHDF5(QString fileName);
-    Q_INVOKABLE void runSaveHDF5();
     Q_INVOKABLE void saveHDF5(QString filename, bool sAnnotations, bool sAutoTracklets, bool sEvents, bool sImages, bool sInfo, bool sObjects, bool sTracklets);
     Q_INVOKABLE void saveHDF5(QString fileName);
     Q_INVOKABLE void saveHDF5();
@@ -61,6 +60,8 @@ public:
     Q_INVOKABLE QString localFileFromURL(QString path);
 
     Q_INVOKABLE QImage requestImage(QString fileName, int frameNumber, int sliceNumber, int channelNumber);
+    RawImage requestRawImage(QString fileName, int frameNumber, int sliceNumber, int channelNumber);
+    RawImage requestRawThumbnail(QString fileName, int frameNumber, int sliceNumber, int channelNumber, int maxSize);
 
     static DataProvider *getInstance();
     static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
@@ -102,6 +103,13 @@ private:
     std::shared_ptr<Import> importer;
     ExportHDF5 exporter;
 
+    /* saving works on a ProjectSnapshot, so the GUI can keep modifying the Project */
+    void runSaveHDF5(std::shared_ptr<Project> snapshot, QString filename, Export::SaveOptions so);
+    void runSaveHDF5(std::shared_ptr<Project> snapshot, QString fileName);
+    void runSaveHDF5(std::shared_ptr<Project> snapshot);
+    void saveSnapshot(std::shared_ptr<Project> const &snapshot, std::function<void()> const &save);
+    bool flushHistory();
+
     QList<QObject *> annotations;
     QList<QObject *> tracklets;
 
@@ -112,6 +120,9 @@ private:
 signals:
     void annotationsChanged(QList<QObject*> value);
     void trackletsChanged(QList<QObject*> value);
+
+private slots:
+    void projectSaved(QString fileName, bool saved);
 };
 
 }
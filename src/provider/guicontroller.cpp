@@ -17,16 +17,21 @@
  */
 #include "guicontroller.h"
 
-#include <QtConcurrent/QtConcurrent>
 #include <QDebug>
+#include <QHash>
 
 #include "guistate.h"
 #include "graphics/base.h"
 #include "graphics/merge.h"
-#include "graphics/separate.h"
 #include "graphics/floodfill.h"
+#include "base/featuretable.h"
 #include "exceptions/tcunimplementedexception.h"
+#include "provider/imagecache.h"
 #include "provider/imageprovider.h"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+#include "provider/undostack.h"
 #include "tracked/trackevent.h"
 #include "tracked/trackeventdivision.hpp"
 #include "tracked/trackeventdead.hpp"
@@ -42,10 +47,34 @@ GUIController *GUIController::theInstance = nullptr;
 
 GUIController::GUIController(QObject *parent) :
     QObject(parent),
-    abortStrategyIssued(false),
     currentStrategy(GUIState::Strategy::STRATEGY_DEFAULT),
     currentStrategyRunning(false),
-    currentAction(GUIState::Action::ACTION_DEFAULT) {}
+    currentAction(GUIState::Action::ACTION_DEFAULT),
+    playbackPos(0),
+    playbackLoop(false),
+    playbackSlot(0),
+    droppedFrames(0),
+    updatingContrast(false)
+{
+    playbackTimer.setTimerType(Qt::PreciseTimer);
+    connect(&playbackTimer, &QTimer::timeout, this, &GUIController::playbackTick);
+
+    GUIState *gs = GUIState::getInstance();
+    connect(gs, &GUIState::currentFrameChanged, this, &GUIController::prefetchAutoTracklet);
+    connect(gs, &GUIState::selectedAutoTrackChanged, this, &GUIController::prefetchAutoTracklet);
+    connect(&resegmentationWatcher, &QFutureWatcher<TrackResegmentation::Result>::finished,
+            this, &GUIController::resegmentationFinished);
+    connect(&linkingWatcher, &QFutureWatcher<QVector<TrackletLinker::Proposal>>::finished,
+            this, &GUIController::linkingFinished);
+
+    /* finishNotification is also sent when a Project was loaded */
+    connect(MessageRelay::getInstance(), &MessageRelay::finishNotification, this, &GUIController::updateContrast);
+    connect(gs, &GUIState::currentChannelChanged, this, &GUIController::updateContrast);
+    connect(gs, &GUIState::contrastLowChanged, this, &GUIController::applyContrast);
+    connect(gs, &GUIState::contrastHighChanged, this, &GUIController::applyContrast);
+    connect(gs, &GUIState::contrastGammaChanged, this, &GUIController::applyContrast);
+    connect(gs, &GUIState::contrastColormapChanged, this, &GUIController::applyContrast);
+}
 
 /*!
  * \brief returns the instance of GUIController
@@ -70,12 +99,6 @@ QObject *GUIController::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scrip
     return getInstance();
 }
 
-void GUIController::waitForFutures()
-{
-    for (QFuture<void> &f : futures)
-        f.waitForFinished();
-}
-
 /*!
  * \brief changes the current Frame to a specific value
  * \param newFrame the number of the new Frame
@@ -390,10 +413,12 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!motherT)
             return;
 
+        UndoStack::getInstance()->begin("Change the daughters of a track", UndoStack::trackletsOf(proj, {mother, daughter}));
         if (gen->hasDaughterObject(motherT, daughter))
             gen->removeDaughterTrack(motherT, daughter);
         else
             gen->addDaughterTrack(motherT, daughter);
+        UndoStack::getInstance()->commit();
 
         emit GUIState::getInstance()->backingDataChanged();
         break;
@@ -418,10 +443,12 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!unmergedT)
             return;
 
+        UndoStack::getInstance()->begin("Change the merge of a track", UndoStack::trackletsOf(proj, {merged, unmerged}));
         if (gen->hasMergerObject(unmergedT, merged))
             gen->removeMergedTrack(unmergedT, merged);
         else
             gen->addMergedTrack(unmergedT, merged);
+        UndoStack::getInstance()->commit();
 
         emit GUIState::getInstance()->backingDataChanged();
         break;
@@ -446,10 +473,12 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!mergedT)
             return;
 
+        UndoStack::getInstance()->begin("Change the unmerge of a track", UndoStack::trackletsOf(proj, {merged, unmerged}));
         if (gen->hasUnmergerObject(mergedT, unmerged))
             gen->removeUnmergedTrack(mergedT, unmerged);
         else
             gen->addUnmergedTrack(mergedT, unmerged);
+        UndoStack::getInstance()->commit();
 
         emit GUIState::getInstance()->backingDataChanged();
         break;
@@ -470,10 +499,12 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!t)
             return;
 
+        UndoStack::getInstance()->begin("Remove a cell from a track", {t});
         t->removeFromContained(currentFrame, cell->getId());
 
         if (t->getContained().isEmpty()) /* remove tracklet if there are no more cells in it */
             proj->getGenealogy()->removeTracklet(t->getId());
+        UndoStack::getInstance()->commit();
 
         emit GUIState::getInstance()->backingDataChanged();
         break;
@@ -494,6 +525,7 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!t)
             return;
 
+        UndoStack::getInstance()->begin("Remove the cells of a track from the current frame on", {t});
         auto contained = t->getContained();
         for (int key: contained.keys()) {
             auto val = contained.value(key);
@@ -503,6 +535,7 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
 
         if (t->getContained().isEmpty()) /* remove tracklet if there are no more cells in it */
             proj->getGenealogy()->removeTracklet(t->getId());
+        UndoStack::getInstance()->commit();
 
         GUIState::getInstance()->backingDataChanged();
         break;
@@ -523,6 +556,7 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
         if (!t)
             return;
 
+        UndoStack::getInstance()->begin("Remove the cells of a track up to the current frame", {t});
         auto contained = t->getContained();
         for (int key: contained.keys()) {
             auto val = contained.value(key);
@@ -532,6 +566,7 @@ void GUIController::selectCell(int frame, int slice, int channel, double x, doub
 
         if (t->getContained().isEmpty()) /* remove tracklet if there are no more cells in it */
             proj->getGenealogy()->removeTracklet(t->getId());
+        UndoStack::getInstance()->commit();
 
         GUIState::getInstance()->backingDataChanged();
         break;
@@ -585,6 +620,7 @@ void GUIController::changeStatus(int trackId, int status)
         return;
 
     TrackEvent<Tracklet>::EVENT_TYPE newTEType = static_cast<TrackEvent<Tracklet>::EVENT_TYPE>(status);
+    UndoStack::getInstance()->begin("Change the status of a track", {t});
     if (t->getNext()) {
         /* remove the old Event and all references to is (meaning also that of following tracklets back to it) */
         TrackEvent<Tracklet>::EVENT_TYPE oldTEType = t->getNext()->getType();
@@ -627,6 +663,7 @@ void GUIController::changeStatus(int trackId, int status)
     case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_MERGE:
     case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_UNMERGE:
         qDebug() << "track event {division, merge, unmerge} should be set by other means";
+        UndoStack::getInstance()->commit();
         return;
     case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_DEAD: {
         auto ted = std::make_shared<TrackEventDead<Tracklet>>();
@@ -644,94 +681,519 @@ void GUIController::changeStatus(int trackId, int status)
         t->setNext(teeom);
         break; }
     }
+    UndoStack::getInstance()->commit();
     selectTrack(GUIState::getInstance()->getSelectedCell().lock(), GUIState::getInstance()->getProj());
     hoverTrack(GUIState::getInstance()->getHoveredCell().lock(), GUIState::getInstance()->getProj());
     emit GUIState::getInstance()->backingDataChanged();
 }
 
+/*!
+ * \brief cuts the Object%s crossed by a straight line
+ * \param startX the x-coordinate of the start of the line
+ * \param startY the y-coordinate of the start of the line
+ * \param endX the x-coordinate of the end of the line
+ * \param endY the y-coordinate of the end of the line
+ */
 void GUIController::cutObject(int startX, int startY, int endX, int endY)
 {
-    QPointF start = QPoint(startX, startY);
-    QPointF end = QPoint(endX, endY);
-    QLineF cutLine(start, end);
-    std::shared_ptr<Object> cuttee = Base::objectCutByLine(cutLine);
-    if (!cuttee) {
+    cutObjectsAlong({QPointF(startX, startY), QPointF(endX, endY)});
+}
+
+/*!
+ * \brief cuts all Object%s of the current Frame/Slice/Channel along a polyline
+ * \param points the points (as points) of the polyline
+ *
+ * Every Object crossed by the polyline is replaced by all the pieces it is cut
+ * into, so a clump of several cells can be split in one edit.
+ */
+void GUIController::cutObjectsAlong(QVariantList points)
+{
+    QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> cuts = Base::objectsCutByPolyline(Base::toPolyline(points));
+    if (cuts.isEmpty()) {
         qDebug() << "could not find object to cut";
         return;
     }
 
+    splitObjects(cuts);
+}
+
+/*!
+ * \brief splits an Object by a Watershed on the image, seeded at the given positions
+ * \param seeds the seeds (as points), the first one selects the Object
+ */
+void GUIController::watershedSplit(QVariantList seeds)
+{
+    QPair<std::shared_ptr<Object>,QList<QPolygonF>> split = Base::objectSplitBySeeds(Base::toPolyline(seeds));
+    if (!split.first) {
+        qDebug() << "could not find object to split";
+        return;
+    }
+    if (split.second.size() < 2) {
+        qDebug() << "need at least two seeds inside of the object";
+        return;
+    }
+
+    splitObjects({split});
+}
+
+/*!
+ * \brief replaces Object%s of the same Channel by the pieces they were split into
+ * \param splits the Object%s, each with the outlines of its pieces
+ */
+void GUIController::splitObjects(QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> const &splits)
+{
+    std::shared_ptr<Object> first = splits.first().first;
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     std::shared_ptr<Movie> mov = proj->getMovie();
-    std::shared_ptr<Frame> frame  = mov->getFrame(cuttee->getFrameId());
-    std::shared_ptr<Slice> slice  = frame->getSlice(cuttee->getSliceId());
-    std::shared_ptr<Channel> chan = slice->getChannel(cuttee->getChannelId());
+    std::shared_ptr<Frame> frame  = mov->getFrame(first->getFrameId());
+    std::shared_ptr<Slice> slice  = frame->getSlice(first->getSliceId());
+    std::shared_ptr<Channel> chan = slice->getChannel(first->getChannelId());
 
     auto objects = chan->getObjects();
     auto max_obj = *std::max_element(objects.begin(), objects.end(),
                                      [](std::shared_ptr<Object> a, std::shared_ptr<Object> b){
                                                 return a->getId() < b->getId();
                                      });
-    int id1 = max_obj->getId() + 1;
-    int id2 = max_obj->getId() + 2;
-    if (id1 == INT_MAX || id2 == INT_MAX) {
+    int count = 0;
+    for (auto const &split : splits)
+        count += split.second.size();
+    if (max_obj->getId() >= static_cast<uint32_t>(INT_MAX - count)) {
         qDebug() << "Too many objects";
         return;
     }
+    int id = max_obj->getId() + 1;
 
-    std::shared_ptr<Object> object1 = std::make_shared<Object>(id1, chan);
-    std::shared_ptr<Object> object2 = std::make_shared<Object>(id2, chan);
+    /* create an object for every piece */
+    QList<std::shared_ptr<Object>> cuttees, pieces;
+    for (auto const &split : splits) {
+        cuttees.append(split.first);
+        for (QPolygonF const &outline : split.second) {
+            auto piece = std::make_shared<Object>(id++, chan);
+            piece->setOutline(std::make_shared<QPolygonF>(outline));
+            FeatureTable::Features f = FeatureTable::compute(outline);
+            piece->setBoundingBox(std::make_shared<QRect>(f.boundingBox.toRect()));
+            piece->setCentroid(std::make_shared<QPoint>(f.centroid.toPoint()));
+            pieces.append(piece);
+        }
+    }
 
-    /* cut the polygon by the line and append the points of the cut outline to the newly created objects */
-    double sf = DataProvider::getInstance()->getScaleFactor();
-    QLineF line(start/sf, end/sf);
-    QPair<QPolygonF,QPolygonF> res = Separate::compute(*cuttee->getOutline(), line);
+    /* replace old objects in HDF5 */
+    UndoStack *history = UndoStack::getInstance();
+    bool ret = history->begin(cuttees.size() > 1 ? "Cut objects" : "Cut an object", UndoStack::trackletsOf(proj, cuttees))
+            && history->write(cuttees, pieces);
+    if (!ret) {
+        history->commit();
+        return;
+    }
+
+    for (std::shared_ptr<Object> const &cuttee : cuttees) {
+        /* remove old object from autotracket/tracklet */
+        if (cuttee->isInAutoTracklet()) {
+            std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(cuttee->getAutoId());
+            at->removeComponent(cuttee->getFrameId());
+        }
+        if (cuttee->isInTracklet()) {
+            std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(cuttee->getTrackId());
+            t->removeFromContained(cuttee->getFrameId(), cuttee->getId());
+        }
+        chan->removeObject(cuttee->getId());
+    }
+
+    /* add the new ones */
+    for (std::shared_ptr<Object> const &piece : pieces)
+        chan->addObject(piece);
+    history->replaced(cuttees, pieces);
+    history->commit();
 
-    if (res.first.isEmpty() || res.second.isEmpty())
+    emit GUIState::getInstance()->backingDataChanged();
+}
+
+/*!
+ * \brief segments all Object%s of a Tracklet or AutoTracklet again in the background
+ * \param id the id of the Tracklet or AutoTracklet
+ * \param autoTracklet if true, id is the id of an AutoTracklet
+ * \param watershed if true, a Watershed is used, otherwise a FloodFill with the current threshold
+ *
+ * The new outlines are shown as a preview once all Frame%s are done, they
+ * are not applied before applyResegmentation() is called.
+ */
+void GUIController::resegmentTrack(int id, bool autoTracklet, bool watershed)
+{
+    if (resegmentationWatcher.isRunning()) {
+        MessageRelay::emitUpdateStatusBar("Already segmenting a track");
         return;
+    }
+    discardResegmentation();
 
-    auto outline1 = std::make_shared<QPolygonF>();
-    for(QPointF p : res.first)
-        outline1->append(p);
-    object1->setOutline(outline1);
-    auto outline2 = std::make_shared<QPolygonF>();
-    for(QPointF p : res.second)
-        outline2->append(p);
-    object2->setOutline(outline2);
-
-    auto bb1 = std::make_shared<QRect>(outline1->boundingRect().toRect());
-    object1->setBoundingBox(bb1);
-    auto bb2 = std::make_shared<QRect>(outline2->boundingRect().toRect());
-    object2->setBoundingBox(bb2);
-
-    /*! \todo: this is the center of the boundingBox, not the centroid of the polygon */
-    auto c1 = std::make_shared<QPoint>(bb1->center());
-    object1->setCentroid(c1);
-    auto c2 = std::make_shared<QPoint>(bb2->center());
-    object2->setCentroid(c2);
-
-    /* replace old object in HDF5 */
-    bool ret = ModifyHDF5::replaceObjects(proj->getFileName(), cuttee, {object1, object2});
-    if (!ret)
+    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+    QList<std::shared_ptr<Object>> objects = TrackResegmentation::objectsOf(proj, id, autoTracklet);
+    if (objects.isEmpty()) {
+        qDebug() << "could not find objects of track" << id;
         return;
+    }
 
-    /* remove old object from autotracket/tracklet */
-    if (cuttee->isInAutoTracklet()) {
-        std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(cuttee->getAutoId());
-        at->removeComponent(cuttee->getFrameId());
+    TrackResegmentation::Method method = watershed ? TrackResegmentation::WATERSHED : TrackResegmentation::FLOOD_FILL;
+    QList<TrackResegmentation::Job> jobs = TrackResegmentation::prepare(proj, GUIState::getInstance()->getProjPath(), objects,
+                                                                        method, GUIState::getInstance()->getThresh());
+    resegmentationWatcher.setFuture(TrackResegmentation::start(jobs));
+}
+
+void GUIController::resegmentationFinished()
+{
+    int failed = 0;
+    resegmentation.clear();
+    for (TrackResegmentation::Result const &r : resegmentationWatcher.future().results()) {
+        if (r.outline.isEmpty())
+            failed++;
+        else
+            resegmentation.append(r);
+    }
+    MessageRelay::emitUpdateStatusBar(QString("Segmented %1 frames, %2 failed")
+                                      .arg(resegmentation.size()).arg(failed));
+    GUIState::getInstance()->setDrawResegmentation(!resegmentation.isEmpty());
+    emit GUIState::getInstance()->backingDataChanged();
+}
+
+/*!
+ * \brief returns the pending new outlines of resegmentTrack()
+ * \return the Object%s with their new outlines
+ */
+QList<TrackResegmentation::Result> GUIController::getResegmentation() const
+{
+    return resegmentation;
+}
+
+/*!
+ * \brief replaces the Object%s segmented by resegmentTrack() with their new outlines
+ *
+ * All Object%s are replaced in the HDF5 file at once. The new Object%s take
+ * the place of the old ones in their Tracklet and AutoTracklet and carry
+ * their Annotation%s.
+ */
+void GUIController::applyResegmentation()
+{
+    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+    if (!proj || resegmentation.isEmpty())
+        return;
+
+    struct Change {
+        std::shared_ptr<Frame> frame;
+        std::shared_ptr<Channel> chan;
+        std::shared_ptr<Object> oldObject, newObject;
+    };
+    QList<Change> changes;
+    QList<ModifyHDF5::Replacement> replacements;
+    QHash<Channel*, uint32_t> nextIds;
+
+    for (TrackResegmentation::Result const &r : resegmentation) {
+        std::shared_ptr<Object> o = r.object;
+        std::shared_ptr<Frame> frame = proj->getMovie()->getFrame(o->getFrameId());
+        std::shared_ptr<Slice> slice = frame ? frame->getSlice(o->getSliceId()) : nullptr;
+        std::shared_ptr<Channel> chan = slice ? slice->getChannel(o->getChannelId()) : nullptr;
+        if (!chan || chan->getObject(o->getId()) != o) { /* changed since the preview */
+            qDebug() << "object" << o->getId() << "in frame" << o->getFrameId() << "no longer exists";
+            continue;
+        }
+
+        if (!nextIds.contains(chan.get())) {
+            uint32_t maxId = 0;
+            for (std::shared_ptr<Object> const &other : chan->getObjects())
+                maxId = std::max(maxId, other->getId());
+            if (maxId >= static_cast<uint32_t>(INT_MAX)) {
+                qDebug() << "Too many objects";
+                continue;
+            }
+            nextIds.insert(chan.get(), maxId + 1);
+        }
+
+        auto n = std::make_shared<Object>(nextIds[chan.get()]++, chan);
+        n->setOutline(std::make_shared<QPolygonF>(r.outline));
+        FeatureTable::Features f = FeatureTable::compute(r.outline);
+        n->setBoundingBox(std::make_shared<QRect>(f.boundingBox.toRect()));
+        n->setCentroid(std::make_shared<QPoint>(f.centroid.toPoint()));
+        n->setAutoId(o->getAutoId());
+        n->setTrackId(o->getTrackId());
+
+        changes.append(Change{frame, chan, o, n});
+        replacements.append(ModifyHDF5::Replacement{{o}, {n}});
+    }
+
+    QList<std::shared_ptr<Object>> oldObjects, newObjects;
+    for (Change const &c : changes) {
+        oldObjects.append(c.oldObject);
+        newObjects.append(c.newObject);
+    }
+    UndoStack *history = UndoStack::getInstance();
+    if (!history->begin("Segment a track again", UndoStack::trackletsOf(proj, oldObjects))
+            || !history->write(replacements)) {
+        history->commit();
+        MessageRelay::emitUpdateStatusBar("Could not replace the objects of the track");
+        return;
+    }
+
+    /* notes the Annotations of the old Objects before they move to the new ones */
+    history->replaced(oldObjects, newObjects);
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    for (Change const &c : changes) {
+        for (std::shared_ptr<Annotation> a : QList<std::shared_ptr<Annotation>>(*c.oldObject->getAnnotations())) {
+            gen->unannotate(c.oldObject, a);
+            gen->annotate(c.newObject, a);
+        }
+        if (c.oldObject->isInAutoTracklet()) {
+            std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(c.oldObject->getAutoId());
+            if (at) {
+                at->removeComponent(c.frame);
+                at->addComponent(c.frame, c.newObject);
+            }
+        }
+        if (c.oldObject->isInTracklet()) {
+            std::shared_ptr<Tracklet> t = gen->getTracklet(c.oldObject->getTrackId());
+            if (t) {
+                t->removeFromContained(c.frame->getID(), c.oldObject->getId());
+                t->addToContained(c.frame, c.newObject);
+            }
+        }
+        c.chan->removeObject(c.oldObject->getId());
+        c.chan->addObject(c.newObject);
     }
-    if (cuttee->isInTracklet()) {
-        std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(cuttee->getTrackId());
-        t->removeFromContained(cuttee->getFrameId(), cuttee->getId());
+    history->commit();
+
+    MessageRelay::emitUpdateStatusBar(QString("Replaced %1 objects").arg(changes.size()));
+    discardResegmentation();
+}
+
+/*!
+ * \brief drops the pending new outlines of resegmentTrack()
+ */
+void GUIController::discardResegmentation()
+{
+    resegmentation.clear();
+    GUIState::getInstance()->setDrawResegmentation(false);
+    emit GUIState::getInstance()->backingDataChanged();
+}
+
+/*!
+ * \brief looks for links between the ends and starts of tracks in the background
+ *
+ * Only the current Slice and Channel are linked. The proposals are shown
+ * once all Frame%s are done, they are not applied before they are accepted.
+ */
+void GUIController::proposeLinks()
+{
+    if (linkingWatcher.isRunning()) {
+        MessageRelay::emitUpdateStatusBar("Already looking for links");
+        return;
     }
+    discardLinkProposals();
+
+    GUIState *gs = GUIState::getInstance();
+    std::shared_ptr<Project> proj = gs->getProj();
+    if (!proj)
+        return;
 
-    /* remove the old object, add the new ones */
-    chan->removeObject(cuttee->getId());
-    chan->addObject(object1);
-    chan->addObject(object2);
+    linkProject = proj;
+    QList<TrackletLinker::Job> jobs = TrackletLinker::prepare(proj, gs->getCurrentSlice(), gs->getCurrentChannel());
+    linkingWatcher.setFuture(TrackletLinker::start(jobs));
+}
 
+void GUIController::linkingFinished()
+{
+    if (GUIState::getInstance()->getProj() != linkProject.lock())
+        return;
+    linkProposals = TrackletLinker::resolve(linkingWatcher.future().results());
+    MessageRelay::emitUpdateStatusBar(QString("Found %1 links").arg(linkProposals.size()));
+    linkProposalsChanged();
+    showLinkProposal(0);
+}
+
+/*!
+ * \brief returns the pending links of proposeLinks()
+ * \return the Proposal%s, empty if they were made for another Project
+ */
+QList<TrackletLinker::Proposal> GUIController::getLinkProposals() const
+{
+    if (GUIState::getInstance()->getProj() != linkProject.lock())
+        return QList<TrackletLinker::Proposal>();
+    return linkProposals;
+}
+
+/*!
+ * \brief makes a pending link the current one and goes to the Frame its track ends in
+ * \param index the index of the link
+ */
+void GUIController::showLinkProposal(int index)
+{
+    if (index < 0 || index >= linkProposals.size())
+        return;
+    GUIState::getInstance()->setCurrentLinkProposal(index);
+    changeFrameAbs(static_cast<int>(linkProposals.at(index).source->getFrameId()));
     emit GUIState::getInstance()->backingDataChanged();
 }
 
+/*!
+ * \brief links the tracks of the current link and shows the next one
+ */
+void GUIController::acceptLinkProposal()
+{
+    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+    int index = GUIState::getInstance()->getCurrentLinkProposal();
+    if (proj != linkProject.lock()) {
+        discardLinkProposals();
+        return;
+    }
+    if (index < 0 || index >= linkProposals.size())
+        return;
+
+    TrackletLinker::Proposal const &p = linkProposals.at(index);
+    UndoStack::getInstance()->begin("Link two tracks", UndoStack::trackletsOf(proj, {p.source, p.target}));
+    if (!TrackletLinker::apply(proj, p))
+        MessageRelay::emitUpdateStatusBar("The tracks of the link were changed, it was dropped");
+    UndoStack::getInstance()->commit();
+    linkProposals.removeAt(index);
+    linkProposalsChanged();
+    showLinkProposal(std::min(index, linkProposals.size() - 1));
+}
+
+/*!
+ * \brief drops the current link and shows the next one
+ */
+void GUIController::rejectLinkProposal()
+{
+    int index = GUIState::getInstance()->getCurrentLinkProposal();
+    if (index < 0 || index >= linkProposals.size())
+        return;
+    linkProposals.removeAt(index);
+    linkProposalsChanged();
+    showLinkProposal(std::min(index, linkProposals.size() - 1));
+}
+
+/*!
+ * \brief links the tracks of all pending links
+ */
+void GUIController::applyLinkProposals()
+{
+    TC_TRACE_SCOPE("GUIController::applyLinkProposals");
+    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+    if (proj && proj == linkProject.lock()) {
+        QList<std::shared_ptr<Object>> linked;
+        for (TrackletLinker::Proposal const &p : linkProposals)
+            linked << p.source << p.target;
+        UndoStack::getInstance()->begin("Link all proposed tracks", UndoStack::trackletsOf(proj, linked));
+        int applied = 0;
+        for (TrackletLinker::Proposal const &p : linkProposals)
+            if (TrackletLinker::apply(proj, p))
+                applied++;
+        UndoStack::getInstance()->commit();
+        MessageRelay::emitUpdateStatusBar(QString("Linked %1 tracks, %2 were changed since the links were proposed")
+                                          .arg(applied).arg(linkProposals.size() - applied));
+    }
+    discardLinkProposals();
+}
+
+/*!
+ * \brief drops the pending links of proposeLinks()
+ */
+void GUIController::discardLinkProposals()
+{
+    linkProposals.clear();
+    linkProposalsChanged();
+}
+
+void GUIController::linkProposalsChanged()
+{
+    GUIState *gs = GUIState::getInstance();
+    gs->setLinkProposals(linkProposals.size());
+    gs->setDrawLinkProposals(!linkProposals.isEmpty());
+    if (linkProposals.isEmpty())
+        gs->setCurrentLinkProposal(0);
+    emit gs->backingDataChanged();
+}
+
+/*!
+ * \brief reads the contrast settings of the current Channel into GUIState
+ */
+void GUIController::updateContrast()
+{
+    GUIState *gs = GUIState::getInstance();
+    if (!gs->getProj() || gs->getProjPath().isEmpty())
+        return;
+
+    RawImage raw;
+    try {
+        raw = ImageCache::getInstance()->raw(gs->getProjPath(), gs->getCurrentFrame(), gs->getCurrentSlice(), gs->getCurrentChannel());
+    } catch (...) {
+        qDebug() << "could not read the image of the current frame";
+        return;
+    }
+    if (raw.isNull())
+        return;
+
+    DisplayLUT::Params p = ImageCache::getInstance()->display(gs->getCurrentChannel(), raw);
+    updatingContrast = true;
+    gs->setContrastMax(raw.maxValue());
+    gs->setContrastLow(p.low);
+    gs->setContrastHigh(p.high);
+    gs->setContrastGamma(p.gamma);
+    gs->setContrastColormap(p.colormap);
+    updatingContrast = false;
+}
+
+/*!
+ * \brief applies the contrast settings in GUIState to the current Channel
+ */
+void GUIController::applyContrast()
+{
+    if (updatingContrast)
+        return;
+
+    GUIState *gs = GUIState::getInstance();
+    DisplayLUT::Params p {gs->getContrastLow(), gs->getContrastHigh(), gs->getContrastGamma(), gs->getContrastColormap()};
+    if (!p.isValid())
+        return;
+    ImageCache::getInstance()->setDisplay(gs->getCurrentChannel(), p);
+    emit gs->backingDataChanged();
+}
+
+/*!
+ * \brief chooses the window of the current Channel from the histogram of the current Frame
+ *
+ * The gamma and the colormap are kept.
+ */
+void GUIController::autoContrast()
+{
+    GUIState *gs = GUIState::getInstance();
+    if (!gs->getProj() || gs->getProjPath().isEmpty())
+        return;
+
+    RawImage raw;
+    try {
+        raw = ImageCache::getInstance()->raw(gs->getProjPath(), gs->getCurrentFrame(), gs->getCurrentSlice(), gs->getCurrentChannel());
+    } catch (...) {
+        qDebug() << "could not read the image of the current frame";
+        return;
+    }
+    if (raw.isNull())
+        return;
+
+    DisplayLUT::Params p = DisplayLUT::autoWindow(raw.histogram());
+    p.gamma = gs->getContrastGamma();
+    p.colormap = gs->getContrastColormap();
+    ImageCache::getInstance()->setDisplay(gs->getCurrentChannel(), p);
+    updateContrast();
+    emit gs->backingDataChanged();
+}
+
+/*!
+ * \brief returns the current Channel to its default contrast settings
+ */
+void GUIController::resetContrast()
+{
+    GUIState *gs = GUIState::getInstance();
+    ImageCache::getInstance()->resetDisplay(gs->getCurrentChannel());
+    updateContrast();
+    emit gs->backingDataChanged();
+}
+
 void GUIController::mergeObjects(int firstX, int firstY, int secondX, int secondY)
 {
     std::shared_ptr<Object> first = DataProvider::getInstance()->cellAt(firstX, firstY);
@@ -746,21 +1208,60 @@ void GUIController::mergeObjects(int firstX, int firstY, int secondX, int second
         return;
     }
 
-    QPolygonF outline1(*first->getOutline());
-    QPolygonF outline2(*second->getOutline());
-    QPolygonF merged = Merge::compute(outline1, outline2);
+    mergeObjectList({first, second});
+}
+
+/*!
+ * \brief merges all Object%s at the given positions in the current Frame/Slice/Channel
+ * \param positions the positions (as points) of the Object%s
+ */
+void GUIController::mergeObjectsAt(QVariantList positions)
+{
+    QList<std::shared_ptr<Object>> objects;
+    for (QVariant const &v : positions) {
+        QPointF p = v.toPointF();
+        std::shared_ptr<Object> o = DataProvider::getInstance()->cellAt(p.x(), p.y());
+        if (!o) {
+            qDebug() << "misclicked one of the cells";
+            return;
+        }
+        if (!objects.contains(o))
+            objects.append(o);
+    }
+    if (objects.size() < 2) {
+        qDebug() << "need at least two different objects for merge";
+        return;
+    }
+
+    mergeObjectList(objects);
+}
+
+/*!
+ * \brief replaces Object%s of the same Channel by one Object with their joined outlines
+ * \param objects the Object%s to merge
+ */
+void GUIController::mergeObjectList(QList<std::shared_ptr<Object>> const &objects)
+{
+    QList<QPolygonF> outlines;
+    for (std::shared_ptr<Object> const &o : objects)
+        outlines.append(*o->getOutline());
+    bool fallback;
+    QPolygonF merged = Merge::compute(outlines, fallback);
 
     if (merged.isEmpty())
         return;
+    if (fallback)
+        MessageRelay::emitUpdateStatusBar("The outlines could not be joined exactly, they were merged approximately");
 
+    std::shared_ptr<Object> first = objects.first();
     std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
     std::shared_ptr<Movie> mov = proj->getMovie();
     std::shared_ptr<Frame> frame = mov->getFrame(first->getFrameId());
     std::shared_ptr<Slice> slice = frame->getSlice(first->getSliceId());
     std::shared_ptr<Channel> chan = slice->getChannel(first->getChannelId());
 
-    auto objects = chan->getObjects();
-    auto max_obj = *std::max_element(objects.begin(), objects.end(),
+    auto chanObjects = chan->getObjects();
+    auto max_obj = *std::max_element(chanObjects.begin(), chanObjects.end(),
                                    [](std::shared_ptr<Object> a, std::shared_ptr<Object> b){
                                         return a->getId() < b->getId();
                                    });
@@ -773,36 +1274,34 @@ void GUIController::mergeObjects(int firstX, int firstY, int secondX, int second
 
     auto mergeObject = std::make_shared<Object>(id, chan);
     mergeObject->setOutline(std::make_shared<QPolygonF>(merged));
-    mergeObject->setBoundingBox(std::make_shared<QRect>(merged.boundingRect().toRect()));
-    mergeObject->setCentroid(std::make_shared<QPoint>(merged.boundingRect().center().toPoint()));
-
-    bool ret = ModifyHDF5::replaceObjects(proj->getFileName(), {first, second}, mergeObject);
-    if (!ret)
+    FeatureTable::Features f = FeatureTable::compute(merged);
+    mergeObject->setBoundingBox(std::make_shared<QRect>(f.boundingBox.toRect()));
+    mergeObject->setCentroid(std::make_shared<QPoint>(f.centroid.toPoint()));
+
+    UndoStack *history = UndoStack::getInstance();
+    bool ret = history->begin("Merge objects", UndoStack::trackletsOf(proj, objects))
+            && history->write(objects, {mergeObject});
+    if (!ret) {
+        history->commit();
         return;
-
-    /* remove first from autotracket/tracklet */
-    if (first->isInAutoTracklet()) {
-        std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(first->getAutoId());
-        at->removeComponent(first->getFrameId());
-    }
-    if (first->isInTracklet()) {
-        std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(first->getTrackId());
-        t->removeFromContained(first->getFrameId(), first->getId());
     }
 
-    /* remove second from autotracket/tracklet */
-    if (second->isInAutoTracklet()) {
-        std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(second->getAutoId());
-        at->removeComponent(second->getFrameId());
-    }
-    if (second->isInTracklet()) {
-        std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(second->getTrackId());
-        t->removeFromContained(second->getFrameId(), second->getId());
+    for (std::shared_ptr<Object> const &o : objects) {
+        /* remove the merged object from autotracket/tracklet */
+        if (o->isInAutoTracklet()) {
+            std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(o->getAutoId());
+            at->removeComponent(o->getFrameId());
+        }
+        if (o->isInTracklet()) {
+            std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(o->getTrackId());
+            t->removeFromContained(o->getFrameId(), o->getId());
+        }
+        chan->removeObject(o->getId());
     }
 
-    chan->removeObject(first->getId());
-    chan->removeObject(second->getId());
     chan->addObject(mergeObject);
+    history->replaced(objects, {mergeObject});
+    history->commit();
     emit GUIState::getInstance()->backingDataChanged();
 }
 
@@ -822,9 +1321,13 @@ void GUIController::deleteObject(double posX, double posY)
     std::shared_ptr<Channel> chan = slice->getChannel(deletee->getChannelId());
 
     /* delete old object in HDF5 */
-    bool ret = ModifyHDF5::removeObject(proj->getFileName(), deletee);
-    if (!ret)
+    UndoStack *history = UndoStack::getInstance();
+    bool ret = history->begin("Delete an object", UndoStack::trackletsOf(proj, {deletee}))
+            && history->write({deletee}, {});
+    if (!ret) {
+        history->commit();
         return;
+    }
 
     /* remove old object from autotracket/tracklet */
     if (deletee->isInAutoTracklet()) {
@@ -838,6 +1341,8 @@ void GUIController::deleteObject(double posX, double posY)
 
     /* remove the old object */
     chan->removeObject(deletee->getId());
+    history->replaced({deletee}, {});
+    history->commit();
 
     emit GUIState::getInstance()->backingDataChanged();
 }
@@ -846,6 +1351,13 @@ void GUIController::floodFill(int posX, int posY)
 {
     std::shared_ptr<Object> toDelete = DataProvider::getInstance()->cellAt(posX, posY);
 
+    /* replacing the Object under the cursor and adding the new one is undone at once */
+    UndoStack *history = UndoStack::getInstance();
+    if (!history->begin("Add an object", UndoStack::trackletsOf(GUIState::getInstance()->getProj(), {toDelete}))) {
+        history->commit();
+        return;
+    }
+
     if (toDelete) {
         std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
         std::shared_ptr<Movie> mov = proj->getMovie();
@@ -854,9 +1366,11 @@ void GUIController::floodFill(int posX, int posY)
         std::shared_ptr<Channel> chan = slice->getChannel(toDelete->getChannelId());
 
         /* delete old object in HDF5 */
-        bool ret = ModifyHDF5::removeObject(proj->getFileName(), toDelete);
-        if (!ret)
+        bool ret = history->write({toDelete}, {});
+        if (!ret) {
+            history->commit();
             return;
+        }
 
         if (toDelete->isInAutoTracklet()) {
             std::shared_ptr<AutoTracklet> at = proj->getAutoTracklet(toDelete->getAutoId());
@@ -870,6 +1384,7 @@ void GUIController::floodFill(int posX, int posY)
 
         /* remove the old object */
         chan->removeObject(toDelete->getId());
+        history->replaced({toDelete}, {});
     }
 
     int fNr = GUIState::getInstance()->getCurrentFrame();
@@ -891,6 +1406,7 @@ void GUIController::floodFill(int posX, int posY)
 
     if (id == INT_MAX) {
         qDebug() << "Too many objects";
+        history->commit();
         return;
     }
 
@@ -909,14 +1425,19 @@ void GUIController::floodFill(int posX, int posY)
     QPolygonF newOutline = ff.compute(p, thresh);
     auto newObject = std::make_shared<Object>(id, chan);
     newObject->setOutline(std::make_shared<QPolygonF>(newOutline));
-    newObject->setBoundingBox(std::make_shared<QRect>(newOutline.boundingRect().toRect()));
-    newObject->setCentroid(std::make_shared<QPoint>(newOutline.boundingRect().center().toPoint()));
+    FeatureTable::Features f = FeatureTable::compute(newOutline);
+    newObject->setBoundingBox(std::make_shared<QRect>(f.boundingBox.toRect()));
+    newObject->setCentroid(std::make_shared<QPoint>(f.centroid.toPoint()));
 
-    bool ret = ModifyHDF5::replaceObjects(proj->getFileName(), {}, newObject);
-    if (!ret)
+    bool ret = history->write({}, {newObject});
+    if (!ret) {
+        history->commit();
         return;
+    }
 
     chan->addObject(newObject);
+    history->replaced({}, {newObject});
+    history->commit();
 
     emit GUIState::getInstance()->backingDataChanged();
 }
@@ -981,147 +1502,216 @@ void GUIController::setCurrentAction(int value)
 }
 
 /*!
- * \brief runs the strategy GUIState::Strategy::STRATEGY_CLICK_JUMP
- * \param delay the delay between frames
+ * \brief plans the strategy GUIState::Strategy::STRATEGY_CLICK_JUMP
  * \param show how many frames to display before the end of the AutoTracklet
+ * \return true, if there is something to play back
  *
  * For a description of strategies, see GUIController::startStrategy
  */
-void GUIController::runStrategyClickJump(unsigned long delay, unsigned int show) {
-    int jumpFrames;
-    int displayFrames = show;
-
+bool GUIController::planStrategyClickJump(unsigned int show) {
     /* get current track */
     std::shared_ptr<AutoTracklet> t = GUIState::getInstance()->getSelectedAutoTrack().lock();
-
     if (!t)
-        goto out;
+        return false;
 
-    {
     /* get length of current track */
     uint32_t start = t->getStart();
     uint32_t end = t->getEnd();
-
     uint32_t curr = GUIState::getInstance()->getCurrentFrame();
 
     if (curr < start || curr >= end) /* nothing to do, we are before or after the track */
-        goto out;
+        return false;
 
+    unsigned int displayFrames = show;
     if (end - curr < show) /* we are already to near to the end to display all requested frames */
-        displayFrames = end -curr;
-
-    jumpFrames = end - displayFrames - curr;
+        displayFrames = end - curr;
 
-    /* jump if jumpFrames > 0 */
-    if (jumpFrames > 0)
-        GUIController::getInstance()->changeFrame(jumpFrames);
+    /* jump right away, the remaining frames are played back */
+    if (end - displayFrames > curr)
+        changeFrameAbs(end - displayFrames);
 
-    for (int i = 0; i < displayFrames; i++) {
-        if (abortStrategyIssued)
-            break;
-        QThread::msleep(delay);
-        GUIState::getInstance()->setImageReady(false);
-        GUIController::getInstance()->changeFrame(1);
-        /* wait until frame is actually displayed */
-        while (!GUIState::getInstance()->getImageReady())
-            QThread::msleep(10);
-    }
-    }
-out:
-    abortStrategyIssued = false;
-    setCurrentStrategy(GUIState::Strategy::STRATEGY_DEFAULT);
-    setCurrentStrategyRunning(false);
-    GUIState::getInstance()->setMouseAreaActive(true);
+    for (uint32_t f = end - displayFrames + 1; f <= end; f++)
+        playbackFrames.append(f);
+    playbackLoop = false;
+    return !playbackFrames.isEmpty();
 }
 
 /*!
- * \brief runs the strategy GUIState::Strategy::STRATEGY_CLICK_SPIN
- * \param delay the delay between frames
+ * \brief plans the strategy GUIState::Strategy::STRATEGY_CLICK_SPIN
+ * \return true, if there is something to play back
  *
  * For a description of strategies, see GUIController::startStrategy
  */
-void GUIController::runStrategyClickSpin(unsigned long delay) {
+bool GUIController::planStrategyClickSpin() {
     /* get current track */
     std::shared_ptr<AutoTracklet> t = GUIState::getInstance()->getSelectedAutoTrack().lock();
-
     if (!t)
-        goto out;
+        return false;
 
-    {
     /* get length of current track */
     uint32_t start = t->getStart();
     uint32_t end = t->getEnd();
-
     uint32_t begin = GUIState::getInstance()->getCurrentFrame();
-    unsigned int curr = begin;
 
     if (begin < start || begin >= end) /* nothing to do, we are at the end of or after the track */
-        goto out;
-
-    while (true) {
-        if (abortStrategyIssued)
-            break;
-        curr = (curr >= end)?begin:curr+1;
-        QThread::msleep(delay);
-        GUIState::getInstance()->setImageReady(false);
-        GUIController::getInstance()->changeFrameAbs(curr);
-        /* wait until frame is actually displayed */
-        while (!GUIState::getInstance()->getImageReady())
-            QThread::msleep(10);
-    }
-    }
-out:
-    abortStrategyIssued = false;
-    setCurrentStrategy(GUIState::Strategy::STRATEGY_DEFAULT);
-    setCurrentStrategyRunning(false);
-    GUIState::getInstance()->setMouseAreaActive(true);
+        return false;
+
+    /* from the frame after the current one to the end, then starting over */
+    for (uint32_t f = begin + 1; f <= end; f++)
+        playbackFrames.append(f);
+    playbackFrames.append(begin);
+    playbackLoop = true;
+    return true;
 }
 
 /*!
- * \brief runs the strategy GUIState::Strategy::STRATEGY_CLICK_STEP
- * \param delay the delay between frames
+ * \brief plans the strategy GUIState::Strategy::STRATEGY_CLICK_STEP
+ * \return true, if there is something to play back
  *
  * For a description of strategies, see GUIController::startStrategy
  */
-void GUIController::runStrategyClickStep(unsigned long delay) {
+bool GUIController::planStrategyClickStep() {
     /* get current track */
     std::shared_ptr<AutoTracklet> t = GUIState::getInstance()->getSelectedAutoTrack().lock();
-
     if (!t)
-        goto out;
+        return false;
 
-    {
     uint32_t end = t->getEnd();
-
-    unsigned int curr = GUIState::getInstance()->getCurrentFrame();
+    uint32_t curr = GUIState::getInstance()->getCurrentFrame();
 
     if (curr >= end) /* nothing to do, we are at the end of or after the track */
-        goto out;
+        return false;
 
-    for (curr = GUIState::getInstance()->getCurrentFrame(); curr < end; curr++) {
-        if (abortStrategyIssued)
-            break;
-        QThread::msleep(delay);
-        GUIState::getInstance()->setImageReady(false);
-        GUIController::getInstance()->changeFrame(1);
-        /* wait until frame is actually displayed */
-        while (!GUIState::getInstance()->getImageReady())
-            QThread::msleep(10);
+    for (uint32_t f = curr + 1; f <= end; f++)
+        playbackFrames.append(f);
+    playbackLoop = false;
+    return true;
+}
+
+/*!
+ * \brief asks the ImageCache to read the frames that are played back next
+ *
+ * About one second of playback is prefetched, so reading the images from the
+ * HDF5 file overlaps with displaying the current frames.
+ */
+void GUIController::prefetchPlayback()
+{
+    if (playbackFrames.isEmpty())
+        return;
+
+    GUIState *gs = GUIState::getInstance();
+    int lookahead = qBound(4, 1000 / std::max(playbackTimer.interval(), 1), 32);
+    QList<int> frames;
+    for (int i = 0; i < lookahead; i++) {
+        int pos = playbackPos + i;
+        if (pos >= playbackFrames.size()) {
+            if (!playbackLoop)
+                break;
+            pos %= playbackFrames.size();
+        }
+        frames.append(playbackFrames[pos]);
     }
+    ImageCache::getInstance()->prefetch(gs->getProjPath(), frames, gs->getCurrentSlice(), gs->getCurrentChannel());
+}
+
+/*!
+ * \brief asks the ImageCache to read the frames of the selected AutoTracklet around the current frame
+ *
+ * Called whenever the current frame or the selected AutoTracklet changes. When
+ * an AutoTracklet is selected, it is usually stepped through frame by frame,
+ * so the next graphics/prefetch_frames frames containing it (and a few before
+ * the current frame, for stepping back) are prefetched. During playback the
+ * planned frames are prefetched instead.
+ */
+void GUIController::prefetchAutoTracklet()
+{
+    if (playbackTimer.isActive())
+        return;
+
+    GUIState *gs = GUIState::getInstance();
+    std::shared_ptr<AutoTracklet> at = gs->getSelectedAutoTrack().lock();
+    if (!at || gs->getProjPath().isEmpty())
+        return;
+
+    TC_TRACE_SCOPE("GUIController::prefetchAutoTracklet");
+    int ahead = std::max(TCSettings::value("graphics/prefetch_frames").toInt(), 0);
+    int behind = std::max(ahead / 4, 2);
+    int curr = gs->getCurrentFrame();
+    QMap<int,std::shared_ptr<Object>> const components = at->getComponents();
+
+    QList<int> frames;
+    for (auto it = components.lowerBound(curr + 1); it != components.end() && frames.size() < ahead; ++it)
+        frames.append(it.key());
+    for (auto it = components.lowerBound(curr); it != components.begin() && behind > 0; behind--)
+        frames.append((--it).key());
+
+    ImageCache::getInstance()->prefetch(gs->getProjPath(), frames, gs->getCurrentSlice(), gs->getCurrentChannel());
+}
+
+/*!
+ * \brief shows the next planned frame
+ *
+ * Called by playbackTimer on the GUI thread. If displaying the previous frame
+ * took longer than the delay, the ticks that were missed are counted as
+ * dropped frames. No frame is skipped, the playback just falls behind.
+ */
+void GUIController::playbackTick()
+{
+    /* time from the frame change until the new frame is displayed */
+    TC_TRACE_SCOPE("GUIController::strategyStep");
+    qint64 interval = std::max(playbackTimer.interval(), 1);
+    qint64 slot = (playbackClock.elapsed() + interval / 2) / interval;
+    if (slot > playbackSlot) {
+        droppedFrames += static_cast<int>(slot - playbackSlot);
+        TC_TRACE_COUNTER("GUIController::droppedFrames", droppedFrames);
+    }
+    playbackSlot = slot + 1;
+
+    GUIState::getInstance()->setImageReady(false);
+    changeFrameAbs(playbackFrames[playbackPos++]);
+
+    if (playbackPos >= playbackFrames.size()) {
+        if (!playbackLoop) {
+            finishStrategy();
+            return;
+        }
+        playbackPos = 0;
     }
-out:
-    abortStrategyIssued = false;
+    prefetchPlayback();
+}
+
+/*!
+ * \brief stops the playback and resets the strategy
+ */
+void GUIController::finishStrategy()
+{
+    bool wasRunning = playbackTimer.isActive();
+    playbackTimer.stop();
+    playbackFrames.clear();
+    playbackPos = 0;
     setCurrentStrategy(GUIState::Strategy::STRATEGY_DEFAULT);
     setCurrentStrategyRunning(false);
     GUIState::getInstance()->setMouseAreaActive(true);
+    if (wasRunning && droppedFrames > 0)
+        MessageRelay::emitUpdateStatusBar(QString("Playback could not keep up, %1 frames were dropped").arg(droppedFrames));
 }
 
 /*!
- * \brief sets abortStrategyIssued to true, causing strategies to stop
+ * \brief stops the running strategy
  */
 void GUIController::abortStrategy()
 {
-    abortStrategyIssued = true;
+    if (currentStrategyRunning)
+        finishStrategy();
+}
+
+/*!
+ * \brief returns the number of frames dropped by the current or last playback
+ * \return the number of dropped frames
+ */
+int GUIController::getDroppedFrames() const
+{
+    return droppedFrames;
 }
 
 /*!
@@ -1136,32 +1726,49 @@ void GUIController::abortStrategy()
  * - STRATEGY_CLICK_SPIN (delay X):
  *     Displays all frames to the end of the AutoTracklet with a delay of X ms
  *     inbetween, then starts from the beginning of the AutoTracklet and loops
- *     until abortStrategyIssued is set to true
+ *     until abortStrategy is called
  * - STRATEGY_CLICK_STEP (delay X):
  *     Displays all frames to the end of the AutoTracklet with a delay of X ms
  *     inbetween and then stops.
  *
+ * The strategies are played back by a timer on the GUI thread, the frames
+ * ahead are prefetched by the ImageCache.
+ *
  * If no strategy is selected, currentStrategy is set to STRATEGY_DEFAULT.
  */
 void GUIController::startStrategy(unsigned long delay, unsigned int show) {
-    QFuture<void> f;
-    abortStrategyIssued = false;
-    GUIState::getInstance()->setMouseAreaActive(false);
+    TC_TRACE_SCOPE("GUIController::startStrategy");
+    playbackTimer.stop();
+    playbackFrames.clear();
+    playbackPos = 0;
+    droppedFrames = 0;
+
+    bool planned = false;
     switch (currentStrategy) {
     case GUIState::Strategy::STRATEGY_CLICK_JUMP:
-        f = QtConcurrent::run(this, &GUIController::runStrategyClickJump, delay, show);
+        planned = planStrategyClickJump(show);
         break;
     case GUIState::Strategy::STRATEGY_CLICK_SPIN:
-        f = QtConcurrent::run(this, &GUIController::runStrategyClickSpin, delay);
+        planned = planStrategyClickSpin();
         break;
     case GUIState::Strategy::STRATEGY_CLICK_STEP:
-        f = QtConcurrent::run(this, &GUIController::runStrategyClickStep, delay);
+        planned = planStrategyClickStep();
         break;
     case GUIState::Strategy::STRATEGY_DEFAULT:
         throw TCUnimplementedException("It shouldn't be possible to call startStrategy with STRATEGY_DEFAULT as the current strategy");
     }
-    futures.push_back(f);
+
+    if (!planned) {
+        finishStrategy();
+        return;
+    }
+
+    GUIState::getInstance()->setMouseAreaActive(false);
     setCurrentStrategyRunning(true);
+    playbackSlot = 1;
+    playbackTimer.start(static_cast<int>(std::max(delay, 1UL)));
+    playbackClock.start();
+    prefetchPlayback();
 }
 
 /*!
@@ -1180,10 +1787,63 @@ bool GUIController::connectTracks() {
     std::shared_ptr<Object> first = gs->getSelectedCell().lock();
     std::shared_ptr<Object> second = DataProvider::getInstance()->cellAtFrame(frame, slice, channel, x, y);
     if (first && second) {
-        return GUIState::getInstance()->getProj()->getGenealogy()->connectObjects(first, second);
+        std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+        UndoStack::getInstance()->begin("Connect tracks", UndoStack::trackletsOf(proj, {first, second}));
+        bool ret = proj->getGenealogy()->connectObjects(first, second);
+        UndoStack::getInstance()->commit();
+        return ret;
     }
     return false;
 }
 
+/*!
+ * \brief undoes the last segmentation or tracking edit
+ */
+void GUIController::undo()
+{
+    if (UndoStack::getInstance()->undo())
+        refreshSelection();
+}
+
+/*!
+ * \brief redoes the last edit that was undone
+ */
+void GUIController::redo()
+{
+    if (UndoStack::getInstance()->redo())
+        refreshSelection();
+}
+
+/*!
+ * \brief selects the (Auto)Tracklet of the selected Object again after undo() or redo()
+ *
+ * If the selected Object was removed, nothing is selected.
+ */
+void GUIController::refreshSelection()
+{
+    GUIState *gs = GUIState::getInstance();
+    std::shared_ptr<Project> proj = gs->getProj();
+    std::shared_ptr<Object> o = gs->getSelectedCell().lock();
+
+    unhoverCell();
+    unhoverTrack();
+    unhoverAutoTracklet();
+    if (o && proj->getGenealogy()->getObjectAt(o->getFrameId(), o->getSliceId(), o->getChannelId(), o->getId()) == o) {
+        if (o->isInTracklet())
+            selectTrack(o, proj);
+        else
+            deselectTrack();
+        if (o->isInAutoTracklet())
+            selectAutoTracklet(o, proj);
+        else
+            deselectAutoTracklet();
+    } else {
+        deselectCell();
+        deselectTrack();
+        deselectAutoTracklet();
+    }
+    emit gs->backingDataChanged();
+}
+
 }
 
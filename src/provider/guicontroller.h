@@ -19,11 +19,19 @@
 #define GUICONTROLLER_H
 
 #include "guistate.h"
+#include "graphics/trackresegmentation.h"
+#include "tracked/trackletlinker.h"
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QObject>
+#include <QPair>
+#include <QPolygonF>
 #include <QQmlEngine>
 #include <QJSEngine>
-#include <QThread>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
 
 namespace TraCurate {
 /*!
@@ -51,9 +59,14 @@ public:
     /* control the running of the current strategy */
     Q_INVOKABLE void startStrategy(unsigned long delay, unsigned int show);
     Q_INVOKABLE void abortStrategy();
+    Q_INVOKABLE int getDroppedFrames() const;
 
     Q_INVOKABLE bool connectTracks();
 
+    /* undo and redo the edits recorded by the UndoStack */
+    Q_INVOKABLE void undo();
+    Q_INVOKABLE void redo();
+
     Q_INVOKABLE void hoverCell(int frame, int slice, int channel, double x, double y);
     Q_INVOKABLE void selectCell(int frame, int slice, int channel, double x, double y);
 
@@ -62,19 +75,38 @@ public:
     Q_INVOKABLE void changeStatus(int trackId, int status);
 
     Q_INVOKABLE void cutObject(int startX, int startY, int endX, int endY);
+    Q_INVOKABLE void cutObjectsAlong(QVariantList points);
     Q_INVOKABLE void mergeObjects(int firstX, int firstY, int secondX, int secondY);
+    Q_INVOKABLE void mergeObjectsAt(QVariantList positions);
     Q_INVOKABLE void deleteObject(double posX, double posY);
     Q_INVOKABLE void floodFill(int posX, int posY);
+    Q_INVOKABLE void watershedSplit(QVariantList seeds);
+
+    /* segment all Objects of a (Auto)Tracklet again, preview and apply the result */
+    Q_INVOKABLE void resegmentTrack(int id, bool autoTracklet, bool watershed);
+    Q_INVOKABLE void applyResegmentation();
+    Q_INVOKABLE void discardResegmentation();
+    QList<TrackResegmentation::Result> getResegmentation() const;
+
+    /* propose links between the ends and starts of tracks, accept them one by one or all at once */
+    Q_INVOKABLE void proposeLinks();
+    Q_INVOKABLE void acceptLinkProposal();
+    Q_INVOKABLE void rejectLinkProposal();
+    Q_INVOKABLE void showLinkProposal(int index);
+    Q_INVOKABLE void applyLinkProposals();
+    Q_INVOKABLE void discardLinkProposals();
+    QList<TrackletLinker::Proposal> getLinkProposals() const;
+
+    /* contrast of the current Channel, the settings are in GUIState */
+    Q_INVOKABLE void autoContrast();
+    Q_INVOKABLE void resetContrast();
 
     static GUIController *getInstance();
     static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
 
-    void waitForFutures();
-
 private:
     explicit GUIController(QObject *parent = 0);
     static GUIController *theInstance;
-    bool abortStrategyIssued;
 
     Q_PROPERTY(int currentStrategy
                READ getCurrentStrategy
@@ -89,11 +121,34 @@ private:
                WRITE setCurrentAction
                NOTIFY currentActionChanged) GUIState::Action currentAction;
 
-    /* the strategies */
-    void runStrategyClickJump(unsigned long delay, unsigned int show);
-    void runStrategyClickSpin(unsigned long delay);
-    void runStrategyClickStep(unsigned long delay);
-
+    /* the strategies, they compute the frames to play back */
+    bool planStrategyClickJump(unsigned int show);
+    bool planStrategyClickSpin();
+    bool planStrategyClickStep();
+
+    /* playback of the planned frames */
+    void prefetchPlayback();
+    void finishStrategy();
+
+    void splitObjects(QList<QPair<std::shared_ptr<Object>,QList<QPolygonF>>> const &splits);
+    void mergeObjectList(QList<std::shared_ptr<Object>> const &objects);
+    void linkProposalsChanged();
+    void refreshSelection();
+
+    QTimer playbackTimer;
+    QElapsedTimer playbackClock;
+    QVector<int> playbackFrames;    /*!< the frames to show, in order */
+    int playbackPos;                /*!< index of the next frame in playbackFrames */
+    bool playbackLoop;              /*!< restart at the first frame after the last one */
+    qint64 playbackSlot;            /*!< the next expected tick of playbackTimer */
+    int droppedFrames;
+
+    QFutureWatcher<TrackResegmentation::Result> resegmentationWatcher;
+    QList<TrackResegmentation::Result> resegmentation;  /*!< the pending new outlines */
+    QFutureWatcher<QVector<TrackletLinker::Proposal>> linkingWatcher;
+    QList<TrackletLinker::Proposal> linkProposals;  /*!< the pending links, ordered by Frame */
+    std::weak_ptr<Project> linkProject;             /*!< the Project linkProposals were made for */
+    bool updatingContrast;          /*!< the contrast settings in GUIState are set from the ImageCache */
 
     /* helper functions for hovering a Cell and (Auto)Track(lets) */
     void hoverCell(std::shared_ptr<Object> const &o);
@@ -110,14 +165,18 @@ private:
     void deselectTrack();
     void selectAutoTracklet(std::shared_ptr<Object> const &o, std::shared_ptr<Project> const &proj);
     void deselectAutoTracklet();
-
-    QList<QFuture<void>> futures;
 signals:
     void currentStrategyChanged(int);
     void currentStrategyRunningChanged(bool);
     void currentActionChanged(int);
 
-public slots:
+private slots:
+    void playbackTick();
+    void prefetchAutoTracklet();
+    void resegmentationFinished();
+    void linkingFinished();
+    void updateContrast();
+    void applyContrast();
 };
 }
 
@@ -74,11 +74,21 @@ GUIState::GUIState(QObject *parent) : QObject(parent),
     drawAggregation(false),
     drawDeletion(false),
     drawFlood(false),
+    drawWatershed(false),
+    drawResegmentation(false),
     startX(-1),
     startY(-1),
     endX(-1),
     endY(-1),
     thresh(5),
+    contrastLow(0),
+    contrastHigh(255),
+    contrastGamma(1.0),
+    contrastColormap(0),
+    contrastMax(255),
+    drawLinkProposals(false),
+    linkProposals(0),
+    currentLinkProposal(0),
     zoomFactor(1.0),
     offX(0),
     offY(0),
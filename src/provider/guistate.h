@@ -157,12 +157,28 @@ private:
     TC_PROP(bool, drawAggregation, DrawAggregation)
     TC_PROP(bool, drawDeletion, DrawDeletion)
     TC_PROP(bool, drawFlood, DrawFlood)
+    TC_PROP(bool, drawWatershed, DrawWatershed)
+    TC_PROP(bool, drawResegmentation, DrawResegmentation)
     TC_PROP(int, startX, StartX)
     TC_PROP(int, startY, StartY)
     TC_PROP(int, endX, EndX)
     TC_PROP(int, endY, EndY)
+    TC_PROP(QVariantList, cutPath, CutPath)
+    TC_PROP(QVariantList, seeds, Seeds)
     TC_PROP_LIMITS(int, thresh, Thresh, 0, 255)
 
+    /* the contrast settings of the current Channel, see DisplayLUT */
+    TC_PROP(int, contrastLow, ContrastLow)
+    TC_PROP(int, contrastHigh, ContrastHigh)
+    TC_PROP_LIMITS_DBL(double, contrastGamma, ContrastGamma, 0.1, 10.0)
+    TC_PROP(int, contrastColormap, ContrastColormap)
+    TC_PROP(int, contrastMax, ContrastMax)
+
+    /* the pending link proposals of GUIController::proposeLinks() */
+    TC_PROP(bool, drawLinkProposals, DrawLinkProposals)
+    TC_PROP(int, linkProposals, LinkProposals)
+    TC_PROP(int, currentLinkProposal, CurrentLinkProposal)
+
     TC_PROP_LIMITS_DBL(double, zoomFactor, ZoomFactor, 0.5, 5.0)
     TC_PROP(int, offX, OffX)
     TC_PROP(int, offY, OffY)
@@ -276,12 +292,26 @@ signals:
     void drawAggregationChanged(bool);
     void drawDeletionChanged(bool);
     void drawFloodChanged(bool);
+    void drawWatershedChanged(bool);
+    void drawResegmentationChanged(bool);
     void startXChanged(int);
     void startYChanged(int);
     void endXChanged(int);
     void endYChanged(int);
+    void cutPathChanged(QVariantList);
+    void seedsChanged(QVariantList);
     void threshChanged(int);
 
+    void contrastLowChanged(int);
+    void contrastHighChanged(int);
+    void contrastGammaChanged(double);
+    void contrastColormapChanged(int);
+    void contrastMaxChanged(int);
+
+    void drawLinkProposalsChanged(bool);
+    void linkProposalsChanged(int);
+    void currentLinkProposalChanged(int);
+
     void zoomFactorChanged(double);
     void offXChanged(int);
     void offYChanged(int);
@@ -0,0 +1,352 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "imagecache.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QDebug>
+
+#include "provider/dataprovider.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+/*!
+ * \brief constructor for ImageCache
+ *
+ * This constructor is private, please use ImageCache::getInstance to obtain an instance of ImageCache
+ */
+ImageCache::ImageCache() :
+    generation(0),
+    contrastGeneration(0)
+{
+    /* the cost of an image is its size in KiB */
+    int maxCost = std::max(TCSettings::value("graphics/image_cache_size").toInt(), 1) * 1024;
+    cache.setMaxCost(maxCost);
+    raws.setMaxCost(maxCost);
+    pool.setMaxThreadCount(1);
+}
+
+/*!
+ * \brief returns an instance of the ImageCache
+ * \return an instance of the ImageCache
+ */
+ImageCache *ImageCache::getInstance()
+{
+    static ImageCache *instance = new ImageCache();
+    return instance;
+}
+
+/*!
+ * \brief reads an image from the HDF5 file
+ * \param key the image to read
+ * \return the image as it is stored
+ */
+RawImage ImageCache::decode(Key const &key)
+{
+    TC_TRACE_SCOPE("ImageCache::decode");
+    return DataProvider::getInstance()->requestRawImage(key.path, key.frame, key.slice, key.channel);
+}
+
+/*!
+ * \brief looks up an image in the cache
+ * \param key the image to look up
+ * \param entry receives the cached image, if it was found
+ * \return true, if the image was found
+ */
+bool ImageCache::lookup(Key const &key, Entry &entry)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Entry *e = cache.object(key);
+    if (!e)
+        return false;
+    entry = *e;
+    return true;
+}
+
+/*!
+ * \brief inserts a drawn image, unless the contrast was changed since it was drawn
+ * \param key the image
+ * \param entry the drawn image
+ * \param contrast the contrastGeneration the image was drawn with
+ */
+void ImageCache::insert(Key const &key, Entry const &entry, int contrast)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (contrast == contrastGeneration)
+        cache.insert(key, new Entry(entry), std::max(entry.image.byteCount() / 1024, 1));
+}
+
+/*!
+ * \brief returns the image for a key as it is stored, reading it if it is not cached
+ * \param path the path of the HDF5 file
+ * \param frame the frame of the image
+ * \param slice the slice of the image
+ * \param channel the channel of the image
+ * \return the RawImage
+ */
+RawImage ImageCache::raw(QString const &path, int frame, int slice, int channel)
+{
+    Key key{path, frame, slice, channel, QSize()};
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        RawImage *r = raws.object(key);
+        if (r)
+            return *r;
+    }
+    RawImage ret = decode(key);
+    std::lock_guard<std::mutex> lock(mtx);
+    raws.insert(key, new RawImage(ret), std::max(ret.byteCount() / 1024, 1));
+    return ret;
+}
+
+/*!
+ * \brief reads a downsampled image from the HDF5 file, it is not cached
+ * \param path the path of the HDF5 file
+ * \param frame the frame of the image
+ * \param slice the slice of the image
+ * \param channel the channel of the image
+ * \param maxSize the longest side of the image
+ * \return the RawImage
+ */
+RawImage ImageCache::thumbnail(QString const &path, int frame, int slice, int channel, int maxSize)
+{
+    TC_TRACE_SCOPE("ImageCache::thumbnail");
+    return DataProvider::getInstance()->requestRawThumbnail(path, frame, slice, channel, maxSize);
+}
+
+/*!
+ * \brief draws a RawImage with the contrast settings of its Channel
+ * \param channel the Channel
+ * \param raw the RawImage, e.g. a thumbnail
+ * \return the image in QImage::Format_ARGB32_Premultiplied
+ */
+QImage ImageCache::draw(int channel, RawImage const &raw)
+{
+    return lutFor(channel, raw)->apply(raw);
+}
+
+/*!
+ * \brief returns the DisplayLUT of a Channel, choosing its contrast settings if there are none
+ * \param channel the Channel
+ * \param raw an image of the Channel, its histogram is used for the default window
+ * \return the DisplayLUT for the bit depth of raw
+ */
+std::shared_ptr<DisplayLUT const> ImageCache::lutFor(int channel, RawImage const &raw)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<DisplayLUT const> lut = luts.value(channel);
+    if (lut && lut->getBitDepth() == raw.bitDepth())
+        return lut;
+
+    if (!displays.contains(channel))
+        displays.insert(channel, raw.bitDepth() == 8 ? DisplayLUT::identity(8) : DisplayLUT::autoWindow(raw.histogram()));
+    lut = std::make_shared<DisplayLUT const>(displays.value(channel), raw.bitDepth());
+    luts.insert(channel, lut);
+    return lut;
+}
+
+/*!
+ * \brief returns the contrast settings of a Channel
+ * \param channel the Channel
+ * \param raw an image of the Channel, used to choose the settings if there are none yet
+ * \return the contrast settings
+ */
+DisplayLUT::Params ImageCache::display(int channel, RawImage const &raw)
+{
+    return lutFor(channel, raw)->getParams();
+}
+
+/*!
+ * \brief changes the contrast settings of a Channel, its images are drawn again when they are requested
+ * \param channel the Channel
+ * \param params the new contrast settings
+ */
+void ImageCache::setDisplay(int channel, DisplayLUT::Params const &params)
+{
+    ++generation;
+    std::lock_guard<std::mutex> lock(mtx);
+    displays.insert(channel, params);
+    luts.remove(channel);
+    dropDrawn(channel);
+}
+
+/*!
+ * \brief returns a Channel to its default contrast settings
+ * \param channel the Channel
+ */
+void ImageCache::resetDisplay(int channel)
+{
+    ++generation;
+    std::lock_guard<std::mutex> lock(mtx);
+    displays.remove(channel);
+    luts.remove(channel);
+    dropDrawn(channel);
+}
+
+/* needs mtx to be locked */
+void ImageCache::dropDrawn(int channel)
+{
+    ++contrastGeneration;
+    queued.clear();
+    for (Key const &key : cache.keys())
+        if (key.channel == channel)
+            cache.remove(key);
+}
+
+/*!
+ * \brief returns the original image for a key, drawing it if it is not cached
+ * \param key the image (the size is ignored)
+ * \return the original image
+ */
+ImageCache::Entry ImageCache::original(Key const &key)
+{
+    Key orig{key.path, key.frame, key.slice, key.channel, QSize()};
+    Entry entry;
+    if (lookup(orig, entry))
+        return entry;
+
+    int contrast = contrastGeneration;
+    RawImage r = raw(key.path, key.frame, key.slice, key.channel);
+    entry.image = lutFor(key.channel, r)->apply(r);
+    entry.originalSize = entry.image.size();
+    insert(orig, entry, contrast);
+    return entry;
+}
+
+/*!
+ * \brief returns an image, reading it from the HDF5 file if it is not cached
+ * \param path the path of the HDF5 file
+ * \param frame the frame of the image
+ * \param slice the slice of the image
+ * \param channel the channel of the image
+ * \param size if valid, the image is scaled to fit into this size keeping the aspect ratio
+ * \param originalSize if not nullptr, receives the size of the unscaled image
+ * \return the image in QImage::Format_ARGB32_Premultiplied
+ *
+ * The size of scaled requests is remembered and used for prefetching.
+ */
+QImage ImageCache::get(QString const &path, int frame, int slice, int channel, QSize const &size, QSize *originalSize)
+{
+    Key key{path, frame, slice, channel, size};
+    if (size.isValid()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        displaySize = size;
+    }
+
+    Entry entry;
+    if (lookup(key, entry)) {
+        TC_TRACE_COUNTER("ImageCache hits", 1);
+    } else {
+        TC_TRACE_COUNTER("ImageCache misses", 1);
+        int contrast = contrastGeneration;
+        entry = original(key);
+        if (size.isValid()) {
+            entry.image = entry.image.scaled(size, Qt::KeepAspectRatio);
+            insert(key, entry, contrast);
+        }
+    }
+    if (originalSize)
+        *originalSize = entry.originalSize;
+    return entry.image;
+}
+
+/*!
+ * \brief tells whether an image is cached
+ * \param path the path of the HDF5 file
+ * \param frame the frame of the image
+ * \param slice the slice of the image
+ * \param channel the channel of the image
+ * \param size the size of the scaled image or an invalid size for the original image
+ * \return true, if the image is cached
+ */
+bool ImageCache::contains(QString const &path, int frame, int slice, int channel, QSize const &size)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return cache.contains({path, frame, slice, channel, size});
+}
+
+/*!
+ * \brief reads and scales images in the background
+ * \param path the path of the HDF5 file
+ * \param frames the frames to read, in the order they are needed
+ * \param slice the slice of the images
+ * \param channel the channel of the images
+ *
+ * The images are scaled to the size of the last scaled request. Requests from
+ * earlier calls that were not started yet are dropped.
+ */
+void ImageCache::prefetch(QString const &path, QList<int> const &frames, int slice, int channel)
+{
+    int gen = ++generation;
+    std::lock_guard<std::mutex> lock(mtx);
+    queued.clear();
+    for (int frame : frames) {
+        Key key{path, frame, slice, channel, displaySize};
+        if (cache.contains(key) || queued.contains(key))
+            continue;
+        queued.insert(key);
+        QtConcurrent::run(&pool, this, &ImageCache::runPrefetch, key, gen);
+    }
+}
+
+void ImageCache::runPrefetch(Key key, int gen)
+{
+    TC_TRACE_SCOPE("ImageCache::prefetch");
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (gen != generation || !queued.remove(key) || cache.contains(key))
+            return;
+    }
+    try {
+        int contrast = contrastGeneration;
+        Entry entry = original(key);
+        if (key.size.isValid()) {
+            entry.image = entry.image.scaled(key.size, Qt::KeepAspectRatio);
+            insert(key, entry, contrast);
+        }
+    } catch (...) {
+        qDebug() << "could not prefetch frame" << key.frame << "slice" << key.slice << "channel" << key.channel;
+    }
+}
+
+/*!
+ * \brief drops all cached images, e.g. because a different Project was loaded
+ */
+void ImageCache::clear()
+{
+    ++generation;
+    std::lock_guard<std::mutex> lock(mtx);
+    queued.clear();
+    cache.clear();
+    raws.clear();
+    displays.clear();
+    luts.clear();
+    ++contrastGeneration;
+}
+
+/*!
+ * \brief drops all pending prefetch requests and waits for the running one
+ */
+void ImageCache::waitForPrefetch()
+{
+    ++generation;
+    pool.clear();
+    pool.waitForDone();
+}
+}
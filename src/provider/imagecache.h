@@ -0,0 +1,124 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef IMAGECACHE_H
+#define IMAGECACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+
+#include "base/rawimage.h"
+#include "graphics/displaylut.h"
+
+namespace TraCurate {
+/*!
+ * \brief The ImageCache class
+ *
+ * Holds the images of the current Project as they are stored (RawImage),
+ * the images drawn from them with the contrast settings of their Channel in
+ * the format ImageProvider draws on, and the same images scaled to the size
+ * they are displayed at. Images can be prefetched in the background, so
+ * stepping through frames waits neither for the HDF5 file nor for scaling.
+ * Prefetched images are scaled to the size that was last requested.
+ *
+ * Changing the contrast of a Channel drops its drawn images, they are drawn
+ * again from the RawImage%s without reading the HDF5 file. Channels without
+ * contrast settings are shown as they are stored if they have 8 bits per
+ * sample, otherwise the window is chosen from the histogram of the first
+ * image that is drawn.
+ *
+ * Prefetching uses a single background thread. Its reads, the thumbnails of
+ * the ThumbnailCache and every other use of the HDF5 library in the process
+ * take turns on lockHDF5(), so they also wait for edits of the file and for
+ * the current step of a save (see yieldHDF5()). A new prefetch request
+ * replaces the ones that were not started yet.
+ *
+ * The size of the cache is set by graphics/image_cache_size (in MiB), the
+ * RawImage%s and the drawn images may each take up this much memory.
+ */
+class ImageCache
+{
+public:
+    static ImageCache *getInstance();
+
+    QImage get(QString const &path, int frame, int slice, int channel,
+               QSize const &size = QSize(), QSize *originalSize = nullptr);
+    bool contains(QString const &path, int frame, int slice, int channel, QSize const &size = QSize());
+    RawImage raw(QString const &path, int frame, int slice, int channel);
+    RawImage thumbnail(QString const &path, int frame, int slice, int channel, int maxSize);
+    QImage draw(int channel, RawImage const &raw);
+    DisplayLUT::Params display(int channel, RawImage const &raw);
+    void setDisplay(int channel, DisplayLUT::Params const &params);
+    void resetDisplay(int channel);
+    void prefetch(QString const &path, QList<int> const &frames, int slice, int channel);
+    void clear();
+    void waitForPrefetch();
+
+private:
+    ImageCache();
+
+    /* an invalid size denotes the original image */
+    struct Key {
+        QString path;
+        int frame, slice, channel;
+        QSize size;
+        bool operator==(Key const &o) const {
+            return frame == o.frame && slice == o.slice && channel == o.channel && size == o.size && path == o.path;
+        }
+        friend uint qHash(Key const &key, uint seed = 0) {
+            return qHash(key.path, seed) ^ qHash(key.frame, seed) ^ (qHash(key.slice, seed) << 8) ^ (qHash(key.channel, seed) << 16)
+                    ^ qHash(key.size.width() * 65536 + key.size.height(), seed);
+        }
+    };
+
+    struct Entry {
+        QImage image;
+        QSize originalSize;
+    };
+
+    RawImage decode(Key const &key);
+    bool lookup(Key const &key, Entry &entry);
+    void insert(Key const &key, Entry const &entry, int contrast);
+    std::shared_ptr<DisplayLUT const> lutFor(int channel, RawImage const &raw);
+    void dropDrawn(int channel);
+    Entry original(Key const &key);
+    void runPrefetch(Key key, int gen);
+
+    std::mutex mtx;         /*!< protects the caches, queued, displaySize and the contrast settings */
+    QCache<Key, Entry> cache;
+    QCache<Key, RawImage> raws;
+    QHash<int, DisplayLUT::Params> displays;            /*!< the contrast settings of each Channel */
+    QHash<int, std::shared_ptr<DisplayLUT const>> luts; /*!< built from displays when they are needed */
+    QSet<Key> queued;
+    QSize displaySize;
+    std::atomic<int> generation;
+    std::atomic<int> contrastGeneration;    /*!< changed with the contrast, so stale images are not inserted */
+    QThreadPool pool;
+};
+}
+
+#endif // IMAGECACHE_H
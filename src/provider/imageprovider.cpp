@@ -21,7 +21,6 @@
 #include "imageprovider.h"
 #include "graphics/base.h"
 #include "graphics/merge.h"
-#include "graphics/separate.h"
 #include "graphics/floodfill.h"
 #include "tracked/trackevent.h"
 #include "tracked/trackeventdead.hpp"
@@ -32,7 +31,10 @@
 #include "tracked/trackeventunmerge.hpp"
 #include "provider/tcsettings.h"
 #include "provider/dataprovider.h"
+#include "provider/guicontroller.h"
 #include "provider/guistate.h"
+#include "provider/imagecache.h"
+#include "provider/tracer.h"
 #include "version.h"
 
 #ifndef GIT_REVISION
@@ -320,7 +322,8 @@ inline void ImageProvider::drawPolygon(QPainter &painter, QPolygon &poly, QColor
  * \param frame the current Frame
  * \param scaleFactor the scaleFactor to use
  */
-void ImageProvider::drawOutlines(QImage &image, int frame, int slice, int channel, double scaleFactor, bool regular, bool separation, bool aggregation, bool deletion, bool flood) {
+void ImageProvider::drawOutlines(QImage &image, int frame, int slice, int channel, double scaleFactor, bool regular, bool separation, bool aggregation, bool deletion, bool flood, bool watershed, bool resegmentation) {
+    TC_TRACE_SCOPE("ImageProvider::drawOutlines");
     /* set up painting equipment */
     QPainter painter(&image);
     QPainter::RenderHints rh = 0;
@@ -348,19 +351,11 @@ void ImageProvider::drawOutlines(QImage &image, int frame, int slice, int channe
     QPointF start(gs->getStartX(), gs->getStartY());
     QPointF end(gs->getEndX(), gs->getEndY());
     if (separation) {
-        QLineF line(start, end);
-        /* find object to remove */
-        std::shared_ptr<Object> cuttee = Base::objectCutByLine(line);
-
-        if (cuttee) {
-            /* calculate new objects */
-            QLineF cutLine(start/scaleFactor, end/scaleFactor);
-            auto newOutlines = Separate::compute(*cuttee->getOutline(), cutLine);
-            if (!newOutlines.first.isEmpty() && !newOutlines.second.isEmpty()) {
-                addObjects.append(newOutlines.first);
-                addObjects.append(newOutlines.second);
-                allObjects.removeAll(cuttee);
-            }
+        /* the pieces of all objects cut by the polyline replace them */
+        QPolygonF path = Base::toPolyline(gs->getCutPath());
+        for (auto const &cut : Base::objectsCutByPolyline(path)) {
+            addObjects.append(cut.second);
+            allObjects.removeAll(cut.first);
         }
     }
 
@@ -418,15 +413,38 @@ void ImageProvider::drawOutlines(QImage &image, int frame, int slice, int channe
         addObjects.push_back(floodPoly);
     }
 
+    if (watershed) {
+        /* the pieces of the object at the first seed replace it */
+        auto split = Base::objectSplitBySeeds(Base::toPolyline(gs->getSeeds()));
+        if (split.second.size() >= 2) {
+            addObjects.append(split.second);
+            allObjects.removeAll(split.first);
+        }
+    }
+
+    if (resegmentation) {
+        /* the pending new outlines of a track replace the objects in this frame */
+        for (TrackResegmentation::Result const &r : GUIController::getInstance()->getResegmentation()) {
+            std::shared_ptr<Object> o = r.object;
+            if (static_cast<int>(o->getFrameId()) != frame || static_cast<int>(o->getSliceId()) != slice
+                    || static_cast<int>(o->getChannelId()) != channel)
+                continue;
+            addObjects.append(r.outline);
+            allObjects.removeAll(o);
+        }
+    }
+
     /* the transformation to apply to the points of the polygons */
     QTransform trans;
     trans = trans.scale(scaleFactor, scaleFactor);
 
     qreal opacity = TCSettings::value("drawing/cell_opacity").toReal();
     painter.setOpacity(opacity);
+    double tolerance = TCSettings::value("drawing/outline_tolerance").toDouble();
 
     for (std::shared_ptr<Object> &o : allObjects) {
-        QPolygon curr = trans.map(*o->getOutline()).toPolygon();
+        /* at low zoom, draw a simplified outline that differs at most tolerance pixels */
+        QPolygon curr = trans.map(*o->getOutlineForScale(scaleFactor, tolerance)).toPolygon();
 
         QPointF mousePos(gs->getMouseX(),
                          gs->getMouseY());
@@ -490,8 +508,12 @@ void ImageProvider::drawObjectInfo(QImage &image, int frame, int slice, int chan
     std::shared_ptr<Slice> s = f->getSlice(slice);
     std::shared_ptr<Channel> c = s->getChannel(channel);
     allObjects.append(c->getObjects().values());
+    FeatureTable const &features = c->getFeatures();
 
     for (std::shared_ptr<Object> &o : allObjects) {
+        /* labels are placed at the centroid, which lies inside most (also concave) objects */
+        QPointF center = o ? features.get(o->getId()).centroid * scaleFactor : QPointF();
+
         /* draw the trackid */
         std::string text = "";
         if (drawTrackletIDs && o && o->isInTracklet())
@@ -507,7 +529,7 @@ void ImageProvider::drawObjectInfo(QImage &image, int frame, int slice, int chan
             pen.setColor(col);
             painter.setPen(pen);
             painter.setOpacity(1);
-            painter.drawText(o->getBoundingBox()->center() * scaleFactor,QString(text.c_str()));
+            painter.drawText(center, QString(text.c_str()));
         }
 
         if (drawAnnotationInfo && o) {
@@ -515,13 +537,13 @@ void ImageProvider::drawObjectInfo(QImage &image, int frame, int slice, int chan
             QPointF imageDims(14, 21);
             QPointF spacing(2, 0);
             if (o->isAnnotated()) {
-                QPointF br = o->getBoundingBox()->center() * scaleFactor - spacing;
+                QPointF br = center - spacing;
                 QPointF tl = br - imageDims;
                 QRectF rect(tl,br);
                 painter.drawImage(rect, objectAnnotationImage);
             }
             if (t && t->isAnnotated()) {;
-                QPointF br = o->getBoundingBox()->center() * scaleFactor - spacing;
+                QPointF br = center - spacing;
                 if (o->isAnnotated()) br = br - QPointF(imageDims.x(), 0) - spacing;
                 QPointF tl = br - imageDims;
                 QRectF rect(tl,br);
@@ -566,22 +588,59 @@ QImage ImageProvider::defaultImage(QSize *size, const QSize &requestedSize = QSi
 
 void ImageProvider::drawCutLine(QImage &image) {
     GUIState *gs = GUIState::getInstance();
-    int startX, startY, endX, endY;
+    QPolygonF path = Base::toPolyline(gs->getCutPath());
+    /* while the polyline is drawn, it follows the mouse */
+    if (!gs->getDrawSeparation())
+        path.append(QPointF(gs->getMouseX(), gs->getMouseY()));
 
-    startX = gs->getStartX();
-    startY = gs->getStartY();
-    if (gs->getDrawSeparation()) {
-        endX = gs->getEndX();
-        endY = gs->getEndY();
-    } else {
-        endX = static_cast<int>(gs->getMouseX());
-        endY = static_cast<int>(gs->getMouseY());
-    }
+    double pr = DataProvider::getInstance()->getDevicePixelRatio();
+    for (QPointF &p : path)
+        p *= pr;
+    QPainter painter(&image);
+    painter.drawPolyline(path);
+}
 
+void ImageProvider::drawSeeds(QImage &image) {
+    QPolygonF seeds = Base::toPolyline(GUIState::getInstance()->getSeeds());
     double pr = DataProvider::getInstance()->getDevicePixelRatio();
-    QLine line(startX*pr, startY*pr, endX*pr, endY*pr);
     QPainter painter(&image);
-    painter.drawLine(line);
+    painter.setPen(QPen(Qt::red, 2 * pr));
+    for (QPointF const &p : seeds)
+        painter.drawEllipse(p * pr, 3 * pr, 3 * pr);
+}
+
+/*!
+ * \brief draws the pending links that start or end in a Frame
+ * \param image the Image to draw to
+ * \param frame the current Frame
+ * \param scaleFactor the scaleFactor to use
+ *
+ * A link is drawn from the centroid of the end of a track to the centroid of
+ * the start it is linked to, the current link in red. Links that skip Frame%s
+ * are dashed and labelled with the number of Frame%s.
+ */
+void ImageProvider::drawLinkProposals(QImage &image, int frame, int slice, int channel, double scaleFactor) {
+    QPainter painter(&image);
+    if (!painter.isActive())
+        return;
+
+    QList<TrackletLinker::Proposal> proposals = GUIController::getInstance()->getLinkProposals();
+    int current = GUIState::getInstance()->getCurrentLinkProposal();
+    for (int i = 0; i < proposals.size(); i++) {
+        TrackletLinker::Proposal const &p = proposals.at(i);
+        if ((static_cast<int>(p.source->getFrameId()) != frame && static_cast<int>(p.target->getFrameId()) != frame)
+                || static_cast<int>(p.source->getSliceId()) != slice || static_cast<int>(p.source->getChannelId()) != channel)
+            continue;
+
+        QPointF from = p.sourceCentroid * scaleFactor;
+        QPointF to = p.targetCentroid * scaleFactor;
+        QPen pen(i == current ? Qt::red : Qt::cyan, i == current ? 3 : 2, p.gap > 1 ? Qt::DashLine : Qt::SolidLine, Qt::RoundCap);
+        painter.setPen(pen);
+        painter.drawLine(from, to);
+        painter.drawEllipse(to, 3, 3);
+        if (p.gap > 1)
+            painter.drawText((from + to) / 2, QString("+%1").arg(p.gap));
+    }
 }
 
 /*!
@@ -593,6 +652,7 @@ void ImageProvider::drawCutLine(QImage &image) {
   */
 QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
+    TC_TRACE_SCOPE("ImageProvider::requestImage");
     Q_UNUSED(id);
     QImage newImage;
     GUIState *gs = GUIState::getInstance();
@@ -607,26 +667,15 @@ QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &
     if (path.isEmpty() || frame < 0 || frame > gs->getMaximumFrame())
         return defaultImage(size, requestedSize);
 
-    /* some caching, so we don't always re-request the image */
-    if (frame == cachedFrame && slice == cachedSlice && channel == cachedChannel && path == cachedPath) {
-        newImage = cachedImage;
-    } else {
-        QImage tmpImage = DataProvider::getInstance()->requestImage(path, frame, slice, channel);
-        /* Image may be imported in another format, so convert it to ARGB32 for drawing in color on it */
-        newImage = tmpImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
-        cachedImage = newImage;
-        cachedPath = path;
-        cachedFrame = frame;
-        cachedSlice = slice;
-        cachedChannel = channel;
-    }
-
+    /* the ImageCache avoids re-requesting the image and may already have prefetched it */
     if (!requestedSize.isValid())
-        return newImage;
+        return ImageCache::getInstance()->get(path, frame, slice, channel);
+
+    QSize originalSize;
+    newImage = ImageCache::getInstance()->get(path, frame, slice, channel, requestedSize, &originalSize);
 
     qreal devicePixelRatio = DataProvider::getInstance()->getDevicePixelRatio();
-    double oldWidth = newImage.width();
-    newImage = newImage.scaled(requestedSize,Qt::KeepAspectRatio);
+    double oldWidth = originalSize.width();
     double newWidth = newImage.width();
     double scaleFactor = newWidth/oldWidth;
 
@@ -641,13 +690,20 @@ QImage ImageProvider::requestImage(const QString &id, QSize *size, const QSize &
     bool drawingAggregation    = gs->getDrawAggregation();
     bool drawingDeletion       = gs->getDrawDeletion();
     bool drawingFlood          = gs->getDrawFlood();
+    bool drawingWatershed      = gs->getDrawWatershed();
+    bool drawingResegmentation = gs->getDrawResegmentation();
 
-    if (drawingOutlines || drawingAggregation || drawingSeparation)
-        drawOutlines(newImage, frame, slice, channel, scaleFactor, drawingOutlines, drawingSeparation, drawingAggregation, drawingDeletion, drawingFlood);
+    if (drawingOutlines || drawingAggregation || drawingSeparation || drawingWatershed || drawingResegmentation)
+        drawOutlines(newImage, frame, slice, channel, scaleFactor, drawingOutlines, drawingSeparation, drawingAggregation,
+                     drawingDeletion, drawingFlood, drawingWatershed, drawingResegmentation);
     if (drawingTrackletIDs || drawingAnnotationInfo)
         drawObjectInfo(newImage, frame, slice, channel, scaleFactor, drawingTrackletIDs, drawingAnnotationInfo);
     if (drawingCutLine)
         drawCutLine(newImage);
+    if (drawingWatershed)
+        drawSeeds(newImage);
+    if (gs->getDrawLinkProposals())
+        drawLinkProposals(newImage, frame, slice, channel, scaleFactor);
 
     size->setHeight(newImage.height());
     size->setWidth(newImage.width());
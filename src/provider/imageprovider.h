@@ -35,8 +35,9 @@ namespace TraCurate {
  * This includes getting them via ImportHDF5::requestImage() and then drawing the outlines
  * and Tracklet-Numbers of the cells over those images.
  *
- * It also implements a Caching-Mechanism to avoid re-requesting the image over and over
- * again when only the outlines should be drawn another way.
+ * The images themselves are cached (and prefetched) by the ImageCache, to avoid
+ * re-requesting the image over and over again when only the outlines should be drawn
+ * another way.
  */
 class ImageProvider : public QQuickImageProvider
 {
@@ -59,16 +60,12 @@ public:
     QImage defaultImage(QSize *size, const QSize &requestedSize);
 
     void drawPolygon(QPainter &painter, QPolygon &poly, QColor col, Qt::BrushStyle style);
-    void drawOutlines(QImage &image, int frame, int slice, int channel, double scaleFactor, bool regular, bool separation, bool aggregation, bool deletion, bool flood);
+    void drawOutlines(QImage &image, int frame, int slice, int channel, double scaleFactor, bool regular, bool separation, bool aggregation, bool deletion, bool flood, bool watershed, bool resegmentation);
     void drawObjectInfo(QImage &image, int frame, int slice, int channel, double scaleFactor, bool drawTrackletIDs, bool drawAnnotationInfo);
     void drawCutLine(QImage &image);
+    void drawSeeds(QImage &image);
+    void drawLinkProposals(QImage &image, int frame, int slice, int channel, double scaleFactor);
     QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
-private:
-    QImage cachedImage;
-    QString cachedPath = "";
-    int cachedFrame = -1;
-    int cachedSlice = -1;
-    int cachedChannel = -1;
 };
 }
 
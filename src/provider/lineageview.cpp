@@ -0,0 +1,268 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "lineageview.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+#include "provider/guistate.h"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+#include "tracked/genealogy.h"
+
+namespace TraCurate {
+
+LineageView::LineageView(QQuickItem *parent) :
+    QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+    selectedColor = TCSettings::value("drawing/selected_track").value<QColor>();
+
+    /* many changes are reported at once, lay out once they are done */
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(0);
+    connect(&refreshTimer, &QTimer::timeout, this, &LineageView::refresh);
+
+    GUIState *gs = GUIState::getInstance();
+    connect(gs, &GUIState::backingDataChanged, &refreshTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(gs, &GUIState::selectedTrackIDChanged, this, &LineageView::selectionChanged);
+    connect(MessageRelay::getInstance(), &MessageRelay::finishNotification, &refreshTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(this, &QQuickItem::visibleChanged, &refreshTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+}
+
+qreal LineageView::getContentX() const
+{
+    return contentX;
+}
+
+void LineageView::setContentX(qreal value)
+{
+    value = std::max(0.0, std::min(value, getContentWidth() - width()));
+    if (contentX != value) {
+        emit contentXChanged(contentX = value);
+        update();
+    }
+}
+
+qreal LineageView::getContentY() const
+{
+    return contentY;
+}
+
+void LineageView::setContentY(qreal value)
+{
+    value = std::max(0.0, std::min(value, getContentHeight() - height()));
+    if (contentY != value) {
+        emit contentYChanged(contentY = value);
+        update();
+    }
+}
+
+qreal LineageView::getFrameWidth() const
+{
+    return frameWidth;
+}
+
+void LineageView::setFrameWidth(qreal value)
+{
+    value = std::max(0.01, std::min(value, 100.0));
+    if (frameWidth != value) {
+        emit frameWidthChanged(frameWidth = value);
+        emit contentSizeChanged();
+        update();
+    }
+}
+
+qreal LineageView::getRowHeight() const
+{
+    return rowHeight;
+}
+
+void LineageView::setRowHeight(qreal value)
+{
+    value = std::max(0.05, std::min(value, 50.0));
+    if (rowHeight != value) {
+        emit rowHeightChanged(rowHeight = value);
+        emit contentSizeChanged();
+        update();
+    }
+}
+
+qreal LineageView::getContentWidth() const
+{
+    return (layout.getLastFrame() + 1) * frameWidth;
+}
+
+qreal LineageView::getContentHeight() const
+{
+    return layout.getRows() * rowHeight;
+}
+
+/*!
+ * \brief lays out the Tracklet%s that changed, or all of them if a different Project was loaded
+ *
+ * Nothing is laid out while the LineageView is not visible, it is refreshed when it is shown.
+ */
+void LineageView::refresh()
+{
+    if (!isVisible())
+        return;
+    TC_TRACE_SCOPE("LineageView::refresh");
+    std::shared_ptr<Project> proj = GUIState::getInstance()->getProj();
+    if (proj != project.lock()) {
+        layout.clear();
+        project = proj;
+    }
+    if (layout.update(proj ? proj->getGenealogy() : nullptr) == 0)
+        return;
+    emit contentSizeChanged();
+    setContentX(contentX);
+    setContentY(contentY);
+    update();
+}
+
+/*!
+ * \brief returns the Tracklet at a position
+ * \param x the x coordinate in the LineageView
+ * \param y the y coordinate in the LineageView
+ * \return the id of the Tracklet or -1 if there is none
+ */
+int LineageView::trackletAt(qreal x, qreal y) const
+{
+    LineageLayout::Node const *node = layout.nodeAt((x + contentX) / frameWidth - 0.5, (y + contentY) / rowHeight - 0.5);
+    return node ? node->id : -1;
+}
+
+/*!
+ * \brief returns the Frame at a position, limited to the Frame%s of a Tracklet
+ * \param x the x coordinate in the LineageView
+ * \param trackId the id of the Tracklet
+ * \return the Frame or -1 if there is no such Tracklet
+ */
+int LineageView::frameAt(qreal x, int trackId) const
+{
+    std::shared_ptr<Project> proj = project.lock();
+    if (!proj || !proj->getGenealogy())
+        return -1;
+    std::shared_ptr<Tracklet> t = proj->getGenealogy()->getTracklet(trackId);
+    if (!t || t->getContained().isEmpty())
+        return -1;
+    int frame = static_cast<int>((x + contentX) / frameWidth);
+    int start = static_cast<int>(t->getStart().first->getID());
+    int end = static_cast<int>(t->getEnd().first->getID());
+    return std::max(start, std::min(frame, end));
+}
+
+/*!
+ * \brief zooms so all lineage trees fit into the LineageView
+ */
+void LineageView::fit()
+{
+    if (layout.getRows() == 0 || width() <= 0 || height() <= 0)
+        return;
+    setFrameWidth(width() / (layout.getLastFrame() + 1));
+    setRowHeight(height() / layout.getRows());
+    setContentX(0);
+    setContentY(0);
+}
+
+void LineageView::geometryChanged(QRectF const &newGeometry, QRectF const &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    update();
+}
+
+void LineageView::selectionChanged(int id)
+{
+    selected = id;
+    selectedColor = TCSettings::value("drawing/selected_track").value<QColor>();
+    update();
+}
+
+/*!
+ * \brief creates the lines of the visible Tracklet%s and TrackEvent%s
+ *
+ * Called on the render thread while the GUI thread is blocked, so the layout
+ * can be read without locking.
+ */
+QSGNode *LineageView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    TC_TRACE_SCOPE("LineageView::updatePaintNode");
+    QSGGeometryNode *node = static_cast<QSGGeometryNode *>(oldNode);
+    if (!node) {
+        node = new QSGGeometryNode();
+        QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawLines);
+        geometry->setLineWidth(1);
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new QSGVertexColorMaterial());
+        node->setFlag(QSGNode::OwnsMaterial);
+    }
+
+    qreal firstFrame = contentX / frameWidth - 1;
+    qreal lastFrame = (contentX + width()) / frameWidth;
+    qreal firstRow = contentY / rowHeight - 1;
+    qreal lastRow = (contentY + height()) / rowHeight;
+
+    std::vector<QSGGeometry::ColoredPoint2D> vertices;
+    auto line = [&vertices](qreal x1, qreal y1, qreal x2, qreal y2, QColor const &c) {
+        QSGGeometry::ColoredPoint2D p;
+        p.set(static_cast<float>(x1), static_cast<float>(y1), c.red(), c.green(), c.blue(), c.alpha());
+        vertices.push_back(p);
+        p.set(static_cast<float>(x2), static_cast<float>(y2), c.red(), c.green(), c.blue(), c.alpha());
+        vertices.push_back(p);
+    };
+    QColor const barColor(Qt::black);
+    QColor const eventColor(Qt::gray);
+
+    for (LineageLayout::Tree const *tree : layout.treesIn(firstRow, lastRow)) {
+        if (tree->last < firstFrame || tree->first > lastFrame)
+            continue;
+        for (LineageLayout::Node const &n : tree->nodes) {
+            qreal row = tree->offset + n.row;
+            qreal y = (row + 0.5) * rowHeight - contentY;
+            if (row >= firstRow && row <= lastRow && n.end >= firstFrame && n.start <= lastFrame)
+                line(n.start * frameWidth - contentX, y, (n.end + 1) * frameWidth - contentX, y,
+                     n.id == selected ? selectedColor : barColor);
+
+            /* from the end of each previous Tracklet down to the start of this one */
+            for (int p : n.parents) {
+                LineageLayout::Node const &parent = tree->nodes[p];
+                qreal parentRow = tree->offset + parent.row;
+                if (std::max(row, parentRow) < firstRow || std::min(row, parentRow) > lastRow
+                        || n.start < firstFrame || parent.end > lastFrame)
+                    continue;
+                qreal x = (parent.end + 1) * frameWidth - contentX;
+                line(x, (parentRow + 0.5) * rowHeight - contentY, x, y, eventColor);
+                line(x, y, n.start * frameWidth - contentX, y, eventColor);
+            }
+        }
+    }
+
+    QSGGeometry *geometry = node->geometry();
+    geometry->allocate(static_cast<int>(vertices.size()));
+    std::copy(vertices.begin(), vertices.end(), geometry->vertexDataAsColoredPoint2D());
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
+}
@@ -0,0 +1,98 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINEAGEVIEW_H
+#define LINEAGEVIEW_H
+
+#include <memory>
+
+#include <QColor>
+#include <QQuickItem>
+#include <QTimer>
+
+#include "project.h"
+#include "tracked/lineagelayout.h"
+
+namespace TraCurate {
+/*!
+ * \brief The LineageView class
+ *
+ * Draws the lineage trees of the current Project as laid out by
+ * LineageLayout, with the Frame%s from left to right and one Tracklet per
+ * row. Only the Tree%s that intersect the visible area are turned into
+ * scene graph geometry, all of it in a single node, so projects with tens of
+ * thousands of Tracklet%s stay smooth while scrolling and zooming.
+ *
+ * The layout is updated when the backing data changes, at most once per
+ * event loop iteration, and only the changed Tree%s are laid out again.
+ */
+class LineageView : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal contentX READ getContentX WRITE setContentX NOTIFY contentXChanged)
+    Q_PROPERTY(qreal contentY READ getContentY WRITE setContentY NOTIFY contentYChanged)
+    Q_PROPERTY(qreal frameWidth READ getFrameWidth WRITE setFrameWidth NOTIFY frameWidthChanged)
+    Q_PROPERTY(qreal rowHeight READ getRowHeight WRITE setRowHeight NOTIFY rowHeightChanged)
+    Q_PROPERTY(qreal contentWidth READ getContentWidth NOTIFY contentSizeChanged)
+    Q_PROPERTY(qreal contentHeight READ getContentHeight NOTIFY contentSizeChanged)
+public:
+    explicit LineageView(QQuickItem *parent = nullptr);
+
+    qreal getContentX() const;
+    void setContentX(qreal value);
+    qreal getContentY() const;
+    void setContentY(qreal value);
+    qreal getFrameWidth() const;
+    void setFrameWidth(qreal value);
+    qreal getRowHeight() const;
+    void setRowHeight(qreal value);
+    qreal getContentWidth() const;
+    qreal getContentHeight() const;
+
+    Q_INVOKABLE void refresh();
+    Q_INVOKABLE int trackletAt(qreal x, qreal y) const;
+    Q_INVOKABLE int frameAt(qreal x, int trackId) const;
+    Q_INVOKABLE void fit();
+
+signals:
+    void contentXChanged(qreal);
+    void contentYChanged(qreal);
+    void frameWidthChanged(qreal);
+    void rowHeightChanged(qreal);
+    void contentSizeChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *);
+    void geometryChanged(QRectF const &newGeometry, QRectF const &oldGeometry);
+
+private slots:
+    void selectionChanged(int id);
+
+private:
+    LineageLayout layout;
+    std::weak_ptr<Project> project;     /*!< the Project that was laid out */
+    QTimer refreshTimer;
+    qreal contentX = 0;
+    qreal contentY = 0;
+    qreal frameWidth = 4;
+    qreal rowHeight = 6;
+    int selected = -1;                  /*!< the id of the selected Tracklet */
+    QColor selectedColor;
+};
+}
+
+#endif // LINEAGEVIEW_H
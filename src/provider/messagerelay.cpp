@@ -17,9 +17,28 @@
  */
 #include "messagerelay.h"
 
+#include <algorithm>
+#include <chrono>
+
+#include "provider/tcsettings.h"
+
 namespace TraCurate {
 MessageRelay *MessageRelay::instance = nullptr;
 
+/*!
+ * \brief constructor for MessageRelay
+ *
+ * This constructor is private, please use MessageRelay::getInstance to obtain an instance of MessageRelay
+ */
+MessageRelay::MessageRelay() :
+    interval(std::max(TCSettings::value("status/progress_interval").toLongLong(), 0LL) * 1000000),
+    detailCurr(0),
+    detailMax(0),
+    phaseStart(now()),
+    lastReport(0)
+{
+}
+
 /*!
  * \brief returns an instance of the MessageRelay
  * \return an instance of the MessageRelay
@@ -44,4 +63,71 @@ QObject *MessageRelay::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *script
 
     return getInstance();
 }
+
+qint64 MessageRelay::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MessageRelay::startPhase()
+{
+    detailCurr = 0;
+    phaseStart = now();
+    lastReport = 0;
+}
+
+/*!
+ * \brief updates the detailed name in the status window and starts a new phase
+ * \param text the new detailed name
+ */
+void MessageRelay::emitUpdateDetailName(QString text)
+{
+    MessageRelay *mr = getInstance();
+    mr->startPhase();
+    mr->updateDetailName(text);
+}
+
+/*!
+ * \brief updates the detailed maximum value and starts a new phase
+ * \param newMax the new detailed maximum
+ */
+void MessageRelay::emitUpdateDetailMax(int newMax)
+{
+    MessageRelay *mr = getInstance();
+    mr->detailMax = newMax;
+    mr->startPhase();
+    mr->updateDetailMax(newMax);
+}
+
+/*!
+ * \brief increases the detailed counter
+ *
+ * Can be called from multiple threads at once. Only emits detailProgress if
+ * the last report is older than status/progress_interval or the maximum was
+ * reached.
+ */
+void MessageRelay::emitIncreaseDetail()
+{
+    MessageRelay *mr = getInstance();
+    int curr = ++mr->detailCurr;
+    qint64 time = now();
+    qint64 last = mr->lastReport;
+    if (curr != mr->detailMax) {
+        /* only the thread that wins the exchange reports */
+        if (time - last < mr->interval || !mr->lastReport.compare_exchange_strong(last, time))
+            return;
+    } else {
+        mr->lastReport = time;
+    }
+    mr->reportDetail(curr, time);
+}
+
+void MessageRelay::reportDetail(int curr, qint64 time)
+{
+    int max = detailMax;
+    double secs = static_cast<double>(time - phaseStart) / 1e9;
+    double perSecond = (secs > 0) ? curr / secs : 0;
+    double eta = (perSecond > 0 && max >= curr) ? (max - curr) / perSecond : -1;
+    emit detailProgress(curr, max, perSecond, eta);
+}
 }
@@ -18,6 +18,8 @@
 #ifndef MESSAGERELAY_H
 #define MESSAGERELAY_H
 
+#include <atomic>
+
 #include <QObject>
 #include <QQmlEngine>
 #include <QJSEngine>
@@ -28,6 +30,13 @@ namespace TraCurate {
  *
  * The MessageRelay is used to relay Messages from C++-Classes to QML-Code without
  * them needing to implement QObject.
+ *
+ * The detailed counter is increased once per item from the worker threads, so
+ * it is kept in an atomic counter and detailProgress is emitted at most once
+ * every status/progress_interval milliseconds (and when the maximum is reached).
+ * Along with the counter it reports the throughput and the estimated remaining
+ * time of the current phase, which starts with emitUpdateDetailName or
+ * emitUpdateDetailMax.
  */
 class MessageRelay : public QObject
 {
@@ -40,7 +49,7 @@ signals:
 
     void updateDetailName(QString text);
     void updateDetailMax(int newMax);
-    void increaseDetail();
+    void detailProgress(int curr, int max, double perSecond, double etaSeconds);
 
     void finishNotification();
 
@@ -65,20 +74,9 @@ public:
      */
     static void emitIncreaseOverall() { MessageRelay::getInstance()->increaseOverall(); }
 
-    /*!
-     * \brief updates the detailed name in the status window
-     * \param text the new detailed name
-     */
-    static void emitUpdateDetailName(QString text) { MessageRelay::getInstance()->updateDetailName(text); }
-    /*!
-     * \brief updates the detailed maximum value
-     * \param newMax the new detailed maximum
-     */
-    static void emitUpdateDetailMax(int newMax) { MessageRelay::getInstance()->updateDetailMax(newMax); }
-    /*!
-     * \brief increases the detailed counter
-     */
-    static void emitIncreaseDetail() { MessageRelay::getInstance()->increaseDetail(); }
+    static void emitUpdateDetailName(QString text);
+    static void emitUpdateDetailMax(int newMax);
+    static void emitIncreaseDetail();
 
     /*!
      * \brief emits a finish notification
@@ -92,9 +90,19 @@ public:
     static void emitUpdateStatusBar(QString message) { MessageRelay::getInstance()->updateStatusBar(message); }
 
 private:
-    MessageRelay() = default;
+    MessageRelay();
 
     static MessageRelay *instance;
+
+    static qint64 now();
+    void startPhase();
+    void reportDetail(int curr, qint64 time);
+
+    qint64 interval;                    /*!< minimal time between two detailProgress signals (in ns) */
+    std::atomic<int> detailCurr;
+    std::atomic<int> detailMax;
+    std::atomic<qint64> phaseStart;     /*!< start of the current phase (in ns) */
+    std::atomic<qint64> lastReport;     /*!< time of the last detailProgress signal (in ns) */
 };
 }
 
@@ -90,6 +90,9 @@ void TCSettings::setDefaults(){
     setDefault("drawing/default_linewidth", "number", 2, true,
                "Default Linewidth",
                "Linewidth used for drawing Cells that are not selected");
+    setDefault("drawing/outline_tolerance", "number", 0.5, true,
+               "Outline Tolerance",
+               "How many pixels a drawn outline may deviate from the original one, larger values draw faster when zoomed out");
     setDefault("text/default_fontsize", "number", 12, true,
                "Default Font Size",
                "Default Font Size");
@@ -114,6 +117,45 @@ void TCSettings::setDefaults(){
     setDefault("graphics/max_pixelmask_percentage", "percent", 0.25, true,
                "Maximum Pixelmask Percentage",
                "The maximum area (relative to image) a pixelmask may fill when using FloodFill");
+    setDefault("graphics/image_cache_size", "number", 512, true,
+               "Image Cache Size",
+               "Memory in MiB used for caching and prefetching images");
+    setDefault("graphics/prefetch_frames", "number", 30, true,
+               "Prefetched Frames",
+               "How many frames of the selected AutoTracklet are read ahead in the background");
+    setDefault("graphics/thumbnail_size", "number", 64, true,
+               "Thumbnail Size",
+               "Longest side in pixels of the thumbnails shown along the frame slider, 0 disables them");
+    setDefault("autosave/enabled", "bool", true, true,
+               "Autosave",
+               "Periodically write changes to a journal next to the HDF5 file, which is replayed after a crash");
+    setDefault("autosave/interval", "number", 30, true,
+               "Autosave Interval",
+               "Seconds between two writes to the autosave journal");
+    setDefault("undo/depth", "number", 100, true,
+               "Undo Steps",
+               "How many segmentation and tracking edits can be undone");
+    setDefault("undo/memory", "number", 64, true,
+               "Undo Memory",
+               "Memory in MiB the edits that can be undone may take up, older edits are dropped first");
+    setDefault("status/progress_interval", "number", 100, true,
+               "Progress Interval",
+               "Minimal time in milliseconds between two updates of the progress in the status window");
+    setDefault("export/object_links", "bool", true, true,
+               "Write Object Links",
+               "Besides the membership table, write one link per Object of a Tracklet, for tools that do not read the table");
+    setDefault("hdf5/swmr", "bool", false, true,
+               "SWMR Compatible Files",
+               "Write HDF5 files in the latest format, so analysis jobs can read them in SWMR mode while they are curated. Needs HDF5 1.10, the files can then not be opened with HDF5 1.8");
+    setDefault("linking/max_distance", "number", 30, true,
+               "Linking Distance",
+               "Largest distance in pixels between the centroids of two Objects in consecutive frames that the linking assistant proposes to link");
+    setDefault("linking/max_gap", "number", 3, true,
+               "Linking Gap",
+               "Largest number of frames between the end of a track and the start of the track the linking assistant proposes to link to it");
+    setDefault("linking/area_weight", "number", 1.0, true,
+               "Linking Area Weight",
+               "How much a change of the area of an Object makes the linking assistant avoid a link, relative to the distance");
     instance->sync();
 }
 
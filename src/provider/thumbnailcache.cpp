@@ -0,0 +1,320 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "thumbnailcache.h"
+
+#include <cstring>
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+
+#include "base/movie.h"
+#include "base/rawimage.h"
+#include "provider/guistate.h"
+#include "provider/imagecache.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+namespace {
+quint32 const thumbsMagic = 0x54435431; /* "TCT1" */
+quint32 const thumbsVersion = 1;
+int const thumbsPerUpdate = 32;         /* thumbnails read before they are written and shown */
+}
+
+ThumbnailCache *ThumbnailCache::theInstance = nullptr;
+
+/*!
+ * \brief constructor for ThumbnailCache
+ *
+ * This constructor is private, please use ThumbnailCache::getInstance to
+ * obtain an instance of ThumbnailCache.
+ */
+ThumbnailCache::ThumbnailCache(QObject *parent) :
+    QObject(parent),
+    generation(0),
+    revision(0)
+{
+    pool.setMaxThreadCount(1);
+    GUIState *gs = GUIState::getInstance();
+    connect(gs, &GUIState::currentSliceChanged, this, &ThumbnailCache::generate);
+    connect(gs, &GUIState::currentChannelChanged, this, &ThumbnailCache::generate);
+}
+
+/*!
+ * \brief returns an instance of the ThumbnailCache
+ * \return an instance of the ThumbnailCache
+ */
+ThumbnailCache *ThumbnailCache::getInstance()
+{
+    if (!theInstance)
+        theInstance = new ThumbnailCache();
+    return theInstance;
+}
+
+/*!
+ * \brief provides an instance of ThumbnailCache for use in QML
+ * \param engine (unused)
+ * \param scriptEngine (unused)
+ * \return a pointer to the instance of ThumbnailCache
+ */
+QObject *ThumbnailCache::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine) {
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+
+    return getInstance();
+}
+
+/*!
+ * \brief returns the name of the thumbnail cache belonging to a HDF5 file
+ * \param fileName the name of the HDF5 file
+ * \return the name of the thumbnail cache
+ */
+QString ThumbnailCache::cacheFileName(QString const &fileName)
+{
+    return fileName + ".thumbs";
+}
+
+/*!
+ * \brief switches to the thumbnails of a Project and starts reading the missing ones
+ * \param proj the Project, which was just loaded
+ * \param source the HDF5 file as it is passed to the ImageCache
+ */
+void ThumbnailCache::open(std::shared_ptr<Project> const &proj, QString const &source)
+{
+    waitForDone();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        path = (proj && !proj->getFileName().isEmpty()) ? cacheFileName(proj->getFileName()) : QString();
+        this->source = source;
+        frames = (proj && proj->getMovie()) ? proj->getMovie()->getFrames().size() : 0;
+        maxSize = std::max(TCSettings::value("graphics/thumbnail_size").toInt(), 0);
+        thumbs.clear();
+        pending.clear();
+    }
+    load();
+    emit revisionChanged(++revision);
+    generate();
+}
+
+/* reads the cache file, needs no generation to be running */
+void ThumbnailCache::load()
+{
+    TC_TRACE_SCOPE("ThumbnailCache::load");
+    std::lock_guard<std::mutex> lock(mtx);
+    if (path.isEmpty() || maxSize <= 0 || !QFile::exists(path))
+        return;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "could not open the thumbnail cache" << path;
+        return;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0, size = 0, count = 0;
+    in >> magic >> version >> size >> count;
+    if (in.status() != QDataStream::Ok || magic != thumbsMagic || version != thumbsVersion
+            || size != static_cast<quint32>(maxSize) || count != static_cast<quint32>(frames)) {
+        /* the header is written again with the first thumbnails */
+        file.resize(0);
+        return;
+    }
+
+    qint64 good = file.pos();
+    while (!in.atEnd()) {
+        Key key;
+        Thumb thumb;
+        in >> key.frame >> key.slice >> key.channel >> thumb.width >> thumb.height >> thumb.samples >> thumb.bitDepth;
+        if (in.status() != QDataStream::Ok || (thumb.samples != 1 && thumb.samples != 3) || (thumb.bitDepth != 8 && thumb.bitDepth != 16))
+            break;
+        int bytes = thumb.width * thumb.height * thumb.samples * (thumb.bitDepth / 8);
+        thumb.data.resize(bytes);
+        if (in.readRawData(thumb.data.data(), bytes) != bytes)
+            break;
+        thumbs.insert(key, thumb);
+        good = file.pos();
+    }
+    /* drop a record that was not completely written, so new records follow the last complete one */
+    if (good < file.size())
+        file.resize(good);
+}
+
+/*!
+ * \brief encodes a thumbnail as it is stored in the cache file
+ * \param key the Frame, Slice and Channel of the thumbnail
+ * \param thumb the thumbnail
+ * \return the record
+ */
+QByteArray ThumbnailCache::encode(Key const &key, Thumb const &thumb)
+{
+    QByteArray ret;
+    QDataStream out(&ret, QIODevice::WriteOnly);
+    out << key.frame << key.slice << key.channel << thumb.width << thumb.height << thumb.samples << thumb.bitDepth;
+    out.writeRawData(thumb.data.constData(), thumb.data.size());
+    return ret;
+}
+
+/*!
+ * \brief returns the frames in the order their thumbnails are read
+ * \param frames the number of frames
+ * \return every 64th frame, then the remaining ones of every 32nd frame and so on
+ */
+QList<int> ThumbnailCache::coarseToFine(int frames)
+{
+    QList<int> ret;
+    QVector<char> seen(frames, false);
+    for (int step = 64; step >= 1; step /= 2) {
+        for (int f = 0; f < frames; f += step) {
+            if (!seen[f]) {
+                seen[f] = true;
+                ret.append(f);
+            }
+        }
+    }
+    return ret;
+}
+
+/*!
+ * \brief starts reading the missing thumbnails of the current Slice and Channel
+ *
+ * A generation that is still running for another Slice or Channel is stopped.
+ */
+void ThumbnailCache::generate()
+{
+    GUIState *gs = GUIState::getInstance();
+    int gen = ++generation;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (source.isEmpty() || maxSize <= 0 || frames <= 0)
+        return;
+    QtConcurrent::run(&pool, this, &ThumbnailCache::run, source, gs->getCurrentSlice(), gs->getCurrentChannel(), gen);
+}
+
+void ThumbnailCache::run(QString source, int slice, int channel, int gen)
+{
+    TC_TRACE_SCOPE("ThumbnailCache::run");
+    int size, count;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        size = maxSize;
+        count = frames;
+    }
+
+    int added = 0;
+    for (int frame : coarseToFine(count)) {
+        if (gen != generation)
+            break;
+        Key key{static_cast<quint32>(frame), static_cast<quint32>(slice), static_cast<quint32>(channel)};
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (thumbs.contains(key))
+                continue;
+        }
+
+        RawImage raw;
+        try {
+            raw = ImageCache::getInstance()->thumbnail(source, frame, slice, channel, size);
+        } catch (...) {
+            qDebug() << "could not read the thumbnail of frame" << frame << "slice" << slice << "channel" << channel;
+            continue;
+        }
+        if (raw.isNull())
+            continue;
+
+        Thumb thumb{static_cast<quint16>(raw.width()), static_cast<quint16>(raw.height()),
+                    static_cast<quint8>(raw.samples()), static_cast<quint8>(raw.bitDepth()),
+                    QByteArray(reinterpret_cast<char const *>(raw.constBits()), raw.byteCount())};
+        QByteArray record = encode(key, thumb);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (gen != generation)
+                break;
+            thumbs.insert(key, thumb);
+            pending.append(record);
+        }
+        if (++added % thumbsPerUpdate == 0) {
+            writePending();
+            emit revisionChanged(++revision);
+        }
+    }
+    if (added % thumbsPerUpdate != 0) {
+        writePending();
+        emit revisionChanged(++revision);
+    }
+}
+
+/* appends the pending records to the cache file, writing the header first if it is empty */
+void ThumbnailCache::writePending()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (path.isEmpty() || pending.isEmpty())
+        return;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "could not write the thumbnail cache" << path;
+        pending.clear();
+        return;
+    }
+    if (file.size() == 0) {
+        QDataStream out(&file);
+        out << thumbsMagic << thumbsVersion << static_cast<quint32>(maxSize) << static_cast<quint32>(frames);
+    }
+    file.write(pending);
+    pending.clear();
+}
+
+/*!
+ * \brief returns the thumbnail of an image, drawn with the contrast settings of its Channel
+ * \param frame the frame of the image
+ * \param slice the slice of the image
+ * \param channel the channel of the image
+ * \return the thumbnail or a null image if it was not read yet
+ */
+QImage ThumbnailCache::get(int frame, int slice, int channel)
+{
+    Thumb thumb;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = thumbs.constFind({static_cast<quint32>(frame), static_cast<quint32>(slice), static_cast<quint32>(channel)});
+        if (it == thumbs.constEnd())
+            return QImage();
+        thumb = it.value();
+    }
+    RawImage raw(thumb.width, thumb.height, thumb.samples, thumb.bitDepth);
+    memcpy(raw.bits(), thumb.data.constData(), static_cast<size_t>(thumb.data.size()));
+    raw.computeHistogram();
+    return ImageCache::getInstance()->draw(channel, raw);
+}
+
+int ThumbnailCache::getRevision() const
+{
+    return revision;
+}
+
+/*!
+ * \brief stops reading thumbnails and waits for the running read
+ */
+void ThumbnailCache::waitForDone()
+{
+    ++generation;
+    pool.clear();
+    pool.waitForDone();
+}
+}
@@ -0,0 +1,121 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QJSEngine>
+#include <QObject>
+#include <QQmlEngine>
+#include <QString>
+#include <QThreadPool>
+
+#include "project.h"
+
+namespace TraCurate {
+/*!
+ * \brief The ThumbnailCache class
+ *
+ * Holds a small version of every image of the current Slice and Channel, so
+ * the timeline below the frame slider can show the whole movie and dragging
+ * the slider can show where it is without reading full images.
+ *
+ * The thumbnails are read in the background, the HDF5 library only reads
+ * every n-th row and column of each image (see ImportHDF5::requestRawThumbnail).
+ * Frames are read coarse to fine (every 64th frame, then every 32nd, …), so the
+ * timeline is filled evenly while the thumbnails are read. Like the images in
+ * the ImageCache, the thumbnails keep their samples as they are stored and are
+ * drawn with the contrast settings of their Channel when they are requested.
+ *
+ * Thumbnails are kept in a cache file next to the HDF5 file
+ * (\<file\>.thumbs), so they are read only once. The file starts with a
+ * header holding the size of the thumbnails and the number of frames, it is
+ * discarded if either changed. A record that was not completely written is
+ * dropped when the file is opened again.
+ *
+ * The size of the thumbnails is set by graphics/thumbnail_size, 0 disables
+ * them.
+ */
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int revision READ getRevision NOTIFY revisionChanged)
+public:
+    static ThumbnailCache *getInstance();
+    static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
+    static QString cacheFileName(QString const &fileName);
+
+    void open(std::shared_ptr<Project> const &proj, QString const &source);
+    QImage get(int frame, int slice, int channel);
+    int getRevision() const;
+    void waitForDone();
+
+public slots:
+    void generate();
+
+signals:
+    void revisionChanged(int);
+
+private:
+    explicit ThumbnailCache(QObject *parent = nullptr);
+    static ThumbnailCache *theInstance;
+
+    struct Key {
+        quint32 frame, slice, channel;
+        bool operator==(Key const &o) const {
+            return frame == o.frame && slice == o.slice && channel == o.channel;
+        }
+        friend uint qHash(Key const &key, uint seed = 0) {
+            return qHashBits(&key, sizeof(key), seed);
+        }
+    };
+
+    /* the samples of a thumbnail as they are stored, without the histogram of a RawImage */
+    struct Thumb {
+        quint16 width, height;
+        quint8 samples, bitDepth;
+        QByteArray data;
+    };
+
+    static QList<int> coarseToFine(int frames);
+    static QByteArray encode(Key const &key, Thumb const &thumb);
+    void load();
+    void run(QString source, int slice, int channel, int gen);
+    void writePending();
+
+    std::mutex mtx;                 /*!< protects all members below */
+    QString path;                   /*!< file name of the cache file, empty if none */
+    QString source;                 /*!< the HDF5 file as it is passed to the ImageCache */
+    int frames = 0;
+    int maxSize = 0;
+    QHash<Key, Thumb> thumbs;
+    QByteArray pending;             /*!< encoded records, not yet written */
+    std::atomic<int> generation;    /*!< changed to stop the running generation */
+    std::atomic<int> revision;      /*!< changed when thumbnails were added */
+    QThreadPool pool;
+};
+}
+
+#endif // THUMBNAILCACHE_H
@@ -0,0 +1,54 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "thumbnailprovider.h"
+
+#include "provider/guistate.h"
+#include "provider/thumbnailcache.h"
+#include "provider/tracer.h"
+
+namespace TraCurate {
+
+ThumbnailProvider::ThumbnailProvider() :
+    QQuickImageProvider(QQuickImageProvider::Image) {}
+
+/*!
+ * \brief returns the thumbnail of a frame of the current Slice and Channel
+ * \param id the frame, followed by a slash and anything else
+ * \param size receives the size of the returned image
+ * \param requestedSize if valid, the thumbnail is scaled to fit into this size
+ * \return the thumbnail or a transparent image if it was not read yet
+ */
+QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    TC_TRACE_SCOPE("ThumbnailProvider::requestImage");
+    GUIState *gs = GUIState::getInstance();
+    int frame = id.section('/', 0, 0).toInt();
+    QImage ret = ThumbnailCache::getInstance()->get(frame, gs->getCurrentSlice(), gs->getCurrentChannel());
+    bool scale = requestedSize.width() > 0 && requestedSize.height() > 0;
+
+    if (ret.isNull()) {
+        ret = QImage(scale ? requestedSize : QSize(1, 1), QImage::Format_ARGB32_Premultiplied);
+        ret.fill(Qt::transparent);
+    } else if (scale) {
+        ret = ret.scaled(requestedSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    if (size)
+        *size = ret.size();
+    return ret;
+}
+}
@@ -0,0 +1,47 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef THUMBNAILPROVIDER_H
+#define THUMBNAILPROVIDER_H
+
+#include <QImage>
+#include <QQuickImageProvider>
+#include <QSize>
+#include <QString>
+
+namespace TraCurate {
+/*!
+ * \brief The ThumbnailProvider class
+ *
+ * This QQuickImageProvider returns the thumbnails of the ThumbnailCache for
+ * the timeline of the frame slider. The id is the frame, optionally followed
+ * by a slash and anything else (e.g. the revision of the ThumbnailCache, so
+ * QML requests the thumbnail again when it was read). Thumbnails that were
+ * not read yet are returned as transparent images, so requests never wait
+ * for the HDF5 file.
+ */
+class ThumbnailProvider : public QQuickImageProvider
+{
+public:
+    explicit ThumbnailProvider();
+    ~ThumbnailProvider() = default;
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize);
+};
+}
+
+#endif // THUMBNAILPROVIDER_H
@@ -24,6 +24,7 @@
 
 #include "guistate.h"
 #include "io/hdf5_aux.h"
+#include "io/journal.h"
 #include "provider/tcsettings.h"
 
 namespace TraCurate {
@@ -60,6 +61,9 @@ void TimeTracker::run() {
     GUIState *gs = GUIState::getInstance();
 
     while (!this->isInterruptionRequested()) {
+        /* the autosave journal is written here to keep disk access off the GUI thread */
+        Journal::getInstance()->flush();
+
         QString date = QDate::currentDate().toString(Qt::ISODate);
         QString path = gs->getProjPath();
         if (path.compare("") != 0 && TCSettings::value("time_tracking/track").toBool()) {
@@ -0,0 +1,322 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "tracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <unordered_set>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariantMap>
+
+namespace TraCurate {
+namespace {
+std::chrono::steady_clock::time_point const epoch = std::chrono::steady_clock::now();
+std::atomic<uint64_t> nextTid(1);
+}
+
+constexpr size_t Tracer::ringSize;
+
+/*!
+ * \brief constructor for Tracer
+ *
+ * This constructor is private, please use Tracer::getInstance to obtain an instance of Tracer
+ */
+Tracer::Tracer(QObject *parent) : QObject(parent) {}
+
+/*!
+ * \brief returns an instance of the Tracer
+ * \return an instance of the Tracer
+ *
+ * Unlike the other providers the Tracer is used from worker threads, so the
+ * instance is created in a thread-safe way.
+ */
+Tracer *Tracer::getInstance()
+{
+    static Tracer *instance = new Tracer();
+    return instance;
+}
+
+/*!
+ * \brief provides an instance of Tracer for use in QML
+ * \param engine (unused)
+ * \param scriptEngine (unused)
+ * \return a pointer to the instance of Tracer
+ */
+QObject *Tracer::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine) {
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+
+    return getInstance();
+}
+
+/*!
+ * \brief returns the current time
+ * \return the time in ns since the start of the program
+ */
+int64_t Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/*!
+ * \brief returns a pointer to a permanent copy of name
+ * \param name the name to intern
+ * \return a pointer that stays valid for the lifetime of the program
+ *
+ * Events only store a pointer to their name, so names that are built at
+ * runtime (e.g. the names of import phases) have to be interned first.
+ */
+const char *Tracer::intern(QString const &name)
+{
+    static std::mutex mtx;
+    static std::unordered_set<std::string> names;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    return names.insert(name.toStdString()).first->c_str();
+}
+
+Tracer::Scope::Scope(const char *name_) :
+    name(name_),
+    start(Tracer::now()) {}
+
+Tracer::Scope::~Scope()
+{
+    Tracer::getInstance()->complete(name, start, Tracer::now() - start);
+}
+
+/*!
+ * \brief records a complete event
+ * \param name the name of the event
+ * \param start the start time as returned by Tracer::now
+ * \param dur the duration in ns
+ */
+void Tracer::complete(const char *name, int64_t start, int64_t dur)
+{
+    record({name, start, dur, 0, 'X'});
+}
+
+/*!
+ * \brief records a counter event
+ * \param name the name of the counter
+ * \param value the current value of the counter
+ */
+void Tracer::counter(const char *name, int64_t value)
+{
+    record({name, now(), 0, value, 'C'});
+}
+
+/*!
+ * \brief returns the ring buffer of the calling thread, creating it if necessary
+ * \return the ring buffer
+ *
+ * Worker threads come and go (QThreadPool retires idle threads), so the buffer
+ * of an exited thread is reused by the next new thread instead of allocating
+ * another one. The buffer keeps its events and its thread id, the two threads
+ * never ran at the same time.
+ */
+Tracer::Buffer *Tracer::threadBuffer()
+{
+    thread_local BufferHolder holder;
+    if (holder.buf)
+        return holder.buf;
+
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    if (!freeBuffers.empty()) {
+        holder.buf = freeBuffers.back();
+        freeBuffers.pop_back();
+        return holder.buf;
+    }
+
+    std::shared_ptr<Buffer> b = std::make_shared<Buffer>();
+    b->events.resize(ringSize);
+    b->tid = nextTid++;
+    buffers.push_back(b);
+    holder.buf = b.get();
+    return holder.buf;
+}
+
+Tracer::BufferHolder::~BufferHolder()
+{
+    if (!buf)
+        return;
+
+    Tracer *tracer = Tracer::getInstance();
+    std::lock_guard<std::mutex> lock(tracer->buffersMtx);
+    tracer->freeBuffers.push_back(buf);
+}
+
+void Tracer::record(Event const &ev)
+{
+    Buffer *buf = threadBuffer();
+
+    /* only contended while the buffers are read for a dump or the statistics */
+    std::lock_guard<std::mutex> lock(buf->mtx);
+    buf->events[buf->next] = ev;
+    if (++buf->next == buf->events.size()) {
+        buf->next = 0;
+        buf->wrapped = true;
+    }
+}
+
+/*!
+ * \brief copies the events of all ring buffers
+ * \param tids if not nullptr, receives the thread id for each returned event
+ * \return the events, oldest first per thread
+ */
+std::vector<Tracer::Event> Tracer::snapshot(std::vector<uint64_t> *tids)
+{
+    std::vector<Event> ret;
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    for (std::shared_ptr<Buffer> &b : buffers) {
+        std::lock_guard<std::mutex> bufLock(b->mtx);
+        if (b->wrapped)
+            ret.insert(ret.end(), b->events.begin() + static_cast<long>(b->next), b->events.end());
+        ret.insert(ret.end(), b->events.begin(), b->events.begin() + static_cast<long>(b->next));
+        if (tids)
+            tids->resize(ret.size(), b->tid);
+    }
+    return ret;
+}
+
+/*!
+ * \brief tells whether tracing was enabled at compile time
+ * \return true if TraCurate was built with TC_TRACING
+ */
+bool Tracer::isEnabled() const
+{
+#ifdef TC_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief writes all recorded events in the Chrome trace-event format
+ * \param fileName the file to write to (may be a file://-URL)
+ * \return true, if the file could be written, false otherwise
+ */
+bool Tracer::dumpChromeTrace(QString fileName)
+{
+    if (fileName.startsWith("file://"))
+        fileName.remove(0, 7);
+
+    std::vector<uint64_t> tids;
+    std::vector<Event> events = snapshot(&tids);
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    for (size_t i = 0; i < events.size(); i++) {
+        Event const &ev = events[i];
+        QJsonObject obj;
+        obj.insert("name", QString(ev.name));
+        obj.insert("ph", QString(ev.phase));
+        obj.insert("ts", ev.ts / 1000.0);
+        obj.insert("pid", pid);
+        obj.insert("tid", static_cast<qint64>(tids[i]));
+        if (ev.phase == 'X')
+            obj.insert("dur", ev.dur / 1000.0);
+        else
+            obj.insert("args", QJsonObject{{"value", static_cast<qint64>(ev.value)}});
+        traceEvents.append(obj);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    QJsonObject root{{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+    return file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+/*!
+ * \brief summarizes the recorded events per name
+ * \param windowMs the window in ms over which the recent rate is calculated
+ * \return a list of maps with name, count, meanMs, maxMs, recentMeanMs, perSecond and value
+ */
+QVariantList Tracer::getStats(int windowMs)
+{
+    struct Stat {
+        uint64_t count = 0;
+        int64_t total = 0;
+        int64_t max = 0;
+        uint64_t recentCount = 0;
+        int64_t recentTotal = 0;
+        int64_t value = 0;
+        bool isCounter = false;
+    };
+
+    int64_t window = static_cast<int64_t>(std::max(windowMs, 1)) * 1000000;
+    int64_t since = now() - window;
+
+    std::map<std::string, Stat> stats;
+    for (Event const &ev : snapshot()) {
+        Stat &s = stats[ev.name];
+        s.count++;
+        if (ev.phase == 'C') {
+            s.isCounter = true;
+            s.value = ev.value;
+            if (ev.ts >= since)
+                s.recentCount++;
+            continue;
+        }
+        s.total += ev.dur;
+        s.max = std::max(s.max, ev.dur);
+        if (ev.ts + ev.dur >= since) {
+            s.recentCount++;
+            s.recentTotal += ev.dur;
+        }
+    }
+
+    QVariantList ret;
+    for (auto &p : stats) {
+        Stat const &s = p.second;
+        QVariantMap m;
+        m["name"] = QString::fromStdString(p.first);
+        m["counter"] = s.isCounter;
+        m["count"] = static_cast<qulonglong>(s.count);
+        m["meanMs"] = s.count ? s.total / 1e6 / s.count : 0.0;
+        m["maxMs"] = s.max / 1e6;
+        m["recentMeanMs"] = s.recentCount ? s.recentTotal / 1e6 / s.recentCount : 0.0;
+        m["perSecond"] = s.recentCount * 1e9 / window;
+        m["value"] = static_cast<qlonglong>(s.value);
+        ret.push_back(m);
+    }
+    return ret;
+}
+
+/*!
+ * \brief drops all recorded events
+ */
+void Tracer::clear()
+{
+    std::lock_guard<std::mutex> lock(buffersMtx);
+    for (std::shared_ptr<Buffer> &b : buffers) {
+        std::lock_guard<std::mutex> bufLock(b->mtx);
+        b->next = 0;
+        b->wrapped = false;
+    }
+}
+}
@@ -0,0 +1,128 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <QObject>
+#include <QQmlEngine>
+#include <QJSEngine>
+#include <QString>
+#include <QVariantList>
+
+namespace TraCurate {
+/*!
+ * \brief The Tracer class
+ *
+ * Collects timing- and counter-events from the hot paths of TraCurate. Every
+ * thread records into its own ring buffer, so recording never contends with
+ * other threads and only the most recent events are kept. The collected
+ * events can be written as Chrome trace-event JSON (to be opened in
+ * chrome://tracing or Perfetto) or summarized for the configuration view.
+ *
+ * Use the macros TC_TRACE_SCOPE and TC_TRACE_COUNTER for instrumentation.
+ * They only expand to code if TC_TRACING is defined (qmake CONFIG+=tracing),
+ * otherwise the Tracer stays empty and costs nothing.
+ */
+class Tracer : public QObject
+{
+    Q_OBJECT
+public:
+    /*!
+     * \brief A single recorded event
+     */
+    struct Event {
+        const char *name;   /*!< interned or static name of the event */
+        int64_t ts;         /*!< start time in ns since the Tracer was created */
+        int64_t dur;        /*!< duration in ns (only for complete events) */
+        int64_t value;      /*!< value (only for counter events) */
+        char phase;         /*!< 'X' for complete events, 'C' for counters */
+    };
+
+    /*!
+     * \brief RAII-helper that records a complete event for its lifetime
+     */
+    class Scope {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+        Scope(Scope const &) = delete;
+        Scope &operator=(Scope const &) = delete;
+    private:
+        const char *name;
+        int64_t start;
+    };
+
+    static Tracer *getInstance();
+    static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
+
+    static int64_t now();
+    static const char *intern(QString const &name);
+
+    void complete(const char *name, int64_t start, int64_t dur);
+    void counter(const char *name, int64_t value);
+
+    Q_INVOKABLE bool isEnabled() const;
+    Q_INVOKABLE bool dumpChromeTrace(QString fileName);
+    Q_INVOKABLE QVariantList getStats(int windowMs = 5000);
+    Q_INVOKABLE void clear();
+
+private:
+    explicit Tracer(QObject *parent = nullptr);
+
+    static constexpr size_t ringSize = 1 << 15;
+
+    struct Buffer {
+        std::mutex mtx;
+        std::vector<Event> events;
+        size_t next = 0;
+        bool wrapped = false;
+        uint64_t tid = 0;
+    };
+
+    /*! \brief hands the ring buffer of a thread back to the Tracer when the thread exits */
+    struct BufferHolder {
+        Buffer *buf = nullptr;
+        ~BufferHolder();
+    };
+
+    void record(Event const &ev);
+    Buffer *threadBuffer();
+    std::vector<Event> snapshot(std::vector<uint64_t> *tids = nullptr);
+
+    std::mutex buffersMtx;
+    std::vector<std::shared_ptr<Buffer>> buffers;
+    std::vector<Buffer *> freeBuffers;
+};
+}
+
+#ifdef TC_TRACING
+# define TC_TRACE_CONCAT_(a, b) a##b
+# define TC_TRACE_CONCAT(a, b) TC_TRACE_CONCAT_(a, b)
+# define TC_TRACE_SCOPE(name) TraCurate::Tracer::Scope TC_TRACE_CONCAT(tcTraceScope, __LINE__)(name)
+# define TC_TRACE_COUNTER(name, value) TraCurate::Tracer::getInstance()->counter((name), static_cast<int64_t>(value))
+#else
+# define TC_TRACE_SCOPE(name)
+# define TC_TRACE_COUNTER(name, value)
+#endif
+
+#endif // TRACER_H
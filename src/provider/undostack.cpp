@@ -0,0 +1,629 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "undostack.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QPolygonF>
+
+#include "base/channel.h"
+#include "base/frame.h"
+#include "base/movie.h"
+#include "base/slice.h"
+#include "io/journal.h"
+#include "io/modifyhdf5.h"
+#include "provider/guistate.h"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+#include "tracked/genealogy.h"
+#include "tracked/trackeventdivision.hpp"
+#include "tracked/trackeventmerge.hpp"
+#include "tracked/trackeventunmerge.hpp"
+
+namespace TraCurate {
+namespace {
+/* milliseconds after the last undo or redo before the HDF5 file is written */
+int const writeDelay = 2000;
+
+std::shared_ptr<Channel> channelOf(std::shared_ptr<Project> const &proj, std::shared_ptr<Object> const &o)
+{
+    std::shared_ptr<Frame> frame = proj->getMovie()->getFrame(o->getFrameId());
+    std::shared_ptr<Slice> slice = frame ? frame->getSlice(o->getSliceId()) : nullptr;
+    return slice ? slice->getChannel(o->getChannelId()) : nullptr;
+}
+}
+
+UndoStack *UndoStack::theInstance = nullptr;
+
+/*!
+ * \brief constructor for UndoStack
+ *
+ * This constructor is private, please use UndoStack::getInstance to obtain an
+ * instance of UndoStack. The instance should be created on the GUI thread, as
+ * the HDF5 file is written from a timer.
+ */
+UndoStack::UndoStack(QObject *parent) : QObject(parent)
+{
+    writeTimer.setSingleShot(true);
+    connect(&writeTimer, &QTimer::timeout, this, &UndoStack::flush);
+}
+
+/*!
+ * \brief returns an instance of the UndoStack
+ * \return an instance of the UndoStack
+ */
+UndoStack *UndoStack::getInstance()
+{
+    if (!theInstance)
+        theInstance = new UndoStack();
+    return theInstance;
+}
+
+/*!
+ * \brief provides an instance of UndoStack for use in QML
+ * \param engine (unused)
+ * \param scriptEngine (unused)
+ * \return a pointer to the instance of UndoStack
+ */
+QObject *UndoStack::qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine) {
+    Q_UNUSED(engine);
+    Q_UNUSED(scriptEngine);
+
+    return getInstance();
+}
+
+/*!
+ * \brief returns the Tracklet%s of Object%s
+ * \param proj the Project
+ * \param objects the Object%s
+ * \return the Tracklet%s the Object%s are in, each only once
+ */
+QList<std::shared_ptr<Tracklet>> UndoStack::trackletsOf(std::shared_ptr<Project> const &proj, QList<std::shared_ptr<Object>> const &objects)
+{
+    QList<std::shared_ptr<Tracklet>> ret;
+    std::shared_ptr<Genealogy> gen = proj ? proj->getGenealogy() : nullptr;
+    if (!gen)
+        return ret;
+    for (std::shared_ptr<Object> const &o : objects) {
+        std::shared_ptr<Tracklet> t = (o && o->isInTracklet()) ? gen->getTracklet(static_cast<int>(o->getTrackId())) : nullptr;
+        if (t && !ret.contains(t))
+            ret.append(t);
+    }
+    return ret;
+}
+
+/*!
+ * \brief returns the Tracklet%s whose records change if the TrackEvent%s of a Tracklet change
+ * \param t the Tracklet
+ * \return the Tracklet%s before and after t and the other Tracklet%s merging with it
+ */
+QList<std::shared_ptr<Tracklet>> UndoStack::neighbours(std::shared_ptr<Tracklet> const &t)
+{
+    QList<std::shared_ptr<Tracklet>> ret;
+    auto add = [&ret](std::weak_ptr<Tracklet> const &w) {
+        std::shared_ptr<Tracklet> n = w.lock();
+        if (n)
+            ret.append(n);
+    };
+
+    std::shared_ptr<TrackEvent<Tracklet>> next = t->getNext();
+    if (next) {
+        switch (next->getType()) {
+        case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+            for (std::weak_ptr<Tracklet> const &n : *std::static_pointer_cast<TrackEventDivision<Tracklet>>(next)->getNext())
+                add(n);
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+            for (std::weak_ptr<Tracklet> const &n : *std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(next)->getNext())
+                add(n);
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_MERGE: {
+            std::shared_ptr<TrackEventMerge<Tracklet>> tem = std::static_pointer_cast<TrackEventMerge<Tracklet>>(next);
+            add(tem->getNext());
+            for (std::weak_ptr<Tracklet> const &p : *tem->getPrev())
+                add(p);
+            break; }
+        default:
+            break;
+        }
+    }
+
+    std::shared_ptr<TrackEvent<Tracklet>> prev = t->getPrev();
+    if (prev) {
+        switch (prev->getType()) {
+        case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+            add(std::static_pointer_cast<TrackEventDivision<Tracklet>>(prev)->getPrev());
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+            add(std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(prev)->getPrev());
+            break;
+        case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:
+            for (std::weak_ptr<Tracklet> const &p : *std::static_pointer_cast<TrackEventMerge<Tracklet>>(prev)->getPrev())
+                add(p);
+            break;
+        default:
+            break;
+        }
+    }
+    return ret;
+}
+
+/*!
+ * \brief returns the current Project, dropping the history if it belongs to another one
+ * \param proj receives the current Project
+ * \return true, if there is a current Project with a Genealogy
+ */
+bool UndoStack::currentProject(std::shared_ptr<Project> &proj)
+{
+    proj = GUIState::getInstance()->getProj();
+    if (proj != project.lock()) {
+        /* the pending writes belong to a Project that is no longer open */
+        pendingRemovals.clear();
+        pendingInsertions.clear();
+        commands.clear();
+        position = 0;
+        memory = 0;
+        project = proj;
+        emit changed();
+    }
+    return proj && proj->getGenealogy() && proj->getMovie();
+}
+
+/*!
+ * \brief starts recording an edit
+ * \param text the description of the edit, e.g. for the menu
+ * \param tracklets the Tracklet%s the edit may change, besides the ones it creates
+ *
+ * \return false, if the pending changes of undo() and redo() could not be written
+ *
+ * Has to be called before the edit changes the Project or the HDF5 file, the
+ * pending changes of undo() and redo() are written first. The edit is recorded
+ * in any case, but if they could not be written, an edit that changes the
+ * Object%s in the HDF5 file must not go ahead and has to commit() right away.
+ */
+bool UndoStack::begin(QString const &text, QList<std::shared_ptr<Tracklet>> const &tracklets)
+{
+    TC_TRACE_SCOPE("UndoStack::begin");
+    if (recording)
+        qDebug() << "edit" << current.text << "was not committed";
+    bool written = flush();
+
+    recording = false;
+    current = Command();
+    scope.clear();
+    known.clear();
+
+    std::shared_ptr<Project> proj;
+    if (!currentProject(proj))
+        return written;
+
+    current.text = text;
+    for (std::shared_ptr<Tracklet> const &t : tracklets) {
+        if (!t)
+            continue;
+        QList<std::shared_ptr<Tracklet>> ts = neighbours(t);
+        ts.prepend(t);
+        for (std::shared_ptr<Tracklet> const &n : ts)
+            if (!scope.contains(n->getId()))
+                scope.insert(n->getId(), Journal::trackletRecord(n));
+    }
+    for (int id : proj->getGenealogy()->getTracklets()->keys())
+        known.insert(id);
+    recording = true;
+    return written;
+}
+
+/*!
+ * \brief records that the current edit replaced Object%s
+ * \param removed the Object%s that were removed
+ * \param added the Object%s that were added
+ *
+ * The Annotation%s of the removed Object%s are noted right away, so it has to
+ * be called before the edit moves them to the added Object%s. The Annotation%s
+ * of the added Object%s are noted by commit().
+ */
+void UndoStack::replaced(QList<std::shared_ptr<Object>> const &removed, QList<std::shared_ptr<Object>> const &added)
+{
+    if (!recording)
+        return;
+    for (std::shared_ptr<Object> const &o : removed)
+        if (o->isAnnotated())
+            current.annotations.insert(o.get(), *o->getAnnotations());
+    current.removed.append(removed);
+    current.added.append(added);
+}
+
+/*!
+ * \brief finishes recording an edit and adds it to the history
+ *
+ * An edit that did not change anything is dropped. Edits that were undone
+ * can no longer be redone.
+ */
+void UndoStack::commit()
+{
+    TC_TRACE_SCOPE("UndoStack::commit");
+    if (!recording)
+        return;
+    recording = false;
+
+    std::shared_ptr<Project> proj;
+    if (!currentProject(proj))
+        return;
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+
+    for (auto it = scope.cbegin(); it != scope.cend(); ++it) {
+        std::shared_ptr<Tracklet> t = gen->getTracklet(it.key());
+        QByteArray rec = t ? Journal::trackletRecord(t) : Journal::trackletRemovedRecord(it.key());
+        if (rec == it.value())
+            continue;
+        /* edits may change the contents of a Tracklet directly, so tell the Journal */
+        if (t)
+            gen->changed(t);
+        current.before.append(it.value());
+        current.after.append(rec);
+    }
+    for (std::shared_ptr<Tracklet> const &t : *gen->getTracklets()) {
+        if (known.contains(t->getId()))
+            continue;
+        gen->changed(t);
+        current.before.append(Journal::trackletRemovedRecord(t->getId()));
+        current.after.append(Journal::trackletRecord(t));
+    }
+    scope.clear();
+    known.clear();
+
+    for (std::shared_ptr<Object> const &o : current.added)
+        if (o->isAnnotated())
+            current.annotations.insert(o.get(), *o->getAnnotations());
+
+    if (current.before.isEmpty() && current.removed.isEmpty() && current.added.isEmpty())
+        return;
+
+    while (commands.size() > position)
+        memory -= commands.takeLast().cost;
+    current.cost = costOf(current);
+    memory += current.cost;
+    commands.append(current);
+    position = commands.size();
+    current = Command();
+    trim();
+    emit changed();
+}
+
+/*!
+ * \brief returns the approximate memory use of an edit
+ * \param c the edit
+ * \return the size in bytes
+ */
+qint64 UndoStack::costOf(Command const &c)
+{
+    qint64 cost = sizeof(Command) + c.text.size() * sizeof(QChar) + c.before.size() + c.after.size()
+            + c.annotations.size() * sizeof(std::shared_ptr<Annotation>);
+    for (QList<std::shared_ptr<Object>> const *list : {&c.removed, &c.added})
+        for (std::shared_ptr<Object> const &o : *list)
+            cost += sizeof(Object) + (o->getOutline() ? o->getOutline()->size() * sizeof(QPointF) : 0);
+    return cost;
+}
+
+/*!
+ * \brief drops the oldest edits until the history fits into undo/depth and undo/memory
+ *
+ * The edit that was just made is always kept.
+ */
+void UndoStack::trim()
+{
+    int depth = std::max(TCSettings::value("undo/depth").toInt(), 0);
+    qint64 limit = qint64(std::max(TCSettings::value("undo/memory").toInt(), 0)) * 1024 * 1024;
+    while (commands.size() > depth || (memory > limit && commands.size() > 1)) {
+        if (position > 0) {
+            memory -= commands.takeFirst().cost;
+            position--;
+        } else {
+            memory -= commands.takeLast().cost;
+        }
+    }
+}
+
+/*!
+ * \brief changes the Project from the state before an edit to the state after it or back
+ * \param proj the Project
+ * \param c the edit
+ * \param forward if true, the edit is redone, otherwise it is undone
+ */
+void UndoStack::apply(std::shared_ptr<Project> const &proj, Command const &c, bool forward)
+{
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    QList<std::shared_ptr<Object>> const &out = forward ? c.removed : c.added;
+    QList<std::shared_ptr<Object>> const &in = forward ? c.added : c.removed;
+
+    for (std::shared_ptr<Object> const &o : out) {
+        std::shared_ptr<Channel> chan = channelOf(proj, o);
+        if (!chan || chan->getObject(o->getId()) != o)
+            continue;
+        uint32_t trackId = o->getTrackId();
+        std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+        if (at && at->getComponents().value(static_cast<int>(o->getFrameId())) == o)
+            at->removeComponent(static_cast<int>(o->getFrameId()));
+        std::shared_ptr<Tracklet> t = o->isInTracklet() ? gen->getTracklet(static_cast<int>(trackId)) : nullptr;
+        if (t) {
+            t->removeFromContained(o->getFrameId(), o->getId());
+            gen->changed(t);
+        }
+        chan->removeObject(o->getId());
+        /* an Object that is not in the Project must not be listed as annotated */
+        for (std::shared_ptr<Annotation> const &a : c.annotations.value(o.get()))
+            gen->unannotate(o, a);
+
+        queueRemoval(o, trackId);
+    }
+
+    for (std::shared_ptr<Object> const &o : in) {
+        std::shared_ptr<Channel> chan = channelOf(proj, o);
+        if (!chan || chan->getObject(o->getId()))
+            continue;
+        chan->addObject(o);
+        for (std::shared_ptr<Annotation> const &a : c.annotations.value(o.get()))
+            gen->annotate(o, a);
+        std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+        if (at)
+            at->addComponent(proj->getMovie()->getFrame(o->getFrameId()), o);
+        queueInsertion(o);
+    }
+
+    /* the Objects have to be in their Channels before the Tracklets refer to them */
+    Journal::applyTrackletRecords(proj, forward ? c.after : c.before);
+
+    if ((!pendingRemovals.isEmpty() || !pendingInsertions.isEmpty()) && saving == 0)
+        writeTimer.start(writeDelay);
+}
+
+/*!
+ * \brief notes that an Object has to be removed from the HDF5 file
+ * \param o the Object
+ * \param trackId the Tracklet it was in when it was removed
+ *
+ * An Object that was waiting to be inserted is not written at all.
+ */
+void UndoStack::queueRemoval(std::shared_ptr<Object> const &o, uint32_t trackId)
+{
+    if (!pendingInsertions.removeOne(o))
+        pendingRemovals.append(PendingRemoval{o, trackId});
+}
+
+/*!
+ * \brief notes that an Object has to be inserted into the HDF5 file
+ * \param o the Object
+ *
+ * An Object that was waiting to be removed is not written at all.
+ */
+void UndoStack::queueInsertion(std::shared_ptr<Object> const &o)
+{
+    auto it = std::find_if(pendingRemovals.begin(), pendingRemovals.end(),
+                           [&o](PendingRemoval const &p) { return p.object == o; });
+    if (it != pendingRemovals.end())
+        pendingRemovals.erase(it);
+    else
+        pendingInsertions.append(o);
+}
+
+/*!
+ * \brief writes the Object%s an edit replaced to the HDF5 file of the current Project
+ * \param replacements the replaced Object%s, the old ones still have to be in their Tracklet%s
+ * \return true, if they were written or are written when the Project has been saved
+ *
+ * While the Project is saved, the Object%s are only noted and written with the
+ * undone changes by saveFinished().
+ */
+bool UndoStack::write(QList<ModifyHDF5::Replacement> const &replacements)
+{
+    std::shared_ptr<Project> proj;
+    if (!currentProject(proj))
+        return false;
+    if (saving == 0)
+        return ModifyHDF5::replaceObjects(proj->getFileName(), replacements);
+
+    for (ModifyHDF5::Replacement const &r : replacements) {
+        for (std::shared_ptr<Object> const &o : r.oldObjects)
+            queueRemoval(o, o->getTrackId());
+        for (std::shared_ptr<Object> const &o : r.newObjects)
+            queueInsertion(o);
+    }
+    return true;
+}
+
+/*!
+ * \brief writes the Object%s an edit replaced to the HDF5 file of the current Project
+ * \param removed the Object%s that are removed, they still have to be in their Tracklet%s
+ * \param added the Object%s that are added
+ * \return true, if they were written or are written when the Project has been saved
+ */
+bool UndoStack::write(QList<std::shared_ptr<Object>> const &removed, QList<std::shared_ptr<Object>> const &added)
+{
+    return write(QList<ModifyHDF5::Replacement>{ModifyHDF5::Replacement{removed, added}});
+}
+
+/*!
+ * \brief notes that a snapshot of the Project is saved in the background
+ *
+ * Has to be called after the pending changes were written and the snapshot
+ * was taken. Until saveFinished() is called, nothing is written to the HDF5
+ * file.
+ */
+void UndoStack::saveStarted()
+{
+    saving++;
+    writeTimer.stop();
+}
+
+/*!
+ * \brief notes that a save has finished and writes what was changed in the meantime
+ *
+ * Has to be called after the file name of the Project was changed to the file
+ * it was saved to, so the changes made during a "save as" end up in the new
+ * file.
+ */
+void UndoStack::saveFinished()
+{
+    if (saving > 0)
+        saving--;
+    if (saving == 0)
+        flush();
+}
+
+/*!
+ * \brief tells whether a save is running
+ * \return true, if the Project is being saved
+ */
+bool UndoStack::isSaving() const
+{
+    return saving > 0;
+}
+
+/*!
+ * \brief undoes the last edit
+ * \return true, if an edit was undone
+ */
+bool UndoStack::undo()
+{
+    TC_TRACE_SCOPE("UndoStack::undo");
+    std::shared_ptr<Project> proj;
+    if (recording || !currentProject(proj) || position == 0)
+        return false;
+
+    Command const &c = commands.at(--position);
+    apply(proj, c, false);
+    MessageRelay::emitUpdateStatusBar(QString("Undid: %1").arg(c.text));
+    emit changed();
+    return true;
+}
+
+/*!
+ * \brief redoes the last edit that was undone
+ * \return true, if an edit was redone
+ */
+bool UndoStack::redo()
+{
+    TC_TRACE_SCOPE("UndoStack::redo");
+    std::shared_ptr<Project> proj;
+    if (recording || !currentProject(proj) || position == commands.size())
+        return false;
+
+    Command const &c = commands.at(position++);
+    apply(proj, c, true);
+    MessageRelay::emitUpdateStatusBar(QString("Redid: %1").arg(c.text));
+    emit changed();
+    return true;
+}
+
+/*!
+ * \brief writes the Object%s that were removed and put back by undo() and redo() to the HDF5 file
+ * \return true, if nothing is left to be written or the changes wait for a save to finish
+ *
+ * All changes are written at once, opening the file only once. Changes that
+ * could not be written are kept and tried again a few seconds later.
+ */
+bool UndoStack::flush()
+{
+    writeTimer.stop();
+    if ((pendingRemovals.isEmpty() && pendingInsertions.isEmpty()) || saving > 0)
+        return true;
+
+    TC_TRACE_SCOPE("UndoStack::flush");
+    std::shared_ptr<Project> proj;
+    if (!currentProject(proj))
+        return pendingRemovals.isEmpty() && pendingInsertions.isEmpty();
+
+    /* ModifyHDF5 removes an Object from the Tracklet it is in, use the one it was in when it was removed */
+    QList<std::shared_ptr<Object>> removals;
+    QList<uint32_t> trackIds;
+    QSet<QString> paths;
+    for (PendingRemoval const &p : pendingRemovals) {
+        removals.append(p.object);
+        trackIds.append(p.object->getTrackId());
+        p.object->setTrackId(p.trackId);
+        paths.insert(QString("%1/%2/%3/%4").arg(p.object->getFrameId()).arg(p.object->getSliceId())
+                     .arg(p.object->getChannelId()).arg(p.object->getId()));
+    }
+
+    /* an Object may take the id of one that is removed, which has to be gone first */
+    bool reused = std::any_of(pendingInsertions.cbegin(), pendingInsertions.cend(), [&paths](std::shared_ptr<Object> const &o) {
+        return paths.contains(QString("%1/%2/%3/%4").arg(o->getFrameId()).arg(o->getSliceId())
+                              .arg(o->getChannelId()).arg(o->getId()));
+    });
+    bool removed = false, inserted = false;
+    if (reused) {
+        /* the removals are kept apart, so a failed insertion does not write them again */
+        removed = ModifyHDF5::replaceObjects(proj->getFileName(), removals, {});
+        inserted = removed && ModifyHDF5::replaceObjects(proj->getFileName(), {}, pendingInsertions);
+    } else {
+        removed = inserted = ModifyHDF5::replaceObjects(proj->getFileName(), removals, pendingInsertions);
+    }
+
+    for (int i = 0; i < removals.size(); i++)
+        removals.at(i)->setTrackId(trackIds.at(i));
+
+    if (removed)
+        pendingRemovals.clear();
+    if (inserted)
+        pendingInsertions.clear();
+    if (removed && inserted)
+        return true;
+
+    MessageRelay::emitUpdateStatusBar("Could not write the undone changes to the HDF5 file, trying again");
+    writeTimer.start(writeDelay);
+    return false;
+}
+
+/*!
+ * \brief writes the pending changes and drops the history, e.g. because another Project is opened
+ */
+void UndoStack::clear()
+{
+    flush();
+    recording = false;
+    current = Command();
+    scope.clear();
+    known.clear();
+    commands.clear();
+    position = 0;
+    memory = 0;
+    emit changed();
+}
+
+bool UndoStack::getCanUndo() const
+{
+    return position > 0;
+}
+
+bool UndoStack::getCanRedo() const
+{
+    return position < commands.size();
+}
+
+QString UndoStack::getUndoText() const
+{
+    return position > 0 ? commands.at(position - 1).text : QString();
+}
+
+QString UndoStack::getRedoText() const
+{
+    return position < commands.size() ? commands.at(position).text : QString();
+}
+}
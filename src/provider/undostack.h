@@ -0,0 +1,154 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include <memory>
+
+#include <QByteArray>
+#include <QHash>
+#include <QJSEngine>
+#include <QList>
+#include <QObject>
+#include <QQmlEngine>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+#include "project.h"
+#include "base/object.h"
+#include "io/modifyhdf5.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+/*!
+ * \brief The UndoStack class
+ *
+ * Keeps the segmentation and tracking edits of the GUIController, so they can
+ * be undone and redone. An edit is recorded between begin() and commit() and
+ * stored as a compact diff:
+ *  - the Object%s it removed and added, which hold their ids and outlines
+ *  - the Annotation%s of these Object%s, which are taken off an Object while
+ *    it is not in the Project and put on it again when it comes back
+ *  - the records (see Journal::trackletRecord) of the Tracklet%s it changed,
+ *    before and after the edit
+ *
+ * Only the Tracklet%s passed to begin(), the Tracklet%s linked to them by a
+ * TrackEvent and the Tracklet%s created by the edit are compared, so recording
+ * an edit does not depend on the size of the Project.
+ *
+ * Undoing and redoing changes the Project in memory right away. The HDF5 file
+ * is changed later in one batch by flush(), Object%s that are removed and put
+ * back again before that are not written at all. flush() is called a few
+ * seconds after the last undo or redo, before a new edit, before the Project
+ * is saved and when TraCurate quits. Changes that could not be written are
+ * kept and written again later, until then edits of Object%s and saving are
+ * refused.
+ *
+ * Edits write the Object%s they replace through write(). While the Project is
+ * saved in the background (between saveStarted() and saveFinished()), these
+ * writes and flush() wait with the undone changes, so the saved file does not
+ * change under the exporter. They are written when the save has finished, to
+ * the file the Project was saved to.
+ *
+ * The history holds at most undo/depth edits and about undo/memory MiB, the
+ * oldest edits are dropped first.
+ */
+class UndoStack : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool canUndo READ getCanUndo NOTIFY changed)
+    Q_PROPERTY(bool canRedo READ getCanRedo NOTIFY changed)
+    Q_PROPERTY(QString undoText READ getUndoText NOTIFY changed)
+    Q_PROPERTY(QString redoText READ getRedoText NOTIFY changed)
+public:
+    static UndoStack *getInstance();
+    static QObject *qmlInstanceProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
+    static QList<std::shared_ptr<Tracklet>> trackletsOf(std::shared_ptr<Project> const &proj, QList<std::shared_ptr<Object>> const &objects);
+
+    bool begin(QString const &text, QList<std::shared_ptr<Tracklet>> const &tracklets);
+    void replaced(QList<std::shared_ptr<Object>> const &removed, QList<std::shared_ptr<Object>> const &added);
+    void commit();
+    bool write(QList<ModifyHDF5::Replacement> const &replacements);
+    bool write(QList<std::shared_ptr<Object>> const &removed, QList<std::shared_ptr<Object>> const &added);
+
+    void saveStarted();
+    void saveFinished();
+    bool isSaving() const;
+
+    bool undo();
+    bool redo();
+    void clear();
+
+    bool getCanUndo() const;
+    bool getCanRedo() const;
+    QString getUndoText() const;
+    QString getRedoText() const;
+
+public slots:
+    bool flush();
+
+signals:
+    void changed();
+
+private:
+    explicit UndoStack(QObject *parent = nullptr);
+    static UndoStack *theInstance;
+
+    struct Command {
+        QString text;
+        QList<std::shared_ptr<Object>> removed;
+        QList<std::shared_ptr<Object>> added;
+        QHash<Object*, QList<std::shared_ptr<Annotation>>> annotations; /*!< the Annotation%s of the removed and added Object%s */
+        QByteArray before;      /*!< records of the changed Tracklet%s before the edit */
+        QByteArray after;       /*!< records of the changed Tracklet%s after the edit */
+        qint64 cost = 0;        /*!< approximate memory use in bytes */
+    };
+
+    /* an Object that still has to be removed from the HDF5 file */
+    struct PendingRemoval {
+        std::shared_ptr<Object> object;
+        uint32_t trackId;       /*!< the Tracklet it was in when it was removed */
+    };
+
+    static qint64 costOf(Command const &c);
+    static QList<std::shared_ptr<Tracklet>> neighbours(std::shared_ptr<Tracklet> const &t);
+    bool currentProject(std::shared_ptr<Project> &proj);
+    void apply(std::shared_ptr<Project> const &proj, Command const &c, bool forward);
+    void queueRemoval(std::shared_ptr<Object> const &o, uint32_t trackId);
+    void queueInsertion(std::shared_ptr<Object> const &o);
+    void trim();
+
+    QTimer writeTimer;
+    std::weak_ptr<Project> project;         /*!< the Project the history belongs to */
+    QList<Command> commands;                /*!< the oldest edit first */
+    int position = 0;                       /*!< the edits before it can be undone, the others redone */
+    qint64 memory = 0;                      /*!< the sum of the costs of commands */
+
+    bool recording = false;
+    Command current;                        /*!< the edit between begin() and commit() */
+    QHash<int, QByteArray> scope;           /*!< records of the Tracklet%s the current edit may change */
+    QSet<int> known;                        /*!< ids of the Tracklet%s before the current edit */
+
+    QList<PendingRemoval> pendingRemovals;
+    QList<std::shared_ptr<Object>> pendingInsertions;
+    int saving = 0;                         /*!< the number of saves that have not finished */
+};
+}
+
+#endif // UNDOSTACK_H
@@ -42,6 +42,9 @@ std::shared_ptr<QList<std::shared_ptr<Annotation> > > Annotateable::getAnnotatio
 void Annotateable::setAnnotations(const std::shared_ptr<QList<std::shared_ptr<Annotation> > > &value)
 {
     annotations = value;
+    annotationSet.clear();
+    for (std::shared_ptr<Annotation> const &a : *annotations)
+        annotationSet.insert(a.get());
 }
 
 /*!
@@ -50,9 +53,10 @@ void Annotateable::setAnnotations(const std::shared_ptr<QList<std::shared_ptr<An
  */
 void Annotateable::annotate(std::shared_ptr<Annotation> a)
 {
-    if (!a || annotations->contains(a))
+    if (!a || annotationSet.contains(a.get()))
         return;
     annotations->append(a);
+    annotationSet.insert(a.get());
 }
 
 /*!
@@ -61,7 +65,7 @@ void Annotateable::annotate(std::shared_ptr<Annotation> a)
  */
 void Annotateable::unannotate(std::shared_ptr<Annotation> a)
 {
-    if (!a)
+    if (!a || !annotationSet.remove(a.get()))
         return;
     annotations->removeOne(a);
 }
@@ -82,7 +86,7 @@ bool Annotateable::isAnnotated()
  */
 bool Annotateable::isAnnotatedWith(std::shared_ptr<Annotation> annotation)
 {
-    return annotations->contains(annotation);
+    return annotationSet.contains(annotation.get());
 }
 
 }
@@ -22,6 +22,9 @@
 #include <memory>
 #include <string>
 
+#include <QList>
+#include <QSet>
+
 #include "annotation.h"
 
 namespace TraCurate { class Annotateable; }
@@ -35,6 +38,9 @@ namespace TraCurate {
  * Provides the means to hold a QList of Annotation%s, add new Annotation%s to this list
  * and remove them again. Also allows an Annotatable to be checked, if it actually holds any
  * Annotation%s.
+ *
+ * The list keeps the order in which the Annotation%s were added, a QSet of the same
+ * Annotation%s answers isAnnotatedWith() without scanning the list.
  */
 class Annotateable
 {
@@ -57,6 +63,7 @@ public:
 
 private:
     std::shared_ptr<QList<std::shared_ptr<Annotation>>> annotations; /*!< the QList of Annotations */
+    QSet<Annotation*> annotationSet;                                 /*!< the same Annotations, for lookups */
 };
 
 }
@@ -71,9 +71,24 @@ Annotation::Annotation(ANNOTATION_TYPE type_, uint32_t id_, QString title_, QStr
  * \brief destructs an Annotation and returns its ID to the IDProvider
  */
 Annotation::~Annotation() {
-    IdProvider::returnAnnotationId(id);
+    if (!snapshot)
+        IdProvider::returnAnnotationId(id);
 }
 
+/*!
+ * \brief constructs a copy of an Annotation for a ProjectSnapshot
+ * \param other the Annotation to copy
+ *
+ * The copy shares the id with other without claiming it from the IdProvider.
+ */
+Annotation::Annotation(Annotation const &other) :
+    QObject(0),
+    snapshot(true),
+    type(other.type),
+    id(other.id),
+    title(other.title),
+    description(other.description) {}
+
 /*!
  * \brief returns the Title of this Annotation
  * \return the title of this Annotation
@@ -25,7 +25,7 @@
 #include <memory>
 #include <string>
 
-namespace TraCurate { class Annotation; }
+namespace TraCurate { class Annotation; class ProjectSnapshot; }
 std::ostream& operator<< (std::ostream&, TraCurate::Annotation&);
 
 namespace TraCurate {
@@ -73,6 +73,10 @@ public:
     void setType(const ANNOTATION_TYPE &value);
 
 private:
+    friend class ProjectSnapshot;
+    Annotation(Annotation const &other);
+    bool snapshot = false; /*!< copies made by ProjectSnapshot don't own their id */
+
     ANNOTATION_TYPE type; /*!< the type of this Annotation */
     uint32_t id;          /*!< the ID of this Annotation */
     QString title;        /*!< the title of this Annotation */
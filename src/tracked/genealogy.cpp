@@ -26,9 +26,30 @@
 #include "trackeventendofmovie.hpp"
 #include "tracklet.h"
 
+#include <functional>
+
 #include <QDebug>
 namespace TraCurate {
 
+namespace {
+/*!
+ * \brief notes the changes of an operation before and after it
+ *
+ * Calls a function noting the changed Tracklet%s when it is created and again
+ * when it goes out of scope. As Genealogy::changed() also notes the neighbours
+ * of a Tracklet, the neighbours before and after the operation are included.
+ */
+class ChangeScope
+{
+public:
+    explicit ChangeScope(std::function<void()> note) : note(note) { note(); }
+    ~ChangeScope() { note(); }
+
+private:
+    std::function<void()> note;
+};
+}
+
 /*!
  * \brief creates a new Genealogy for a Project
  * \param p the Project of this Genealogy
@@ -46,10 +67,9 @@ Genealogy::Genealogy(std::shared_ptr<Project> p) :
  */
 std::shared_ptr<Annotation> Genealogy::getAnnotation(int id) const
 {
-    for (std::shared_ptr<Annotation> a : *annotations)
-        if (id >= 0 && a->getId() == static_cast<uint32_t>(id))
-            return a;
-    return nullptr;
+    if (id < 0)
+        return nullptr;
+    return annotationIds.value(static_cast<uint32_t>(id));
 }
 
 /*!
@@ -81,6 +101,7 @@ bool Genealogy::addTracklet(const std::shared_ptr<Tracklet> &value)
     if (tracklets->contains(value->getId()))
         return false;
     tracklets->insert(value->getId(),value);
+    changed(value);
     return true;
 }
 
@@ -92,6 +113,7 @@ bool Genealogy::addTracklet(const std::shared_ptr<Tracklet> &value)
 int Genealogy::removeTracklet(int id)
 {
     std::weak_ptr<Tracklet> t = tracklets->value(id);
+    changed(t.lock());
     std::shared_ptr<TrackEvent<Tracklet>> next = t.lock()->getNext();
     std::shared_ptr<TrackEvent<Tracklet>> prev = t.lock()->getPrev();
 
@@ -220,6 +242,9 @@ std::shared_ptr<QList<std::shared_ptr<Annotation> > > Genealogy::getAnnotations(
 void Genealogy::setAnnotations(const std::shared_ptr<QList<std::shared_ptr<Annotation>>> &value)
 {
     annotations = value;
+    annotationIds.clear();
+    for (std::shared_ptr<Annotation> const &a : *annotations)
+        annotationIds.insert(a->getId(), a);
 }
 
 /*!
@@ -228,7 +253,11 @@ void Genealogy::setAnnotations(const std::shared_ptr<QList<std::shared_ptr<Annot
  */
 void Genealogy::addAnnotation(std::shared_ptr<Annotation> a)
 {
+    if (!a)
+        return;
     annotations->append(a);
+    annotationIds.insert(a->getId(), a);
+    changed(a);
 }
 
 /*!
@@ -240,13 +269,23 @@ void Genealogy::addAnnotation(std::shared_ptr<Annotation> a)
  */
 void Genealogy::deleteAnnotation(std::shared_ptr<Annotation> a)
 {
+    if (!a)
+        return;
+
+    changed(a);
+
     /* remove from annotations */
     annotations->removeOne(a);
+    if (annotationIds.value(a->getId()) == a)
+        annotationIds.remove(a->getId());
 
     /* remove references from annotated */
-    for (std::shared_ptr<Annotateable> abl : *annotated) {
-        if (abl->getAnnotations()->contains(a))
-            abl->unannotate(a);
+    for (Annotateable *abl : annotatedWith.take(a.get())) {
+        if (annotatedPos.contains(abl))
+            changedAnnotated(annotated->at(annotatedPos.value(abl)), a);
+        abl->unannotate(a);
+        if (!abl->isAnnotated())
+            removeAnnotated(abl);
     }
 }
 
@@ -259,10 +298,14 @@ void Genealogy::annotate(std::shared_ptr<Annotateable> annotatee, std::shared_pt
 {
     if (!annotatee || !annotation)
         return;
-    if (annotations->contains(annotation)) {
+    if (annotationIds.value(annotation->getId()) == annotation) {
         annotatee->annotate(annotation);
-        if (!annotated->contains(annotatee))
+        changedAnnotated(annotatee, annotation);
+        annotatedWith[annotation.get()].insert(annotatee.get());
+        if (!annotatedPos.contains(annotatee.get())) {
+            annotatedPos.insert(annotatee.get(), annotated->size());
             annotated->append(annotatee);
+        }
     }
 }
 
@@ -278,12 +321,61 @@ void Genealogy::unannotate(std::shared_ptr<Annotateable> annotatee, std::shared_
 {
     if (!annotatee || !annotation)
         return;
-    if (annotations->contains(annotation)) {
+    if (annotationIds.value(annotation->getId()) == annotation) {
         annotatee->unannotate(annotation);
+        changedAnnotated(annotatee, annotation);
+        auto it = annotatedWith.find(annotation.get());
+        if (it != annotatedWith.end())
+            it->remove(annotatee.get());
         if (!annotatee->isAnnotated())
-            annotated->removeOne(annotatee);
+            removeAnnotated(annotatee.get());
+    }
+}
+
+/*!
+ * \brief removes an Annotateable from annotated
+ * \param annotatee the Annotateable
+ *
+ * The last Annotateable takes its place, so the order of annotated is not kept.
+ */
+void Genealogy::removeAnnotated(Annotateable *annotatee)
+{
+    auto it = annotatedPos.find(annotatee);
+    if (it == annotatedPos.end())
+        return;
+    int pos = it.value();
+    annotatedPos.erase(it);
+
+    int last = annotated->size() - 1;
+    if (pos != last) {
+        std::shared_ptr<Annotateable> moved = annotated->at(last);
+        (*annotated)[pos] = moved;
+        annotatedPos[moved.get()] = pos;
     }
+    annotated->removeLast();
+}
 
+/*!
+ * \brief returns all Annotateable%s that are annotated with an Annotation, e.g. to filter a view
+ * \param annotation the Annotation
+ * \return the Annotateable%s, in no particular order
+ */
+QList<std::shared_ptr<Annotateable>> Genealogy::getAnnotatedWith(std::shared_ptr<Annotation> const &annotation) const
+{
+    QList<std::shared_ptr<Annotateable>> ret;
+    for (Annotateable *a : annotatedWith.value(annotation.get()))
+        ret.append(annotated->at(annotatedPos.value(a)));
+    return ret;
+}
+
+/*!
+ * \brief returns how many Annotateable%s are annotated with an Annotation
+ * \param annotation the Annotation
+ * \return the number of Annotateable%s
+ */
+int Genealogy::countAnnotatedWith(std::shared_ptr<Annotation> const &annotation) const
+{
+    return annotatedWith.value(annotation.get()).size();
 }
 
 /*!
@@ -336,6 +428,7 @@ void Genealogy::addObject(int frameId, int trackId, std::shared_ptr<Object> cons
 {
     std::shared_ptr<Frame> f = this->project.lock()->getMovie()->getFrame(frameId);
     this->tracklets->value(trackId)->addToContained(f,obj);
+    changed(this->tracklets->value(trackId));
 }
 
 /*!
@@ -347,6 +440,7 @@ void Genealogy::addObject(int frameId, int trackId, std::shared_ptr<Object> cons
 void Genealogy::removeObject(int frameId, int trackId, uint32_t objId)
 {
     this->tracklets->value(trackId)->removeFromContained(frameId, objId);
+    changed(this->tracklets->value(trackId));
 }
 
 /*!
@@ -365,6 +459,7 @@ bool Genealogy::addDaughterTrack(std::shared_ptr<Tracklet> mother, std::shared_p
 
     if (!mother || !daughterObj) /* Function was called falsely */
         return false;
+    ChangeScope scope([&]() { changed(mother); });
     if (daughterObj->getFrameId() < mother->getStart().first->getID()) /* daughter Frame is prior to begin of tracklet */
         return false;
 
@@ -410,6 +505,7 @@ bool Genealogy::addUnmergedTrack(std::shared_ptr<Tracklet> merged, std::shared_p
 
     if (!merged || !unmergedObj) /* Function was called falsely */
         return false;
+    ChangeScope scope([&]() { changed(merged); });
     if (unmergedObj->getFrameId() < merged->getStart().first->getID()) /* merged Frame is prior to begin of tracklet */
         return false;
 
@@ -446,6 +542,7 @@ bool Genealogy::addMergedTrack(std::shared_ptr<Tracklet> unmerged, std::shared_p
 
     if (!unmerged || !mergedObj) /* Function was called falsely */
         return false;
+    ChangeScope scope([&]() { changed(unmerged); });
     if (mergedObj->getFrameId() < unmerged->getStart().first->getID()) /* unmerged Frame is prior to begin of tracklet */
         return false;
 
@@ -531,6 +628,7 @@ bool Genealogy::removeDaughterTrack(std::shared_ptr<Tracklet> mother, std::share
     if (!mother || !daughterObj || !mother->getNext() || mother->getNext()->getType() !=
             TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_DIVISION)
         return false;
+    ChangeScope scope([&]() { changed(mother); });
     std::shared_ptr<TrackEventDivision<Tracklet>> ted =
             std::static_pointer_cast<TrackEventDivision<Tracklet>>(mother->getNext());
     std::shared_ptr<QList<std::weak_ptr<Tracklet>>> next = ted->getNext();
@@ -567,6 +665,7 @@ bool Genealogy::removeUnmergedTrack(std::shared_ptr<Tracklet> merged, std::share
     if (!merged || !unmergedObj || !merged->getNext() || merged->getNext()->getType() !=
             TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_UNMERGE)
         return false;
+    ChangeScope scope([&]() { changed(merged); });
     std::shared_ptr<TrackEventUnmerge<Tracklet>> ted =
             std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(merged->getNext());
     std::shared_ptr<QList<std::weak_ptr<Tracklet>>> next = ted->getNext();
@@ -603,6 +702,7 @@ bool Genealogy::removeMergedTrack(std::shared_ptr<Tracklet> unmerged, std::share
     if (!unmerged || !mergedObj || !unmerged->getPrev() || unmerged->getPrev()->getType() !=
             TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_MERGE)
         return false;
+    ChangeScope scope([&]() { changed(unmerged); });
     std::shared_ptr<TrackEventMerge<Tracklet>> ted =
             std::static_pointer_cast<TrackEventMerge<Tracklet>>(unmerged->getPrev());
     std::shared_ptr<QList<std::weak_ptr<Tracklet>>> prev = ted->getPrev();
@@ -642,6 +742,7 @@ bool Genealogy::setDead(std::shared_ptr<Tracklet> t)
 {
     if (t == nullptr)
         return false;
+    ChangeScope scope([&]() { changed(t); });
     t->setNext(std::make_shared<TrackEventDead<Tracklet>>());
     return true;
 }
@@ -655,6 +756,7 @@ bool Genealogy::setLost(std::shared_ptr<Tracklet> t)
 {
     if (t == nullptr)
         return false;
+    ChangeScope scope([&]() { changed(t); });
     t->setNext(std::make_shared<TrackEventLost<Tracklet>>());
     return true;
 }
@@ -668,6 +770,7 @@ bool Genealogy::setOpen(std::shared_ptr<Tracklet> t)
 {
     if (t == nullptr)
         return false;
+    ChangeScope scope([&]() { changed(t); });
     t->setNext(nullptr);
     return true;
 }
@@ -680,6 +783,7 @@ bool Genealogy::setOpen(std::shared_ptr<Tracklet> t)
  */
 bool Genealogy::addMerge(std::shared_ptr<Tracklet> prev, std::shared_ptr<Tracklet> merge)
 {
+    ChangeScope scope([&]() { changed(prev); changed(merge); });
     if (prev && merge) {
         std::shared_ptr<TrackEventMerge<Tracklet>> ev = std::static_pointer_cast<TrackEventMerge<Tracklet>>(prev->getNext());
         if (ev == nullptr) {
@@ -706,6 +810,7 @@ bool Genealogy::addMerge(std::shared_ptr<Tracklet> prev, std::shared_ptr<Trackle
  */
 bool Genealogy::addUnmerge(std::shared_ptr<Tracklet> merge, std::shared_ptr<Tracklet> next)
 {
+    ChangeScope scope([&]() { changed(merge); changed(next); });
     if (merge && next) {
         std::shared_ptr<TrackEventUnmerge<Tracklet>> ev = std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(merge->getNext());
         if (ev == nullptr) {
@@ -740,6 +845,14 @@ std::shared_ptr<QList<std::shared_ptr<Annotateable> > > Genealogy::getAnnotated(
 void Genealogy::setAnnotated(const std::shared_ptr<QList<std::shared_ptr<Annotateable> > > &value)
 {
     annotated = value;
+    annotatedPos.clear();
+    annotatedWith.clear();
+    for (int i = 0; i < annotated->size(); i++) {
+        std::shared_ptr<Annotateable> const &abl = annotated->at(i);
+        annotatedPos.insert(abl.get(), i);
+        for (std::shared_ptr<Annotation> const &a : *abl->getAnnotations())
+            annotatedWith[a.get()].insert(abl.get());
+    }
 }
 
 /*!
@@ -784,6 +897,11 @@ bool Genealogy::connectObjects(std::shared_ptr<Object> first, std::shared_ptr<Ob
                                           .arg(__LINE__));
         return false;
     }
+    /* the Object%s may change their Tracklet%s, so these are looked up again afterwards */
+    ChangeScope scope([&]() {
+        changed(getTracklet(static_cast<int>(first->getTrackId())));
+        changed(getTracklet(static_cast<int>(second->getTrackId())));
+    });
 
     /* If the objects are the same and are not yet associated to any tracklet (thus the object only appears in some auto_tracklet).  */
     if(first==second && !first->isInTracklet()) {
@@ -1013,6 +1131,7 @@ void Genealogy::allFromAT(std::shared_ptr<Tracklet> t, std::shared_ptr<AutoTrack
 {
     if(!t || !at)
         return;
+    changed(t);
     for (auto p: at->getComponents().toStdMap()) {
         std::shared_ptr<Frame> f = this->project.lock()->getMovie()->getFrame(p.first);
         QPair<std::shared_ptr<Frame>, std::shared_ptr<Object>> pair(f, p.second);
@@ -1034,6 +1153,7 @@ void Genealogy::allFromATBetween(std::shared_ptr<Tracklet> t,
 {
     if(!t || !at || !from || !to)
         return;
+    changed(t);
     for (auto p: at->getComponents().toStdMap()) {
         if (p.first >= 0 && static_cast<uint32_t>(p.first) >= from->getID() && static_cast<uint32_t>(p.first) <= to->getID()) {
             std::shared_ptr<Frame> f = this->project.lock()->getMovie()->getFrame(p.first);
@@ -1055,6 +1175,7 @@ void Genealogy::allFromATFrom(std::shared_ptr<Tracklet> t,
 {
     if(!t || !at || !from)
         return;
+    changed(t);
     for (auto p: at->getComponents().toStdMap()) {
         if (p.first >= 0 && static_cast<uint32_t>(p.first) >= from->getID()) {
             std::shared_ptr<Frame> f = this->project.lock()->getMovie()->getFrame(p.first);
@@ -1076,6 +1197,7 @@ void Genealogy::allFromATUntil(std::shared_ptr<Tracklet> t,
 {
     if(!t || !at || !to)
         return;
+    changed(t);
     for (auto p: at->getComponents().toStdMap()) {
         if (p.first >= 0 && static_cast<uint32_t>(p.first) <= to->getID()) {
             std::shared_ptr<Frame> f = this->project.lock()->getMovie()->getFrame(p.first);
@@ -1085,6 +1207,101 @@ void Genealogy::allFromATUntil(std::shared_ptr<Tracklet> t,
     }
 }
 
+/*!
+ * \brief notes that a Tracklet changed
+ * \param tracklet the Tracklet, may be nullptr
+ *
+ * The Tracklet%s it is connected to by its TrackEvent%s are noted as well, as
+ * their records contain these connections.
+ */
+void Genealogy::changed(std::shared_ptr<Tracklet> const &tracklet)
+{
+    if (!tracklet)
+        return;
+    changedTracklets.insert(tracklet->getId());
+
+    auto note = [this](std::weak_ptr<Tracklet> const &t) {
+        if (std::shared_ptr<Tracklet> sp = t.lock())
+            changedTracklets.insert(sp->getId());
+    };
+    for (std::shared_ptr<TrackEvent<Tracklet>> const &ev : {tracklet->getPrev(), tracklet->getNext()}) {
+        if (!ev)
+            continue;
+        switch (ev->getType()) {
+        case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_DIVISION: {
+            std::shared_ptr<TrackEventDivision<Tracklet>> ted = std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev);
+            note(ted->getPrev());
+            for (std::weak_ptr<Tracklet> const &n : *ted->getNext())
+                note(n);
+            break; }
+        case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_UNMERGE: {
+            std::shared_ptr<TrackEventUnmerge<Tracklet>> teu = std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev);
+            note(teu->getPrev());
+            for (std::weak_ptr<Tracklet> const &n : *teu->getNext())
+                note(n);
+            break; }
+        case TrackEvent<Tracklet>::EVENT_TYPE::EVENT_TYPE_MERGE: {
+            std::shared_ptr<TrackEventMerge<Tracklet>> tem = std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev);
+            for (std::weak_ptr<Tracklet> const &p : *tem->getPrev())
+                note(p);
+            note(tem->getNext());
+            break; }
+        default:
+            break;
+        }
+    }
+}
+
+/*!
+ * \brief notes that an Annotation was added, changed or deleted
+ * \param annotation the Annotation
+ */
+void Genealogy::changed(std::shared_ptr<Annotation> const &annotation)
+{
+    if (annotation)
+        changedAnnotations.insert(annotation->getId());
+}
+
+/*!
+ * \brief notes that the Annotation%s of an Object changed
+ * \param object the Object
+ */
+void Genealogy::changed(std::shared_ptr<Object> const &object)
+{
+    if (object)
+        changedObjects.insert(object.get(), object);
+}
+
+/*!
+ * \brief notes that an Annotateable was (un)annotated
+ * \param annotatee the Annotateable
+ * \param annotation the Annotation, its type tells what the Annotateable is
+ */
+void Genealogy::changedAnnotated(std::shared_ptr<Annotateable> const &annotatee, std::shared_ptr<Annotation> const &annotation)
+{
+    /* Annotateable is not polymorphic, like ExportHDF5 use the type of the Annotation */
+    if (annotation->getType() == Annotation::OBJECT_ANNOTATION)
+        changed(std::static_pointer_cast<Object>(annotatee));
+    else
+        changed(std::static_pointer_cast<Tracklet>(annotatee));
+}
+
+/*!
+ * \brief returns the changes noted since the last call and forgets them
+ * \param trackletIds receives the IDs of the changed Tracklet%s, they may have been removed
+ * \param annotationIds receives the IDs of the changed Annotation%s, they may have been deleted
+ * \param objects receives the Object%s whose Annotation%s changed
+ */
+void Genealogy::takeChanges(QSet<int> &trackletIds, QSet<uint32_t> &annotationIds, QList<std::shared_ptr<Object>> &objects)
+{
+    trackletIds.clear();
+    trackletIds.swap(changedTracklets);
+    annotationIds.clear();
+    annotationIds.swap(changedAnnotations);
+    objects = changedObjects.values();
+    changedObjects.clear();
+}
+
 }
 
 std::ostream &operator<<(std::ostream &strm, TraCurate::Genealogy &g)
@@ -23,6 +23,7 @@
 
 #include <QList>
 #include <QHash>
+#include <QSet>
 
 #include "annotation.h"
 #include "base/movie.h"
@@ -39,6 +40,18 @@ namespace TraCurate {
  *
  * This Class represents the generated genealogy. It holds all the Tracklet%s and Annotation%s
  * and provides operations on those.
+ *
+ * Annotation%s are indexed by their ID and by the Annotateable%s annotated with
+ * them, so looking them up, (un)annotating and finding everything that carries an
+ * Annotation does not scan the lists. The index is kept up to date by the
+ * Annotation-related operations below, so the lists returned by getAnnotations()
+ * and getAnnotated() should not be modified directly. The ID of an Annotation
+ * should not change after it was added.
+ *
+ * The operations below also note which Tracklet%s, Annotation%s and annotated
+ * Object%s they change, the Journal takes these changes instead of comparing
+ * the whole Genealogy. Code that changes a Tracklet or Annotation directly
+ * reports it with changed().
  */
 class Genealogy
 {
@@ -56,6 +69,8 @@ public:
     void unannotate(std::shared_ptr<Annotateable>, std::shared_ptr<Annotation>);
     std::shared_ptr<QList<std::shared_ptr<Annotateable> > > getAnnotated() const;
     void setAnnotated(const std::shared_ptr<QList<std::shared_ptr<Annotateable> > > &value);
+    QList<std::shared_ptr<Annotateable>> getAnnotatedWith(std::shared_ptr<Annotation> const &annotation) const;
+    int countAnnotatedWith(std::shared_ptr<Annotation> const &annotation) const;
 
     // Object-related operations
     std::shared_ptr<Object> getObject(int trackId, int frameId, uint32_t objId) const;
@@ -92,11 +107,26 @@ public:
     bool addMerge(std::shared_ptr<Tracklet> prev, std::shared_ptr<Tracklet> merge);
     bool addUnmerge(std::shared_ptr<Tracklet> merge, std::shared_ptr<Tracklet> next);
 
+    // Changes, collected by the Journal
+    void changed(std::shared_ptr<Tracklet> const &tracklet);
+    void changed(std::shared_ptr<Annotation> const &annotation);
+    void changed(std::shared_ptr<Object> const &object);
+    void takeChanges(QSet<int> &trackletIds, QSet<uint32_t> &annotationIds, QList<std::shared_ptr<Object>> &objects);
+
 private:
+    void removeAnnotated(Annotateable *annotatee);
+    void changedAnnotated(std::shared_ptr<Annotateable> const &annotatee, std::shared_ptr<Annotation> const &annotation);
+
     std::shared_ptr<QHash<int,std::shared_ptr<Tracklet>>> tracklets; /*!< all existing Tracklet%s */
     std::shared_ptr<QList<std::shared_ptr<Annotation>>> annotations; /*!< all existing Annotation%s */
     std::shared_ptr<QList<std::shared_ptr<Annotateable>>> annotated; /*!< all existing Annotateable%s */
+    QHash<uint32_t, std::shared_ptr<Annotation>> annotationIds;      /*!< the Annotation%s by their ID */
+    QHash<Annotateable*, int> annotatedPos;                          /*!< the index of each Annotateable in annotated */
+    QHash<Annotation*, QSet<Annotateable*>> annotatedWith;           /*!< the Annotateable%s of each Annotation */
     std::weak_ptr<Project> project;                                  /*!< the Project */
+    QSet<int> changedTracklets;                                      /*!< IDs of the Tracklet%s changed since takeChanges() */
+    QSet<uint32_t> changedAnnotations;                               /*!< IDs of the Annotation%s changed since takeChanges() */
+    QHash<Object*, std::shared_ptr<Object>> changedObjects;          /*!< Object%s whose Annotation%s changed since takeChanges() */
 };
 
 }
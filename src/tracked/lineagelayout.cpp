@@ -0,0 +1,385 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "lineagelayout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QSet>
+
+#include "provider/tracer.h"
+#include "tracked/trackeventdivision.hpp"
+#include "tracked/trackeventmerge.hpp"
+#include "tracked/trackeventunmerge.hpp"
+
+namespace TraCurate {
+
+/*!
+ * \brief returns the first and last Frame of a Tracklet
+ * \param t the Tracklet
+ * \return the first and last Frame, -1 for both if the Tracklet is empty
+ */
+QPair<int,int> LineageLayout::span(std::shared_ptr<Tracklet> const &t)
+{
+    QPair<int,int> ret(-1, -1);
+    for (QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>> const &p : t->getContained()) {
+        int f = static_cast<int>(p.first->getID());
+        if (ret.first < 0 || f < ret.first)
+            ret.first = f;
+        if (f > ret.second)
+            ret.second = f;
+    }
+    return ret;
+}
+
+/*!
+ * \brief returns the Tracklet%s before a Tracklet
+ * \param t the Tracklet
+ * \return the mother of a division or unmerge, or the Tracklet%s of a merge
+ */
+QList<std::shared_ptr<Tracklet>> LineageLayout::previous(std::shared_ptr<Tracklet> const &t)
+{
+    QList<std::shared_ptr<Tracklet>> ret;
+    std::shared_ptr<TrackEvent<Tracklet>> ev = t->getPrev();
+    if (!ev)
+        return ret;
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+        ret.append(std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev)->getPrev().lock());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+        ret.append(std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev)->getPrev().lock());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:
+        for (std::weak_ptr<Tracklet> const &p : *std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev)->getPrev())
+            ret.append(p.lock());
+        break;
+    default:
+        break;
+    }
+    ret.removeAll(nullptr);
+    return ret;
+}
+
+/*!
+ * \brief returns the Tracklet%s after a Tracklet
+ * \param t the Tracklet
+ * \return the daughters of a division or unmerge, or the Tracklet after a merge
+ */
+QList<std::shared_ptr<Tracklet>> LineageLayout::next(std::shared_ptr<Tracklet> const &t)
+{
+    QList<std::shared_ptr<Tracklet>> ret;
+    std::shared_ptr<TrackEvent<Tracklet>> ev = t->getNext();
+    if (!ev)
+        return ret;
+    switch (ev->getType()) {
+    case TrackEvent<Tracklet>::EVENT_TYPE_DIVISION:
+        for (std::weak_ptr<Tracklet> const &n : *std::static_pointer_cast<TrackEventDivision<Tracklet>>(ev)->getNext())
+            ret.append(n.lock());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_UNMERGE:
+        for (std::weak_ptr<Tracklet> const &n : *std::static_pointer_cast<TrackEventUnmerge<Tracklet>>(ev)->getNext())
+            ret.append(n.lock());
+        break;
+    case TrackEvent<Tracklet>::EVENT_TYPE_MERGE:
+        ret.append(std::static_pointer_cast<TrackEventMerge<Tracklet>>(ev)->getNext().lock());
+        break;
+    default:
+        break;
+    }
+    ret.removeAll(nullptr);
+    return ret;
+}
+
+/*!
+ * \brief returns a fingerprint of everything the layout of a Tracklet depends on
+ * \param t the Tracklet
+ * \return the fingerprint of its span and its previous and next Tracklet%s
+ */
+quint64 LineageLayout::fingerprint(std::shared_ptr<Tracklet> const &t)
+{
+    /* FNV-1a over the values */
+    quint64 h = 14695981039346656037ULL;
+    auto mix = [&h](qint64 v) { h = (h ^ static_cast<quint64>(v)) * 1099511628211ULL; };
+
+    QPair<int,int> s = span(t);
+    mix(t->getId());
+    mix(s.first);
+    mix(s.second);
+    mix(t->getPrev() ? t->getPrev()->getType() : -1);
+    for (std::shared_ptr<Tracklet> const &p : previous(t))
+        mix(p->getId());
+    mix(t->getNext() ? t->getNext()->getType() : -1);
+    for (std::shared_ptr<Tracklet> const &n : next(t))
+        mix(n->getId());
+    return h;
+}
+
+/*!
+ * \brief lays out the Tracklet%s of one Tree
+ * \param members the Tracklet%s connected by TrackEvent%s
+ * \return the Tree, its offset is not set yet
+ */
+std::shared_ptr<LineageLayout::Tree> LineageLayout::layout(QList<std::shared_ptr<Tracklet>> const &members)
+{
+    auto tree = std::make_shared<Tree>();
+    tree->offset = 0;
+    tree->first = std::numeric_limits<int>::max();
+    tree->last = -1;
+    tree->minId = std::numeric_limits<int>::max();
+
+    for (std::shared_ptr<Tracklet> const &t : members) {
+        QPair<int,int> s = span(t);
+        tree->nodes.append(Node{t->getId(), s.first, s.second, 0, QVector<int>()});
+    }
+    std::sort(tree->nodes.begin(), tree->nodes.end(), [](Node const &a, Node const &b) {
+        return a.start < b.start || (a.start == b.start && a.id < b.id);
+    });
+
+    int n = tree->nodes.size();
+    QHash<int,int> index;
+    for (int i = 0; i < n; i++) {
+        Node const &node = tree->nodes[i];
+        index.insert(node.id, i);
+        tree->first = std::min(tree->first, node.start);
+        tree->last = std::max(tree->last, node.end);
+        tree->minId = std::min(tree->minId, node.id);
+    }
+
+    QVector<QVector<int>> children(n);
+    for (std::shared_ptr<Tracklet> const &t : members) {
+        int i = index.value(t->getId());
+        for (std::shared_ptr<Tracklet> const &p : previous(t))
+            if (index.contains(p->getId()))
+                tree->nodes[i].parents.append(index.value(p->getId()));
+        for (std::shared_ptr<Tracklet> const &c : next(t))
+            if (index.contains(c->getId()))
+                children[i].append(index.value(c->getId()));
+        std::sort(children[i].begin(), children[i].end());
+    }
+
+    /* depth first from the roots, a Tracklet is placed below the first Tracklet that reaches it */
+    QVector<char> placed(n, false);
+    QVector<double> lo(n, std::numeric_limits<double>::max());
+    QVector<double> hi(n, std::numeric_limits<double>::lowest());
+    QVector<QPair<int,int>> stack;  /* Node and its next child */
+    double nextRow = 0;
+    auto place = [&](int root) {
+        placed[root] = true;
+        stack.append(qMakePair(root, 0));
+        while (!stack.isEmpty()) {
+            QPair<int,int> &top = stack.last();
+            int v = top.first;
+            if (top.second < children[v].size()) {
+                int c = children[v][top.second++];
+                if (!placed[c]) {
+                    placed[c] = true;
+                    stack.append(qMakePair(c, 0));
+                }
+                continue;
+            }
+            stack.removeLast();
+            double row = (lo[v] <= hi[v]) ? (lo[v] + hi[v]) / 2 : nextRow++;
+            tree->nodes[v].row = row;
+            if (!stack.isEmpty()) {
+                int p = stack.last().first;
+                lo[p] = std::min(lo[p], row);
+                hi[p] = std::max(hi[p], row);
+            }
+        }
+    };
+    for (int i = 0; i < n; i++)
+        if (!placed[i] && tree->nodes[i].parents.isEmpty())
+            place(i);
+    for (int i = 0; i < n; i++) /* only reached if the TrackEvents form a cycle */
+        if (!placed[i])
+            place(i);
+
+    tree->rows = std::max(static_cast<int>(nextRow), 1);
+    return tree;
+}
+
+/* removes a Tree, its Tracklets are appended to members */
+void LineageLayout::drop(Tree *tree, QList<int> &members)
+{
+    for (Node const &node : tree->nodes) {
+        members.append(node.id);
+        treeOf.remove(node.id);
+    }
+    for (int i = 0; i < trees.size(); i++) {
+        if (trees[i].get() == tree) {
+            trees.removeAt(i);
+            break;
+        }
+    }
+}
+
+/*!
+ * \brief lays out the Tree%s that changed since the last call again
+ * \param gen the Genealogy
+ * \return the number of Tree%s that were laid out
+ */
+int LineageLayout::update(std::shared_ptr<Genealogy> const &gen)
+{
+    TC_TRACE_SCOPE("LineageLayout::update");
+    std::shared_ptr<QHash<int,std::shared_ptr<Tracklet>>> tracklets = gen ? gen->getTracklets() : nullptr;
+    if (!tracklets)
+        tracklets = std::make_shared<QHash<int,std::shared_ptr<Tracklet>>>();
+
+    /* the Tracklets that were added, removed or changed */
+    QList<int> seeds;
+    QHash<int, quint64> fps;
+    fps.reserve(tracklets->size());
+    for (std::shared_ptr<Tracklet> const &t : *tracklets) {
+        quint64 fp = fingerprint(t);
+        fps.insert(t->getId(), fp);
+        auto it = fingerprints.constFind(t->getId());
+        if (it == fingerprints.constEnd() || it.value() != fp)
+            seeds.append(t->getId());
+    }
+    for (auto it = fingerprints.constBegin(); it != fingerprints.constEnd(); ++it)
+        if (!fps.contains(it.key()))
+            seeds.append(it.key());
+    fingerprints = fps;
+    if (seeds.isEmpty())
+        return 0;
+
+    /* their Trees are laid out again, with all Tracklets in them */
+    for (int i = 0; i < seeds.size(); i++) {
+        Tree *tree = treeOf.value(seeds[i]);
+        if (tree)
+            drop(tree, seeds);
+    }
+
+    /* the connected components of the remaining Tracklets become the new Trees */
+    int laidOut = 0;
+    QSet<int> done;
+    for (int id : seeds) {
+        std::shared_ptr<Tracklet> t = tracklets->value(id);
+        if (!t || done.contains(id))
+            continue;
+
+        QList<std::shared_ptr<Tracklet>> members;
+        QList<std::shared_ptr<Tracklet>> queue {t};
+        done.insert(id);
+        while (!queue.isEmpty()) {
+            std::shared_ptr<Tracklet> cur = queue.takeLast();
+            members.append(cur);
+            for (std::shared_ptr<Tracklet> const &o : previous(cur) + next(cur)) {
+                if (done.contains(o->getId()))
+                    continue;
+                done.insert(o->getId());
+                queue.append(o);
+                /* a Tree that was not changed, but is connected now */
+                Tree *other = treeOf.value(o->getId());
+                if (other) {
+                    QList<int> ids;
+                    drop(other, ids);
+                    for (int oid : ids) {
+                        std::shared_ptr<Tracklet> ot = tracklets->value(oid);
+                        if (ot && !done.contains(oid)) {
+                            done.insert(oid);
+                            queue.append(ot);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::shared_ptr<Tree> tree = layout(members);
+        auto pos = std::lower_bound(trees.begin(), trees.end(), tree, [](std::shared_ptr<Tree> const &a, std::shared_ptr<Tree> const &b) {
+            return a->first < b->first || (a->first == b->first && a->minId < b->minId);
+        });
+        trees.insert(pos, tree);
+        for (Node const &node : tree->nodes)
+            treeOf.insert(node.id, tree.get());
+        laidOut++;
+    }
+
+    rows = 0;
+    lastFrame = -1;
+    for (std::shared_ptr<Tree> const &tree : trees) {
+        tree->offset = rows;
+        rows += tree->rows;
+        lastFrame = std::max(lastFrame, tree->last);
+    }
+    return laidOut;
+}
+
+/*!
+ * \brief drops the layout, the next update() lays out all Tracklet%s
+ */
+void LineageLayout::clear()
+{
+    trees.clear();
+    treeOf.clear();
+    fingerprints.clear();
+    rows = 0;
+    lastFrame = -1;
+}
+
+int LineageLayout::getRows() const
+{
+    return rows;
+}
+
+int LineageLayout::getLastFrame() const
+{
+    return lastFrame;
+}
+
+/*!
+ * \brief returns the Tree%s that occupy rows in a range
+ * \param firstRow the first row
+ * \param lastRow the last row
+ * \return the Tree%s, ordered by their rows
+ */
+QList<LineageLayout::Tree const *> LineageLayout::treesIn(double firstRow, double lastRow) const
+{
+    QList<Tree const *> ret;
+    auto it = std::upper_bound(trees.begin(), trees.end(), firstRow, [](double row, std::shared_ptr<Tree> const &tree) {
+        return row < tree->offset + tree->rows;
+    });
+    for (; it != trees.end() && (*it)->offset <= lastRow; ++it)
+        ret.append(it->get());
+    return ret;
+}
+
+/*!
+ * \brief finds the Tracklet at a position
+ * \param frame the Frame
+ * \param row the row
+ * \return the Node of the Tracklet or nullptr if there is none
+ */
+LineageLayout::Node const *LineageLayout::nodeAt(double frame, double row) const
+{
+    Node const *ret = nullptr;
+    double best = 0.5;
+    for (Tree const *tree : treesIn(row, row)) {
+        for (Node const &node : tree->nodes) {
+            double d = std::abs(tree->offset + node.row - row);
+            if (d <= best && frame >= node.start - 0.5 && frame <= node.end + 0.5) {
+                best = d;
+                ret = &node;
+            }
+        }
+    }
+    return ret;
+}
+}
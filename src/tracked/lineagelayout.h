@@ -0,0 +1,92 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef LINEAGELAYOUT_H
+#define LINEAGELAYOUT_H
+
+#include <memory>
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+#include "tracked/genealogy.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+/*!
+ * \brief The LineageLayout class
+ *
+ * Lays out the Tracklet%s of a Genealogy as lineage trees: every Tracklet is a
+ * bar from its first to its last Frame in a row of its own, the Tracklet%s
+ * after a division, merge or unmerge are placed in the rows below it. The
+ * Tracklet%s connected by TrackEvent%s form a Tree, which occupies
+ * consecutive rows. Leaves get a row each, a Tracklet with successors is
+ * centered between its first and last successor.
+ *
+ * update() only lays out the Tree%s again whose Tracklet%s were added, removed
+ * or changed since the last call, which is found by a fingerprint of the span
+ * and the TrackEvent%s of each Tracklet. The Tree%s are ordered by their first
+ * Frame, so a changed Tree only shifts the rows of the Tree%s after it.
+ */
+class LineageLayout
+{
+public:
+    /*! \brief the bar of one Tracklet */
+    struct Node {
+        int id;
+        int start, end;             /*!< the first and last Frame */
+        double row;                 /*!< relative to the first row of the Tree */
+        QVector<int> parents;       /*!< the Node%s of the previous Tracklet%s, as indices in the Tree */
+    };
+
+    /*! \brief the Tracklet%s connected by TrackEvent%s */
+    struct Tree {
+        QVector<Node> nodes;        /*!< ordered by their first Frame */
+        int offset;                 /*!< the first row of the Tree */
+        int rows;
+        int first, last;            /*!< the first and last Frame of all Node%s */
+        int minId;
+    };
+
+    int update(std::shared_ptr<Genealogy> const &gen);
+    void clear();
+
+    int getRows() const;
+    int getLastFrame() const;
+    QList<Tree const *> treesIn(double firstRow, double lastRow) const;
+    Node const *nodeAt(double frame, double row) const;
+
+private:
+    static quint64 fingerprint(std::shared_ptr<Tracklet> const &t);
+    static QPair<int,int> span(std::shared_ptr<Tracklet> const &t);
+    static QList<std::shared_ptr<Tracklet>> previous(std::shared_ptr<Tracklet> const &t);
+    static QList<std::shared_ptr<Tracklet>> next(std::shared_ptr<Tracklet> const &t);
+    static std::shared_ptr<Tree> layout(QList<std::shared_ptr<Tracklet>> const &members);
+
+    void drop(Tree *tree, QList<int> &members);
+
+    QList<std::shared_ptr<Tree>> trees;     /*!< ordered by their first Frame and smallest Tracklet id */
+    QHash<int, Tree *> treeOf;              /*!< the Tree of each Tracklet id */
+    QHash<int, quint64> fingerprints;
+    int rows = 0;
+    int lastFrame = -1;
+};
+}
+
+#endif // LINEAGELAYOUT_H
@@ -44,9 +44,24 @@ Tracklet::Tracklet() :
  * \brief destructs a Tracklet
  */
 Tracklet::~Tracklet() {
-    IdProvider::returnTrackletId(this->id);
+    if (!snapshot)
+        IdProvider::returnTrackletId(this->id);
 }
 
+/*!
+ * \brief constructs a copy of a Tracklet for a ProjectSnapshot
+ * \param other the Tracklet to copy
+ *
+ * The copy shares the id with other without claiming it from the IdProvider.
+ * Events and annotations are not copied, this is done by ProjectSnapshot.
+ */
+Tracklet::Tracklet(Tracklet const &other) :
+    QObject(0),
+    Annotateable(),
+    snapshot(true),
+    contained(other.contained),
+    id(other.id) {}
+
 /*!
  * \brief returns a QList of QPair%s of Frames and Objects at a certain Frame (this should only be one)
  * \param frameId the Frame
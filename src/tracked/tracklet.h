@@ -31,7 +31,7 @@
 #include "trackevent.h"
 #include "trackeventdivision.hpp"
 
-namespace TraCurate { class Tracklet; template <typename T> class TrackEvent; }
+namespace TraCurate { class Tracklet; class ProjectSnapshot; template <typename T> class TrackEvent; }
 std::ostream& operator<< (std::ostream&, TraCurate::Tracklet&);
 
 namespace TraCurate {
@@ -91,6 +91,10 @@ public:
     Q_INVOKABLE QString qmlOAnno();
 
 private:
+    friend class ProjectSnapshot;
+    Tracklet(Tracklet const &other);
+    bool snapshot = false;  /*!< copies made by ProjectSnapshot don't own their id */
+
     /*! \todo change to QHash<int, std::shared_ptr<Object>> if possible */
     QHash<uint, QPair<std::shared_ptr<Frame>,std::shared_ptr<Object>>> contained;
 
@@ -0,0 +1,523 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "trackletlinker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QtConcurrent/QtConcurrent>
+#include <QHash>
+#include <QSet>
+
+#include "base/autotracklet.h"
+#include "base/channel.h"
+#include "base/frame.h"
+#include "base/movie.h"
+#include "base/slice.h"
+#include "provider/messagerelay.h"
+#include "provider/tcsettings.h"
+#include "provider/tracer.h"
+#include "tracked/genealogy.h"
+#include "tracked/tracklet.h"
+
+namespace TraCurate {
+
+/* leaving a track unlinked costs as much as a link at the border of the search radius */
+static constexpr double NO_LINK_COST = 1.0;
+/* the cost of each Frame that a link skips */
+static constexpr double GAP_PENALTY = 0.1;
+/* the cost of impossible assignments, large but finite so the potentials stay finite */
+static constexpr double FORBIDDEN_COST = 1e9;
+/* the largest number of cells of a Grid in each direction */
+static constexpr int MAX_GRID_CELLS = 1024;
+
+/*!
+ * \brief sorts the starts of one Frame into a uniform grid
+ * \param endpoints the starts
+ * \param cellSize the side length of the cells, it is increased if the Object%s are far apart
+ */
+TrackletLinker::Grid::Grid(QVector<Endpoint> const &endpoints, double cellSize) :
+    endpoints(endpoints),
+    cellSize(cellSize),
+    x0(0),
+    y0(0),
+    cols(1),
+    rows(1)
+{
+    double x1 = 0, y1 = 0;
+    if (!endpoints.isEmpty()) {
+        x0 = x1 = endpoints.first().centroid.x();
+        y0 = y1 = endpoints.first().centroid.y();
+    }
+    for (Endpoint const &e : endpoints) {
+        x0 = std::min(x0, e.centroid.x());
+        y0 = std::min(y0, e.centroid.y());
+        x1 = std::max(x1, e.centroid.x());
+        y1 = std::max(y1, e.centroid.y());
+    }
+    this->cellSize = std::max({cellSize, (x1 - x0) / (MAX_GRID_CELLS - 1), (y1 - y0) / (MAX_GRID_CELLS - 1)});
+    cols = static_cast<int>((x1 - x0) / this->cellSize) + 1;
+    rows = static_cast<int>((y1 - y0) / this->cellSize) + 1;
+
+    /* counting sort of the endpoints by their cell */
+    std::vector<int> cells(endpoints.size());
+    first.assign(cols * rows + 1, 0);
+    for (int i = 0; i < endpoints.size(); i++) {
+        int cx = std::min(static_cast<int>((endpoints[i].centroid.x() - x0) / this->cellSize), cols - 1);
+        int cy = std::min(static_cast<int>((endpoints[i].centroid.y() - y0) / this->cellSize), rows - 1);
+        cells[i] = cy * cols + cx;
+        first[cells[i] + 1]++;
+    }
+    for (size_t c = 1; c < first.size(); c++)
+        first[c] += first[c - 1];
+    items.resize(endpoints.size());
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    for (int i = 0; i < endpoints.size(); i++)
+        items[fill[cells[i]]++] = i;
+}
+
+QVector<TrackletLinker::Endpoint> const &TrackletLinker::Grid::getEndpoints() const
+{
+    return endpoints;
+}
+
+/*!
+ * \brief finds the starts near a point
+ * \param p the point
+ * \param radius the largest distance of the centroids to p
+ * \return the indices of the starts in getEndpoints()
+ */
+std::vector<int> TrackletLinker::Grid::near(QPointF const &p, double radius) const
+{
+    std::vector<int> ret;
+    int cx0 = std::max(static_cast<int>(std::floor((p.x() - radius - x0) / cellSize)), 0);
+    int cy0 = std::max(static_cast<int>(std::floor((p.y() - radius - y0) / cellSize)), 0);
+    int cx1 = std::min(static_cast<int>(std::floor((p.x() + radius - x0) / cellSize)), cols - 1);
+    int cy1 = std::min(static_cast<int>(std::floor((p.y() + radius - y0) / cellSize)), rows - 1);
+    double r2 = radius * radius;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            int c = cy * cols + cx;
+            for (int k = first[c]; k < first[c + 1]; k++) {
+                QPointF d = endpoints[items[k]].centroid - p;
+                if (d.x() * d.x() + d.y() * d.y() <= r2)
+                    ret.push_back(items[k]);
+            }
+        }
+    }
+    return ret;
+}
+
+/*!
+ * \brief returns the first Object of the run of untracked Object%s of an AutoTracklet that contains an Object
+ * \param proj the Project
+ * \param o the Object
+ * \return the first Object of the run, o if it is in no AutoTracklet
+ */
+std::shared_ptr<Object> TrackletLinker::runStart(std::shared_ptr<Project> const &proj, std::shared_ptr<Object> const &o)
+{
+    std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+    if (!at)
+        return o;
+    QMap<int, std::shared_ptr<Object>> components = at->getComponents();
+    std::shared_ptr<Object> ret = o;
+    for (int f = static_cast<int>(o->getFrameId()) - 1; ; f--) {
+        std::shared_ptr<Object> prev = components.value(f);
+        if (!prev || prev->isInTracklet())
+            return ret;
+        ret = prev;
+    }
+}
+
+/*!
+ * \brief returns the last Object of the run of untracked Object%s of an AutoTracklet that contains an Object
+ * \param proj the Project
+ * \param o the Object
+ * \return the last Object of the run, o if it is in no AutoTracklet
+ */
+std::shared_ptr<Object> TrackletLinker::runEnd(std::shared_ptr<Project> const &proj, std::shared_ptr<Object> const &o)
+{
+    std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+    if (!at)
+        return o;
+    QMap<int, std::shared_ptr<Object>> components = at->getComponents();
+    std::shared_ptr<Object> ret = o;
+    for (int f = static_cast<int>(o->getFrameId()) + 1; ; f++) {
+        std::shared_ptr<Object> next = components.value(f);
+        if (!next || next->isInTracklet())
+            return ret;
+        ret = next;
+    }
+}
+
+/*!
+ * \brief collects the ends and starts of the tracks in a Slice and Channel
+ * \param proj the Project
+ * \param slice the Slice
+ * \param channel the Channel
+ * \return one Job per Frame in which tracks end that may be continued
+ */
+QList<TrackletLinker::Job> TrackletLinker::prepare(std::shared_ptr<Project> const &proj, int slice, int channel)
+{
+    TC_TRACE_SCOPE("TrackletLinker::prepare");
+    QList<Job> jobs;
+    if (!proj || !proj->getMovie() || !proj->getGenealogy())
+        return jobs;
+
+    double maxDistance = std::max(TCSettings::value("linking/max_distance").toDouble(), 1.0);
+    int maxGap = std::max(TCSettings::value("linking/max_gap").toInt(), 1);
+    double areaWeight = std::max(TCSettings::value("linking/area_weight").toDouble(), 0.0);
+
+    /* Tracklets with a TrackEvent are already linked on that side */
+    QSet<Object *> trackletEnds, trackletStarts;
+    std::shared_ptr<QHash<int,std::shared_ptr<Tracklet>>> tracklets = proj->getGenealogy()->getTracklets();
+    for (std::shared_ptr<Tracklet> const &t : *tracklets) {
+        if (t->getContained().isEmpty())
+            continue;
+        if (!t->getNext())
+            trackletEnds.insert(t->getEnd().second.get());
+        if (!t->getPrev())
+            trackletStarts.insert(t->getStart().second.get());
+    }
+
+    auto untrackedAt = [](std::shared_ptr<AutoTracklet> const &at, int frame) {
+        std::shared_ptr<Object> o = at ? at->getComponents().value(frame) : nullptr;
+        return o && !o->isInTracklet();
+    };
+
+    std::shared_ptr<Movie> movie = proj->getMovie();
+    QList<uint32_t> frameIds = movie->getFrames().keys();
+    std::sort(frameIds.begin(), frameIds.end());
+    QHash<uint32_t, QVector<Endpoint>> ends;
+    QHash<uint32_t, std::shared_ptr<Grid const>> starts;
+
+    for (uint32_t id : frameIds) {
+        std::shared_ptr<Frame> f = movie->getFrame(id);
+        std::shared_ptr<Slice> s = f ? f->getSlice(slice) : nullptr;
+        std::shared_ptr<Channel> c = s ? s->getChannel(channel) : nullptr;
+        if (!c)
+            continue;
+
+        FeatureTable const &features = c->getFeatures();
+        QVector<Endpoint> frameEnds, frameStarts;
+        for (std::shared_ptr<Object> const &o : c->getObjects()) {
+            bool isEnd, isStart;
+            if (o->isInTracklet()) {
+                isEnd = trackletEnds.contains(o.get());
+                isStart = trackletStarts.contains(o.get());
+            } else {
+                std::shared_ptr<AutoTracklet> at = o->isInAutoTracklet() ? proj->getAutoTracklet(o->getAutoId()) : nullptr;
+                isEnd = at && !untrackedAt(at, static_cast<int>(id) + 1);
+                isStart = !untrackedAt(at, static_cast<int>(id) - 1);
+            }
+            if (!isEnd && !isStart)
+                continue;
+
+            FeatureTable::Features ft = features.get(o->getId());
+            Endpoint e {o, ft.centroid, ft.area};
+            if (isEnd)
+                frameEnds.append(e);
+            if (isStart)
+                frameStarts.append(e);
+        }
+        if (!frameEnds.isEmpty())
+            ends.insert(id, frameEnds);
+        if (!frameStarts.isEmpty())
+            starts.insert(id, std::make_shared<Grid const>(frameStarts, maxDistance));
+    }
+
+    for (uint32_t id : frameIds) {
+        if (!ends.contains(id))
+            continue;
+        Job job;
+        job.frame = static_cast<int>(id);
+        job.sources = ends.value(id);
+        job.maxDistance = maxDistance;
+        job.areaWeight = areaWeight;
+        bool any = false;
+        for (int gap = 1; gap <= maxGap; gap++) {
+            std::shared_ptr<Grid const> g = starts.value(id + static_cast<uint32_t>(gap));
+            job.targets.append(g);
+            any = any || g;
+        }
+        if (any)
+            jobs.append(job);
+    }
+    return jobs;
+}
+
+/*!
+ * \brief links the tracks of all Job%s in the background
+ * \param jobs the Job%s
+ * \return the future of the Proposal%s of each Job
+ */
+QFuture<QVector<TrackletLinker::Proposal>> TrackletLinker::start(QList<Job> const &jobs)
+{
+    MessageRelay::emitUpdateDetailName("Linking frames");
+    MessageRelay::emitUpdateDetailMax(jobs.size());
+    return QtConcurrent::mapped(jobs, &TrackletLinker::run);
+}
+
+/*!
+ * \brief links the tracks ending in the Frame of a Job to the starts after it
+ * \param job the Job
+ * \return the Proposal%s, at most one per track
+ */
+QVector<TrackletLinker::Proposal> TrackletLinker::run(Job const &job)
+{
+    TC_TRACE_SCOPE("TrackletLinker::run");
+    struct Edge {
+        int source, target;
+        double cost;
+    };
+
+    /* the possible links, the starts get consecutive numbers after the ends */
+    int n = job.sources.size();
+    std::vector<Edge> edges;
+    std::vector<std::pair<int,int>> targets;    /* gap - 1 and index in the Grid */
+    QHash<QPair<int,int>, int> targetIds;
+    for (int i = 0; i < n; i++) {
+        Endpoint const &s = job.sources[i];
+        for (int g = 0; g < job.targets.size(); g++) {
+            Grid const *grid = job.targets[g].get();
+            if (!grid)
+                continue;
+            double radius = job.maxDistance * std::sqrt(g + 1.0);
+            for (int k : grid->near(s.centroid, radius)) {
+                Endpoint const &t = grid->getEndpoints()[k];
+                QPointF d = t.centroid - s.centroid;
+                double cost = (d.x() * d.x() + d.y() * d.y()) / (radius * radius) + GAP_PENALTY * g;
+                if (s.area > 0 && t.area > 0)
+                    cost += job.areaWeight * std::fabs(std::log(t.area / s.area));
+                if (cost >= NO_LINK_COST)
+                    continue;
+
+                QPair<int,int> key(g, k);
+                int id = targetIds.value(key, -1);
+                if (id < 0) {
+                    id = static_cast<int>(targets.size());
+                    targetIds.insert(key, id);
+                    targets.push_back(std::make_pair(g, k));
+                }
+                edges.push_back(Edge{i, n + id, cost});
+            }
+        }
+    }
+
+    /* split the graph of possible links into connected components */
+    std::vector<int> parent(n + targets.size());
+    for (size_t i = 0; i < parent.size(); i++)
+        parent[i] = static_cast<int>(i);
+    auto root = [&](int x) {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    for (Edge const &e : edges)
+        parent[root(e.source)] = root(e.target);
+
+    QHash<int, std::vector<int>> components;    /* the edges of each component */
+    for (size_t i = 0; i < edges.size(); i++)
+        components[root(edges[i].source)].push_back(static_cast<int>(i));
+
+    QVector<Proposal> ret;
+    std::vector<int> local(parent.size(), -1);
+    for (std::vector<int> const &component : components) {
+        /* number the ends and starts of the component */
+        std::vector<int> rows, cols;
+        for (int e : component) {
+            if (local[edges[e].source] < 0) {
+                local[edges[e].source] = static_cast<int>(rows.size());
+                rows.push_back(edges[e].source);
+            }
+            if (local[edges[e].target] < 0) {
+                local[edges[e].target] = static_cast<int>(cols.size());
+                cols.push_back(edges[e].target);
+            }
+        }
+
+        /* every end may also be assigned to its own column for staying unlinked */
+        int r = static_cast<int>(rows.size());
+        int c = static_cast<int>(cols.size()) + r;
+        std::vector<double> cost(static_cast<size_t>(r) * c, FORBIDDEN_COST);
+        for (int e : component)
+            cost[local[edges[e].source] * c + local[edges[e].target]] = edges[e].cost;
+        for (int i = 0; i < r; i++)
+            cost[i * c + static_cast<int>(cols.size()) + i] = NO_LINK_COST;
+
+        std::vector<int> assignment = solveAssignment(cost, r, c);
+        for (int i = 0; i < r; i++) {
+            int j = assignment[i];
+            if (j < 0 || j >= static_cast<int>(cols.size()) || cost[i * c + j] >= NO_LINK_COST)
+                continue;
+            Endpoint const &s = job.sources[rows[i]];
+            std::pair<int,int> const &t = targets[cols[j] - n];
+            Endpoint const &te = job.targets[t.first]->getEndpoints()[t.second];
+            ret.append(Proposal{s.object, te.object, s.centroid, te.centroid, t.first + 1, cost[i * c + j]});
+        }
+    }
+
+    MessageRelay::emitIncreaseDetail();
+    return ret;
+}
+
+/*!
+ * \brief finds the assignment of rows to columns with the lowest total cost
+ * \param cost the costs, row by row
+ * \param rows the number of rows
+ * \param cols the number of columns, at least rows
+ * \return the column assigned to each row
+ *
+ * This is the Hungarian method with shortest augmenting paths, it takes
+ * O(rows² · cols) steps.
+ */
+std::vector<int> TrackletLinker::solveAssignment(std::vector<double> const &cost, int rows, int cols)
+{
+    /* 1-based, column 0 and row 0 are used as the start of the augmenting paths */
+    double const inf = std::numeric_limits<double>::infinity();
+    std::vector<double> u(rows + 1, 0), v(cols + 1, 0), minv(cols + 1);
+    std::vector<int> match(cols + 1, 0), way(cols + 1, 0);
+    std::vector<char> used(cols + 1);
+
+    for (int i = 1; i <= rows; i++) {
+        match[0] = i;
+        int j0 = 0;
+        std::fill(minv.begin(), minv.end(), inf);
+        std::fill(used.begin(), used.end(), false);
+        do {
+            used[j0] = true;
+            int i0 = match[j0], j1 = 0;
+            double delta = inf;
+            for (int j = 1; j <= cols; j++) {
+                if (used[j])
+                    continue;
+                double cur = cost[(i0 - 1) * cols + j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= cols; j++) {
+                if (used[j]) {
+                    u[match[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (match[j0] != 0);
+
+        do {
+            int j1 = way[j0];
+            match[j0] = match[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    std::vector<int> ret(rows, -1);
+    for (int j = 1; j <= cols; j++)
+        if (match[j] > 0)
+            ret[match[j] - 1] = j - 1;
+    return ret;
+}
+
+/*!
+ * \brief combines the Proposal%s of all Frame%s
+ * \param results the Proposal%s of each Job
+ * \return the Proposal%s in which every start is used once, ordered by Frame
+ *
+ * A start that tracks from different Frame%s were assigned to goes to the
+ * shortest gap, then to the lowest cost.
+ */
+QList<TrackletLinker::Proposal> TrackletLinker::resolve(QList<QVector<Proposal>> const &results)
+{
+    QList<Proposal> all;
+    for (QVector<Proposal> const &r : results)
+        for (Proposal const &p : r)
+            all.append(p);
+    std::stable_sort(all.begin(), all.end(), [](Proposal const &a, Proposal const &b) {
+        return a.gap < b.gap || (a.gap == b.gap && a.cost < b.cost);
+    });
+
+    QList<Proposal> ret;
+    QSet<Object *> claimed;
+    for (Proposal const &p : all) {
+        if (claimed.contains(p.target.get()))
+            continue;
+        claimed.insert(p.target.get());
+        ret.append(p);
+    }
+    std::stable_sort(ret.begin(), ret.end(), [](Proposal const &a, Proposal const &b) {
+        return a.source->getFrameId() < b.source->getFrameId();
+    });
+    return ret;
+}
+
+/*!
+ * \brief links two tracks as proposed
+ * \param proj the Project
+ * \param proposal the Proposal
+ * \return true, if the tracks were linked, false if they changed since the Proposal was made
+ *
+ * An untracked run of an AutoTracklet that ends in the source becomes a
+ * Tracklet first. If the target starts a Tracklet, the Tracklet of the source
+ * is joined with it, otherwise the untracked run of its AutoTracklet that
+ * starts in the target is added to the Tracklet of the source.
+ */
+bool TrackletLinker::apply(std::shared_ptr<Project> const &proj, Proposal const &proposal)
+{
+    std::shared_ptr<Genealogy> gen = proj ? proj->getGenealogy() : nullptr;
+    std::shared_ptr<Object> source = proposal.source;
+    std::shared_ptr<Object> target = proposal.target;
+    if (!gen || !source || !target || target->getFrameId() <= source->getFrameId())
+        return false;
+
+    if (!source->isInTracklet()) {
+        if (runEnd(proj, source) != source || !gen->connectObjects(runStart(proj, source), source))
+            return false;
+    }
+    std::shared_ptr<Tracklet> t = gen->getTracklet(static_cast<int>(source->getTrackId()));
+    if (!t || t->getNext() || t->getEnd().second != source)
+        return false;
+
+    if (target->isInTracklet()) {
+        std::shared_ptr<Tracklet> next = gen->getTracklet(static_cast<int>(target->getTrackId()));
+        if (!next || next == t || next->getPrev() || next->getStart().second != target)
+            return false;
+        return gen->connectObjects(source, target);
+    }
+
+    std::shared_ptr<Movie> movie = proj->getMovie();
+    std::shared_ptr<Frame> from = movie->getFrame(target->getFrameId());
+    if (!from)
+        return false;
+    std::shared_ptr<AutoTracklet> at = target->isInAutoTracklet() ? proj->getAutoTracklet(target->getAutoId()) : nullptr;
+    if (at)
+        gen->allFromATBetween(t, at, from, movie->getFrame(runEnd(proj, target)->getFrameId()));
+    else
+        t->addToContained(from, target);
+    gen->changed(t);
+    return true;
+}
+}
@@ -0,0 +1,124 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef TRACKLETLINKER_H
+#define TRACKLETLINKER_H
+
+#include <memory>
+#include <vector>
+
+#include <QFuture>
+#include <QList>
+#include <QPointF>
+#include <QVector>
+
+#include "base/object.h"
+#include "project.h"
+
+namespace TraCurate {
+/*!
+ * \brief The TrackletLinker class
+ *
+ * Proposes links between the ends and starts of tracks, so the curator can
+ * accept them one by one or all at once instead of connecting the Object%s by
+ * hand. The tracks are the Tracklet%s that have no next TrackEvent and the
+ * runs of Object%s of an AutoTracklet that are not in any Tracklet yet. A
+ * track that ends in a Frame may be continued by a track that starts in one
+ * of the following linking/max_gap Frames (direct continuations and gap
+ * closing), Object%s that are in no AutoTracklet may only continue a track.
+ *
+ * The cost of a link is the squared distance of the centroids relative to
+ * the search radius, the change of the area and a penalty for every skipped
+ * Frame. The search radius is linking/max_distance, multiplied by the square
+ * root of the number of Frame%s between the Object%s. For each Frame the
+ * tracks ending in it are assigned to the starts near them by a global
+ * assignment of minimal cost (Hungarian method), in which every track may
+ * also stay unlinked. Only the connected components of the graph of possible
+ * links are solved together, which keeps dense Frame%s cheap.
+ *
+ * The Project is only read on the calling thread (prepare()), where the
+ * starts of each Frame are put into a uniform grid. The Frame%s are solved
+ * in parallel by the QtConcurrent worker pool (start()). A start that is
+ * claimed by tracks ending in different Frame%s goes to the shortest gap,
+ * then to the lowest cost (resolve()).
+ */
+class TrackletLinker
+{
+public:
+    TrackletLinker() = delete;
+
+    /*! \brief the end or the start of a track, copied from the Project */
+    struct Endpoint {
+        std::shared_ptr<Object> object;
+        QPointF centroid;
+        double area;
+    };
+
+    /*!
+     * \brief the starts of tracks in one Frame, sorted into cells of a uniform grid
+     */
+    class Grid
+    {
+    public:
+        Grid(QVector<Endpoint> const &endpoints, double cellSize);
+
+        QVector<Endpoint> const &getEndpoints() const;
+        std::vector<int> near(QPointF const &p, double radius) const;
+
+    private:
+        QVector<Endpoint> endpoints;
+        double cellSize;
+        double x0, y0;
+        int cols, rows;
+        std::vector<int> first;     /*!< the first entry of each cell in items, one more for the end */
+        std::vector<int> items;     /*!< indices into endpoints, ordered by cell */
+    };
+
+    /*! \brief everything needed to link the tracks ending in one Frame */
+    struct Job {
+        int frame;
+        QVector<Endpoint> sources;
+        QVector<std::shared_ptr<Grid const>> targets;   /*!< the starts in the following Frame%s, the next Frame first */
+        double maxDistance;     /*!< the search radius for the next Frame */
+        double areaWeight;
+    };
+
+    /*! \brief a proposed link from the end of one track to the start of another */
+    struct Proposal {
+        std::shared_ptr<Object> source;     /*!< the last Object of the track that is continued */
+        std::shared_ptr<Object> target;     /*!< the first Object of the continuation */
+        QPointF sourceCentroid;
+        QPointF targetCentroid;
+        int gap;                            /*!< the difference of the Frame%s, 1 for a direct continuation */
+        double cost;
+    };
+
+    static QList<Job> prepare(std::shared_ptr<Project> const &proj, int slice, int channel);
+    static QFuture<QVector<Proposal>> start(QList<Job> const &jobs);
+    static QVector<Proposal> run(Job const &job);
+    static QList<Proposal> resolve(QList<QVector<Proposal>> const &results);
+    static bool apply(std::shared_ptr<Project> const &proj, Proposal const &proposal);
+
+    static std::vector<int> solveAssignment(std::vector<double> const &cost, int rows, int cols);
+
+private:
+    static std::shared_ptr<Object> runStart(std::shared_ptr<Project> const &proj, std::shared_ptr<Object> const &o);
+    static std::shared_ptr<Object> runEnd(std::shared_ptr<Project> const &proj, std::shared_ptr<Object> const &o);
+};
+}
+
+#endif // TRACKLETLINKER_H
@@ -0,0 +1,486 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTransform>
+
+#include "syntheticproject.h"
+
+#include "exceptions/tcexception.h"
+#include "graphics/floodfill.h"
+#include "graphics/merge.h"
+#include "graphics/separate.h"
+#include "graphics/watershed.h"
+#include "io/exporthdf5.h"
+#include "io/importhdf5.h"
+#include "io/modifyhdf5.h"
+#include "io/projectsnapshot.h"
+#include "provider/dataprovider.h"
+#include "provider/guistate.h"
+#include "tracked/lineagelayout.h"
+#include "tracked/trackletlinker.h"
+
+using namespace TraCurate;
+
+/*!
+ * \brief runs a function multiple times and measures each run
+ * \param runs how often to run the function
+ * \param fun the function to measure, it is given the number of the run
+ * \return the durations of all runs in milliseconds
+ */
+static std::vector<double> measure(int runs, std::function<void(int)> fun) {
+    std::vector<double> samples;
+    QElapsedTimer et;
+    for (int i = 0; i < runs; i++) {
+        et.start();
+        fun(i);
+        samples.push_back(static_cast<double>(et.nsecsElapsed()) / 1e6);
+    }
+    return samples;
+}
+
+/*!
+ * \brief summarizes the samples of a scenario
+ * \param name the name of the scenario
+ * \param samples the durations of the runs in milliseconds
+ * \return a JSON object with count, min, median, mean, max and total
+ */
+static QJsonObject summarize(QString name, std::vector<double> samples) {
+    QJsonObject ret {{"name", name}, {"runs", static_cast<int>(samples.size())}};
+    if (samples.empty())
+        return ret;
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double s : samples)
+        total += s;
+    size_t mid = samples.size() / 2;
+    double median = (samples.size() % 2) ? samples[mid] : (samples[mid-1] + samples[mid]) / 2;
+    ret["min_ms"]    = samples.front();
+    ret["median_ms"] = median;
+    ret["mean_ms"]   = total / samples.size();
+    ret["max_ms"]    = samples.back();
+    ret["total_ms"]  = total;
+    std::cerr << name.toStdString() << ": median " << median << " ms over " << samples.size() << " runs" << std::endl;
+    return ret;
+}
+
+/*!
+ * \brief loads a project and makes it the current project
+ *
+ * ModifyHDF5 and DataProvider look up the current project in GUIState, so
+ * every scenario that uses them needs to go through this function.
+ */
+static std::shared_ptr<Project> load(QString fileName) {
+    std::shared_ptr<Project> proj = ImportHDF5().load(fileName);
+    GUIState::getInstance()->setProj(proj);
+    return proj;
+}
+
+/*!
+ * \brief merges outlines and checks the result
+ * \param name the name of the check, printed if it fails
+ * \param outlines the outlines to merge
+ * \param minArea the smallest area the merged outline may have
+ * \param maxArea the largest area the merged outline may have
+ * \return true, if Merge did not fall back to QPolygonF::united and the area is in range
+ */
+static bool checkMerge(QString name, QList<QPolygonF> const &outlines, double minArea, double maxArea) {
+    bool fallback;
+    double area = FeatureTable::compute(Merge::compute(outlines, fallback)).area;
+    if (!fallback && minArea <= area && area <= maxArea)
+        return true;
+    std::cerr << "merge check " << name.toStdString() << " failed: area " << area
+              << (fallback ? ", fell back to QPolygonF::united" : "") << std::endl;
+    return false;
+}
+
+/*!
+ * \brief merges outlines for which Merge is known to fall back to QPolygonF::united
+ * \param name the name of the check
+ * \param outlines the outlines to merge
+ * \return always true, a known failure does not fail the checks
+ *
+ * Prints a note once the fallback is gone, the case can then become a regular check.
+ */
+static bool checkKnownFallback(QString name, QList<QPolygonF> const &outlines) {
+    bool fallback;
+    Merge::compute(outlines, fallback);
+    if (!fallback)
+        std::cerr << "merge check " << name.toStdString() << " no longer falls back to QPolygonF::united" << std::endl;
+    return true;
+}
+
+/*!
+ * \brief generates random star-shaped outlines on the grid of Merge (1/8 pixel)
+ * \param index the number of the case in the sequence of seed 1
+ * \return the outlines of that case, two to four with 5 to 44 vertices each
+ */
+static QList<QPolygonF> randomMergeCase(int index) {
+    std::mt19937 rng(1);
+    QList<QPolygonF> outlines;
+    for (int t = 0; t <= index; t++) {
+        outlines.clear();
+        int k = 2 + static_cast<int>(rng() % 3);
+        for (int i = 0; i < k; i++) {
+            int n = 5 + static_cast<int>(rng() % 40);
+            double cx = 50 + rng() % 60;
+            double cy = 50 + rng() % 60;
+            double radius = 5 + rng() % 30;
+            QPolygonF outline;
+            for (int j = 0; j < n; j++) {
+                double a = 2 * M_PI * j / n;
+                double r = radius * (0.6 + 0.4 * (rng() % 1000) / 1000.0);
+                outline.append(QPointF(std::llround((cx + r * std::cos(a)) * 8) / 8.0,
+                                       std::llround((cy + r * std::sin(a)) * 8) / 8.0));
+            }
+            outlines.append(outline);
+        }
+    }
+    return outlines;
+}
+
+/*!
+ * \brief merges outlines with known results, e.g. crossings that have to be snap rounded
+ * \return true, if all checks passed
+ */
+static bool checkMergeCases() {
+    auto square = [](double x, double y, double size) { return QPolygonF(QRectF(x, y, size, size)); };
+    bool ok = true;
+    ok = checkMerge("overlapping", {square(0, 0, 10), square(5, 5, 10)}, 175, 175) && ok;
+    ok = checkMerge("adjacent", {square(0, 0, 10), square(10, 0, 10)}, 200, 200) && ok;
+    ok = checkMerge("contained", {square(0, 0, 10), square(2, 2, 4)}, 100, 100) && ok;
+    ok = checkMerge("disjoint", {square(0, 0, 10), square(20, 0, 10)}, 300, 300) && ok;
+    ok = checkMerge("gap_below_grid", {square(0, 0, 10), square(10.05, 0, 10)}, 199, 202) && ok;
+
+    /* thin slivers through one point, crossing each other between the grid points */
+    QList<QPolygonF> fan;
+    QPolygonF reference;
+    for (int i = 0; i < 12; i++) {
+        QTransform t;
+        t.translate(100, 100);
+        t.rotateRadians(0.013 * i + 0.001);
+        QPolygonF sliver = t.map(QPolygonF(QRectF(-60, -0.75, 120, 1.5)));
+        fan.append(sliver);
+        reference = reference.united(sliver);
+    }
+    double area = FeatureTable::compute(reference).area;
+    ok = checkMerge("fan", fan, 0.98 * area, 1.02 * area) && ok;
+
+    /* known failures: out of 100000 random cases, in these two iterated snap
+     * rounding moves a vertex about 2.2 units, beyond the tolerance of
+     * PolygonUnion::covers */
+    ok = checkKnownFallback("random_94663", randomMergeCase(94663)) && ok;
+    ok = checkKnownFallback("random_96175", randomMergeCase(96175)) && ok;
+    return ok;
+}
+
+static std::shared_ptr<Channel> firstChannel(std::shared_ptr<Project> proj, uint32_t frame) {
+    return proj->getMovie()->getFrame(frame)->getSlice(0)->getChannel(0);
+}
+
+static uint32_t nextObjectId(std::shared_ptr<Channel> chan) {
+    uint32_t max = 0;
+    for (uint32_t id : chan->getObjects().keys())
+        max = std::max(max, id);
+    return max + 1;
+}
+
+__attribute__((noreturn)) static void usage(char *argv[]) {
+    std::cerr << "Usage:" << std::endl
+              << "\t" << argv[0] << " [options]" << std::endl
+              << std::endl
+              << "Generates a synthetic project, runs all scenarios on it and prints the results as JSON." << std::endl
+              << "The results of Merge are checked as well, the exit status is 1 if a check failed." << std::endl
+              << std::endl
+              << "Options (default in brackets):" << std::endl
+              << "\t--frames N\tnumber of frames [50]" << std::endl
+              << "\t--objects N\tobjects per frame [100]" << std::endl
+              << "\t--vertices N\tvertices per outline [64]" << std::endl
+              << "\t--tracklets N\tnumber of tracklets [20]" << std::endl
+              << "\t--width N\timage width [512]" << std::endl
+              << "\t--height N\timage height [512]" << std::endl
+              << "\t--seed N\tseed of the generator [42]" << std::endl
+              << "\t--repeat N\trepetitions of whole-project scenarios [5]" << std::endl
+              << "\t--hovers N\tnumber of hover queries [10000]" << std::endl
+              << "\t--edits N\tnumber of cut/merge/flood fill edits [20]" << std::endl
+              << "\t--workdir DIR\tdirectory for the generated files [system temp dir]" << std::endl
+              << "\t--commit ID\tcommit to tag the results with" << std::endl
+              << "\t--keep\t\tdo not delete the generated files" << std::endl;
+    exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+
+    SyntheticProject::Spec spec {50, 100, 64, 20, 512, 512, 42};
+    int repeat = 5;
+    int hovers = 10000;
+    int edits = 20;
+    QString workDir = QDir::tempPath();
+    QString commit;
+    bool keep = false;
+
+    for (int i = 0; i < args.size(); i++) {
+        QString a = args[i];
+        if (a == "--keep") {
+            keep = true;
+            continue;
+        }
+        if (i + 1 >= args.size())
+            usage(argv);
+        QString v = args[++i];
+        bool ok = true;
+        if      (a == "--frames")    spec.frames = v.toUInt(&ok);
+        else if (a == "--objects")   spec.objects = v.toUInt(&ok);
+        else if (a == "--vertices")  spec.vertices = v.toUInt(&ok);
+        else if (a == "--tracklets") spec.tracklets = v.toUInt(&ok);
+        else if (a == "--width")     spec.width = v.toUInt(&ok);
+        else if (a == "--height")    spec.height = v.toUInt(&ok);
+        else if (a == "--seed")      spec.seed = v.toUInt(&ok);
+        else if (a == "--repeat")    repeat = v.toInt(&ok);
+        else if (a == "--hovers")    hovers = v.toInt(&ok);
+        else if (a == "--edits")     edits = v.toInt(&ok);
+        else if (a == "--workdir")   workDir = v;
+        else if (a == "--commit")    commit = v;
+        else usage(argv);
+        if (!ok)
+            usage(argv);
+    }
+
+    QDir wd(workDir);
+    QString projFile = wd.filePath("tc-benchmark.h5");
+    QString editFile = wd.filePath("tc-benchmark-edit.h5");
+    QString saveFile = wd.filePath("tc-benchmark-save.h5");
+    std::mt19937 rng(spec.seed);
+    QJsonArray scenarios;
+    bool checksPassed = true;
+
+    try {
+        scenarios.append(summarize("generate", measure(1, [&](int) { SyntheticProject::generate(projFile, spec); })));
+
+        scenarios.append(summarize("validate", measure(repeat, [&](int) {
+            if (!Validator::validTraCurateFile(projFile, true, true, true))
+                throw TCException();
+        })));
+
+        scenarios.append(summarize("load_full", measure(repeat, [&](int) { load(projFile); })));
+
+        /* until loading is lazy, the first frame is only available after the full load */
+        scenarios.append(summarize("first_frame", measure(repeat, [&](int) {
+            load(projFile);
+            ImportHDF5().requestImage(projFile, 0, 0, 0);
+        })));
+
+        scenarios.append(summarize("request_image_scrub", measure(static_cast<int>(spec.frames), [&](int f) {
+            ImportHDF5().requestImage(projFile, f, 0, 0);
+        })));
+
+        std::shared_ptr<Project> proj = load(projFile);
+        {
+            std::uniform_int_distribution<uint32_t> frameDist(0, spec.frames - 1);
+            std::uniform_real_distribution<double> xDist(0, spec.width);
+            std::uniform_real_distribution<double> yDist(0, spec.height);
+            std::vector<std::tuple<int,double,double>> queries;
+            for (int i = 0; i < hovers; i++)
+                queries.push_back(std::make_tuple(frameDist(rng), xDist(rng), yDist(rng)));
+            DataProvider::getInstance()->setScaleFactor(1.0);
+            scenarios.append(summarize("cell_at_frame_hover", measure(hovers, [&](int i) {
+                DataProvider::getInstance()->cellAtFrame(std::get<0>(queries[i]), 0, 0, std::get<1>(queries[i]), std::get<2>(queries[i]));
+            })));
+        }
+
+        {
+            std::shared_ptr<QImage> img = ImportHDF5().requestImage(projFile, 0, 0, 0);
+            RawImage raw = ImportHDF5().requestRawImage(projFile, 0, 0, 0);
+            QList<std::shared_ptr<Object>> objs = firstChannel(proj, 0)->getObjects().values();
+            scenarios.append(summarize("flood_fill", measure(std::min(edits, objs.size()), [&](int i) {
+                FloodFill ff(*img, 1);
+                ff.compute(*objs[i]->getCentroid(), 50);
+            })));
+
+            /* two seeds left and right of the centroid, like two clicks of the user */
+            scenarios.append(summarize("watershed_split", measure(std::min(edits, objs.size()), [&](int i) {
+                QRectF bb = objs[i]->getOutline()->boundingRect();
+                QPointF c = bb.center();
+                QList<QPointF> seeds {c - QPointF(bb.width() / 4, 0), c + QPointF(bb.width() / 4, 0)};
+                Watershed::compute(raw, *objs[i]->getOutline(), seeds);
+            })));
+        }
+
+        {
+            /* the outlines of the first objects of a frame, merged without modifying the file */
+            int n = std::min(edits, static_cast<int>(spec.frames));
+            std::vector<QList<QPolygonF>> pairs, quads;
+            for (int i = 0; i < n; i++) {
+                QList<QPolygonF> outlines;
+                std::shared_ptr<Channel> chan = firstChannel(proj, i);
+                for (uint32_t id = 0; id < 4; id++)
+                    if (std::shared_ptr<Object> o = chan->getObject(id))
+                        outlines.append(*o->getOutline());
+                pairs.push_back(outlines.mid(0, 2));
+                quads.push_back(outlines);
+            }
+            scenarios.append(summarize("merge_compute_2", measure(n, [&](int i) { Merge::compute(pairs[i]); })));
+            scenarios.append(summarize("merge_compute_4", measure(n, [&](int i) { Merge::compute(quads[i]); })));
+
+            /* regression check, the merged outline covers the largest outline */
+            checksPassed = checkMergeCases() && checksPassed;
+            for (int i = 0; i < n; i++) {
+                double largest = 0;
+                for (QPolygonF const &outline : quads[i])
+                    largest = std::max(largest, FeatureTable::compute(outline).area);
+                checksPassed = checkMerge(QString("frame_%1").arg(i), quads[i], 0.99 * largest, std::numeric_limits<double>::max()) && checksPassed;
+            }
+        }
+
+        {
+            /* a zigzag across the first object of a frame, cut without modifying the file */
+            int n = std::min(edits, static_cast<int>(spec.frames));
+            std::vector<QPolygonF> outlines, scribbles;
+            for (int i = 0; i < n; i++) {
+                std::shared_ptr<Object> o = firstChannel(proj, i)->getObject(0);
+                QPolygonF outline = o ? *o->getOutline() : QPolygonF();
+                QRectF bb = outline.boundingRect();
+                QPolygonF scribble;
+                for (int k = 0; k <= 8; k++)
+                    scribble << QPointF(bb.left() - 1 + (bb.width() + 2) * k / 8, (k % 2) ? bb.top() - 1 : bb.bottom() + 1);
+                outlines.push_back(outline);
+                scribbles.push_back(scribble);
+            }
+            scenarios.append(summarize("cut_compute_polyline", measure(n, [&](int i) { Separate::compute(outlines[i], scribbles[i]); })));
+        }
+
+        /* proposing links for all frames, without applying them */
+        scenarios.append(summarize("link_propose", measure(repeat, [&](int) {
+            QList<TrackletLinker::Job> jobs = TrackletLinker::prepare(proj, 0, 0);
+            TrackletLinker::resolve(TrackletLinker::start(jobs).results());
+        })));
+
+        scenarios.append(summarize("lineage_layout", measure(repeat, [&](int) {
+            LineageLayout layout;
+            layout.update(proj->getGenealogy());
+        })));
+
+        /* the edits modify the file, so they work on a copy */
+        QFile::remove(editFile);
+        QFile::copy(projFile, editFile);
+        proj = load(editFile);
+
+        scenarios.append(summarize("cut_edit", measure(std::min(edits, static_cast<int>(spec.frames)), [&](int i) {
+            std::shared_ptr<Channel> chan = firstChannel(proj, i);
+            std::shared_ptr<Object> cuttee = chan->getObject(0);
+            QRectF bb = cuttee->getOutline()->boundingRect();
+            QLineF line(bb.left() - 1, bb.center().y(), bb.right() + 1, bb.center().y());
+            QPair<QPolygonF,QPolygonF> res = Separate::compute(*cuttee->getOutline(), line);
+
+            uint32_t id = nextObjectId(chan);
+            auto o1 = std::make_shared<Object>(id, chan);
+            auto o2 = std::make_shared<Object>(id + 1, chan);
+            o1->setOutline(std::make_shared<QPolygonF>(res.first));
+            o2->setOutline(std::make_shared<QPolygonF>(res.second));
+            FeatureTable::Features f1 = FeatureTable::compute(res.first);
+            FeatureTable::Features f2 = FeatureTable::compute(res.second);
+            o1->setBoundingBox(std::make_shared<QRect>(f1.boundingBox.toRect()));
+            o2->setBoundingBox(std::make_shared<QRect>(f2.boundingBox.toRect()));
+            o1->setCentroid(std::make_shared<QPoint>(f1.centroid.toPoint()));
+            o2->setCentroid(std::make_shared<QPoint>(f2.centroid.toPoint()));
+            ModifyHDF5::replaceObjects(editFile, cuttee, {o1, o2});
+            chan->removeObject(cuttee->getId());
+            chan->addObject(o1);
+            chan->addObject(o2);
+        })));
+
+        scenarios.append(summarize("merge_edit", measure(std::min(edits, static_cast<int>(spec.frames)), [&](int i) {
+            std::shared_ptr<Channel> chan = firstChannel(proj, i);
+            std::shared_ptr<Object> first = chan->getObject(1);
+            std::shared_ptr<Object> second = chan->getObject(2);
+            if (!first || !second)
+                return;
+            QPolygonF p1(*first->getOutline());
+            QPolygonF p2(*second->getOutline());
+            QPolygonF merged = Merge::compute(p1, p2);
+
+            auto m = std::make_shared<Object>(nextObjectId(chan), chan);
+            m->setOutline(std::make_shared<QPolygonF>(merged));
+            FeatureTable::Features f = FeatureTable::compute(merged);
+            m->setBoundingBox(std::make_shared<QRect>(f.boundingBox.toRect()));
+            m->setCentroid(std::make_shared<QPoint>(f.centroid.toPoint()));
+            ModifyHDF5::replaceObjects(editFile, {first, second}, m);
+            chan->removeObject(first->getId());
+            chan->removeObject(second->getId());
+            chan->addObject(m);
+        })));
+
+        /* the time the GUI thread is blocked before a background save can start */
+        scenarios.append(summarize("save_snapshot", measure(repeat, [&](int) {
+            ProjectSnapshot::create(proj);
+        })));
+
+        /* saving to the file the project was loaded from only writes the tracking data */
+        scenarios.append(summarize("save_incremental", measure(repeat, [&](int) {
+            ExportHDF5().save(proj, editFile);
+        })));
+
+        scenarios.append(summarize("save_full", measure(repeat, [&](int) {
+            ExportHDF5().save(proj, saveFile);
+            proj->setFileName(editFile);
+        })));
+    } catch (TCException &e) {
+        std::cerr << "benchmark failed: " << e.what() << std::endl;
+        return 1;
+    } catch (H5::Exception &e) {
+        std::cerr << "benchmark failed: " << e.getDetailMsg() << std::endl;
+        return 1;
+    }
+
+    if (!keep) {
+        QFile::remove(projFile);
+        QFile::remove(editFile);
+        QFile::remove(saveFile);
+    }
+
+    QJsonObject result {
+        {"commit", commit},
+        {"spec", QJsonObject{
+             {"frames",    static_cast<int>(spec.frames)},
+             {"objects",   static_cast<int>(spec.objects)},
+             {"vertices",  static_cast<int>(spec.vertices)},
+             {"tracklets", static_cast<int>(spec.tracklets)},
+             {"width",     static_cast<int>(spec.width)},
+             {"height",    static_cast<int>(spec.height)},
+             {"seed",      static_cast<int>(spec.seed)}}},
+        {"scenarios", scenarios},
+        {"checks_passed", checksPassed}};
+    std::cout << QJsonDocument(result).toJson(QJsonDocument::Indented).toStdString();
+    return checksPassed ? 0 : 1;
+}
@@ -0,0 +1,469 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <H5Cpp.h>
+
+#include "exceptions/tcexception.h"
+#include "exceptions/tcexportexception.h"
+#include "io/exportcsv.h"
+#include "io/exportctc.h"
+#include "io/exporthdf5.h"
+#include "io/importhdf5.h"
+#include "io/importlabels.h"
+#include "io/importxml.h"
+#include "provider/guistate.h"
+#include "provider/messagerelay.h"
+#include "provider/tracer.h"
+
+using namespace TraCurate;
+
+/*!
+ * \brief writes one JSON object as a single line to stderr
+ * \param obj the object to write
+ *
+ * All machine-readable output of tracurate-cli (progress, timings, errors)
+ * goes to stderr, one object per line, so it can be consumed by line-based
+ * tools on the compute nodes. Results (e.g. of stats) go to stdout.
+ * Workers of validate, import and export report concurrently, so the lines
+ * are written one at a time.
+ */
+static void report(QJsonObject obj) {
+    static std::mutex reportMtx;
+    QByteArray line = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    std::lock_guard<std::mutex> lock(reportMtx);
+    std::cerr << line.toStdString() << std::endl;
+}
+
+/*!
+ * \brief The CliProgress class
+ *
+ * Subscribes to the MessageRelay signals that the io-layer emits and turns
+ * them into JSON progress lines instead of updating the status window.
+ *
+ * The signals are emitted from the QtConcurrent workers and the commands
+ * block the main thread, so queued connections would only be delivered
+ * after the command finished. The slots run directly on the emitting
+ * threads instead and share the state under a mutex.
+ */
+class CliProgress
+{
+public:
+    CliProgress() {
+        MessageRelay *mr = MessageRelay::getInstance();
+        QObject::connect(mr, &MessageRelay::updateOverallName, [this](QString n) {
+            std::lock_guard<std::mutex> lock(mtx);
+            overallName = n; overallCurr = 0; emitProgress("overall");
+        });
+        QObject::connect(mr, &MessageRelay::updateOverallMax,  [this](int m) {
+            std::lock_guard<std::mutex> lock(mtx);
+            overallMax = m;
+        });
+        QObject::connect(mr, &MessageRelay::increaseOverall,   [this]() {
+            std::lock_guard<std::mutex> lock(mtx);
+            overallCurr++; emitProgress("overall");
+        });
+        QObject::connect(mr, &MessageRelay::updateDetailName,  [this](QString n) {
+            std::lock_guard<std::mutex> lock(mtx);
+            detailName = n; detailCurr = 0; emitProgress("detail");
+        });
+        QObject::connect(mr, &MessageRelay::updateDetailMax,   [this](int m) {
+            std::lock_guard<std::mutex> lock(mtx);
+            detailMax = m; detailCurr = 0;
+        });
+        /* detail progress is rate limited by the MessageRelay, so report every update */
+        QObject::connect(mr, &MessageRelay::detailProgress,    [this](int c, int m, double perSecond, double eta) {
+            std::lock_guard<std::mutex> lock(mtx);
+            detailCurr = c;
+            detailMax = m;
+            report(QJsonObject{
+                       {"event", "progress"},
+                       {"level", "detail"},
+                       {"name",  detailName},
+                       {"value", detailCurr},
+                       {"max",   detailMax},
+                       {"per_second", perSecond},
+                       {"eta_s", eta}});
+        });
+    }
+
+private:
+    /* expects mtx to be held */
+    void emitProgress(QString level) {
+        bool overall = (level == "overall");
+        report(QJsonObject{
+                   {"event", "progress"},
+                   {"level", level},
+                   {"name",  overall ? overallName : detailName},
+                   {"value", overall ? overallCurr : detailCurr},
+                   {"max",   overall ? overallMax  : detailMax}});
+    }
+
+    std::mutex mtx;
+    QString overallName;
+    int overallMax = 0;
+    int overallCurr = 0;
+    QString detailName;
+    int detailMax = 0;
+    int detailCurr = 0;
+};
+
+/*!
+ * \brief reports wrongly used arguments
+ * \param message what was expected
+ * \return the exit code for wrong usage
+ */
+static int badArguments(QString message) {
+    report(QJsonObject{{"event", "error"}, {"message", message}});
+    return -1;
+}
+
+/*!
+ * \brief runs a step and reports the time it took
+ * \param step the name of the step
+ * \param fun the function implementing the step
+ */
+static void timed(QString step, std::function<void()> fun) {
+    QElapsedTimer et;
+    et.start();
+    fun();
+    report(QJsonObject{{"event", "timing"}, {"step", step}, {"ms", static_cast<double>(et.nsecsElapsed()) / 1e6}});
+}
+
+/* set by --labels, the label images to take the objects of a project directory from */
+static QString labelImages;
+
+static std::shared_ptr<Project> loadProject(QString fileName) {
+    std::shared_ptr<Project> proj;
+    timed("load", [&]() {
+        QDir dir(fileName);
+        if (dir.exists() && (!labelImages.isEmpty() || (!dir.exists("xml") && dir.exists("labels"))))
+            proj = ImportLabels(labelImages).load(fileName);
+        else if (dir.exists())
+            proj = ImportXML().load(fileName);
+        else
+            proj = ImportHDF5().load(fileName);
+    });
+    /* some parts of the io-layer look up the current project in GUIState */
+    GUIState::getInstance()->setProj(proj);
+    return proj;
+}
+
+/*!
+ * \brief converts an XML project directory (or an HDF5 file) to a new HDF5 file
+ *
+ * The objects of a project directory are read from label images instead of
+ * its xml directory if --labels is given or it only has a labels directory.
+ */
+static int cmdConvert(QStringList args) {
+    if (args.size() != 2)
+        return badArguments("convert expects <input> <output.h5>");
+    std::shared_ptr<Project> proj = loadProject(args[0]);
+    timed("save", [&]() { ExportHDF5().save(proj, args[1]); });
+    return 0;
+}
+
+/*!
+ * \brief validates one or more HDF5 files, reporting the findings as they are found
+ *
+ * Each file is checked on up to --threads threads (if HDF5 is thread-safe),
+ * the files themselves are checked one after another. With --fail-fast a file
+ * is only checked until its first error.
+ */
+static int cmdValidate(QStringList args) {
+    Validator::Options options;
+    options.stopAtFirstError = args.removeAll("--fail-fast") > 0;
+    options.threads = QThreadPool::globalInstance()->maxThreadCount();
+    if (args.isEmpty())
+        return badArguments("validate expects at least one <file.h5>");
+    int ret = 0;
+    for (QString fn : args) {
+        bool valid = false;
+        options.report = [fn](Validator::Finding const &f) {
+            report(QJsonObject{{"event", "finding"}, {"file", fn},
+                               {"severity", (f.severity == Validator::Finding::ERROR) ? "error" : "warning"},
+                               {"path", QString::fromStdString(f.path)}, {"message", QString::fromStdString(f.message)}});
+        };
+        timed("validate", [&]() { valid = Validator::validTraCurateFile(fn, options); });
+        report(QJsonObject{{"event", "result"}, {"file", fn}, {"valid", valid}});
+        if (!valid)
+            ret = 1;
+    }
+    return ret;
+}
+
+/*!
+ * \brief prints statistics about a project as JSON to stdout
+ *
+ * Once the project is in memory, the per-frame counts are gathered in
+ * parallel on the global QThreadPool.
+ */
+static int cmdStats(QStringList args) {
+    if (args.size() != 1)
+        return badArguments("stats expects <file.h5>");
+    std::shared_ptr<Project> proj = loadProject(args[0]);
+
+    struct Counts { qint64 slices; qint64 channels; qint64 objects; qint64 outlinePoints; qint64 inTracklet; double area; };
+    Counts total {0, 0, 0, 0, 0, 0};
+    timed("stats", [&]() {
+        QList<std::shared_ptr<Frame>> frames = proj->getMovie()->getFrames().values();
+        std::function<Counts(const std::shared_ptr<Frame>&)> count = [](const std::shared_ptr<Frame> &f) {
+            Counts c {0, 0, 0, 0, 0, 0};
+            for (std::shared_ptr<Slice> s : f->getSlices()) {
+                c.slices++;
+                for (std::shared_ptr<Channel> ch : s->getChannels()) {
+                    c.channels++;
+                    for (double a : ch->getFeatures().getAreas())
+                        c.area += a;
+                    for (std::shared_ptr<Object> o : ch->getObjects()) {
+                        c.objects++;
+                        if (o->getOutline())
+                            c.outlinePoints += o->getOutline()->size();
+                        if (o->isInTracklet())
+                            c.inTracklet++;
+                    }
+                }
+            }
+            return c;
+        };
+        std::function<void(Counts&, const Counts&)> sum = [](Counts &t, const Counts &c) {
+            t.slices += c.slices; t.channels += c.channels; t.objects += c.objects;
+            t.outlinePoints += c.outlinePoints; t.inTracklet += c.inTracklet; t.area += c.area;
+        };
+        total = QtConcurrent::blockingMappedReduced<Counts>(frames, count, sum);
+    });
+
+    std::shared_ptr<Genealogy> gen = proj->getGenealogy();
+    QJsonObject stats {
+        {"file",          args[0]},
+        {"frames",        proj->getMovie()->getFrames().size()},
+        {"slices",        total.slices},
+        {"channels",      total.channels},
+        {"objects",       total.objects},
+        {"outlinePoints", total.outlinePoints},
+        {"trackedObjects",total.inTracklet},
+        {"meanObjectArea",total.objects ? total.area / total.objects : 0.0},
+        {"autotracklets", proj->getAutoTracklets().size()},
+        {"tracklets",     gen->getTracklets()->size()},
+        {"annotations",   gen->getAnnotations()->size()}};
+    std::cout << QJsonDocument(stats).toJson(QJsonDocument::Indented).toStdString();
+    return 0;
+}
+
+static herr_t repackLink(hid_t group_id, const char *name, const H5L_info_t *info, void *op_data) {
+    hid_t dst = *static_cast<hid_t*>(op_data);
+    if (info->type == H5L_TYPE_HARD)
+        return H5Ocopy(group_id, name, dst, name, H5P_DEFAULT, H5P_DEFAULT);
+
+    /* soft links are recreated verbatim */
+    H5L_info_t li;
+    if (H5Lget_info(group_id, name, &li, H5P_DEFAULT) < 0)
+        return -1;
+    std::vector<char> target(li.u.val_size);
+    if (H5Lget_val(group_id, name, target.data(), target.size(), H5P_DEFAULT) < 0)
+        return -1;
+    return H5Lcreate_soft(target.data(), dst, name, H5P_DEFAULT, H5P_DEFAULT);
+}
+
+/*!
+ * \brief copies all objects of a file into a fresh file
+ *
+ * HDF5 does not give back space of deleted objects, so files that were edited
+ * a lot grow. Copying everything into a new file reclaims that space.
+ */
+static int cmdRepack(QStringList args) {
+    if (args.size() != 2)
+        return badArguments("repack expects <input.h5> <output.h5>");
+    qint64 before = QFileInfo(args[0]).size();
+    timed("repack", [&]() {
+        H5::H5File in(args[0].toStdString(), H5F_ACC_RDONLY);
+        H5::H5File out(args[1].toStdString(), H5F_ACC_TRUNC);
+        hid_t outId = out.getId();
+        if (H5Literate(in.getId(), H5_INDEX_NAME, H5_ITER_INC, nullptr, repackLink, &outId) < 0)
+            throw TCExportException("copying the contents of " + args[0].toStdString() + " failed");
+    });
+    report(QJsonObject{{"event", "result"}, {"file", args[1]}, {"bytesBefore", before}, {"bytesAfter", QFileInfo(args[1]).size()}});
+    return 0;
+}
+
+/*! \brief the options of the export command */
+struct ExportOptions {
+    QStringList without;    /*!< the parts of the project to leave out of an HDF5 file */
+    QString format;         /*!< h5, csv, tsv or ctc */
+    uint32_t slice;         /*!< the slice exported by ctc */
+    uint32_t channel;       /*!< the channel exported by ctc */
+};
+
+/*!
+ * \brief saves (parts of) a project to a new HDF5 file or exports it for analysis
+ *
+ * The formats csv, tsv and ctc write into a directory, see ExportCSV and
+ * ExportCTC. They stream the project frame by frame, using the global
+ * QThreadPool.
+ */
+static int cmdExport(QStringList args, ExportOptions const &eo) {
+    if (args.size() != 2)
+        return badArguments("export expects <input> <output>");
+    if (eo.format == "csv" || eo.format == "tsv") {
+        std::shared_ptr<Project> proj = loadProject(args[0]);
+        timed("export", [&]() { ExportCSV(eo.format == "tsv" ? '\t' : ',').save(proj, args[1]); });
+        return 0;
+    }
+    if (eo.format == "ctc") {
+        std::shared_ptr<Project> proj = loadProject(args[0]);
+        timed("export", [&]() { ExportCTC(eo.slice, eo.channel).save(proj, args[1]); });
+        return 0;
+    }
+    if (eo.format != "h5")
+        return badArguments("unknown export format " + eo.format);
+
+    Export::SaveOptions so {!eo.without.contains("annotations"),
+                            !eo.without.contains("autotracklets"),
+                            !eo.without.contains("events"),
+                            !eo.without.contains("images"),
+                            true,
+                            true,
+                            !eo.without.contains("tracklets")};
+    std::shared_ptr<Project> proj = loadProject(args[0]);
+    if (QFileInfo::exists(args[1]))
+        QFile::remove(args[1]);
+    timed("save", [&]() { ExportHDF5().save(proj, args[1], so); });
+    return 0;
+}
+
+__attribute__((noreturn)) static void usage(char *argv[]) {
+    std::cerr << "Usage:" << std::endl
+              << "\t" << argv[0] << " [--threads N] [--swmr] [--trace file.json] command [args]" << std::endl
+              << std::endl
+              << "Commands:" << std::endl
+              << "\tconvert  input output.h5\tconvert an XML project directory or HDF5 file to HDF5," << std::endl
+              << "\t\t\t\t\tthe objects of the directory may come from --labels" << std::endl
+              << "\tvalidate file.h5 [...] [--fail-fast]" << std::endl
+              << "\t\t\t\t\tcheck that the files are valid TraCurate projects," << std::endl
+              << "\t\t\t\t\tstopping at the first error of a file with --fail-fast" << std::endl
+              << "\tstats    file.h5\t\tprint statistics about a project to stdout" << std::endl
+              << "\trepack   input.h5 output.h5\tcopy a project to a new file, reclaiming unused space" << std::endl
+              << "\texport   input output.h5 [--without part[,part]]" << std::endl
+              << "\t\t\t\t\tsave a project to a new file, leaving out annotations," << std::endl
+              << "\t\t\t\t\tautotracklets, events, images or tracklets" << std::endl
+              << "\texport   input dir --format csv|tsv|ctc [--slice N] [--channel N]" << std::endl
+              << "\t\t\t\t\twrite tables of the objects and tracklets (csv, tsv) or" << std::endl
+              << "\t\t\t\t\tCell Tracking Challenge masks and tracks of one slice" << std::endl
+              << "\t\t\t\t\tand channel (ctc, default 0 and 0) to a directory" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "\t--threads N\tuse at most N worker threads (default: number of cores)" << std::endl
+              << "\t--swmr\t\topen the input files as SWMR reader, e.g. while they are curated" << std::endl
+              << "\t--trace file\twrite a Chrome trace of the run (needs a build with CONFIG+=tracing)" << std::endl
+              << "\t--labels src\ttake the objects of a project directory from label images: a directory" << std::endl
+              << "\t\t\tof TIFF or PNG files or file.h5:/dataset (default: its labels directory," << std::endl
+              << "\t\t\tif it has no xml directory)" << std::endl
+              << std::endl
+              << "Progress, timings and errors are written as JSON lines to stderr." << std::endl;
+    exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments().mid(1);
+    ExportOptions eo {QStringList(), "h5", 0, 0};
+    QString traceFile;
+
+    for (int i = 0; i < args.size(); ) {
+        if (args[i] == "--threads" && i + 1 < args.size()) {
+            bool ok;
+            int n = args[i+1].toInt(&ok);
+            if (!ok || n < 1)
+                usage(argv);
+            QThreadPool::globalInstance()->setMaxThreadCount(n);
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else if (args[i] == "--swmr") {
+            ImportHDF5::setSwmrRead(true);
+            args.removeAt(i);
+        } else if (args[i] == "--trace" && i + 1 < args.size()) {
+            traceFile = args[i+1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else if (args[i] == "--without" && i + 1 < args.size()) {
+            eo.without.append(args[i+1].split(",", QString::SkipEmptyParts));
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else if (args[i] == "--labels" && i + 1 < args.size()) {
+            labelImages = args[i+1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else if (args[i] == "--format" && i + 1 < args.size()) {
+            eo.format = args[i+1];
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else if ((args[i] == "--slice" || args[i] == "--channel") && i + 1 < args.size()) {
+            bool ok;
+            uint n = args[i+1].toUInt(&ok);
+            if (!ok)
+                usage(argv);
+            (args[i] == "--slice" ? eo.slice : eo.channel) = n;
+            args.erase(args.begin() + i, args.begin() + i + 2);
+        } else {
+            i++;
+        }
+    }
+    if (args.isEmpty())
+        usage(argv);
+
+    QString cmd = args.takeFirst();
+    CliProgress progress;
+    Q_UNUSED(progress)
+
+    int ret;
+    QElapsedTimer et;
+    et.start();
+    try {
+        if (cmd == "convert")
+            ret = cmdConvert(args);
+        else if (cmd == "validate")
+            ret = cmdValidate(args);
+        else if (cmd == "stats")
+            ret = cmdStats(args);
+        else if (cmd == "repack")
+            ret = cmdRepack(args);
+        else if (cmd == "export")
+            ret = cmdExport(args, eo);
+        else
+            usage(argv);
+    } catch (TCException &e) {
+        report(QJsonObject{{"event", "error"}, {"command", cmd}, {"message", e.what()}});
+        ret = 2;
+    } catch (H5::Exception &e) {
+        report(QJsonObject{{"event", "error"}, {"command", cmd}, {"message", QString::fromStdString(e.getDetailMsg())}});
+        ret = 2;
+    }
+    report(QJsonObject{{"event", "timing"}, {"step", "total"}, {"ms", static_cast<double>(et.nsecsElapsed()) / 1e6},
+                       {"threads", QThreadPool::globalInstance()->maxThreadCount()}});
+    if (!traceFile.isEmpty() && !Tracer::getInstance()->dumpChromeTrace(traceFile))
+        report(QJsonObject{{"event", "error"}, {"command", cmd}, {"message", "could not write trace to " + traceFile}});
+    return ret;
+}
@@ -0,0 +1,135 @@
+# TraCurate – A curation tool for object tracks.
+# Copyright (C) 2018 Sebastian Wagner
+#
+# TraCurate is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# TraCurate is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+TARGET = tracurate-cli
+
+# qml is only needed for the QQmlEngine-declarations in the provider headers,
+# no QML engine is created by the CLI
+QT += qml xml concurrent
+QT -= quick
+CONFIG += console
+CONFIG -= app_bundle
+QMAKE_INCDIR += ../src/
+
+# build with "qmake CONFIG+=tracing" to enable the instrumentation from provider/tracer.h
+tracing: DEFINES += TC_TRACING
+
+QMAKE_CXXFLAGS_DEBUG += -O0 -g -std=c++11 -Wall -Wextra -pedantic -Wdeprecated -Wmissing-noreturn -Wunreachable-code -Wswitch-enum
+QMAKE_CXXFLAGS_RELEASE += -O2 -std=c++11 -Wall -Wextra -pedantic
+
+LIBS += -lhdf5_cpp -lhdf5
+
+macx
+{
+    CONFIG += c++11
+    INCLUDEPATH += /usr/local/opt/hdf5@1.8/include
+    LIBS += -L/usr/local/opt/hdf5@1.8/lib
+    QMAKE_RPATHDIR += @executable_path/../Frameworks
+}
+
+SOURCES += cli.cpp \
+    ../src/project.cpp \
+    ../src/exceptions/tcexception.cpp \
+    ../src/exceptions/tcimportexception.cpp \
+    ../src/exceptions/tcformatexception.cpp \
+    ../src/exceptions/tcdataexception.cpp \
+    ../src/exceptions/tcdependencyexception.cpp \
+    ../src/exceptions/tcmissingelementexception.cpp \
+    ../src/exceptions/tcexportexception.cpp \
+    ../src/exceptions/tcunimplementedexception.cpp \
+    ../src/provider/messagerelay.cpp \
+    ../src/provider/tracer.cpp \
+    ../src/provider/tcsettings.cpp \
+    ../src/provider/guistate.cpp \
+    ../src/provider/idprovider.cpp \
+    ../src/io/export.cpp \
+    ../src/io/exportcsv.cpp \
+    ../src/io/exportctc.cpp \
+    ../src/io/exporthdf5.cpp \
+    ../src/io/import.cpp \
+    ../src/io/importhdf5.cpp \
+    ../src/io/importxml.cpp \
+    ../src/io/importlabels.cpp \
+    ../src/io/hdf5_aux.cpp \
+    ../src/io/tiffio.cpp \
+    ../src/base/autotracklet.cpp \
+    ../src/base/channel.cpp \
+    ../src/base/featuretable.cpp \
+    ../src/base/rawimage.cpp \
+    ../src/graphics/displaylut.cpp \
+    ../src/graphics/bordertracer.cpp \
+    ../src/base/frame.cpp \
+    ../src/base/info.cpp \
+    ../src/base/movie.cpp \
+    ../src/base/object.cpp \
+    ../src/base/outlinelod.cpp \
+    ../src/base/slice.cpp \
+    ../src/tracked/annotateable.cpp \
+    ../src/tracked/annotation.cpp \
+    ../src/tracked/genealogy.cpp \
+    ../src/tracked/trackevent.cpp \
+    ../src/tracked/tracklet.cpp
+
+# Default rules for deployment.
+include(../deployment.pri)
+
+HEADERS += \
+    ../src/project.h \
+    ../src/exceptions/tcexception.h \
+    ../src/exceptions/tcimportexception.h \
+    ../src/exceptions/tcformatexception.h \
+    ../src/exceptions/tcdataexception.h \
+    ../src/exceptions/tcdependencyexception.h \
+    ../src/exceptions/tcmissingelementexception.h \
+    ../src/exceptions/tcexportexception.h \
+    ../src/exceptions/tcunimplementedexception.h \
+    ../src/provider/messagerelay.h \
+    ../src/provider/tracer.h \
+    ../src/provider/tcsettings.h \
+    ../src/provider/guistate.h \
+    ../src/provider/idprovider.h \
+    ../src/io/export.h \
+    ../src/io/exportcsv.h \
+    ../src/io/exportctc.h \
+    ../src/io/exporthdf5.h \
+    ../src/io/import.h \
+    ../src/io/importhdf5.h \
+    ../src/io/importxml.h \
+    ../src/io/importlabels.h \
+    ../src/io/hdf5_aux.h \
+    ../src/io/tiffio.h \
+    ../src/base/autotracklet.h \
+    ../src/base/channel.h \
+    ../src/base/featuretable.h \
+    ../src/base/rawimage.h \
+    ../src/graphics/displaylut.h \
+    ../src/graphics/bordertracer.h \
+    ../src/base/frame.h \
+    ../src/base/info.h \
+    ../src/base/movie.h \
+    ../src/base/object.h \
+    ../src/base/outlinelod.h \
+    ../src/base/slice.h \
+    ../src/tracked/annotateable.h \
+    ../src/tracked/annotation.h \
+    ../src/tracked/genealogy.h \
+    ../src/tracked/trackevent.h \
+    ../src/tracked/trackeventdead.hpp \
+    ../src/tracked/trackeventdivision.hpp \
+    ../src/tracked/trackeventendofmovie.hpp \
+    ../src/tracked/trackeventlost.hpp \
+    ../src/tracked/trackeventmerge.hpp \
+    ../src/tracked/trackeventunmerge.hpp \
+    ../src/tracked/tracklet.h
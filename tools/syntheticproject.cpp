@@ -0,0 +1,227 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "syntheticproject.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <H5Cpp.h>
+
+#include "exceptions/tcexportexception.h"
+#include "io/hdf5_aux.h"
+
+namespace TraCurate {
+using namespace H5;
+
+/*!
+ * \brief generates a synthetic project and writes it to a HDF5 file
+ * \param fileName the name of the file to write (it is overwritten)
+ * \param spec the parameters of the project
+ * \throw TCExportException if the spec is unusable or writing failed
+ */
+void SyntheticProject::generate(QString fileName, Spec const &spec)
+{
+    if (spec.frames == 0 || spec.objects == 0 || spec.vertices < 3 || spec.width == 0 || spec.height == 0)
+        throw TCExportException("synthetic project needs at least one frame, one object, three vertices and a non-empty image");
+
+    const uint32_t W = spec.width;
+    const uint32_t H = spec.height;
+    const uint32_t cols = static_cast<uint32_t>(std::ceil(std::sqrt(spec.objects)));
+    const uint32_t rows = (spec.objects + cols - 1) / cols;
+    const double cellW = static_cast<double>(W) / cols;
+    const double cellH = static_cast<double>(H) / rows;
+    const double radius = 0.35 * std::min(cellW, cellH);
+    const uint32_t nTracklets = std::min(spec.tracklets, spec.objects);
+
+    if (radius < 2)
+        throw TCExportException("too many objects for the given image size");
+
+    std::mt19937 rng(spec.seed);
+    std::uniform_real_distribution<double> jitter(0.85, 1.0);
+    std::uniform_int_distribution<int> noise(0, 20);
+
+    try {
+        H5File file(fileName.toStdString().c_str(), H5F_ACC_TRUNC);
+
+        writeFixedLengthString("Cartesian", file, "coordinate_format");
+        writeFixedLengthString("1.0", file, "data_format_version");
+        Group info = openOrCreateGroup(file, "info", 1);
+        openOrCreateGroup(info, "tracking_info");
+
+        { /* events and (empty) annotations */
+            Group eventsGroup = file.createGroup("events");
+            std::vector<std::pair<std::string,std::string>> names =
+            { {"cell_death",    "The cell is identified as dead."},
+              {"cell_division", "The cell divides in 2 or more other cells."},
+              {"cell_lost",     "The cell is lost during the tracking process."},
+              {"cell_merge",    "Two or more cells are merged into an object."},
+              {"cell_unmerge",  "Two or more cells unmerge from an object."},
+              {"end_of_movie",  "The cell track ends at the end of the movie."} };
+            for (unsigned int i = 0; i < names.size(); i++) {
+                Group evGroup = eventsGroup.createGroup(names[i].first, 3);
+                writeFixedLengthString(names[i].second, evGroup, "description");
+                writeSingleValue<unsigned int>(i, evGroup, "event_id", PredType::NATIVE_UINT16);
+                writeFixedLengthString(names[i].first, evGroup, "name");
+            }
+
+            Group annotationsGroup = file.createGroup("annotations", 2);
+            annotationsGroup.createGroup("object_annotations");
+            annotationsGroup.createGroup("track_annotations");
+        }
+
+        Group images = file.createGroup("images", 5); /* frame_rate, frames, nframes, nslices, slice_shape */
+        {
+            uint16_t slice_shape[2] = { 1, 1 };
+            hsize_t dims[] = { 2 };
+            writeSingleValue<float>(-1.0, images, "frame_rate", PredType::NATIVE_FLOAT);
+            writeSingleValue<uint32_t>(spec.frames, images, "nframes", PredType::NATIVE_UINT32);
+            writeSingleValue<uint16_t>(1, images, "nslices", PredType::NATIVE_UINT16);
+            writeMultipleValues<uint16_t>(slice_shape, images, "slice_shape", PredType::NATIVE_UINT16, 1, dims);
+        }
+        Group objects = file.createGroup("objects", 5);
+        linkOrOverwriteLink(H5L_TYPE_SOFT, objects, "/images/frame_rate", "frame_rate");
+        linkOrOverwriteLink(H5L_TYPE_SOFT, objects, "/images/nframes", "nframes");
+        linkOrOverwriteLink(H5L_TYPE_SOFT, objects, "/images/nslices", "nslices");
+        linkOrOverwriteLink(H5L_TYPE_SOFT, objects, "/images/slice_shape", "slice_shape");
+
+        Group imageFrames = images.createGroup("frames", spec.frames);
+        Group objectFrames = objects.createGroup("frames", spec.frames);
+
+        std::vector<uint8_t> img(static_cast<size_t>(W) * H);
+        std::vector<uint32_t> outline(2 * spec.vertices);
+
+        for (uint32_t f = 0; f < spec.frames; f++) {
+            std::string fName = std::to_string(f);
+            std::string slicePath = "/images/frames/" + fName + "/slices/0";
+
+            /* image: noisy dark background, objects are painted in below */
+            for (uint8_t &px : img)
+                px = static_cast<uint8_t>(30 + noise(rng));
+
+            Group objFrame = objectFrames.createGroup(fName, 2);
+            writeSingleValue<uint32_t>(f, objFrame, "frame_id", PredType::NATIVE_UINT32);
+            Group objSlice = objFrame.createGroup("slices", 1).createGroup("0", 4);
+            writeSingleValue<uint16_t>(0, objSlice, "slice_id", PredType::NATIVE_UINT16);
+            linkOrOverwriteLink(H5L_TYPE_SOFT, objSlice, slicePath + "/dimensions", "dimensions");
+            linkOrOverwriteLink(H5L_TYPE_SOFT, objSlice, slicePath + "/nchannels", "nchannels");
+            Group objChannel = objSlice.createGroup("channels", 1).createGroup("0", 2);
+            writeSingleValue<uint16_t>(0, objChannel, "channel_id", PredType::NATIVE_UINT16);
+            Group objObjects = objChannel.createGroup("objects", spec.objects);
+
+            for (uint32_t o = 0; o < spec.objects; o++) {
+                /* objects drift on a small circle, so consecutive frames differ */
+                double phase = 2 * M_PI * (f + o) / 16.0;
+                double cx = (o % cols + 0.5) * cellW + 0.1 * radius * std::cos(phase);
+                double cy = (o / cols + 0.5) * cellH + 0.1 * radius * std::sin(phase);
+
+                int minX = static_cast<int>(W), minY = static_cast<int>(H), maxX = 0, maxY = 0;
+                for (uint32_t v = 0; v < spec.vertices; v++) {
+                    double a = 2 * M_PI * v / spec.vertices;
+                    double r = radius * jitter(rng);
+                    int x = std::max(0, std::min(static_cast<int>(W) - 1, static_cast<int>(std::lround(cx + r * std::cos(a)))));
+                    int y = std::max(0, std::min(static_cast<int>(H) - 1, static_cast<int>(std::lround(cy + r * std::sin(a)))));
+                    minX = std::min(minX, x); maxX = std::max(maxX, x);
+                    minY = std::min(minY, y); maxY = std::max(maxY, y);
+                    /* the data format stores cartesian coordinates */
+                    outline[2*v]     = static_cast<uint32_t>(x);
+                    outline[2*v + 1] = H - static_cast<uint32_t>(y);
+                }
+
+                /* paint the inner disc, that every vertex lies outside of */
+                double inner = 0.85 * radius;
+                for (int y = std::max(0, static_cast<int>(cy - inner)); y <= std::min(static_cast<int>(H) - 1, static_cast<int>(cy + inner)); y++)
+                    for (int x = std::max(0, static_cast<int>(cx - inner)); x <= std::min(static_cast<int>(W) - 1, static_cast<int>(cx + inner)); x++)
+                        if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= inner * inner)
+                            img[static_cast<size_t>(y) * W + x] = static_cast<uint8_t>(200 + noise(rng));
+
+                Group objGroup = objObjects.createGroup(std::to_string(o), 8);
+                uint16_t bounding_box[2][2] = {
+                    { static_cast<uint16_t>(minX), static_cast<uint16_t>(H - minY) },
+                    { static_cast<uint16_t>(maxX), static_cast<uint16_t>(H - maxY) } };
+                hsize_t bbDims[] = { 2, 2 };
+                writeMultipleValues<uint16_t>(*bounding_box, objGroup, "bounding_box", PredType::NATIVE_UINT16, 2, bbDims);
+
+                uint16_t centroid[2] = { static_cast<uint16_t>(std::lround(cx)), static_cast<uint16_t>(H - std::lround(cy)) };
+                hsize_t cDims[] = { 1, 2 };
+                writeMultipleValues<uint16_t>(centroid, objGroup, "centroid", PredType::NATIVE_UINT16, 2, cDims);
+
+                writeSingleValue<uint16_t>(0, objGroup, "channel_id", PredType::NATIVE_UINT16);
+                writeSingleValue<uint32_t>(f, objGroup, "frame_id", PredType::NATIVE_UINT32);
+                writeSingleValue<uint32_t>(o, objGroup, "object_id", PredType::NATIVE_UINT32);
+                writeSingleValue<uint32_t>(0, objGroup, "slice_id", PredType::NATIVE_UINT32);
+
+                hsize_t oDims[] = { spec.vertices, 2 };
+                writeMultipleValues<uint32_t>(outline.data(), objGroup, "outline", PredType::NATIVE_UINT32, 2, oDims);
+            }
+
+            Group imgFrame = imageFrames.createGroup(fName, 2);
+            writeSingleValue<uint32_t>(f, imgFrame, "frame_id", PredType::NATIVE_UINT32);
+            Group imgSlice = imgFrame.createGroup("slices", 1).createGroup("0", 4);
+            uint32_t dimensions[] = { H, W };
+            hsize_t dDims[] = { 2 };
+            writeSingleValue<uint16_t>(1, imgSlice, "nchannels", PredType::NATIVE_UINT16);
+            writeMultipleValues<uint32_t>(dimensions, imgSlice, "dimensions", PredType::NATIVE_UINT32, 1, dDims);
+            writeSingleValue<uint16_t>(0, imgSlice, "slice_id", PredType::NATIVE_UINT16);
+            hsize_t iDims[] = { H, W };
+            writeMultipleValues<uint8_t>(img.data(), imgSlice.createGroup("channels", 1), "0", PredType::NATIVE_UINT8, 2, iDims);
+        }
+
+        /* every grid position is one autotracklet, the first ones are also tracklets */
+        Group autoTracklets = file.createGroup("autotracklets", spec.objects);
+        Group tracklets = file.createGroup("tracklets", nTracklets);
+        for (uint32_t o = 0; o < spec.objects; o++) {
+            std::string oName = std::to_string(o);
+            Group atGroup = autoTracklets.createGroup(oName, 5);
+            writeSingleValue<uint32_t>(o, atGroup, "autotracklet_id", PredType::NATIVE_UINT32);
+            writeSingleValue<uint32_t>(0, atGroup, "start", PredType::NATIVE_UINT32);
+            writeSingleValue<uint32_t>(spec.frames - 1, atGroup, "end", PredType::NATIVE_UINT32);
+            Group atObjects = atGroup.createGroup("objects", spec.frames);
+
+            Group tGroup;
+            Group tObjects;
+            if (o < nTracklets) {
+                tGroup = tracklets.createGroup(oName, 5);
+                writeSingleValue<uint32_t>(o, tGroup, "tracklet_id", PredType::NATIVE_UINT32);
+                writeSingleValue<uint32_t>(0, tGroup, "start", PredType::NATIVE_UINT32);
+                writeSingleValue<uint32_t>(spec.frames - 1, tGroup, "end", PredType::NATIVE_UINT32);
+                tObjects = tGroup.createGroup("objects", spec.frames);
+            }
+
+            /* written like ExportHDF5 does, as membership table and links */
+            std::vector<MemberRow> members;
+            for (uint32_t f = 0; f < spec.frames; f++)
+                members.push_back({{f, 0, 0, o}});
+            writeMembers(members, atGroup);
+            if (o < nTracklets)
+                writeMembers(members, tGroup);
+
+            for (uint32_t f = 0; f < spec.frames; f++) {
+                std::string objectPath = "/objects/frames/" + std::to_string(f) + "/slices/0/channels/0/objects/" + oName;
+                linkOrOverwriteLink(H5L_TYPE_SOFT, atObjects, objectPath, std::to_string(f));
+                if (o < nTracklets)
+                    linkOrOverwriteLink(H5L_TYPE_SOFT, tObjects, objectPath, std::to_string(f));
+            }
+        }
+    } catch (H5::Exception &e) {
+        throw TCExportException("Writing the synthetic project failed: " + e.getDetailMsg());
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * TraCurate – A curation tool for object tracks.
+ * Copyright (C) 2018 Sebastian Wagner
+ *
+ * TraCurate is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * TraCurate is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SYNTHETICPROJECT_H
+#define SYNTHETICPROJECT_H
+
+#include <cstdint>
+
+#include <QString>
+
+namespace TraCurate {
+/*!
+ * \brief The SyntheticProject class
+ *
+ * Writes a synthetic TraCurate HDF5 project that can be loaded by ImportHDF5.
+ * The objects are placed on a regular grid and drift slightly from frame to
+ * frame, each grid position forms one AutoTracklet over the whole movie. The
+ * images contain bright discs at the positions of the objects, so tools like
+ * FloodFill behave like on real data.
+ *
+ * All randomness comes from a generator seeded with Spec::seed, so the same
+ * Spec always results in the same file contents.
+ */
+class SyntheticProject
+{
+public:
+    struct Spec {
+        uint32_t frames;          /*!< number of frames */
+        uint32_t objects;         /*!< number of objects per frame */
+        uint32_t vertices;        /*!< number of vertices of each outline */
+        uint32_t tracklets;       /*!< number of tracklets (at most objects) */
+        uint32_t width;           /*!< image width in pixels */
+        uint32_t height;          /*!< image height in pixels */
+        uint32_t seed;            /*!< seed for the random number generator */
+    };
+
+    SyntheticProject() = delete;
+    ~SyntheticProject() = delete;
+
+    static void generate(QString fileName, Spec const &spec);
+};
+}
+
+#endif // SYNTHETICPROJECT_H
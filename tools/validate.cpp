@@ -19,28 +19,74 @@
 
 #include <iostream>
 
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QString>
 #include <QFile>
 
 __attribute__((noreturn)) void usage(char *argv[]) {
     std::cerr << "Usage:" << std::endl
-              << "\t" << argv[0] << " filename [args]" << std::endl
+              << "\t" << argv[0] << " [--json] [--fail-fast] [--threads N] filename" << std::endl
               << std::endl
-              << "filename\tName of the HDF5 file to check" << std::endl;
+              << "filename\tName of the HDF5 file to check" << std::endl
+              << "--json\t\tprint one JSON object per finding and one for the result" << std::endl
+              << "--fail-fast\tstop at the first error" << std::endl
+              << "--threads N\tuse at most N threads (default: number of cores)" << std::endl
+              << std::endl
+              << "The findings are printed as they are found. The exit status is 0 if the" << std::endl
+              << "file is valid and 1 if it is not." << std::endl;
     exit(-1);
 }
 
 int main(int argc, char *argv[])
 {
-    if (argc < 2)
+    using namespace TraCurate;
+
+    Validator::Options options;
+    bool json = false;
+    QString qs;
+    for (int i = 1; i < argc; i++) {
+        QString arg(argv[i]);
+        if (arg == "--json")
+            json = true;
+        else if (arg == "--fail-fast")
+            options.stopAtFirstError = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            options.threads = QString(argv[++i]).toInt();
+        else if (qs.isEmpty() && !arg.startsWith("--"))
+            qs = arg;
+        else
+            usage(argv);
+    }
+    if (qs.isEmpty())
         usage(argv);
 
-    QString qs(argv[1]);
     QFile qf(qs);
     if (!qf.exists()) {
         std::cerr << qs.toStdString() << " is not a file." << std::endl;
         return -1;
     }
-    TraCurate::Validator::validTraCurateFile(qs, true, true, true);
-    return 0;
+
+    int errors = 0, warnings = 0;
+    options.report = [&](Validator::Finding const &f) {
+        bool error = (f.severity == Validator::Finding::ERROR);
+        (error ? errors : warnings)++;
+        if (json)
+            std::cout << QJsonDocument(QJsonObject{{"severity", error ? "error" : "warning"},
+                                                   {"path", QString::fromStdString(f.path)},
+                                                   {"message", QString::fromStdString(f.message)}})
+                         .toJson(QJsonDocument::Compact).toStdString() << std::endl;
+        else
+            std::cout << (error ? "error: " : "warning: ") << f.path << " " << f.message << std::endl;
+    };
+
+    bool valid = Validator::validTraCurateFile(qs, options);
+    if (json)
+        std::cout << QJsonDocument(QJsonObject{{"result", valid ? "valid" : "invalid"},
+                                               {"errors", errors}, {"warnings", warnings}})
+                     .toJson(QJsonDocument::Compact).toStdString() << std::endl;
+    else
+        std::cout << qs.toStdString() << (valid ? " is valid" : " is invalid") << " ("
+                  << errors << " errors, " << warnings << " warnings)" << std::endl;
+    return valid ? 0 : 1;
 }
@@ -15,9 +15,12 @@
 # along with TraCurate.  If not, see <https://www.gnu.org/licenses/>.
 TARGET = validate
 
-QT += qml quick xml
+QT += qml quick xml concurrent
 QMAKE_INCDIR += ../src/
 
+# build with "qmake CONFIG+=tracing" to enable the instrumentation from provider/tracer.h
+tracing: DEFINES += TC_TRACING
+
 QMAKE_CXXFLAGS_DEBUG += -O0 -g -std=c++11 -Wall -Wextra -pedantic -Wdeprecated -Wmissing-noreturn -Wunreachable-code -Wswitch-enum
 QMAKE_CXXFLAGS_RELEASE += -O0 -g -std=c++11 -Wall -Wextra -pedantic
 
@@ -40,6 +43,7 @@ SOURCES += validate.cpp \
     ../src/exceptions/tcdependencyexception.cpp \
     ../src/exceptions/tcmissingelementexception.cpp \
     ../src/provider/messagerelay.cpp \
+    ../src/provider/tracer.cpp \
     ../src/exceptions/tcexportexception.cpp \
     ../src/provider/dataprovider.cpp \
     ../src/provider/tcsettings.cpp \
@@ -47,27 +51,41 @@ SOURCES += validate.cpp \
     ../src/provider/guicontroller.cpp \
     ../src/exceptions/tcunimplementedexception.cpp \
     ../src/provider/imageprovider.cpp \
+    ../src/provider/imagecache.cpp \
+    ../src/provider/thumbnailcache.cpp \
+    ../src/provider/undostack.cpp \
     ../src/io/export.cpp \
     ../src/io/exporthdf5.cpp \
+    ../src/io/projectsnapshot.cpp \
+    ../src/io/journal.cpp \
     ../src/io/import.cpp \
     ../src/io/importhdf5.cpp \
     ../src/io/importxml.cpp \
     ../src/io/hdf5_aux.cpp \
     ../src/base/autotracklet.cpp \
     ../src/base/channel.cpp \
+    ../src/base/featuretable.cpp \
+    ../src/base/rawimage.cpp \
+    ../src/graphics/displaylut.cpp \
     ../src/base/frame.cpp \
     ../src/base/info.cpp \
     ../src/base/movie.cpp \
     ../src/base/object.cpp \
+    ../src/base/outlinelod.cpp \
     ../src/base/slice.cpp \
     ../src/tracked/annotateable.cpp \
     ../src/tracked/annotation.cpp \
     ../src/tracked/genealogy.cpp \
     ../src/tracked/trackevent.cpp \
     ../src/tracked/tracklet.cpp \
+    ../src/tracked/trackletlinker.cpp \
     ../src/provider/idprovider.cpp \
     ../src/graphics/separate.cpp \
+    ../src/graphics/watershed.cpp \
+    ../src/graphics/bordertracer.cpp \
+    ../src/graphics/trackresegmentation.cpp \
     ../src/graphics/merge.cpp \
+    ../src/graphics/polygonunion.cpp \
     ../src/io/modifyhdf5.cpp \
     ../src/graphics/base.cpp \
     ../src/graphics/floodfill.cpp
@@ -89,6 +107,7 @@ HEADERS += \
     ../src/exceptions/tcdependencyexception.h \
     ../src/exceptions/tcmissingelementexception.h \
     ../src/provider/messagerelay.h \
+    ../src/provider/tracer.h \
     ../src/exceptions/tcexportexception.h \
     ../src/provider/dataprovider.h \
     ../src/provider/tcsettings.h \
@@ -96,18 +115,27 @@ HEADERS += \
     ../src/provider/guicontroller.h \
     ../src/exceptions/tcunimplementedexception.h \
     ../src/provider/imageprovider.h \
+    ../src/provider/imagecache.h \
+    ../src/provider/thumbnailcache.h \
+    ../src/provider/undostack.h \
     ../src/io/export.h \
     ../src/io/exporthdf5.h \
+    ../src/io/projectsnapshot.h \
+    ../src/io/journal.h \
     ../src/io/import.h \
     ../src/io/importhdf5.h \
     ../src/io/importxml.h \
     ../src/io/hdf5_aux.h \
     ../src/base/autotracklet.h \
     ../src/base/channel.h \
+    ../src/base/featuretable.h \
+    ../src/base/rawimage.h \
+    ../src/graphics/displaylut.h \
     ../src/base/frame.h \
     ../src/base/info.h \
     ../src/base/movie.h \
     ../src/base/object.h \
+    ../src/base/outlinelod.h \
     ../src/base/slice.h \
     ../src/tracked/annotateable.h \
     ../src/tracked/annotation.h \
@@ -121,8 +149,13 @@ HEADERS += \
     ../src/tracked/trackeventmerge.hpp \
     ../src/tracked/trackeventunmerge.hpp \
     ../src/tracked/tracklet.h \
+    ../src/tracked/trackletlinker.h \
     ../src/graphics/separate.h \
+    ../src/graphics/watershed.h \
+    ../src/graphics/bordertracer.h \
+    ../src/graphics/trackresegmentation.h \
     ../src/graphics/merge.h \
+    ../src/graphics/polygonunion.h \
     ../src/io/modifyhdf5.h \
     ../src/graphics/base.h \
     ../src/graphics/floodfill.h
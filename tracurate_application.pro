@@ -16,8 +16,11 @@
 TEMPLATE = app
 
 TARGET = TraCurate
-QT += qml quick svg xml gui
+QT += qml quick svg xml gui concurrent
 QMAKE_INCDIR += src/
+
+# build with "qmake CONFIG+=tracing" to enable the instrumentation from provider/tracer.h
+tracing: DEFINES += TC_TRACING
 RC_ICONS = "icons/tc-logo.ico"
 
 macx {
@@ -130,32 +133,50 @@ SOURCES += main.cpp \
     src/provider/guicontroller.cpp \
     src/exceptions/tcunimplementedexception.cpp \
     src/provider/imageprovider.cpp \
+    src/provider/imagecache.cpp \
+    src/provider/lineageview.cpp \
+    src/provider/thumbnailcache.cpp \
+    src/provider/undostack.cpp \
+    src/provider/thumbnailprovider.cpp \
     src/io/export.cpp \
     src/io/exporthdf5.cpp \
+    src/io/projectsnapshot.cpp \
+    src/io/journal.cpp \
     src/io/import.cpp \
     src/io/importhdf5.cpp \
     src/io/importxml.cpp \
     src/io/hdf5_aux.cpp \
     src/base/autotracklet.cpp \
     src/base/channel.cpp \
+    src/base/featuretable.cpp \
+    src/base/rawimage.cpp \
+    src/graphics/displaylut.cpp \
     src/base/frame.cpp \
     src/base/info.cpp \
     src/base/movie.cpp \
     src/base/object.cpp \
+    src/base/outlinelod.cpp \
     src/base/slice.cpp \
     src/tracked/annotateable.cpp \
     src/tracked/annotation.cpp \
     src/tracked/genealogy.cpp \
     src/tracked/trackevent.cpp \
     src/tracked/tracklet.cpp \
+    src/tracked/trackletlinker.cpp \
+    src/tracked/lineagelayout.cpp \
     src/provider/idprovider.cpp \
     src/exceptions/tcdependencyexception.cpp \
     src/graphics/merge.cpp \
+    src/graphics/polygonunion.cpp \
     src/graphics/separate.cpp \
+    src/graphics/watershed.cpp \
+    src/graphics/bordertracer.cpp \
+    src/graphics/trackresegmentation.cpp \
     src/io/modifyhdf5.cpp \
     src/graphics/base.cpp \
     src/graphics/floodfill.cpp \
-    src/provider/timetracker.cpp
+    src/provider/timetracker.cpp \
+    src/provider/tracer.cpp
 
 # examples
 SOURCES += src/examples/examplewriteallimages.cpp \
@@ -197,18 +218,29 @@ HEADERS += \
     src/provider/guicontroller.h \
     src/exceptions/tcunimplementedexception.h \
     src/provider/imageprovider.h \
+    src/provider/imagecache.h \
+    src/provider/lineageview.h \
+    src/provider/thumbnailcache.h \
+    src/provider/undostack.h \
+    src/provider/thumbnailprovider.h \
     src/io/export.h \
     src/io/exporthdf5.h \
+    src/io/projectsnapshot.h \
+    src/io/journal.h \
     src/io/import.h \
     src/io/importhdf5.h \
     src/io/importxml.h \
     src/io/hdf5_aux.h \
     src/base/autotracklet.h \
     src/base/channel.h \
+    src/base/featuretable.h \
+    src/base/rawimage.h \
+    src/graphics/displaylut.h \
     src/base/frame.h \
     src/base/info.h \
     src/base/movie.h \
     src/base/object.h \
+    src/base/outlinelod.h \
     src/base/slice.h \
     src/tracked/annotateable.h \
     src/tracked/annotation.h \
@@ -216,15 +248,22 @@ HEADERS += \
     src/provider/idprovider.h \
     src/tracked/trackevent.h \
     src/tracked/tracklet.h \
+    src/tracked/trackletlinker.h \
+    src/tracked/lineagelayout.h \
     src/exceptions/tcdependencyexception.h \
     src/graphics/merge.h \
+    src/graphics/polygonunion.h \
     src/graphics/separate.h \
+    src/graphics/watershed.h \
+    src/graphics/bordertracer.h \
+    src/graphics/trackresegmentation.h \
     src/version.h \
     src/io/modify.h \
     src/io/modifyhdf5.h \
     src/graphics/base.h \
     src/graphics/floodfill.h \
     src/provider/timetracker.h \
+    src/provider/tracer.h \
     src/tracked/trackeventdead.hpp \
     src/tracked/trackeventdivision.hpp \
     src/tracked/trackeventendofmovie.hpp \